@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationtracker.cpp
+// ============
+// heap allocation counting - replaces the global operator new so the render
+// loop can check that steady-state frames never allocate
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AllocationTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+// declaration of the global variables and defines
+namespace
+{
+	// operator new calls made by each thread - a plain counter
+	// per thread, so counting never needs a lock
+	thread_local uint64_t t_AllocationCount = 0;
+
+	/***********************************************************
+	 *  CountedAllocate()
+	 *
+	 *  This function counts and performs one heap allocation.
+	 ***********************************************************/
+	void* CountedAllocate(size_t size)
+	{
+		t_AllocationCount++;
+
+		if (size == 0)
+		{
+			size = 1;
+		}
+
+		void* pMemory = std::malloc(size);
+		while (NULL == pMemory)
+		{
+			std::new_handler handler = std::get_new_handler();
+			if (NULL == handler)
+			{
+				throw std::bad_alloc();
+			}
+			handler();
+			pMemory = std::malloc(size);
+		}
+
+		return(pMemory);
+	}
+}
+
+/***********************************************************
+ *  GetThreadAllocations()
+ *
+ *  This method returns the number of operator new calls made
+ *  by the calling thread.
+ ***********************************************************/
+uint64_t AllocationTracker::GetThreadAllocations()
+{
+	return(t_AllocationCount);
+}
+
+// the replaced global allocation functions - every form is
+// replaced, so an allocation is always counted and a sized or
+// nothrow delete never reaches the library's own allocator
+void* operator new(size_t size)
+{
+	return(CountedAllocate(size));
+}
+
+void* operator new[](size_t size)
+{
+	return(CountedAllocate(size));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return(CountedAllocate(size));
+	}
+	catch (const std::bad_alloc&)
+	{
+		return(NULL);
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return(CountedAllocate(size));
+	}
+	catch (const std::bad_alloc&)
+	{
+		return(NULL);
+	}
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory, size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, const std::nothrow_t&) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory, const std::nothrow_t&) noexcept
+{
+	std::free(pMemory);
+}
@@ -0,0 +1,24 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationtracker.h
+// ============
+// heap allocation counting - replaces the global operator new so the render
+// loop can check that steady-state frames never allocate
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+/***********************************************************
+ *  AllocationTracker
+ *
+ *  This class reports the number of calls to operator new
+ *  made by the calling thread.  Taking the count before and
+ *  after a block of code shows whether the block allocated.
+ ***********************************************************/
+class AllocationTracker
+{
+public:
+	// number of operator new calls made by the calling thread
+	static uint64_t GetThreadAllocations();
+};
@@ -0,0 +1,443 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.cpp
+// ============
+// keyframe animation - curves on object transforms, balloons, lights and
+// material colors, evaluated in batches over every track at once
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AnimationSystem.h"
+#include "TraceRecorder.h"
+#include "AssetPack.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+// the tracks are blended four at a time with SSE2, which every x86
+// target of the project has
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define ANIMATION_SSE2
+#include <emmintrin.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	struct PROPERTY_NAME
+	{
+		const char* name;
+		SceneManager::ANIMATED_PROPERTY property;
+	};
+
+	const PROPERTY_NAME g_PropertyNames[] =
+	{
+		{ "object-position", SceneManager::ANIMATE_OBJECT_POSITION },
+		{ "object-rotation", SceneManager::ANIMATE_OBJECT_ROTATION },
+		{ "object-scale", SceneManager::ANIMATE_OBJECT_SCALE },
+		{ "balloon-position", SceneManager::ANIMATE_BALLOON_POSITION },
+		{ "light-position", SceneManager::ANIMATE_LIGHT_POSITION },
+		{ "light-diffuse", SceneManager::ANIMATE_LIGHT_DIFFUSE },
+		{ "light-specular", SceneManager::ANIMATE_LIGHT_SPECULAR },
+		{ "material-diffuse", SceneManager::ANIMATE_MATERIAL_DIFFUSE },
+		{ "material-specular", SceneManager::ANIMATE_MATERIAL_SPECULAR }
+	};
+
+	// number of numbers, and so of tracks, in every channel
+	const int CHANNEL_TRACKS = 3;
+
+	// the golden ratio spreads the start of the bobbing evenly
+	const float GOLDEN_RATIO_FRACTION = 0.618034f;
+}
+
+/***********************************************************
+ *  AnimationSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AnimationSystem::AnimationSystem(SceneManager* pSceneManager)
+{
+	m_pSceneManager = pSceneManager;
+	m_time = 0.0f;
+	m_trackCount = 0;
+	m_totalUpdateUs = 0.0;
+	m_maxUpdateUs = 0.0;
+	m_changedChannels = 0;
+	m_updateCount = 0;
+}
+
+/***********************************************************
+ *  LoadFile()
+ *
+ *  This method is used to read the channels of an animation
+ *  file.  Each channel line names the value it drives and is
+ *  followed by its keys:
+ *
+ *  channel <property> <target> <loop|once> <linear|smooth> [start seconds]
+ *  key <seconds> <x> <y> <z>
+ ***********************************************************/
+bool AnimationSystem::LoadFile(const char* filename)
+{
+	std::string contents;
+	if (AssetPack::ReadTextFile(filename, contents) == false)
+	{
+		std::cout << "Could not open animation file:" << filename << std::endl;
+		return(false);
+	}
+	std::istringstream file(contents);
+
+	// the channel being read, added once all of its keys are in
+	SceneManager::ANIMATED_PROPERTY property = SceneManager::ANIMATE_OBJECT_POSITION;
+	int target = -1;
+	bool bLoop = false;
+	bool bSmooth = false;
+	float startSeconds = 0.0f;
+	std::vector<ANIMATION_KEY> keys;
+	int channelLine = 0;
+
+	std::string text;
+	int lineNumber = 0;
+	bool bValid = true;
+	while (bValid && std::getline(file, text))
+	{
+		lineNumber++;
+
+		// strip comments
+		size_t comment = text.find('#');
+		if (comment != std::string::npos)
+		{
+			text.erase(comment);
+		}
+
+		std::istringstream line(text);
+		std::string entry;
+		if (!(line >> entry))
+		{
+			continue;
+		}
+
+		if (entry == "channel")
+		{
+			if ((channelLine > 0) && (AddChannel(property, target, keys, bLoop, bSmooth, startSeconds) == false))
+			{
+				lineNumber = channelLine;
+				bValid = false;
+				break;
+			}
+
+			std::string propertyName;
+			std::string targetName;
+			std::string playback;
+			std::string easing;
+			line >> propertyName >> targetName >> playback >> easing;
+			bValid = !line.fail() &&
+				((playback == "loop") || (playback == "once")) &&
+				((easing == "linear") || (easing == "smooth"));
+
+			bool bFoundProperty = false;
+			for (const PROPERTY_NAME& name : g_PropertyNames)
+			{
+				if (propertyName == name.name)
+				{
+					property = name.property;
+					bFoundProperty = true;
+				}
+			}
+			bValid = bValid && bFoundProperty;
+
+			startSeconds = 0.0f;
+			if (bValid && !(line >> startSeconds))
+			{
+				startSeconds = 0.0f;
+			}
+
+			target = bValid ? m_pSceneManager->FindAnimationTarget(property, targetName) : -1;
+			if (bValid && (target < 0))
+			{
+				std::cout << "The animation target " << targetName << " is not in the scene" << std::endl;
+				bValid = false;
+			}
+			bLoop = (playback == "loop");
+			bSmooth = (easing == "smooth");
+			keys.clear();
+			channelLine = lineNumber;
+		}
+		else if ((entry == "key") && (channelLine > 0))
+		{
+			ANIMATION_KEY key;
+			line >> key.time >> key.value.x >> key.value.y >> key.value.z;
+			bValid = !line.fail() && (keys.empty() || (key.time >= keys.back().time));
+			keys.push_back(key);
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (bValid && (channelLine > 0) && (AddChannel(property, target, keys, bLoop, bSmooth, startSeconds) == false))
+	{
+		lineNumber = channelLine;
+		bValid = false;
+	}
+	if (false == bValid)
+	{
+		std::cout << "Could not read animation file:" << filename << ", line:" << lineNumber << std::endl;
+		return(false);
+	}
+
+	std::cout << "INFO: animation file " << filename << " - channels:" << m_channels.size()
+		<< ", tracks:" << m_trackCount << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  AddChannel()
+ *
+ *  This method is used to add a channel with one track for
+ *  each of its three numbers, appending their keys to the
+ *  key arrays.
+ ***********************************************************/
+bool AnimationSystem::AddChannel(
+	SceneManager::ANIMATED_PROPERTY property,
+	int target,
+	const std::vector<ANIMATION_KEY>& keys,
+	bool bLoop,
+	bool bSmooth,
+	float startSeconds)
+{
+	if ((target < 0) || (true == keys.empty()))
+	{
+		return(false);
+	}
+
+	ANIMATION_CHANNEL channel;
+	channel.property = property;
+	channel.target = target;
+	channel.firstTrack = m_trackCount;
+	m_channels.push_back(channel);
+
+	for (int component = 0; component < CHANNEL_TRACKS; component++)
+	{
+		m_trackFirstKey.push_back((int)m_keyTimes.size());
+		m_trackKeyCount.push_back((int)keys.size());
+		m_trackCursor.push_back(0);
+		m_trackStart.push_back(startSeconds);
+		m_trackDuration.push_back(keys.back().time);
+		m_trackLoops.push_back(bLoop ? 1 : 0);
+		m_trackSmoothing.push_back(bSmooth ? 1.0f : 0.0f);
+		for (const ANIMATION_KEY& key : keys)
+		{
+			m_keyTimes.push_back(key.time);
+			m_keyValues.push_back(key.value[component]);
+		}
+	}
+	m_trackCount += CHANNEL_TRACKS;
+
+	// no value has been written yet, so every value is different
+	// from the first one blended
+	m_segmentTime.resize(m_trackCount, 0.0f);
+	m_segmentInverseSpan.resize(m_trackCount, 0.0f);
+	m_segmentFrom.resize(m_trackCount, 0.0f);
+	m_segmentChange.resize(m_trackCount, 0.0f);
+	m_values.resize(m_trackCount, std::numeric_limits<float>::quiet_NaN());
+	m_trackChanged.resize(m_trackCount, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  AddObjectBobbing()
+ *
+ *  This method is used to bob every object of the loaded
+ *  scene description up and down around where it stands.
+ *  The objects start at different moments, so they do not
+ *  move as one.
+ ***********************************************************/
+void AnimationSystem::AddObjectBobbing(float height, float periodSeconds)
+{
+	std::vector<ANIMATION_KEY> keys(3);
+	for (int i = 0; i < m_pSceneManager->GetSceneObjectCount(); i++)
+	{
+		glm::vec3 position;
+		if (m_pSceneManager->GetAnimatedValue(SceneManager::ANIMATE_OBJECT_POSITION, i, position) == false)
+		{
+			continue;
+		}
+
+		keys[0].time = 0.0f;
+		keys[0].value = position;
+		keys[1].time = periodSeconds * 0.5f;
+		keys[1].value = position + glm::vec3(0.0f, height, 0.0f);
+		keys[2].time = periodSeconds;
+		keys[2].value = position;
+
+		float start = std::fmod(i * GOLDEN_RATIO_FRACTION, 1.0f) * periodSeconds;
+		AddChannel(SceneManager::ANIMATE_OBJECT_POSITION, i, keys, true, true, start);
+	}
+
+	std::cout << "INFO: animation bobbing objects - channels:" << m_channels.size()
+		<< ", tracks:" << m_trackCount << std::endl;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to move the animation forward, blend
+ *  every track, and write the channels that changed into the
+ *  scene.
+ ***********************************************************/
+void AnimationSystem::Update(float elapsedSeconds)
+{
+	if ((0 == m_trackCount) || (elapsedSeconds <= 0.0f))
+	{
+		return;
+	}
+
+	TRACE_SCOPE("AnimationSystem::Update");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	m_time += elapsedSeconds;
+	FindSegments();
+	BlendSegments();
+
+	for (const ANIMATION_CHANNEL& channel : m_channels)
+	{
+		int track = channel.firstTrack;
+		if ((0 == m_trackChanged[track]) && (0 == m_trackChanged[track + 1]) && (0 == m_trackChanged[track + 2]))
+		{
+			continue;
+		}
+
+		m_pSceneManager->SetAnimatedValue(channel.property, channel.target,
+			glm::vec3(m_values[track], m_values[track + 1], m_values[track + 2]));
+		m_changedChannels++;
+	}
+
+	double updateUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	m_totalUpdateUs += updateUs;
+	m_maxUpdateUs = (updateUs > m_maxUpdateUs) ? updateUs : m_maxUpdateUs;
+	m_updateCount++;
+}
+
+/***********************************************************
+ *  FindSegments()
+ *
+ *  This method is used to find the keys either side of the
+ *  current time of every track.  Time only moves forward, so
+ *  each track steps on from the key it reached last, and
+ *  starts again from its first key when it loops.
+ ***********************************************************/
+void AnimationSystem::FindSegments()
+{
+	for (int i = 0; i < m_trackCount; i++)
+	{
+		const float* times = &m_keyTimes[m_trackFirstKey[i]];
+		const float* values = &m_keyValues[m_trackFirstKey[i]];
+		const int keyCount = m_trackKeyCount[i];
+		const float duration = m_trackDuration[i];
+
+		float local = m_time + m_trackStart[i];
+		if ((0 != m_trackLoops[i]) && (duration > 0.0f))
+		{
+			local -= duration * std::floor(local / duration);
+		}
+		else if (local > duration)
+		{
+			local = duration;
+		}
+
+		int cursor = m_trackCursor[i];
+		if (local < times[cursor])
+		{
+			cursor = 0;
+		}
+		while ((cursor + 2 < keyCount) && (local >= times[cursor + 1]))
+		{
+			cursor++;
+		}
+		m_trackCursor[i] = cursor;
+
+		if (keyCount < 2)
+		{
+			m_segmentTime[i] = 0.0f;
+			m_segmentInverseSpan[i] = 0.0f;
+			m_segmentFrom[i] = values[0];
+			m_segmentChange[i] = 0.0f;
+			continue;
+		}
+
+		float span = times[cursor + 1] - times[cursor];
+		m_segmentTime[i] = local - times[cursor];
+		m_segmentInverseSpan[i] = (span > 0.0f) ? 1.0f / span : 0.0f;
+		m_segmentFrom[i] = values[cursor];
+		m_segmentChange[i] = values[cursor + 1] - values[cursor];
+	}
+}
+
+/***********************************************************
+ *  BlendSegments()
+ *
+ *  This method is used to blend between the keys found for
+ *  every track, easing in and out for the smooth tracks, and
+ *  to mark the tracks whose value changed.
+ ***********************************************************/
+void AnimationSystem::BlendSegments()
+{
+	int i = 0;
+#ifdef ANIMATION_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 three = _mm_set1_ps(3.0f);
+	for (; i + 4 <= m_trackCount; i += 4)
+	{
+		__m128 blend = _mm_mul_ps(_mm_loadu_ps(&m_segmentTime[i]), _mm_loadu_ps(&m_segmentInverseSpan[i]));
+		blend = _mm_min_ps(_mm_max_ps(blend, zero), one);
+		__m128 eased = _mm_mul_ps(_mm_mul_ps(blend, blend), _mm_sub_ps(three, _mm_mul_ps(two, blend)));
+		blend = _mm_add_ps(blend, _mm_mul_ps(_mm_loadu_ps(&m_trackSmoothing[i]), _mm_sub_ps(eased, blend)));
+		__m128 value = _mm_add_ps(_mm_loadu_ps(&m_segmentFrom[i]), _mm_mul_ps(_mm_loadu_ps(&m_segmentChange[i]), blend));
+
+		int changed = _mm_movemask_ps(_mm_cmpneq_ps(value, _mm_loadu_ps(&m_values[i])));
+		_mm_storeu_ps(&m_values[i], value);
+		m_trackChanged[i] = (uint8_t)(changed & 1);
+		m_trackChanged[i + 1] = (uint8_t)((changed >> 1) & 1);
+		m_trackChanged[i + 2] = (uint8_t)((changed >> 2) & 1);
+		m_trackChanged[i + 3] = (uint8_t)((changed >> 3) & 1);
+	}
+#endif
+	for (; i < m_trackCount; i++)
+	{
+		float blend = m_segmentTime[i] * m_segmentInverseSpan[i];
+		blend = (blend < 0.0f) ? 0.0f : ((blend > 1.0f) ? 1.0f : blend);
+		float eased = blend * blend * (3.0f - 2.0f * blend);
+		blend += m_trackSmoothing[i] * (eased - blend);
+		float value = m_segmentFrom[i] + m_segmentChange[i] * blend;
+
+		// written so a value that is not yet a number is changed
+		m_trackChanged[i] = (value != m_values[i]) ? 1 : 0;
+		m_values[i] = value;
+	}
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print the update times and how
+ *  many channels were written into the scene.
+ ***********************************************************/
+void AnimationSystem::PrintReport() const
+{
+	if (0 == m_updateCount)
+	{
+		return;
+	}
+
+	std::cout << "ANIMATION: channels:" << m_channels.size()
+		<< ", tracks:" << m_trackCount
+		<< ", updates:" << m_updateCount
+		<< ", average us:" << (m_totalUpdateUs / m_updateCount)
+		<< ", max us:" << m_maxUpdateUs
+		<< ", changed channels per update:" << (m_changedChannels / m_updateCount) << std::endl;
+}
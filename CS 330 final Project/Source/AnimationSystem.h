@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.h
+// ============
+// keyframe animation - curves on object transforms, balloons, lights and
+// material colors, evaluated in batches over every track at once
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  AnimationSystem
+ *
+ *  This class plays keyframe animation on the scene.  Each
+ *  channel drives one three number value of the scene, such
+ *  as the position of an object or the diffuse color of a
+ *  light, with one track of keys for each of the numbers.
+ *  The keys of every track are kept end to end in one pair
+ *  of arrays, and each track remembers the key it reached
+ *  last, so finding the current keys is a short step forward.
+ *  The keys found are copied into arrays of their own, which
+ *  are then blended four tracks at a time.  Only the channels
+ *  whose value changed are written into the scene.
+ ***********************************************************/
+class AnimationSystem
+{
+public:
+	// one key of a channel - the time in seconds from the start
+	// of the channel and the value at that time
+	struct ANIMATION_KEY
+	{
+		float time;
+		glm::vec3 value;
+	};
+
+	// constructor
+	AnimationSystem(SceneManager* pSceneManager);
+
+	// read the channels of an animation file and bind them to
+	// the scene - call once the scene is loaded
+	bool LoadFile(const char* filename);
+	// add a channel from code - keys must be in time order, and
+	// the channel starts the passed in number of seconds in
+	bool AddChannel(
+		SceneManager::ANIMATED_PROPERTY property,
+		int target,
+		const std::vector<ANIMATION_KEY>& keys,
+		bool bLoop,
+		bool bSmooth,
+		float startSeconds);
+	// bob every object of the loaded scene description up and
+	// down, each at its own moment, to load test the animation
+	void AddObjectBobbing(float height, float periodSeconds);
+
+	// move the animation forward and write the changed values
+	// into the scene
+	void Update(float elapsedSeconds);
+
+	int GetChannelCount() const { return((int)m_channels.size()); }
+	int GetTrackCount() const { return(m_trackCount); }
+
+	// print the update times
+	void PrintReport() const;
+
+private:
+	// a channel binds three tracks, starting at firstTrack, to a
+	// value of the scene
+	struct ANIMATION_CHANNEL
+	{
+		SceneManager::ANIMATED_PROPERTY property;
+		int target;
+		int firstTrack;
+	};
+
+	SceneManager* m_pSceneManager;
+	std::vector<ANIMATION_CHANNEL> m_channels;
+	float m_time;
+	int m_trackCount;
+
+	// the keys of every track, end to end
+	std::vector<float> m_keyTimes;
+	std::vector<float> m_keyValues;
+
+	// the tracks - where their keys are, how long they run,
+	// whether they loop and ease, and the key reached last
+	std::vector<int> m_trackFirstKey;
+	std::vector<int> m_trackKeyCount;
+	std::vector<int> m_trackCursor;
+	std::vector<float> m_trackStart;
+	std::vector<float> m_trackDuration;
+	std::vector<uint8_t> m_trackLoops;
+	std::vector<float> m_trackSmoothing;
+
+	// the keys either side of the current time of every track,
+	// blended as a batch into the values
+	std::vector<float> m_segmentTime;
+	std::vector<float> m_segmentInverseSpan;
+	std::vector<float> m_segmentFrom;
+	std::vector<float> m_segmentChange;
+	std::vector<float> m_values;
+	std::vector<uint8_t> m_trackChanged;
+
+	// update timing
+	double m_totalUpdateUs;
+	double m_maxUpdateUs;
+	uint64_t m_changedChannels;
+	int m_updateCount;
+
+	// find the keys either side of the current time of a range of
+	// tracks, then blend them
+	void FindSegments();
+	void BlendSegments();
+};
@@ -0,0 +1,532 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetfilereader.cpp
+// ============
+// batched asset file reads - reads a list of asset files into memory in one
+// batch of io_uring requests where the build and kernel support it
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetFileReader.h"
+#include "TraceRecorder.h"
+
+#if defined(__linux__) && defined(ASSET_IO_URING)
+#define ASSET_FILE_READER_URING
+#include <liburing.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+#ifdef ASSET_FILE_READER_URING
+	// requests in flight at once - every file takes an open and a
+	// size request, so half as many files go into each submission
+	const unsigned int QUEUE_DEPTH = 128;
+	const size_t FILES_PER_SUBMISSION = QUEUE_DEPTH / 2;
+	// waits for a completion that fail before the ring is given up
+	const int WAIT_ATTEMPTS = 16;
+#endif
+
+	/***********************************************************
+	 *  AllocateAligned()
+	 *
+	 *  This function is used to allocate a buffer of at least
+	 *  the passed in size, rounded up to the alignment, that
+	 *  starts on an aligned address.
+	 ***********************************************************/
+	unsigned char* AllocateAligned(size_t size)
+	{
+		size_t alignedSize = (size + AssetFileReader::ALIGNMENT - 1) & ~(AssetFileReader::ALIGNMENT - 1);
+		if (alignedSize == 0)
+		{
+			alignedSize = AssetFileReader::ALIGNMENT;
+		}
+
+#ifdef _WIN32
+		return((unsigned char*)_aligned_malloc(alignedSize, AssetFileReader::ALIGNMENT));
+#else
+		void* pBuffer = NULL;
+		if (posix_memalign(&pBuffer, AssetFileReader::ALIGNMENT, alignedSize) != 0)
+		{
+			return(NULL);
+		}
+		return((unsigned char*)pBuffer);
+#endif
+	}
+
+	/***********************************************************
+	 *  FreeAligned()
+	 *
+	 *  This function is used to free a buffer allocated by
+	 *  AllocateAligned().
+	 ***********************************************************/
+	void FreeAligned(unsigned char* pBuffer)
+	{
+#ifdef _WIN32
+		_aligned_free(pBuffer);
+#else
+		free(pBuffer);
+#endif
+	}
+
+	/***********************************************************
+	 *  ReadFileBlocking()
+	 *
+	 *  This function is used to read a whole file with blocking
+	 *  reads, for builds and kernels without io_uring.
+	 ***********************************************************/
+	bool ReadFileBlocking(const std::string& filename, ASSET_FILE_BUFFER& buffer)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			return(false);
+		}
+
+		std::streamoff size = file.tellg();
+		if (size < 0)
+		{
+			return(false);
+		}
+
+		buffer.data = AllocateAligned((size_t)size);
+		if (NULL == buffer.data)
+		{
+			return(false);
+		}
+		buffer.size = (size_t)size;
+
+		file.seekg(0, std::ios::beg);
+		if (!file.read((char*)buffer.data, size))
+		{
+			FreeAligned(buffer.data);
+			buffer.data = NULL;
+			buffer.size = 0;
+			return(false);
+		}
+
+		buffer.bLoaded = true;
+		return(true);
+	}
+
+#ifdef ASSET_FILE_READER_URING
+	/***********************************************************
+	 *  GetRequest()
+	 *
+	 *  This function is used to get a free request from the
+	 *  ring, submitting the queued ones to make room when it is
+	 *  full.  Returns NULL when there is still no room.
+	 ***********************************************************/
+	struct io_uring_sqe* GetRequest(struct io_uring& ring)
+	{
+		struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+		if (NULL == sqe)
+		{
+			io_uring_submit(&ring);
+			sqe = io_uring_get_sqe(&ring);
+		}
+		return(sqe);
+	}
+
+	/***********************************************************
+	 *  WaitCompletion()
+	 *
+	 *  This function is used to wait for the next completed
+	 *  request, trying the wait again when it is interrupted or
+	 *  the ring is busy.  Returns NULL when the wait keeps
+	 *  failing, and requests still in flight then have to be
+	 *  left to the kernel.
+	 ***********************************************************/
+	struct io_uring_cqe* WaitCompletion(struct io_uring& ring)
+	{
+		struct io_uring_cqe* cqe = NULL;
+		int attempts = 0;
+		int result = io_uring_wait_cqe(&ring, &cqe);
+		while ((result < 0) && (attempts < WAIT_ATTEMPTS))
+		{
+			if (result != -EINTR)
+			{
+				if ((result != -EAGAIN) && (result != -EBUSY) && (result != -ETIME))
+				{
+					break;
+				}
+				attempts++;
+			}
+			result = io_uring_wait_cqe(&ring, &cqe);
+		}
+		return((result < 0) ? NULL : cqe);
+	}
+
+	/***********************************************************
+	 *  FinishRead()
+	 *
+	 *  This function is used to read the rest of a file that a
+	 *  batched read left short or failed on, with blocking
+	 *  reads and without direct I/O.
+	 ***********************************************************/
+	bool FinishRead(int fd, ASSET_FILE_BUFFER& buffer, size_t offset)
+	{
+		int flags = fcntl(fd, F_GETFL);
+		if ((flags >= 0) && ((flags & O_DIRECT) != 0))
+		{
+			fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+		}
+
+		while (offset < buffer.size)
+		{
+			ssize_t bytesRead = pread(fd, buffer.data + offset, buffer.size - offset, (off_t)offset);
+			if (bytesRead < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return(false);
+			}
+			if (bytesRead == 0)
+			{
+				// the file shrank since it was sized
+				buffer.size = offset;
+				break;
+			}
+			offset += (size_t)bytesRead;
+		}
+
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ReadFilesBatched()
+	 *
+	 *  This function is used to read the files of a list with
+	 *  io_uring.  Each submission opens and sizes its files in
+	 *  one batch, then reads all of them in a second - with
+	 *  direct I/O when the file system takes it, so the bytes
+	 *  go straight into the aligned buffers.  Returns false
+	 *  when io_uring cannot be set up, before anything is read.
+	 *
+	 *  When waiting on the ring fails for good, the files still
+	 *  in flight keep their buffers and descriptors, since the
+	 *  kernel may still write to them, and the rest of the list
+	 *  is read with blocking reads.
+	 ***********************************************************/
+	bool ReadFilesBatched(
+		const std::vector<std::string>& filenames,
+		std::vector<ASSET_FILE_BUFFER>& buffers)
+	{
+		struct io_uring ring;
+		if (io_uring_queue_init(QUEUE_DEPTH, &ring, 0) < 0)
+		{
+			return(false);
+		}
+
+		std::vector<int> fds;
+		std::vector<struct statx> sizes;
+		std::vector<int> sizeResults;
+		std::vector<bool> inFlight;
+		bool bRingFailed = false;
+		for (size_t first = 0; first < filenames.size(); first += FILES_PER_SUBMISSION)
+		{
+			if (true == bRingFailed)
+			{
+				for (size_t i = first; i < filenames.size(); i++)
+				{
+					if (false == filenames[i].empty())
+					{
+						ReadFileBlocking(filenames[i], buffers[i]);
+					}
+				}
+				break;
+			}
+
+			size_t count = filenames.size() - first;
+			if (count > FILES_PER_SUBMISSION)
+			{
+				count = FILES_PER_SUBMISSION;
+			}
+			fds.assign(count, -1);
+			sizes.resize(count);
+			sizeResults.assign(count, -1);
+			inFlight.assign(count, false);
+
+			// open and size every file of the submission - the user
+			// data is the file number times two, plus one for sizes.
+			// A file the ring has no room for is opened here, and
+			// sized after it is open
+			unsigned int requests = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				const std::string& filename = filenames[first + i];
+				if (filename.empty())
+				{
+					continue;
+				}
+
+				struct io_uring_sqe* sqe = GetRequest(ring);
+				if (NULL == sqe)
+				{
+					fds[i] = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+					continue;
+				}
+				io_uring_prep_openat(sqe, AT_FDCWD, filename.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC, 0);
+				sqe->user_data = i * 2;
+				inFlight[i] = true;
+				requests++;
+
+				sqe = GetRequest(ring);
+				if (NULL != sqe)
+				{
+					io_uring_prep_statx(sqe, AT_FDCWD, filename.c_str(), 0, STATX_SIZE, &sizes[i]);
+					sqe->user_data = i * 2 + 1;
+					requests++;
+				}
+			}
+
+			io_uring_submit(&ring);
+			for (unsigned int n = 0; n < requests; n++)
+			{
+				struct io_uring_cqe* cqe = WaitCompletion(ring);
+				if (NULL == cqe)
+				{
+					bRingFailed = true;
+					break;
+				}
+				size_t i = (size_t)(cqe->user_data / 2);
+				if ((cqe->user_data & 1) != 0)
+				{
+					sizeResults[i] = cqe->res;
+				}
+				else
+				{
+					fds[i] = cqe->res;
+					inFlight[i] = false;
+				}
+				io_uring_cqe_seen(&ring, cqe);
+			}
+
+			// once the ring has failed, a size request may still be
+			// writing into the sizes, so they are left allocated, and
+			// the files of the submission are read the slow way
+			if (true == bRingFailed)
+			{
+				new std::vector<struct statx>(std::move(sizes));
+				for (size_t i = 0; i < count; i++)
+				{
+					if ((false == inFlight[i]) && (fds[i] >= 0))
+					{
+						close(fds[i]);
+					}
+					if (false == filenames[first + i].empty())
+					{
+						ReadFileBlocking(filenames[first + i], buffers[first + i]);
+					}
+				}
+				io_uring_queue_exit(&ring);
+				continue;
+			}
+
+			// read every file that opened into an aligned buffer
+			requests = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				const std::string& filename = filenames[first + i];
+				if (filename.empty())
+				{
+					continue;
+				}
+
+				// file systems without direct I/O refuse the open, so
+				// the file is opened again for buffered reads
+				if (fds[i] == -EINVAL)
+				{
+					fds[i] = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+				}
+				if (fds[i] < 0)
+				{
+					fds[i] = -1;
+					continue;
+				}
+
+				ASSET_FILE_BUFFER& buffer = buffers[first + i];
+				if (sizeResults[i] == 0)
+				{
+					buffer.size = (size_t)sizes[i].stx_size;
+				}
+				else
+				{
+					struct stat fileStat;
+					if (fstat(fds[i], &fileStat) != 0)
+					{
+						continue;
+					}
+					buffer.size = (size_t)fileStat.st_size;
+				}
+
+				buffer.data = AllocateAligned(buffer.size);
+				if (NULL == buffer.data)
+				{
+					buffer.size = 0;
+					continue;
+				}
+
+				// a direct read has to cover whole aligned blocks, and
+				// stops short at the end of the file
+				size_t readSize = (buffer.size + AssetFileReader::ALIGNMENT - 1) & ~(AssetFileReader::ALIGNMENT - 1);
+				struct io_uring_sqe* sqe = GetRequest(ring);
+				if (NULL == sqe)
+				{
+					if (true == FinishRead(fds[i], buffer, 0))
+					{
+						buffer.bLoaded = true;
+					}
+					continue;
+				}
+				io_uring_prep_read(sqe, fds[i], buffer.data, (unsigned int)readSize, 0);
+				sqe->user_data = i;
+				inFlight[i] = true;
+				requests++;
+			}
+
+			io_uring_submit(&ring);
+			for (unsigned int n = 0; n < requests; n++)
+			{
+				struct io_uring_cqe* cqe = WaitCompletion(ring);
+				if (NULL == cqe)
+				{
+					bRingFailed = true;
+					break;
+				}
+				size_t i = (size_t)cqe->user_data;
+				ASSET_FILE_BUFFER& buffer = buffers[first + i];
+				size_t bytesRead = (cqe->res > 0) ? (size_t)cqe->res : 0;
+				inFlight[i] = false;
+				io_uring_cqe_seen(&ring, cqe);
+
+				// a failed or short read is finished the slow way
+				if ((bytesRead >= buffer.size) || (true == FinishRead(fds[i], buffer, bytesRead)))
+				{
+					buffer.bLoaded = true;
+				}
+			}
+
+			// a read still in flight keeps its buffer and descriptor,
+			// and the file is read again into a buffer of its own
+			for (size_t i = 0; i < count; i++)
+			{
+				ASSET_FILE_BUFFER& buffer = buffers[first + i];
+				if (true == inFlight[i])
+				{
+					buffer.data = NULL;
+					buffer.size = 0;
+					ReadFileBlocking(filenames[first + i], buffer);
+					continue;
+				}
+				if ((false == buffer.bLoaded) && (NULL != buffer.data))
+				{
+					AssetFileReader::FreeBuffer(buffer);
+				}
+				if (fds[i] >= 0)
+				{
+					close(fds[i]);
+				}
+			}
+
+			if (true == bRingFailed)
+			{
+				io_uring_queue_exit(&ring);
+			}
+		}
+
+		if (false == bRingFailed)
+		{
+			io_uring_queue_exit(&ring);
+		}
+		return(true);
+	}
+#endif
+}
+
+/***********************************************************
+ *  ReadFiles()
+ *
+ *  This method is used to read every file of the list into
+ *  a buffer of its own, as batches of io_uring requests when
+ *  they are available, or with a blocking read per file.
+ ***********************************************************/
+int AssetFileReader::ReadFiles(
+	const std::vector<std::string>& filenames,
+	std::vector<ASSET_FILE_BUFFER>& buffers)
+{
+	TRACE_SCOPE("ReadAssetFiles");
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	ASSET_FILE_BUFFER emptyBuffer = { NULL, 0, false };
+	buffers.assign(filenames.size(), emptyBuffer);
+
+	bool bBatched = false;
+#ifdef ASSET_FILE_READER_URING
+	bBatched = ReadFilesBatched(filenames, buffers);
+#endif
+	if (false == bBatched)
+	{
+		for (size_t i = 0; i < filenames.size(); i++)
+		{
+			if (false == filenames[i].empty())
+			{
+				ReadFileBlocking(filenames[i], buffers[i]);
+			}
+		}
+	}
+
+	int filesRead = 0;
+	size_t bytesRead = 0;
+	for (size_t i = 0; i < filenames.size(); i++)
+	{
+		if (true == buffers[i].bLoaded)
+		{
+			filesRead++;
+			bytesRead += buffers[i].size;
+		}
+		else if (false == filenames[i].empty())
+		{
+			std::cerr << "ERROR: could not read asset file:" << filenames[i] << std::endl;
+		}
+	}
+
+	double milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "INFO: read " << filesRead << " asset files, KB:" << (bytesRead / 1024)
+		<< (bBatched ? ", batched with io_uring" : ", with blocking reads")
+		<< ", ms:" << milliseconds << std::endl;
+
+	return(filesRead);
+}
+
+/***********************************************************
+ *  FreeBuffer()
+ *
+ *  This method is used to free the bytes of a buffer read
+ *  by ReadFiles().
+ ***********************************************************/
+void AssetFileReader::FreeBuffer(ASSET_FILE_BUFFER& buffer)
+{
+	if (NULL != buffer.data)
+	{
+		FreeAligned(buffer.data);
+	}
+	buffer.data = NULL;
+	buffer.size = 0;
+	buffer.bLoaded = false;
+}
@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetfilereader.h
+// ============
+// batched asset file reads - reads a list of asset files into memory in one
+// batch of io_uring requests where the build and kernel support it
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// the bytes of one asset file read into memory - the buffer is
+// aligned for direct I/O and freed with FreeBuffer()
+struct ASSET_FILE_BUFFER
+{
+	unsigned char* data;
+	size_t size;
+	bool bLoaded;
+};
+
+/***********************************************************
+ *  AssetFileReader
+ *
+ *  This class reads whole asset files into memory, so they
+ *  can be decoded from memory on any thread.  On Linux builds
+ *  that define ASSET_IO_URING, the files of a list are opened,
+ *  sized and read as batches of io_uring requests, with
+ *  direct I/O into aligned buffers where the file system
+ *  allows it - a few submissions in place of an open, a read
+ *  and a close per file.  Elsewhere, or when the kernel has
+ *  no io_uring, each file is read with blocking reads.
+ ***********************************************************/
+class AssetFileReader
+{
+public:
+	// buffers are aligned to this, and direct reads are rounded
+	// up to it
+	static const size_t ALIGNMENT = 4096;
+
+	// read every file of the list - the buffers line up with the
+	// filenames, and an empty filename or a file that cannot be
+	// read leaves its buffer unloaded.  Returns the number of
+	// files read.
+	static int ReadFiles(
+		const std::vector<std::string>& filenames,
+		std::vector<ASSET_FILE_BUFFER>& buffers);
+	// free the bytes of a buffer read by ReadFiles()
+	static void FreeBuffer(ASSET_FILE_BUFFER& buffer);
+};
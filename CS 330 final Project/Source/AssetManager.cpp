@@ -0,0 +1,556 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetmanager.cpp
+// ============
+// asynchronous asset loading - textures are requested without waiting, drawn
+// with a placeholder, and loaded on a thread with its own shared OpenGL context
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetManager.h"
+#include "AssetPack.h"
+#include "HitchDetector.h"
+#include "TraceRecorder.h"
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+/***********************************************************
+ *  BuildMipLevels()
+ *
+ *  This function builds the mipmap chain of an image on the
+ *  CPU, largest level first, down to 1x1.  Each texel of a
+ *  level is the average of the 2x2 texels above it - at an
+ *  odd edge, the last row or column is used twice.
+ ***********************************************************/
+void BuildMipLevels(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	int colorChannels,
+	std::vector<std::vector<unsigned char> >& levels)
+{
+	levels.clear();
+	levels.push_back(std::vector<unsigned char>(pixels, pixels + (size_t)width * height * colorChannels));
+
+	while ((width > 1) || (height > 1))
+	{
+		int levelWidth = std::max(1, width / 2);
+		int levelHeight = std::max(1, height / 2);
+		std::vector<unsigned char> level((size_t)levelWidth * levelHeight * colorChannels);
+		const unsigned char* above = levels.back().data();
+		size_t aboveStride = (size_t)width * colorChannels;
+
+		for (int y = 0; y < levelHeight; y++)
+		{
+			const unsigned char* row0 = above + aboveStride * std::min(y * 2, height - 1);
+			const unsigned char* row1 = above + aboveStride * std::min(y * 2 + 1, height - 1);
+			unsigned char* out = level.data() + (size_t)y * levelWidth * colorChannels;
+			for (int x = 0; x < levelWidth; x++)
+			{
+				int x0 = std::min(x * 2, width - 1) * colorChannels;
+				int x1 = std::min(x * 2 + 1, width - 1) * colorChannels;
+				for (int c = 0; c < colorChannels; c++)
+				{
+					*out++ = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+			}
+		}
+
+		levels.push_back(std::move(level));
+		width = levelWidth;
+		height = levelHeight;
+	}
+}
+
+/***********************************************************
+ *  AssetManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetManager::AssetManager(SceneManager* pSceneManager, FrameScheduler* pFrameScheduler, size_t mipUploadBytesPerFrame)
+{
+	m_pSceneManager = pSceneManager;
+	m_pFrameScheduler = pFrameScheduler;
+	m_pLoaderWindow = NULL;
+	m_bShutdown = false;
+	m_outstandingRequests = 0;
+	m_mipUploadBytesPerFrame = mipUploadBytesPerFrame;
+	m_requestCount = 0;
+	m_failedCount = 0;
+	m_lastSwapMs = 0.0;
+	m_streamedLevels = 0;
+	m_maxMipUploadMs = 0.0;
+}
+
+/***********************************************************
+ *  ~AssetManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AssetManager::~AssetManager()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		m_bShutdown = true;
+	}
+	m_loaderReady.notify_all();
+	if (m_loader.joinable())
+	{
+		m_loader.join();
+	}
+
+	// the textures are shared with the main context, so the ones
+	// never swapped in are freed here with their handles
+	for (LOADED_TEXTURE& loaded : m_loadedTextures)
+	{
+		if (NULL != loaded.fence)
+		{
+			glDeleteSync((GLsync)loaded.fence);
+		}
+	}
+	for (LOADED_TEXTURE& loaded : m_pendingTextures)
+	{
+		if (NULL != loaded.fence)
+		{
+			glDeleteSync((GLsync)loaded.fence);
+		}
+	}
+	m_loadedTextures.clear();
+	m_pendingTextures.clear();
+
+	if (NULL != m_pLoaderWindow)
+	{
+		glfwDestroyWindow(m_pLoaderWindow);
+		m_pLoaderWindow = NULL;
+	}
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to create a hidden window whose
+ *  context shares its objects with the main window, and to
+ *  start the loader thread on that context.  It must be
+ *  called on the main thread.
+ ***********************************************************/
+bool AssetManager::Start(GLFWwindow* pMainWindow)
+{
+	// the context version hints of the main window still apply
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	m_pLoaderWindow = glfwCreateWindow(1, 1, "asset loader", NULL, pMainWindow);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	if (NULL == m_pLoaderWindow)
+	{
+		std::cout << "ERROR: could not create the shared context for asset loading" << std::endl;
+		return(false);
+	}
+
+	m_loader = std::thread(&AssetManager::LoaderLoop, this);
+	return(true);
+}
+
+/***********************************************************
+ *  RequestTexture()
+ *
+ *  This method is used to request a texture.  The texture
+ *  slot is given a placeholder straight away, and the image
+ *  is handed to the loader thread.
+ ***********************************************************/
+int AssetManager::RequestTexture(const std::string& filename, const std::string& tag)
+{
+	int slot = m_pSceneManager->CreatePlaceholderTexture(tag, filename);
+	if (slot < 0)
+	{
+		return(-1);
+	}
+
+	if (0 == m_requestCount)
+	{
+		m_firstRequestTime = std::chrono::steady_clock::now();
+	}
+	m_requestCount++;
+	m_outstandingRequests++;
+
+	TEXTURE_REQUEST request;
+	request.slot = slot;
+	request.filename = filename;
+	request.tag = tag;
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		m_requests.push_back(request);
+	}
+	m_loaderReady.notify_one();
+
+	return(slot);
+}
+
+/***********************************************************
+ *  LoaderLoop()
+ *
+ *  This method is the loop of the loader thread - it loads
+ *  the requested textures in turn, and wakes the main loop
+ *  for each one so it is swapped in without waiting for
+ *  input.
+ ***********************************************************/
+void AssetManager::LoaderLoop()
+{
+	TraceRecorder::SetThreadName("asset loader");
+	glfwMakeContextCurrent(m_pLoaderWindow);
+	// rows of RGB images are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	while (true)
+	{
+		TEXTURE_REQUEST request;
+		{
+			std::unique_lock<std::mutex> lock(m_loaderMutex);
+			m_loaderReady.wait(lock, [this]() { return(m_bShutdown || (false == m_requests.empty())); });
+			if (true == m_bShutdown)
+			{
+				break;
+			}
+			request = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		// a failed load is still handed back, without a texture, so
+		// the placeholder stays and the request is finished
+		LOADED_TEXTURE loaded;
+		loaded.slot = request.slot;
+		loaded.fence = NULL;
+		loaded.width = 0;
+		loaded.height = 0;
+		loaded.colorChannels = 0;
+		bool bLoaded = LoadTexture(request, loaded);
+		{
+			std::lock_guard<std::mutex> lock(m_loaderMutex);
+			m_failedCount += (true == bLoaded) ? 0 : 1;
+			m_loadedTextures.push_back(std::move(loaded));
+		}
+		if (NULL != m_pFrameScheduler)
+		{
+			m_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_ASSETS);
+		}
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+/***********************************************************
+ *  LoadTexture()
+ *
+ *  This method is used on the loader thread to decode an
+ *  image file and upload it, with its mipmaps, into a new
+ *  texture.  A fence is set behind the upload and flushed,
+ *  so the main thread can tell when the texture is complete
+ *  without waiting on it.
+ ***********************************************************/
+bool AssetManager::LoadTexture(const TEXTURE_REQUEST& request, LOADED_TEXTURE& loaded)
+{
+	TRACE_SCOPE("AssetManager::LoadTexture");
+	HitchActivity activity(HitchDetector::ACTIVITY_ASSET_LOAD, "AssetManager::LoadTexture");
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	unsigned char* pixels = AssetPack::LoadImagePixels(request.filename.c_str(), &width, &height, &colorChannels, 0);
+	if (NULL == pixels)
+	{
+		std::cout << "Could not load image:" << request.filename << std::endl;
+		return(false);
+	}
+	if ((colorChannels != 3) && (colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		AssetPack::FreeImagePixels(pixels);
+		return(false);
+	}
+
+	// with mip streaming the main thread does the uploads
+	if (m_mipUploadBytesPerFrame > 0)
+	{
+		loaded.width = width;
+		loaded.height = height;
+		loaded.colorChannels = colorChannels;
+		BuildMipLevels(pixels, width, height, colorChannels, loaded.mipLevels);
+		AssetPack::FreeImagePixels(pixels);
+		return(true);
+	}
+
+	loaded.texture.Create(request.tag, GPU_RESOURCE_SITE);
+	glBindTexture(GL_TEXTURE_2D, loaded.texture.Get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (colorChannels == 3)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	loaded.texture.SetByteSize(GpuResourceTracker::GetTextureBytes(width, height, colorChannels, true));
+	AssetPack::FreeImagePixels(pixels);
+
+	loaded.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	std::cout << "Successfully loaded image:" << request.filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to take the textures the loader
+ *  thread has finished and swap each one into its slot once
+ *  the fence behind its upload has signaled.  The fences are
+ *  only polled, never waited on, and another frame is asked
+ *  for while any are still pending.
+ ***********************************************************/
+void AssetManager::Update()
+{
+	if (0 == m_outstandingRequests)
+	{
+		return;
+	}
+
+	TRACE_SCOPE("AssetManager::Update");
+
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		for (LOADED_TEXTURE& loaded : m_loadedTextures)
+		{
+			if (false == loaded.mipLevels.empty())
+			{
+				StartMipStream(loaded);
+			}
+			else
+			{
+				m_pendingTextures.push_back(std::move(loaded));
+			}
+		}
+		m_loadedTextures.clear();
+	}
+	UploadMipLevels();
+
+	for (size_t i = 0; i < m_pendingTextures.size();)
+	{
+		LOADED_TEXTURE& loaded = m_pendingTextures[i];
+		if (NULL != loaded.fence)
+		{
+			GLenum status = glClientWaitSync((GLsync)loaded.fence, 0, 0);
+			if ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED))
+			{
+				i++;
+				continue;
+			}
+			glDeleteSync((GLsync)loaded.fence);
+			loaded.fence = NULL;
+		}
+
+		if (0 != loaded.texture.Get())
+		{
+			m_pSceneManager->SwapInTexture(loaded.slot, loaded.texture);
+			m_lastSwapMs = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - m_firstRequestTime).count();
+		}
+		m_outstandingRequests--;
+
+		m_pendingTextures[i] = std::move(m_pendingTextures.back());
+		m_pendingTextures.pop_back();
+	}
+
+	if (((false == m_pendingTextures.empty()) || (false == m_mipStreams.empty())) && (NULL != m_pFrameScheduler))
+	{
+		m_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_ASSETS);
+	}
+}
+
+/***********************************************************
+ *  StartMipStream()
+ *
+ *  This method is used to create the texture for a mipmap
+ *  chain built by the loader thread, with storage for every
+ *  level, and to queue its levels for uploading.  Nothing is
+ *  sampled from the texture until its smallest level is in.
+ ***********************************************************/
+void AssetManager::StartMipStream(LOADED_TEXTURE& loaded)
+{
+	MIP_STREAM stream;
+	stream.slot = loaded.slot;
+	stream.textureID = 0;
+	stream.width = loaded.width;
+	stream.height = loaded.height;
+	stream.colorChannels = loaded.colorChannels;
+	stream.mipLevels = std::move(loaded.mipLevels);
+	stream.nextLevel = (int)stream.mipLevels.size() - 1;
+	stream.uploadedRows = 0;
+
+	GLenum format = (stream.colorChannels == 4) ? GL_RGBA : GL_RGB;
+	GLint internalFormat = (stream.colorChannels == 4) ? GL_RGBA8 : GL_RGB8;
+
+	glActiveTexture(GL_TEXTURE0 + SceneManager::SPARE_TEXTURE_UNIT);
+	stream.texture.Create("AssetManager mip stream", GPU_RESOURCE_SITE);
+	glBindTexture(GL_TEXTURE_2D, stream.texture.Get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	for (int level = 0; level < (int)stream.mipLevels.size(); level++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, internalFormat,
+			std::max(1, stream.width >> level), std::max(1, stream.height >> level), 0,
+			format, GL_UNSIGNED_BYTE, NULL);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, stream.nextLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, stream.nextLevel);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, (float)stream.nextLevel);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	stream.texture.SetByteSize(GpuResourceTracker::GetTextureBytes(
+		stream.width, stream.height, stream.colorChannels, true));
+
+	m_mipStreams.push_back(std::move(stream));
+}
+
+/***********************************************************
+ *  UploadMipLevels()
+ *
+ *  This method is used to upload the next rows of the mip
+ *  levels, always the smallest level still missing from any
+ *  texture first, until the bytes for this frame are spent.
+ *  As each level completes, the base level and the smallest
+ *  level of detail of its texture are lowered to it, and a
+ *  texture is swapped into its slot with its first level.
+ ***********************************************************/
+void AssetManager::UploadMipLevels()
+{
+	if (true == m_mipStreams.empty())
+	{
+		return;
+	}
+
+	TRACE_SCOPE("AssetManager::UploadMipLevels");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t budget = m_mipUploadBytesPerFrame;
+
+	glActiveTexture(GL_TEXTURE0 + SceneManager::SPARE_TEXTURE_UNIT);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while ((budget > 0) && (false == m_mipStreams.empty()))
+	{
+		// the stream missing the smallest level
+		size_t next = 0;
+		for (size_t i = 1; i < m_mipStreams.size(); i++)
+		{
+			if (m_mipStreams[i].nextLevel > m_mipStreams[next].nextLevel)
+			{
+				next = i;
+			}
+		}
+		MIP_STREAM& stream = m_mipStreams[next];
+
+		// a texture swapped in may since have been replaced, such as
+		// by a scene reload, and is then dropped
+		if ((0 != stream.textureID) && (m_pSceneManager->GetSlotTexture(stream.slot) != stream.textureID))
+		{
+			m_outstandingRequests--;
+			m_mipStreams[next] = std::move(m_mipStreams.back());
+			m_mipStreams.pop_back();
+			continue;
+		}
+
+		int level = stream.nextLevel;
+		int levelWidth = std::max(1, stream.width >> level);
+		int levelHeight = std::max(1, stream.height >> level);
+		size_t rowBytes = (size_t)levelWidth * stream.colorChannels;
+		int rows = std::min(levelHeight - stream.uploadedRows, std::max(1, (int)(budget / rowBytes)));
+
+		uint32_t textureID = (0 != stream.textureID) ? stream.textureID : stream.texture.Get();
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, stream.uploadedRows, levelWidth, rows,
+			(stream.colorChannels == 4) ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE,
+			stream.mipLevels[level].data() + rowBytes * stream.uploadedRows);
+		stream.uploadedRows += rows;
+		budget -= std::min(budget, rows * rowBytes);
+		if (stream.uploadedRows < levelHeight)
+		{
+			continue;
+		}
+
+		// the level is complete, so sampling may now start from it
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, (float)level);
+		std::vector<unsigned char>().swap(stream.mipLevels[level]);
+		m_streamedLevels++;
+		stream.nextLevel--;
+		stream.uploadedRows = 0;
+
+		bool bFinished = (stream.nextLevel < 0);
+		if (0 == stream.textureID)
+		{
+			stream.textureID = stream.texture.Get();
+			if (m_pSceneManager->SwapInTexture(stream.slot, stream.texture) == false)
+			{
+				bFinished = true;
+			}
+			// the slot units are bound by the swap
+			glActiveTexture(GL_TEXTURE0 + SceneManager::SPARE_TEXTURE_UNIT);
+		}
+		if (true == bFinished)
+		{
+			m_lastSwapMs = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - m_firstRequestTime).count();
+			m_outstandingRequests--;
+			m_mipStreams[next] = std::move(m_mipStreams.back());
+			m_mipStreams.pop_back();
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glActiveTexture(GL_TEXTURE0);
+
+	double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_maxMipUploadMs = (uploadMs > m_maxMipUploadMs) ? uploadMs : m_maxMipUploadMs;
+}
+
+/***********************************************************
+ *  IsIdle()
+ *
+ *  This method returns true once every requested texture has
+ *  been swapped in, or has failed to load.
+ ***********************************************************/
+bool AssetManager::IsIdle() const
+{
+	return(0 == m_outstandingRequests);
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print how many textures were
+ *  loaded and how long after the first request the last one
+ *  was swapped in.
+ ***********************************************************/
+void AssetManager::PrintReport() const
+{
+	int failedCount = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		failedCount = m_failedCount;
+	}
+
+	std::cout << "ASSETS: textures:" << m_requestCount
+		<< ", failed:" << failedCount
+		<< ", still loading:" << m_outstandingRequests
+		<< ", last swapped in ms:" << m_lastSwapMs;
+	if (m_mipUploadBytesPerFrame > 0)
+	{
+		std::cout << ", mip levels streamed:" << m_streamedLevels
+			<< ", max mip upload ms:" << m_maxMipUploadMs;
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetmanager.h
+// ============
+// asynchronous asset loading - textures are requested without waiting, drawn
+// with a placeholder, and loaded on a thread with its own shared OpenGL context
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "FrameScheduler.h"
+#include "GpuResourceTracker.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct GLFWwindow;
+
+/***********************************************************
+ *  BuildMipLevels()
+ *
+ *  This function builds the mipmap chain of an image on the
+ *  CPU, largest level first, down to 1x1.
+ ***********************************************************/
+void BuildMipLevels(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	int colorChannels,
+	std::vector<std::vector<unsigned char> >& levels);
+
+/***********************************************************
+ *  AssetManager
+ *
+ *  This class loads textures without holding up the frames.
+ *  A request puts a 1x1 placeholder into a texture slot of
+ *  the scene and returns the slot straight away.  The loader
+ *  thread, which has an OpenGL context shared with the main
+ *  window, decodes the image, uploads it into a new texture
+ *  and sets a fence behind the upload.  Once the fence has
+ *  signaled, the main thread swaps the finished texture into
+ *  the slot, so the scene fills in texture by texture.
+ *
+ *  With mip streaming on, the loader thread builds the whole
+ *  mipmap chain on the CPU instead, and the main thread
+ *  uploads it within a budget of bytes per frame, smallest
+ *  levels first across all of the textures.  A texture is
+ *  swapped in as soon as its smallest level is in, and its
+ *  base level is lowered as each larger level arrives, so no
+ *  frame takes the upload of a whole large texture.
+ ***********************************************************/
+class AssetManager
+{
+public:
+	// constructor
+	// mipUploadBytesPerFrame turns on mip streaming, 0 uploads
+	// every texture whole on the loader thread
+	AssetManager(SceneManager* pSceneManager, FrameScheduler* pFrameScheduler, size_t mipUploadBytesPerFrame = 0);
+	// destructor
+	~AssetManager();
+
+	// create the shared context and start the loader thread -
+	// must be called on the main thread with its context current
+	bool Start(GLFWwindow* pMainWindow);
+
+	// request a texture under a tag - returns the texture slot,
+	// which holds the placeholder until the texture is loaded,
+	// or -1 when no slot is free
+	int RequestTexture(const std::string& filename, const std::string& tag);
+
+	// swap in the textures whose uploads have finished - called
+	// once a frame on the main thread
+	void Update();
+
+	// true once every requested texture has been swapped in
+	bool IsIdle() const;
+
+	// print the loading totals
+	void PrintReport() const;
+
+private:
+	struct TEXTURE_REQUEST
+	{
+		int slot;
+		std::string filename;
+		std::string tag;
+	};
+
+	// a texture uploaded by the loader thread, waiting for the
+	// fence behind its upload - or with mip streaming, the mipmap
+	// chain built by the loader thread, largest level first
+	struct LOADED_TEXTURE
+	{
+		int slot;
+		GLTextureHandle texture;
+		void* fence;
+		int width;
+		int height;
+		int colorChannels;
+		std::vector<std::vector<unsigned char> > mipLevels;
+	};
+
+	// a texture being uploaded a level at a time, from the
+	// smallest level up
+	struct MIP_STREAM
+	{
+		int slot;
+		GLTextureHandle texture;
+		// the texture, kept once the handle is swapped into the slot
+		uint32_t textureID;
+		int width;
+		int height;
+		int colorChannels;
+		std::vector<std::vector<unsigned char> > mipLevels;
+		// the level being uploaded and the rows of it that are in
+		int nextLevel;
+		int uploadedRows;
+	};
+
+	SceneManager* m_pSceneManager;
+	FrameScheduler* m_pFrameScheduler;
+	// hidden window owning the context of the loader thread
+	GLFWwindow* m_pLoaderWindow;
+
+	// the loader thread and its queues
+	std::thread m_loader;
+	mutable std::mutex m_loaderMutex;
+	std::condition_variable m_loaderReady;
+	std::deque<TEXTURE_REQUEST> m_requests;
+	std::vector<LOADED_TEXTURE> m_loadedTextures;
+	bool m_bShutdown;
+
+	// textures taken from the loader thread, waiting to be swapped
+	// in on the main thread
+	std::vector<LOADED_TEXTURE> m_pendingTextures;
+	int m_outstandingRequests;
+	// the textures still streaming their mip levels
+	size_t m_mipUploadBytesPerFrame;
+	std::vector<MIP_STREAM> m_mipStreams;
+
+	// loading totals - failures are counted by the loader thread
+	int m_requestCount;
+	int m_failedCount;
+	std::chrono::steady_clock::time_point m_firstRequestTime;
+	double m_lastSwapMs;
+	int m_streamedLevels;
+	double m_maxMipUploadMs;
+
+	// the loop of the loader thread
+	void LoaderLoop();
+	// decode and upload one texture on the loader thread
+	bool LoadTexture(const TEXTURE_REQUEST& request, LOADED_TEXTURE& loaded);
+	// upload the next mip levels within the budget of this frame
+	void UploadMipLevels();
+	// start streaming a texture whose mip levels have been built
+	void StartMipStream(LOADED_TEXTURE& loaded);
+};
@@ -0,0 +1,426 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpack.cpp
+// ============
+// single file asset pack - the assets of the application in one indexed,
+// aligned file that is memory mapped, with the images stored ready to upload
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetPack.h"
+#include "TraceRecorder.h"
+
+#include "stb_image.h"
+
+#ifdef ASSET_PACK_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the pack the loaders read from
+	AssetPack* g_pMountedPack = NULL;
+
+	const char ASSET_PACK_MAGIC[4] = { 'C', 'S', 'P', 'K' };
+}
+
+/***********************************************************
+ *  AssetPack()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetPack::AssetPack()
+{
+	m_pData = NULL;
+	m_size = 0;
+	m_pEntries = NULL;
+	m_entryCount = 0;
+}
+
+/***********************************************************
+ *  ~AssetPack()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AssetPack::~AssetPack()
+{
+	if (g_pMountedPack == this)
+	{
+		g_pMountedPack = NULL;
+	}
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to map a pack file into memory and
+ *  check its header and index.  The operating system is
+ *  asked to start reading the whole file ahead, so the pages
+ *  are on their way before the first image is uploaded.
+ ***********************************************************/
+bool AssetPack::Open(const char* filename)
+{
+	TRACE_SCOPE("AssetPack::Open");
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "ERROR: could not open asset pack:" << filename << std::endl;
+		return(false);
+	}
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = NULL;
+	if ((GetFileSizeEx(file, &fileSize) != FALSE) && (fileSize.QuadPart > 0))
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	// the view keeps the file mapped once the handles are closed
+	if (NULL != mapping)
+	{
+		m_pData = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		m_size = (size_t)fileSize.QuadPart;
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+#else
+	int file = open(filename, O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		std::cout << "ERROR: could not open asset pack:" << filename << std::endl;
+		return(false);
+	}
+	struct stat fileState;
+	if ((fstat(file, &fileState) == 0) && (fileState.st_size > 0))
+	{
+		void* pMapped = mmap(NULL, (size_t)fileState.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (pMapped != MAP_FAILED)
+		{
+			m_pData = (const unsigned char*)pMapped;
+			m_size = (size_t)fileState.st_size;
+			posix_madvise(pMapped, m_size, POSIX_MADV_WILLNEED);
+		}
+	}
+	// the mapping keeps the file open once it is closed
+	close(file);
+#endif
+
+	if (NULL == m_pData)
+	{
+		m_size = 0;
+		std::cout << "ERROR: could not map asset pack:" << filename << std::endl;
+		return(false);
+	}
+
+	// check the header and that the index and names are inside
+	// the file
+	const ASSET_PACK_HEADER* pHeader = (const ASSET_PACK_HEADER*)m_pData;
+	bool bValid = (m_size >= sizeof(ASSET_PACK_HEADER)) &&
+		(memcmp(pHeader->magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) == 0) &&
+		(pHeader->version == VERSION) &&
+		(pHeader->indexOffset % sizeof(uint64_t) == 0) &&
+		(pHeader->indexOffset <= m_size) &&
+		(pHeader->entryCount <= (m_size - pHeader->indexOffset) / sizeof(ASSET_PACK_ENTRY)) &&
+		(pHeader->namesOffset <= m_size) &&
+		(pHeader->namesSize <= m_size - pHeader->namesOffset);
+	if (true == bValid)
+	{
+		m_pEntries = (const ASSET_PACK_ENTRY*)(m_pData + pHeader->indexOffset);
+		m_entryCount = pHeader->entryCount;
+		const char* pNames = (const char*)(m_pData + pHeader->namesOffset);
+		for (size_t i = 0; (true == bValid) && (i < m_entryCount); i++)
+		{
+			const ASSET_PACK_ENTRY& entry = m_pEntries[i];
+			bValid = (entry.nameOffset <= pHeader->namesSize) &&
+				(entry.nameLength <= pHeader->namesSize - entry.nameOffset) &&
+				(entry.offset <= m_size) &&
+				(entry.storedSize <= m_size - entry.offset);
+			// an image has to hold the pixels its size calls for, with
+			// the channels the loaders can upload
+			if ((true == bValid) && (entry.type == ENTRY_IMAGE))
+			{
+				bValid = ((entry.colorChannels == 3) || (entry.colorChannels == 4)) &&
+					(entry.width > 0) &&
+					(entry.height > 0) &&
+					(entry.size == (uint64_t)entry.width * entry.height * entry.colorChannels);
+			}
+			if (true == bValid)
+			{
+				m_index[std::string(pNames + entry.nameOffset, entry.nameLength)] = i;
+			}
+		}
+	}
+	if (false == bValid)
+	{
+		std::cout << "ERROR: not a valid asset pack:" << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	std::cout << "INFO: mapped asset pack:" << filename << ", entries:" << m_entryCount
+		<< ", MB:" << (m_size / (1024.0 * 1024.0)) << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the pack file and free any
+ *  expanded buffers.
+ ***********************************************************/
+void AssetPack::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_expandedMutex);
+		m_expanded.clear();
+	}
+	m_index.clear();
+	m_pEntries = NULL;
+	m_entryCount = 0;
+
+	if (NULL != m_pData)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+#else
+		munmap((void*)m_pData, m_size);
+#endif
+		m_pData = NULL;
+		m_size = 0;
+	}
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method returns the entry packed from the passed in
+ *  file path, or NULL when the pack does not hold it.
+ ***********************************************************/
+const ASSET_PACK_ENTRY* AssetPack::Find(const std::string& filename) const
+{
+	std::unordered_map<std::string, size_t>::const_iterator found = m_index.find(filename);
+	if (found == m_index.end())
+	{
+		return(NULL);
+	}
+	return(&m_pEntries[found->second]);
+}
+
+/***********************************************************
+ *  Acquire()
+ *
+ *  This method returns the bytes of an entry.  An entry that
+ *  is stored as it is comes straight from the mapped file;
+ *  a compressed one is expanded into a buffer that is kept
+ *  until it is released.
+ ***********************************************************/
+const unsigned char* AssetPack::Acquire(const ASSET_PACK_ENTRY& entry)
+{
+	if (entry.compression == COMPRESSION_NONE)
+	{
+		return((entry.storedSize == entry.size) ? m_pData + entry.offset : NULL);
+	}
+
+#ifdef ASSET_PACK_ZSTD
+	if (entry.compression == COMPRESSION_ZSTD)
+	{
+		TRACE_SCOPE("AssetPack::Expand");
+		std::vector<unsigned char> expanded((size_t)entry.size);
+		size_t expandedSize = ZSTD_decompress(expanded.data(), expanded.size(),
+			m_pData + entry.offset, (size_t)entry.storedSize);
+		if ((ZSTD_isError(expandedSize) != 0) || (expandedSize != entry.size))
+		{
+			return(NULL);
+		}
+
+		std::lock_guard<std::mutex> lock(m_expandedMutex);
+		const unsigned char* pData = expanded.data();
+		m_expanded[pData] = std::move(expanded);
+		return(pData);
+	}
+#endif
+
+	std::cout << "ERROR: asset pack entry is compressed in a way this build cannot expand" << std::endl;
+	return(NULL);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used to free the expanded buffer of an
+ *  entry.  Bytes in the mapped file are left alone.
+ ***********************************************************/
+void AssetPack::Release(const unsigned char* data)
+{
+	if ((data >= m_pData) && (data < m_pData + m_size))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_expandedMutex);
+	m_expanded.erase(data);
+}
+
+/***********************************************************
+ *  GetEntryCount()
+ *
+ *  This method returns the number of entries in the pack.
+ ***********************************************************/
+size_t AssetPack::GetEntryCount() const
+{
+	return(m_entryCount);
+}
+
+/***********************************************************
+ *  GetMappedBytes()
+ *
+ *  This method returns the size of the mapped pack file.
+ ***********************************************************/
+size_t AssetPack::GetMappedBytes() const
+{
+	return(m_size);
+}
+
+/***********************************************************
+ *  Mount()
+ *
+ *  This method is used to make a pack the one the loaders
+ *  read from, or to unmount it with NULL.
+ ***********************************************************/
+void AssetPack::Mount(AssetPack* pPack)
+{
+	g_pMountedPack = pPack;
+}
+
+/***********************************************************
+ *  GetMounted()
+ *
+ *  This method returns the mounted pack, or NULL.
+ ***********************************************************/
+AssetPack* AssetPack::GetMounted()
+{
+	return(g_pMountedPack);
+}
+
+/***********************************************************
+ *  LoadImagePixels()
+ *
+ *  This method is used to load an image in place of
+ *  stbi_load().  When the mounted pack holds the image with
+ *  the wanted channels, the pixels come from the pack;
+ *  otherwise the image file is decoded from disk.  The
+ *  pixels are freed with FreeImagePixels().
+ ***********************************************************/
+unsigned char* AssetPack::LoadImagePixels(
+	const char* filename,
+	int* width,
+	int* height,
+	int* colorChannels,
+	int desiredChannels)
+{
+	AssetPack* pPack = g_pMountedPack;
+	const ASSET_PACK_ENTRY* pEntry = (NULL != pPack) ? pPack->Find(filename) : NULL;
+	if ((NULL != pEntry) && (pEntry->type == ENTRY_IMAGE) &&
+		((desiredChannels == 0) || (desiredChannels == pEntry->colorChannels)))
+	{
+		const unsigned char* pixels = pPack->Acquire(*pEntry);
+		if (NULL != pixels)
+		{
+			*width = pEntry->width;
+			*height = pEntry->height;
+			*colorChannels = pEntry->colorChannels;
+			// the pixels are read only, as the pages are mapped
+			// from the file
+			return((unsigned char*)pixels);
+		}
+	}
+
+	return(stbi_load(filename, width, height, colorChannels, desiredChannels));
+}
+
+/***********************************************************
+ *  FreeImagePixels()
+ *
+ *  This method is used to free the pixels returned by
+ *  LoadImagePixels().
+ ***********************************************************/
+void AssetPack::FreeImagePixels(unsigned char* pixels)
+{
+	AssetPack* pPack = g_pMountedPack;
+	if (NULL != pPack)
+	{
+		if ((pixels >= pPack->m_pData) && (pixels < pPack->m_pData + pPack->m_size))
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(pPack->m_expandedMutex);
+		if (pPack->m_expanded.erase(pixels) > 0)
+		{
+			return;
+		}
+	}
+
+	stbi_image_free(pixels);
+}
+
+/***********************************************************
+ *  ReadTextFile()
+ *
+ *  This method is used to read a whole text file, from the
+ *  mounted pack when it holds the file, or from disk.
+ ***********************************************************/
+bool AssetPack::ReadTextFile(const char* filename, std::string& contents)
+{
+	AssetPack* pPack = g_pMountedPack;
+	const ASSET_PACK_ENTRY* pEntry = (NULL != pPack) ? pPack->Find(filename) : NULL;
+	if ((NULL != pEntry) && (pEntry->type == ENTRY_FILE))
+	{
+		const unsigned char* pData = pPack->Acquire(*pEntry);
+		if (NULL != pData)
+		{
+			contents.assign((const char*)pData, (size_t)pEntry->size);
+			pPack->Release(pData);
+			return(true);
+		}
+	}
+
+	return(ReadDiskTextFile(filename, contents));
+}
+
+/***********************************************************
+ *  ReadDiskTextFile()
+ *
+ *  This method is used to read a whole text file from disk,
+ *  for files that are edited while the program runs.
+ ***********************************************************/
+bool AssetPack::ReadDiskTextFile(const char* filename, std::string& contents)
+{
+	std::ifstream file(filename);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+	contents = text.str();
+	return(true);
+}
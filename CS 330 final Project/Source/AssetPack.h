@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpack.h
+// ============
+// single file asset pack - the assets of the application in one indexed,
+// aligned file that is memory mapped, with the images stored ready to upload
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// the start of an asset pack file.  The stored data of every entry
+// starts on a multiple of the alignment, followed by the index of
+// entries and then their names.  Numbers are little endian.
+struct ASSET_PACK_HEADER
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t alignment;
+	uint64_t indexOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+
+// one file of an asset pack, under the path it was packed from
+struct ASSET_PACK_ENTRY
+{
+	uint64_t nameOffset;
+	uint32_t nameLength;
+	uint32_t type;
+	uint64_t offset;
+	// bytes in the pack, and bytes once expanded
+	uint64_t storedSize;
+	uint64_t size;
+	uint32_t compression;
+	// the image of a texture entry
+	int32_t width;
+	int32_t height;
+	int32_t colorChannels;
+};
+
+/***********************************************************
+ *  AssetPack
+ *
+ *  This class maps an asset pack file into memory and finds
+ *  its files by the path they were packed from.  Images are
+ *  stored decoded and flipped the way stb_image loads them,
+ *  so an image that is stored as it is can be uploaded
+ *  straight from the mapped file, with no file reads, no
+ *  decoding and no copies.  Entries compressed with zstd are
+ *  expanded into a buffer of their own when they are used.
+ *
+ *  Once a pack is mounted, the loaders read the files it
+ *  holds from the pack and every other file from disk.
+ ***********************************************************/
+class AssetPack
+{
+public:
+	// the kinds of entries
+	enum ENTRY_TYPE
+	{
+		ENTRY_FILE = 0,
+		ENTRY_IMAGE
+	};
+
+	// how an entry is stored
+	enum COMPRESSION_TYPE
+	{
+		COMPRESSION_NONE = 0,
+		COMPRESSION_ZSTD
+	};
+
+	static const uint32_t VERSION = 1;
+	// the entries start on page boundaries, so each one maps and
+	// reads on its own pages
+	static const uint32_t ALIGNMENT = 4096;
+
+	// constructor
+	AssetPack();
+	// destructor
+	~AssetPack();
+
+	// map a pack file and read its index
+	bool Open(const char* filename);
+	// unmap the pack file
+	void Close();
+
+	// the entry packed from a file path, NULL when there is none
+	const ASSET_PACK_ENTRY* Find(const std::string& filename) const;
+	// the bytes of an entry - a pointer into the mapped file when
+	// it is stored as it is, or a buffer the pack keeps until the
+	// bytes are released; NULL when it cannot be expanded
+	const unsigned char* Acquire(const ASSET_PACK_ENTRY& entry);
+	// free an expanded buffer - bytes in the mapped file are left
+	void Release(const unsigned char* data);
+
+	size_t GetEntryCount() const;
+	size_t GetMappedBytes() const;
+
+	// the pack the loaders read from, NULL when none is mounted -
+	// mount before any loader starts, and unmount after they stop
+	static void Mount(AssetPack* pPack);
+	static AssetPack* GetMounted();
+
+	// load an image the way stbi_load() does, from the mounted
+	// pack when it holds the file, and free it again
+	static unsigned char* LoadImagePixels(
+		const char* filename,
+		int* width,
+		int* height,
+		int* colorChannels,
+		int desiredChannels);
+	static void FreeImagePixels(unsigned char* pixels);
+	// read a whole text file from the mounted pack when it holds
+	// the file, or from disk
+	static bool ReadTextFile(const char* filename, std::string& contents);
+	// read a whole text file from disk, even when the mounted
+	// pack holds it
+	static bool ReadDiskTextFile(const char* filename, std::string& contents);
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+	const ASSET_PACK_ENTRY* m_pEntries;
+	size_t m_entryCount;
+	// entry numbers by packed path
+	std::unordered_map<std::string, size_t> m_index;
+
+	// the expanded buffers of compressed entries, which may be
+	// used on loader threads
+	std::mutex m_expandedMutex;
+	std::map<const unsigned char*, std::vector<unsigned char> > m_expanded;
+};
@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpacker.cpp
+// ============
+// asset pack builder - writes the files listed in a manifest into one asset
+// pack file, with the images decoded ahead of time
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetPacker.h"
+#include "AssetPack.h"
+
+#include "stb_image.h"
+
+#ifdef ASSET_PACK_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the file extensions that are decoded into images
+	const char* const IMAGE_EXTENSIONS[] = { ".jpg", ".jpeg", ".png", ".bmp", ".tga" };
+
+	// zstd level for packs built for deployment - slower to build,
+	// as fast to expand
+	const int ZSTD_LEVEL = 19;
+
+	const double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+
+	/***********************************************************
+	 *  IsImageFile()
+	 *
+	 *  This function returns true when the file extension is
+	 *  one of the image extensions.
+	 ***********************************************************/
+	bool IsImageFile(const std::string& filename)
+	{
+		size_t dot = filename.rfind('.');
+		if (dot == std::string::npos)
+		{
+			return(false);
+		}
+
+		std::string extension = filename.substr(dot);
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](unsigned char c) { return((char)std::tolower(c)); });
+		for (const char* imageExtension : IMAGE_EXTENSIONS)
+		{
+			if (extension == imageExtension)
+			{
+				return(true);
+			}
+		}
+		return(false);
+	}
+
+	/***********************************************************
+	 *  ReadManifest()
+	 *
+	 *  This function is used to read the file paths of a
+	 *  manifest.  Blank lines and lines starting with # are
+	 *  skipped, and each path is listed once.
+	 ***********************************************************/
+	bool ReadManifest(const char* manifestFilename, std::vector<std::string>& filenames)
+	{
+		std::ifstream manifest(manifestFilename);
+		if (!manifest.is_open())
+		{
+			std::cout << "ERROR: could not open asset manifest:" << manifestFilename << std::endl;
+			return(false);
+		}
+
+		std::set<std::string> listed;
+		std::string line;
+		while (std::getline(manifest, line))
+		{
+			// the packed paths use forward slashes, as the loaders do
+			std::replace(line.begin(), line.end(), '\\', '/');
+			size_t first = line.find_first_not_of(" \t\r");
+			size_t last = line.find_last_not_of(" \t\r");
+			if ((first == std::string::npos) || (line[first] == '#'))
+			{
+				continue;
+			}
+			line = line.substr(first, last - first + 1);
+			if (listed.insert(line).second == true)
+			{
+				filenames.push_back(line);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  WritePadding()
+	 *
+	 *  This function is used to write zeros up to the next
+	 *  multiple of the alignment.
+	 ***********************************************************/
+	void WritePadding(std::ofstream& pack, uint64_t& offset, uint64_t alignment)
+	{
+		static const char zeros[AssetPack::ALIGNMENT] = { 0 };
+		uint64_t padding = (alignment - (offset % alignment)) % alignment;
+		pack.write(zeros, (std::streamsize)padding);
+		offset += padding;
+	}
+}
+
+/***********************************************************
+ *  BuildAssetPack()
+ *
+ *  This function is used to write the files of a manifest
+ *  into an asset pack.  Images are decoded and flipped the
+ *  way the scene loads them, so the pack holds the pixels
+ *  that are uploaded; other files are stored as they are.
+ *  Every entry starts on a page boundary.
+ ***********************************************************/
+bool BuildAssetPack(const char* manifestFilename, const char* packFilename, bool bCompress)
+{
+#ifndef ASSET_PACK_ZSTD
+	if (true == bCompress)
+	{
+		std::cout << "ERROR: this build has no zstd - define ASSET_PACK_ZSTD to compress asset packs" << std::endl;
+		return(false);
+	}
+#endif
+
+	std::vector<std::string> filenames;
+	if (ReadManifest(manifestFilename, filenames) == false)
+	{
+		return(false);
+	}
+
+	std::ofstream pack(packFilename, std::ios::binary | std::ios::trunc);
+	if (!pack.is_open())
+	{
+		std::cout << "ERROR: could not write asset pack:" << packFilename << std::endl;
+		return(false);
+	}
+
+	// the header is written again at the end, once it is known
+	ASSET_PACK_HEADER header;
+	memset(&header, 0, sizeof(header));
+	pack.write((const char*)&header, sizeof(header));
+	uint64_t offset = sizeof(header);
+
+	stbi_set_flip_vertically_on_load(true);
+
+	std::vector<ASSET_PACK_ENTRY> entries;
+	std::string names;
+	uint64_t totalBytes = 0;
+	for (const std::string& filename : filenames)
+	{
+		ASSET_PACK_ENTRY entry;
+		memset(&entry, 0, sizeof(entry));
+
+		std::string contents;
+		unsigned char* pixels = NULL;
+		const unsigned char* pData = NULL;
+		if (true == IsImageFile(filename))
+		{
+			pixels = stbi_load(filename.c_str(), &entry.width, &entry.height, &entry.colorChannels, 0);
+			if (NULL == pixels)
+			{
+				std::cout << "ERROR: could not decode image:" << filename << std::endl;
+				return(false);
+			}
+			if ((entry.colorChannels != 3) && (entry.colorChannels != 4))
+			{
+				std::cout << "ERROR: image does not have 3 or 4 channels:" << filename << std::endl;
+				stbi_image_free(pixels);
+				return(false);
+			}
+			entry.type = AssetPack::ENTRY_IMAGE;
+			entry.size = (uint64_t)entry.width * entry.height * entry.colorChannels;
+			pData = pixels;
+		}
+		else
+		{
+			if (AssetPack::ReadTextFile(filename.c_str(), contents) == false)
+			{
+				std::cout << "ERROR: could not read file:" << filename << std::endl;
+				return(false);
+			}
+			entry.type = AssetPack::ENTRY_FILE;
+			entry.size = contents.size();
+			pData = (const unsigned char*)contents.data();
+		}
+
+		entry.compression = AssetPack::COMPRESSION_NONE;
+		entry.storedSize = entry.size;
+#ifdef ASSET_PACK_ZSTD
+		std::vector<unsigned char> compressed;
+		if (true == bCompress)
+		{
+			compressed.resize(ZSTD_compressBound((size_t)entry.size));
+			size_t compressedSize = ZSTD_compress(compressed.data(), compressed.size(),
+				pData, (size_t)entry.size, ZSTD_LEVEL);
+			// an entry that does not shrink is stored as it is, so
+			// it can still be used straight from the mapped file
+			if ((ZSTD_isError(compressedSize) == 0) && (compressedSize < entry.size))
+			{
+				entry.compression = AssetPack::COMPRESSION_ZSTD;
+				entry.storedSize = compressedSize;
+				pData = compressed.data();
+			}
+		}
+#endif
+
+		WritePadding(pack, offset, AssetPack::ALIGNMENT);
+		entry.offset = offset;
+		pack.write((const char*)pData, (std::streamsize)entry.storedSize);
+		offset += entry.storedSize;
+		if (NULL != pixels)
+		{
+			stbi_image_free(pixels);
+		}
+
+		entry.nameOffset = names.size();
+		entry.nameLength = (uint32_t)filename.size();
+		names += filename;
+		entries.push_back(entry);
+		totalBytes += entry.size;
+	}
+
+	WritePadding(pack, offset, sizeof(uint64_t));
+	header.indexOffset = offset;
+	pack.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(ASSET_PACK_ENTRY)));
+	offset += entries.size() * sizeof(ASSET_PACK_ENTRY);
+	header.namesOffset = offset;
+	header.namesSize = names.size();
+	pack.write(names.data(), (std::streamsize)names.size());
+	offset += names.size();
+
+	memcpy(header.magic, "CSPK", sizeof(header.magic));
+	header.version = AssetPack::VERSION;
+	header.entryCount = (uint32_t)entries.size();
+	header.alignment = AssetPack::ALIGNMENT;
+	pack.seekp(0);
+	pack.write((const char*)&header, sizeof(header));
+	pack.close();
+	if (pack.fail())
+	{
+		std::cout << "ERROR: could not write asset pack:" << packFilename << std::endl;
+		return(false);
+	}
+
+	std::cout << "INFO: packed " << entries.size() << " files into " << packFilename
+		<< ", asset MB:" << (totalBytes / BYTES_PER_MEGABYTE)
+		<< ", pack MB:" << (offset / BYTES_PER_MEGABYTE) << std::endl;
+	return(true);
+}
@@ -0,0 +1,14 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpacker.h
+// ============
+// asset pack builder - writes the files listed in a manifest into one asset
+// pack file, with the images decoded ahead of time
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// build an asset pack from the files listed in a manifest, one
+// path per line - images are stored decoded, and with
+// bCompress every entry that shrinks is compressed with zstd,
+// which needs a build with ASSET_PACK_ZSTD
+bool BuildAssetPack(const char* manifestFilename, const char* packFilename, bool bCompress);
@@ -0,0 +1,307 @@
+///////////////////////////////////////////////////////////////////////////////
+// bakedscene.h
+// ============
+// compile-time baked scene for fixed installations - the scene layout is a
+// constexpr table, and the model matrices and state changes of every draw are
+// worked out by the compiler into read-only draw packets
+//
+// the baked scene is used in place of the hand written RenderScene() code
+// when BAKED_SCENE is defined for the build, such as for kiosk builds
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "ResourceTag.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BakedScene
+{
+	/***********************************************************
+	 *  Constexpr math
+	 *
+	 *  The standard sin() and cos() cannot be used at compile
+	 *  time, so these are evaluated as Taylor series after the
+	 *  angle is reduced to the range -pi to pi.
+	 ***********************************************************/
+	constexpr double PI = 3.14159265358979323846;
+
+	constexpr double ReduceAngle(double radians)
+	{
+		double turns = radians / (2.0 * PI);
+		radians -= 2.0 * PI * (double)(long long)turns;
+		if (radians > PI)
+		{
+			radians -= 2.0 * PI;
+		}
+		else if (radians < -PI)
+		{
+			radians += 2.0 * PI;
+		}
+		return(radians);
+	}
+
+	constexpr double Sin(double radians)
+	{
+		double x = ReduceAngle(radians);
+		double term = x;
+		double sum = x;
+		for (int n = 1; n < 12; n++)
+		{
+			term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+			sum += term;
+		}
+		return(sum);
+	}
+
+	constexpr double Cos(double radians)
+	{
+		double x = ReduceAngle(radians);
+		double term = 1.0;
+		double sum = 1.0;
+		for (int n = 1; n < 12; n++)
+		{
+			term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+			sum += term;
+		}
+		return(sum);
+	}
+
+	// one object of the scene, as it is laid out by hand
+	struct SCENE_OBJECT
+	{
+		float scale[3];
+		// rotation in degrees around X, Y and Z
+		float rotation[3];
+		float position[3];
+		SceneManager::SHAPE_MESH mesh;
+		// texture tag, or no tag to draw with the color instead
+		ResourceTag texture;
+		float color[4];
+		float uvScale[2];
+		// material tag, or no tag to keep the previous material
+		ResourceTag material;
+	};
+
+	// the shader state a draw packet changes
+	enum STATE_CHANGE
+	{
+		CHANGE_TEXTURE_MODE = 1,
+		CHANGE_TEXTURE = 2,
+		CHANGE_COLOR = 4,
+		CHANGE_UV_SCALE = 8,
+		CHANGE_MATERIAL = 16
+	};
+
+	// one draw, ready to be streamed to the shader
+	struct DRAW_PACKET
+	{
+		// column-major model matrix
+		float model[16];
+		SceneManager::SHAPE_MESH mesh;
+		ResourceTag texture;
+		float color[4];
+		float uvScale[2];
+		ResourceTag material;
+		// STATE_CHANGE flags - only the state that differs from
+		// the previous packet is sent
+		unsigned int changes;
+	};
+
+	template <size_t COUNT>
+	struct DRAW_LIST
+	{
+		DRAW_PACKET packets[COUNT];
+	};
+
+	/***********************************************************
+	 *  BakeModelMatrix()
+	 *
+	 *  This function builds the model matrix of an object the
+	 *  same way SetTransformations() does - translation, then
+	 *  Z, Y and X rotation, then scale.
+	 ***********************************************************/
+	constexpr void BakeModelMatrix(const SCENE_OBJECT& object, float (&model)[16])
+	{
+		double radiansPerDegree = PI / 180.0;
+		double cx = Cos(object.rotation[0] * radiansPerDegree);
+		double sx = Sin(object.rotation[0] * radiansPerDegree);
+		double cy = Cos(object.rotation[1] * radiansPerDegree);
+		double sy = Sin(object.rotation[1] * radiansPerDegree);
+		double cz = Cos(object.rotation[2] * radiansPerDegree);
+		double sz = Sin(object.rotation[2] * radiansPerDegree);
+
+		// rows of the combined Z * Y * X rotation
+		double rotation[3][3] =
+		{
+			{ cz * cy, cz * sy * sx - sz * cx, cz * sy * cx + sz * sx },
+			{ sz * cy, sz * sy * sx + cz * cx, sz * sy * cx - cz * sx },
+			{ -sy, cy * sx, cy * cx }
+		};
+
+		for (int column = 0; column < 3; column++)
+		{
+			for (int row = 0; row < 3; row++)
+			{
+				model[column * 4 + row] = (float)(rotation[row][column] * object.scale[column]);
+			}
+			model[column * 4 + 3] = 0.0f;
+		}
+		model[12] = object.position[0];
+		model[13] = object.position[1];
+		model[14] = object.position[2];
+		model[15] = 1.0f;
+	}
+
+	/***********************************************************
+	 *  BakeDrawList()
+	 *
+	 *  This function turns the scene layout into draw packets,
+	 *  working out which shader state each packet changes.
+	 ***********************************************************/
+	template <size_t COUNT>
+	constexpr DRAW_LIST<COUNT> BakeDrawList(const SCENE_OBJECT (&objects)[COUNT])
+	{
+		DRAW_LIST<COUNT> list = {};
+		for (size_t i = 0; i < COUNT; i++)
+		{
+			const SCENE_OBJECT& object = objects[i];
+			DRAW_PACKET& packet = list.packets[i];
+
+			BakeModelMatrix(object, packet.model);
+			packet.mesh = object.mesh;
+			packet.texture = object.texture;
+			packet.material = object.material;
+			for (int c = 0; c < 4; c++)
+			{
+				packet.color[c] = object.color[c];
+			}
+			packet.uvScale[0] = object.uvScale[0];
+			packet.uvScale[1] = object.uvScale[1];
+
+			if (i == 0)
+			{
+				packet.changes = CHANGE_TEXTURE_MODE | CHANGE_TEXTURE | CHANGE_COLOR | CHANGE_UV_SCALE;
+				if (object.material.IsValid())
+				{
+					packet.changes |= CHANGE_MATERIAL;
+				}
+				continue;
+			}
+
+			// compare with the state left by the earlier packets
+			const DRAW_PACKET& previous = list.packets[i - 1];
+			bool bTextured = object.texture.IsValid();
+			unsigned int changes = 0;
+			if (bTextured != previous.texture.IsValid())
+			{
+				changes |= CHANGE_TEXTURE_MODE;
+			}
+			if (bTextured && (object.texture != previous.texture))
+			{
+				changes |= CHANGE_TEXTURE;
+			}
+			if (!bTextured &&
+				((object.color[0] != previous.color[0]) || (object.color[1] != previous.color[1]) ||
+				(object.color[2] != previous.color[2]) || (object.color[3] != previous.color[3])))
+			{
+				changes |= CHANGE_COLOR;
+			}
+			if ((object.uvScale[0] != previous.uvScale[0]) || (object.uvScale[1] != previous.uvScale[1]))
+			{
+				changes |= CHANGE_UV_SCALE;
+			}
+			if (object.material.IsValid() && (object.material != previous.material))
+			{
+				changes |= CHANGE_MATERIAL;
+			}
+			// a packet that keeps the material passes it on, so the
+			// next packet compares against the material in use
+			if (!object.material.IsValid())
+			{
+				packet.material = previous.material;
+			}
+			// a textured packet leaves the last color in the shader
+			if (bTextured)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					packet.color[c] = previous.color[c];
+				}
+			}
+			// an untextured packet leaves the last texture bound
+			else
+			{
+				packet.texture = ResourceTag();
+			}
+			packet.changes = changes;
+		}
+		return(list);
+	}
+
+	// color of the objects that are drawn with a texture
+	#define BAKED_NO_COLOR { 1.0f, 1.0f, 1.0f, 1.0f }
+
+	/***********************************************************
+	 *  SCENE_LAYOUT
+	 *
+	 *  The party scene, in the order RenderScene() draws it.
+	 *  The cake and its icing name the textures that end up
+	 *  on screen - RenderScene() follows them with the tag
+	 *  "Cake", which has no texture and leaves them bound.
+	 ***********************************************************/
+	constexpr SCENE_OBJECT SCENE_LAYOUT[] =
+	{
+		// floor
+		{ { 20.0f, 1.0f, 10.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f },
+			SceneManager::MESH_PLANE, TAG("Floor"), BAKED_NO_COLOR, { 2.5f, 2.5f }, TAG("Ceramic") },
+		// party hat and its top
+		{ { 1.0f, 2.25f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 5.0f, 4.36f, -1.5f },
+			SceneManager::MESH_CONE, TAG("Party"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("PaperHat") },
+		{ { 0.25f, 0.25f, 0.25f }, { 0.0f, 0.0f, 0.0f }, { 5.0f, 6.80f, -1.5f },
+			SceneManager::MESH_SPHERE, TAG("Blue"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("PaperHat") },
+		// napkin
+		{ { 5.0f, 0.01f, 5.0f }, { 0.0f, 35.0f, 0.0f }, { 5.0f, 4.33f, -1.5f },
+			SceneManager::MESH_BOX, TAG("Blue"), BAKED_NO_COLOR, { 1.0f, 1.0f }, ResourceTag() },
+		// table top and legs
+		{ { 19.0f, 0.5f, 10.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 4.0f, 0.0f },
+			SceneManager::MESH_BOX, TAG("Table"), BAKED_NO_COLOR, { 3.0f, 3.0f }, TAG("Wood") },
+		{ { 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { -9.2f, 2.0f, -4.7f },
+			SceneManager::MESH_BOX, TAG("Table"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("Wood") },
+		{ { 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { 9.2f, 2.0f, -4.7f },
+			SceneManager::MESH_BOX, TAG("Table"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("Wood") },
+		{ { 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { -9.2f, 2.0f, 4.7f },
+			SceneManager::MESH_BOX, TAG("Table"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("Wood") },
+		{ { 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { 9.2f, 2.0f, 4.7f },
+			SceneManager::MESH_BOX, TAG("Table"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("Wood") },
+		// present
+		{ { 3.0f, 3.0f, 3.0f }, { 0.0f, -35.0f, 0.0f }, { -6.0f, 5.76f, -2.0f },
+			SceneManager::MESH_BOX, TAG("present"), BAKED_NO_COLOR, { 0.2f, 0.5f }, TAG("WrappingPaper") },
+		// balloon, knot and string
+		{ { 2.0f, 2.5f, 2.0f }, { 0.0f, 0.0f, 0.0f }, { 4.0f, 12.0f, -4.0f },
+			SceneManager::MESH_SPHERE, TAG("balloon"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("Balloon") },
+		{ { 0.3f, 0.3f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { 4.0f, 9.45f, -4.0f },
+			SceneManager::MESH_PYRAMID4, TAG("balloon"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("Balloon") },
+		{ { 0.025f, 10.0f, 0.05f }, { 0.0f, 0.0f, 0.0f }, { 4.0f, 4.2f, -4.0f },
+			SceneManager::MESH_CYLINDER, ResourceTag(), { 0.3f, 0.3f, 0.3f, 1.0f }, { 1.0f, 1.0f }, ResourceTag() },
+		// cake, icing and plate
+		{ { 3.0f, 2.0f, 3.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 4.33f, 0.0f },
+			SceneManager::MESH_CYLINDER, TAG("Frost_sides"), BAKED_NO_COLOR, { 1.5f, 1.5f }, ResourceTag() },
+		{ { 3.01f, 0.1f, 3.01f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 6.18f, 0.0f },
+			SceneManager::MESH_CYLINDER, TAG("Frost"), BAKED_NO_COLOR, { 1.0f, 1.0f }, ResourceTag() },
+		{ { 3.5f, 0.1f, 3.5f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 4.33f, 0.0f },
+			SceneManager::MESH_CYLINDER, TAG("Plate"), BAKED_NO_COLOR, { 1.0f, 1.0f }, TAG("Ceramic") },
+		// candle
+		{ { 0.1f, 2.0f, 0.1f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 6.33f, 0.0f },
+			SceneManager::MESH_CYLINDER, ResourceTag(), { 0.9f, 0.9f, 0.4f, 1.0f }, { 1.0f, 1.0f }, TAG("Candle") }
+	};
+
+	#undef BAKED_NO_COLOR
+
+	const size_t TOTAL_PACKETS = sizeof(SCENE_LAYOUT) / sizeof(SCENE_LAYOUT[0]);
+
+	// the draw packets, baked by the compiler into read-only data
+	constexpr DRAW_LIST<TOTAL_PACKETS> DRAW_PACKETS = BakeDrawList(SCENE_LAYOUT);
+}
@@ -0,0 +1,699 @@
+///////////////////////////////////////////////////////////////////////////////
+// balloonphysics.cpp
+// ============
+// buoyant balloon physics - strings, the ceiling, wind and balloon collisions,
+// with a spatial hash broadphase and SIMD sphere tests split across threads
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BalloonPhysics.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// the sphere tests run four at a time with SSE2, which every x86
+// target of the project has
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define BALLOONS_SSE2
+#include <emmintrin.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// height of the ceiling the balloons rest against
+	const float CEILING_HEIGHT = 20.0f;
+	// upward acceleration of the helium, less gravity
+	const float LIFT_ACCELERATION = 3.0f;
+	// how quickly the air slows the balloons
+	const float AIR_DRAG = 1.2f;
+	// the steady draft through the room, how quickly the balloons
+	// pick up its speed, and the size of the gusts
+	const glm::vec3 WIND_VELOCITY(0.8f, 0.0f, 0.3f);
+	const float WIND_RESPONSE = 0.6f;
+	const float GUST_SPEED = 0.5f;
+	// bounciness of balloon against balloon, and of the ceiling
+	const float BALLOON_RESTITUTION = 0.3f;
+	const float CEILING_RESTITUTION = 0.2f;
+
+	// below this many balloons the threads cost more than they save
+	const int PARALLEL_MIN_BALLOONS = 64;
+	const int MAX_THREADS = 8;
+	// fewest buckets of the spatial hash
+	const int MIN_BUCKETS = 64;
+
+	// the room the extra balloons are tied around
+	const float ROOM_HALF_WIDTH = 18.0f;
+	const float ROOM_HALF_DEPTH = 9.0f;
+	const float MIN_EXTRA_RADIUS = 0.6f;
+	const float MAX_EXTRA_RADIUS = 1.0f;
+	const float MIN_EXTRA_STRING = 8.0f;
+	const float MAX_EXTRA_STRING = 16.0f;
+
+	/***********************************************************
+	 *  NextRandom()
+	 *
+	 *  This function returns a number from 0 up to 1 and moves
+	 *  the xorshift state on.
+	 ***********************************************************/
+	float NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return((state >> 8) / 16777216.0f);
+	}
+}
+
+/***********************************************************
+ *  BalloonPhysics()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BalloonPhysics::BalloonPhysics(int threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	m_threadCount = (threadCount < 1) ? 1 : ((threadCount > MAX_THREADS) ? MAX_THREADS : threadCount);
+
+	m_count = 0;
+	m_bStarted = false;
+	m_time = 0.0f;
+	m_stepSeconds = 0.0f;
+	m_cellSize = 1.0f;
+	m_bucketMask = 0;
+	m_workGeneration = 0;
+	m_pendingWorkers = 0;
+	m_workStage = STAGE_INTEGRATE;
+	m_bShutdown = false;
+	m_totalStepMs = 0.0;
+	m_maxStepMs = 0.0;
+	m_stepCount = 0;
+}
+
+/***********************************************************
+ *  ~BalloonPhysics()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BalloonPhysics::~BalloonPhysics()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_bShutdown = true;
+	}
+	m_workReady.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+/***********************************************************
+ *  AddBalloon()
+ *
+ *  This method is used to add a balloon, tied by a string of
+ *  the passed in length from the anchor to its center.
+ ***********************************************************/
+bool BalloonPhysics::AddBalloon(const glm::vec3& position, float radius, const glm::vec3& anchor, float stringLength)
+{
+	if ((true == m_bStarted) || (radius <= 0.0f))
+	{
+		return(false);
+	}
+
+	m_positionX.push_back(position.x);
+	m_positionY.push_back(position.y);
+	m_positionZ.push_back(position.z);
+	m_velocityX.push_back(0.0f);
+	m_velocityY.push_back(0.0f);
+	m_velocityZ.push_back(0.0f);
+	m_radius.push_back(radius);
+	m_anchorX.push_back(anchor.x);
+	m_anchorY.push_back(anchor.y);
+	m_anchorZ.push_back(anchor.z);
+	m_stringLength.push_back(stringLength);
+	// every balloon catches the gusts at its own moment
+	m_windPhase.push_back(m_count * 2.399963f);
+	m_count++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  AddRoomBalloons()
+ *
+ *  This method is used to add the passed in number of smaller
+ *  balloons, tied to the floor around the room at places
+ *  picked by the seed.
+ ***********************************************************/
+void BalloonPhysics::AddRoomBalloons(int count, unsigned int seed)
+{
+	// spread the bits of small seeds before the xorshift
+	uint32_t random = (seed + 1) * 0x9E3779B9u;
+	random = (random == 0) ? 0x2545F491u : random;
+
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 anchor(
+			(NextRandom(random) * 2.0f - 1.0f) * ROOM_HALF_WIDTH,
+			0.0f,
+			(NextRandom(random) * 2.0f - 1.0f) * ROOM_HALF_DEPTH);
+		float radius = MIN_EXTRA_RADIUS + (MAX_EXTRA_RADIUS - MIN_EXTRA_RADIUS) * NextRandom(random);
+		float stringLength = MIN_EXTRA_STRING + (MAX_EXTRA_STRING - MIN_EXTRA_STRING) * NextRandom(random);
+
+		// start a little below the full length of the string, so
+		// the balloons rise into place
+		glm::vec3 position = anchor + glm::vec3(
+			(NextRandom(random) - 0.5f) * radius,
+			stringLength * 0.8f,
+			(NextRandom(random) - 0.5f) * radius);
+		AddBalloon(position, radius, anchor, stringLength);
+	}
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to size the working arrays for the
+ *  added balloons and to start the worker threads.
+ ***********************************************************/
+void BalloonPhysics::Start()
+{
+	if (true == m_bStarted)
+	{
+		return;
+	}
+	m_bStarted = true;
+
+	std::vector<float>* corrections[] =
+	{
+		&m_pushX, &m_pushY, &m_pushZ, &m_impulseX, &m_impulseY, &m_impulseZ,
+		&m_sortedX, &m_sortedY, &m_sortedZ, &m_sortedRadius
+	};
+	for (std::vector<float>* values : corrections)
+	{
+		values->assign(m_count, 0.0f);
+	}
+	m_sortedIndex.assign(m_count, 0);
+	m_bucketOfBalloon.assign(m_count, 0);
+
+	// a cell is as wide as the largest balloon, so touching
+	// balloons are always in neighboring cells
+	float maxRadius = 0.0f;
+	for (int i = 0; i < m_count; i++)
+	{
+		maxRadius = (m_radius[i] > maxRadius) ? m_radius[i] : maxRadius;
+	}
+	m_cellSize = (maxRadius > 0.0f) ? 2.0f * maxRadius : 1.0f;
+
+	// about half of the buckets are left empty, to keep unrelated
+	// cells from sharing a bucket
+	int buckets = MIN_BUCKETS;
+	while (buckets < 2 * m_count)
+	{
+		buckets *= 2;
+	}
+	m_bucketMask = (uint32_t)(buckets - 1);
+	m_bucketStart.assign(buckets, 0);
+	m_bucketCount.assign(buckets, 0);
+
+	m_candidates.resize(m_threadCount);
+	for (CANDIDATE_LIST& candidates : m_candidates)
+	{
+		candidates.positionX.assign(m_count, 0.0f);
+		candidates.positionY.assign(m_count, 0.0f);
+		candidates.positionZ.assign(m_count, 0.0f);
+		candidates.radius.assign(m_count, 0.0f);
+		candidates.index.assign(m_count, 0);
+		candidates.testedPairs = 0;
+		candidates.contacts = 0;
+	}
+
+	m_poses.resize(m_count);
+	for (int i = 0; i < m_count; i++)
+	{
+		m_poses[i].position = glm::vec3(m_positionX[i], m_positionY[i], m_positionZ[i]);
+		m_poses[i].anchor = glm::vec3(m_anchorX[i], m_anchorY[i], m_anchorZ[i]);
+		m_poses[i].radius = m_radius[i];
+	}
+
+	// a few balloons are stepped on the calling thread alone
+	if (m_count < PARALLEL_MIN_BALLOONS)
+	{
+		m_threadCount = 1;
+	}
+	for (int i = 1; i < m_threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&BalloonPhysics::WorkerLoop, this, i));
+	}
+
+	std::cout << "INFO: balloon physics ready for " << m_count << " balloons on "
+		<< m_threadCount << " threads" << std::endl;
+}
+
+/***********************************************************
+ *  Step()
+ *
+ *  This method is used to move the balloons forward by one
+ *  step.  The forces are applied and the balloons moved, the
+ *  balloons are sorted into the spatial hash, the touching
+ *  balloons are found, and then the collisions, strings and
+ *  ceiling are resolved.
+ ***********************************************************/
+void BalloonPhysics::Step(float elapsedSeconds)
+{
+	if ((false == m_bStarted) || (0 == m_count) || (elapsedSeconds <= 0.0f))
+	{
+		return;
+	}
+
+	TRACE_SCOPE("BalloonPhysics::Step");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	m_time += elapsedSeconds;
+	m_stepSeconds = elapsedSeconds;
+
+	RunStage(STAGE_INTEGRATE);
+	BuildSpatialHash();
+	RunStage(STAGE_COLLIDE);
+	RunStage(STAGE_RESOLVE);
+
+	double stepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_totalStepMs += stepMs;
+	m_maxStepMs = (stepMs > m_maxStepMs) ? stepMs : m_maxStepMs;
+	m_stepCount++;
+}
+
+/***********************************************************
+ *  RunStage()
+ *
+ *  This method is used to run a stage of the step over every
+ *  range of balloons - the first range on the calling thread
+ *  and the rest on the workers - and to wait for all of them.
+ ***********************************************************/
+void BalloonPhysics::RunStage(STEP_STAGE stage)
+{
+	if (true == m_workers.empty())
+	{
+		RunRange(stage, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_workStage = stage;
+		m_pendingWorkers = (int)m_workers.size();
+		m_workGeneration++;
+	}
+	m_workReady.notify_all();
+	RunRange(stage, 0);
+	{
+		std::unique_lock<std::mutex> lock(m_workMutex);
+		m_workDone.wait(lock, [this]() { return(0 == m_pendingWorkers); });
+	}
+}
+
+/***********************************************************
+ *  RunRange()
+ *
+ *  This method is used to run a stage of the step over one
+ *  range of balloons.
+ ***********************************************************/
+void BalloonPhysics::RunRange(STEP_STAGE stage, int range)
+{
+	int first = (int)((int64_t)m_count * range / m_threadCount);
+	int last = (int)((int64_t)m_count * (range + 1) / m_threadCount);
+
+	switch (stage)
+	{
+	case STAGE_INTEGRATE:
+		Integrate(first, last);
+		break;
+	case STAGE_COLLIDE:
+		Collide(first, last, m_candidates[range]);
+		break;
+	case STAGE_RESOLVE:
+		Resolve(first, last);
+		break;
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is the loop of one worker thread - it waits
+ *  for a stage to start, runs it over its range and reports
+ *  back, until the physics is destroyed.
+ ***********************************************************/
+void BalloonPhysics::WorkerLoop(int range)
+{
+	TraceRecorder::SetThreadName("balloon physics");
+
+	uint64_t lastGeneration = 0;
+	while (true)
+	{
+		STEP_STAGE stage = STAGE_INTEGRATE;
+		{
+			std::unique_lock<std::mutex> lock(m_workMutex);
+			m_workReady.wait(lock, [&]() { return(m_bShutdown || (m_workGeneration != lastGeneration)); });
+			if (true == m_bShutdown)
+			{
+				return;
+			}
+			lastGeneration = m_workGeneration;
+			stage = m_workStage;
+		}
+
+		RunRange(stage, range);
+
+		{
+			std::lock_guard<std::mutex> lock(m_workMutex);
+			m_pendingWorkers--;
+		}
+		m_workDone.notify_one();
+	}
+}
+
+/***********************************************************
+ *  Integrate()
+ *
+ *  This method is used to apply the lift, the wind and the
+ *  drag to a range of balloons, move them, and find the
+ *  spatial hash bucket each one has moved into.
+ ***********************************************************/
+void BalloonPhysics::Integrate(int first, int last)
+{
+	const float step = m_stepSeconds;
+	const float damping = std::exp(-AIR_DRAG * step);
+	// the draft rises and falls slowly through the room
+	const float draft = 0.6f + 0.4f * std::sin(m_time * 0.23f);
+
+	for (int i = first; i < last; i++)
+	{
+		float windX = WIND_VELOCITY.x * draft + GUST_SPEED * std::sin(m_time * 0.9f + m_windPhase[i]);
+		float windZ = WIND_VELOCITY.z * draft + GUST_SPEED * std::cos(m_time * 0.7f + m_windPhase[i]);
+
+		m_velocityX[i] = (m_velocityX[i] + WIND_RESPONSE * (windX - m_velocityX[i]) * step) * damping;
+		m_velocityY[i] = (m_velocityY[i] + LIFT_ACCELERATION * step) * damping;
+		m_velocityZ[i] = (m_velocityZ[i] + WIND_RESPONSE * (windZ - m_velocityZ[i]) * step) * damping;
+
+		m_positionX[i] += m_velocityX[i] * step;
+		m_positionY[i] += m_velocityY[i] * step;
+		m_positionZ[i] += m_velocityZ[i] * step;
+
+		m_bucketOfBalloon[i] = GetBucket(GetCell(m_positionX[i]), GetCell(m_positionY[i]), GetCell(m_positionZ[i]));
+	}
+}
+
+/***********************************************************
+ *  BuildSpatialHash()
+ *
+ *  This method is used to sort the balloons by bucket with
+ *  a counting sort, copying their positions and radii into
+ *  bucket order so the narrowphase reads them in runs.
+ ***********************************************************/
+void BalloonPhysics::BuildSpatialHash()
+{
+	TRACE_SCOPE("BalloonPhysics::BuildSpatialHash");
+
+	std::fill(m_bucketCount.begin(), m_bucketCount.end(), 0);
+	for (int i = 0; i < m_count; i++)
+	{
+		m_bucketCount[m_bucketOfBalloon[i]]++;
+	}
+
+	int start = 0;
+	for (size_t bucket = 0; bucket < m_bucketStart.size(); bucket++)
+	{
+		m_bucketStart[bucket] = start;
+		start += m_bucketCount[bucket];
+		// counted back up as the balloons are placed
+		m_bucketCount[bucket] = 0;
+	}
+
+	for (int i = 0; i < m_count; i++)
+	{
+		uint32_t bucket = m_bucketOfBalloon[i];
+		int sorted = m_bucketStart[bucket] + m_bucketCount[bucket]++;
+		m_sortedIndex[sorted] = i;
+		m_sortedX[sorted] = m_positionX[i];
+		m_sortedY[sorted] = m_positionY[i];
+		m_sortedZ[sorted] = m_positionZ[i];
+		m_sortedRadius[sorted] = m_radius[i];
+	}
+}
+
+/***********************************************************
+ *  Collide()
+ *
+ *  This method is used to find the balloons touching each
+ *  balloon of a range, and to work out how far to push it
+ *  apart and how much to slow it.  The balloons of the 27
+ *  cells around each balloon are gathered into a list, and
+ *  the list is tested four spheres at a time.  Only the
+ *  balloons of the range are changed - each side of a touching
+ *  pair takes half of the correction on its own range.
+ ***********************************************************/
+void BalloonPhysics::Collide(int first, int last, CANDIDATE_LIST& candidates)
+{
+	for (int i = first; i < last; i++)
+	{
+		const float x = m_positionX[i];
+		const float y = m_positionY[i];
+		const float z = m_positionZ[i];
+		const float radius = m_radius[i];
+		const int cellX = GetCell(x);
+		const int cellY = GetCell(y);
+		const int cellZ = GetCell(z);
+
+		// the buckets of the neighboring cells - cells can share a
+		// bucket, and each bucket is gathered once
+		uint32_t buckets[27];
+		int bucketCount = 0;
+		for (int dz = -1; dz <= 1; dz++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					uint32_t bucket = GetBucket(cellX + dx, cellY + dy, cellZ + dz);
+					bool bSeen = false;
+					for (int b = 0; (b < bucketCount) && (false == bSeen); b++)
+					{
+						bSeen = (buckets[b] == bucket);
+					}
+					if (false == bSeen)
+					{
+						buckets[bucketCount++] = bucket;
+					}
+				}
+			}
+		}
+
+		int count = 0;
+		for (int b = 0; b < bucketCount; b++)
+		{
+			int sorted = m_bucketStart[buckets[b]];
+			int end = sorted + m_bucketCount[buckets[b]];
+			for (; sorted < end; sorted++)
+			{
+				if (m_sortedIndex[sorted] == i)
+				{
+					continue;
+				}
+				candidates.positionX[count] = m_sortedX[sorted];
+				candidates.positionY[count] = m_sortedY[sorted];
+				candidates.positionZ[count] = m_sortedZ[sorted];
+				candidates.radius[count] = m_sortedRadius[sorted];
+				candidates.index[count] = m_sortedIndex[sorted];
+				count++;
+			}
+		}
+		candidates.testedPairs += count;
+
+		// the narrowphase - the touching candidates are marked by
+		// the bits of a mask, four candidates to a mask
+		int c = 0;
+		while (c < count)
+		{
+			int lanes = 1;
+			int touching = 0;
+#ifdef BALLOONS_SSE2
+			if (c + 4 <= count)
+			{
+				__m128 offsetX = _mm_sub_ps(_mm_loadu_ps(&candidates.positionX[c]), _mm_set1_ps(x));
+				__m128 offsetY = _mm_sub_ps(_mm_loadu_ps(&candidates.positionY[c]), _mm_set1_ps(y));
+				__m128 offsetZ = _mm_sub_ps(_mm_loadu_ps(&candidates.positionZ[c]), _mm_set1_ps(z));
+				__m128 distanceSquared = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ));
+				__m128 reach = _mm_add_ps(_mm_loadu_ps(&candidates.radius[c]), _mm_set1_ps(radius));
+				touching = _mm_movemask_ps(_mm_cmplt_ps(distanceSquared, _mm_mul_ps(reach, reach)));
+				lanes = 4;
+			}
+			else
+#endif
+			{
+				float offsetX = candidates.positionX[c] - x;
+				float offsetY = candidates.positionY[c] - y;
+				float offsetZ = candidates.positionZ[c] - z;
+				float reach = candidates.radius[c] + radius;
+				touching = ((offsetX * offsetX + offsetY * offsetY + offsetZ * offsetZ) < (reach * reach)) ? 1 : 0;
+			}
+
+			for (int lane = 0; (lane < lanes) && (0 != touching); lane++)
+			{
+				if (0 == (touching & (1 << lane)))
+				{
+					continue;
+				}
+				touching &= ~(1 << lane);
+
+				int other = c + lane;
+				int j = candidates.index[other];
+				glm::vec3 offset(candidates.positionX[other] - x, candidates.positionY[other] - y, candidates.positionZ[other] - z);
+				float distance = glm::length(offset);
+				// balloons in the same place are split along X, in
+				// opposite directions for the two of them
+				glm::vec3 normal = (distance > 1.0e-5f) ? offset / distance : glm::vec3((i < j) ? 1.0f : -1.0f, 0.0f, 0.0f);
+				float overlap = candidates.radius[other] + radius - distance;
+
+				m_pushX[i] -= normal.x * overlap * 0.5f;
+				m_pushY[i] -= normal.y * overlap * 0.5f;
+				m_pushZ[i] -= normal.z * overlap * 0.5f;
+
+				// only balloons moving together bounce apart
+				float closingSpeed =
+					(m_velocityX[j] - m_velocityX[i]) * normal.x +
+					(m_velocityY[j] - m_velocityY[i]) * normal.y +
+					(m_velocityZ[j] - m_velocityZ[i]) * normal.z;
+				if (closingSpeed < 0.0f)
+				{
+					float impulse = closingSpeed * 0.5f * (1.0f + BALLOON_RESTITUTION);
+					m_impulseX[i] += normal.x * impulse;
+					m_impulseY[i] += normal.y * impulse;
+					m_impulseZ[i] += normal.z * impulse;
+				}
+				candidates.contacts++;
+			}
+
+			c += lanes;
+		}
+	}
+}
+
+/***********************************************************
+ *  Resolve()
+ *
+ *  This method is used to apply the collision corrections to
+ *  a range of balloons, hold them within their strings and
+ *  under the ceiling, and write out their poses.
+ ***********************************************************/
+void BalloonPhysics::Resolve(int first, int last)
+{
+	for (int i = first; i < last; i++)
+	{
+		glm::vec3 position(m_positionX[i] + m_pushX[i], m_positionY[i] + m_pushY[i], m_positionZ[i] + m_pushZ[i]);
+		glm::vec3 velocity(m_velocityX[i] + m_impulseX[i], m_velocityY[i] + m_impulseY[i], m_velocityZ[i] + m_impulseZ[i]);
+		m_pushX[i] = m_pushY[i] = m_pushZ[i] = 0.0f;
+		m_impulseX[i] = m_impulseY[i] = m_impulseZ[i] = 0.0f;
+
+		// the string holds the balloon within its length of the
+		// anchor, and stops it moving any further away
+		glm::vec3 anchor(m_anchorX[i], m_anchorY[i], m_anchorZ[i]);
+		glm::vec3 offset = position - anchor;
+		float distance = glm::length(offset);
+		if ((distance > m_stringLength[i]) && (distance > 0.0f))
+		{
+			glm::vec3 direction = offset / distance;
+			position = anchor + direction * m_stringLength[i];
+			float outwardSpeed = glm::dot(velocity, direction);
+			if (outwardSpeed > 0.0f)
+			{
+				velocity -= direction * outwardSpeed;
+			}
+		}
+
+		// the ceiling stops the balloons with a small bounce, and
+		// the floor keeps them out of the scene
+		float radius = m_radius[i];
+		if (position.y + radius > CEILING_HEIGHT)
+		{
+			position.y = CEILING_HEIGHT - radius;
+			velocity.y = (velocity.y > 0.0f) ? -velocity.y * CEILING_RESTITUTION : velocity.y;
+		}
+		if (position.y < radius)
+		{
+			position.y = radius;
+			velocity.y = (velocity.y < 0.0f) ? 0.0f : velocity.y;
+		}
+
+		m_positionX[i] = position.x;
+		m_positionY[i] = position.y;
+		m_positionZ[i] = position.z;
+		m_velocityX[i] = velocity.x;
+		m_velocityY[i] = velocity.y;
+		m_velocityZ[i] = velocity.z;
+		m_poses[i].position = position;
+	}
+}
+
+/***********************************************************
+ *  GetCell()
+ *
+ *  This method returns the cell of the spatial hash along
+ *  one axis for the passed in coordinate.
+ ***********************************************************/
+int BalloonPhysics::GetCell(float value) const
+{
+	return((int)std::floor(value / m_cellSize));
+}
+
+/***********************************************************
+ *  GetBucket()
+ *
+ *  This method returns the bucket of the spatial hash that
+ *  the passed in cell falls into.
+ ***********************************************************/
+uint32_t BalloonPhysics::GetBucket(int cellX, int cellY, int cellZ) const
+{
+	uint32_t hash =
+		((uint32_t)cellX * 73856093u) ^
+		((uint32_t)cellY * 19349663u) ^
+		((uint32_t)cellZ * 83492791u);
+	return(hash & m_bucketMask);
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print the step times and how much
+ *  work the broadphase left for the narrowphase.
+ ***********************************************************/
+void BalloonPhysics::PrintReport() const
+{
+	if (0 == m_stepCount)
+	{
+		return;
+	}
+
+	uint64_t testedPairs = 0;
+	uint64_t contacts = 0;
+	for (const CANDIDATE_LIST& candidates : m_candidates)
+	{
+		testedPairs += candidates.testedPairs;
+		contacts += candidates.contacts;
+	}
+
+	std::cout << "BALLOONS: balloons:" << m_count
+		<< ", threads:" << m_threadCount
+		<< ", steps:" << m_stepCount
+		<< ", average step ms:" << (m_totalStepMs / m_stepCount)
+		<< ", max step ms:" << m_maxStepMs
+		<< ", pairs tested per step:" << (testedPairs / m_stepCount)
+		<< ", contacts per step:" << (contacts / m_stepCount) << std::endl;
+}
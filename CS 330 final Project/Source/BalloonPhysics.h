@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+// balloonphysics.h
+// ============
+// buoyant balloon physics - strings, the ceiling, wind and balloon collisions,
+// with a spatial hash broadphase and SIMD sphere tests split across threads
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  BalloonPhysics
+ *
+ *  This class moves balloons that float up against their
+ *  strings, drift in the wind, bump into each other and
+ *  rest against the ceiling.  Every value of the balloons is
+ *  kept in its own array.  Each step the balloons are sorted
+ *  into a uniform spatial hash, and each balloon is tested
+ *  against the balloons of the cells around it four at a
+ *  time.  The balloons are split into ranges, one for each
+ *  thread, and every thread only writes the balloons of its
+ *  own range, so the threads never wait on each other within
+ *  a stage.  The positions are passed on to the scene manager
+ *  as the poses to draw.
+ ***********************************************************/
+class BalloonPhysics
+{
+public:
+	// constructor - a thread count of 0 picks one from the
+	// number of processors
+	BalloonPhysics(int threadCount);
+	// destructor
+	~BalloonPhysics();
+
+	// add a balloon of the passed in radius held by a string of
+	// the passed in length, tied at the anchor - returns false
+	// once the balloons have been started
+	bool AddBalloon(const glm::vec3& position, float radius, const glm::vec3& anchor, float stringLength);
+	// add the passed in number of smaller balloons tied to the
+	// floor around the room, placed by the seed
+	void AddRoomBalloons(int count, unsigned int seed);
+	// size the working arrays and start the threads - call once
+	// all of the balloons have been added
+	void Start();
+
+	// move the balloons forward by one fixed step
+	void Step(float elapsedSeconds);
+
+	// the poses of the balloons after the last step
+	const SceneManager::BALLOON_POSE* GetPoses() const { return(m_poses.data()); }
+	int GetBalloonCount() const { return(m_count); }
+
+	// print the step times
+	void PrintReport() const;
+
+private:
+	// the parts of a step run over the balloon ranges
+	enum STEP_STAGE
+	{
+		STAGE_INTEGRATE = 0,
+		STAGE_COLLIDE,
+		STAGE_RESOLVE
+	};
+
+	// candidates gathered for the narrowphase of one balloon, one
+	// list for every thread
+	struct CANDIDATE_LIST
+	{
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+		std::vector<float> radius;
+		std::vector<int> index;
+		// sphere pairs tested and found touching by the thread
+		uint64_t testedPairs;
+		uint64_t contacts;
+	};
+
+	int m_count;
+	int m_threadCount;
+	bool m_bStarted;
+	float m_time;
+	float m_stepSeconds;
+
+	// the balloons
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+	std::vector<float> m_velocityX;
+	std::vector<float> m_velocityY;
+	std::vector<float> m_velocityZ;
+	std::vector<float> m_radius;
+	std::vector<float> m_anchorX;
+	std::vector<float> m_anchorY;
+	std::vector<float> m_anchorZ;
+	std::vector<float> m_stringLength;
+	std::vector<float> m_windPhase;
+	// corrections from the collisions of the current step
+	std::vector<float> m_pushX;
+	std::vector<float> m_pushY;
+	std::vector<float> m_pushZ;
+	std::vector<float> m_impulseX;
+	std::vector<float> m_impulseY;
+	std::vector<float> m_impulseZ;
+
+	// the spatial hash - the balloons sorted by cell, with the
+	// first sorted balloon and the number of balloons of every
+	// hash bucket
+	float m_cellSize;
+	uint32_t m_bucketMask;
+	std::vector<uint32_t> m_bucketOfBalloon;
+	std::vector<int> m_bucketStart;
+	std::vector<int> m_bucketCount;
+	std::vector<int> m_sortedIndex;
+	std::vector<float> m_sortedX;
+	std::vector<float> m_sortedY;
+	std::vector<float> m_sortedZ;
+	std::vector<float> m_sortedRadius;
+
+	std::vector<CANDIDATE_LIST> m_candidates;
+	std::vector<SceneManager::BALLOON_POSE> m_poses;
+
+	// the worker threads, one for every range after the first,
+	// which runs on the calling thread
+	std::vector<std::thread> m_workers;
+	std::mutex m_workMutex;
+	std::condition_variable m_workReady;
+	std::condition_variable m_workDone;
+	uint64_t m_workGeneration;
+	int m_pendingWorkers;
+	STEP_STAGE m_workStage;
+	bool m_bShutdown;
+
+	// step timing
+	double m_totalStepMs;
+	double m_maxStepMs;
+	int m_stepCount;
+
+	// the loop of one worker thread
+	void WorkerLoop(int range);
+	// run a stage over every range and wait for it to finish
+	void RunStage(STEP_STAGE stage);
+	void RunRange(STEP_STAGE stage, int range);
+
+	// the stages of a step, over the balloons from first up to
+	// but not including last
+	void Integrate(int first, int last);
+	void Collide(int first, int last, CANDIDATE_LIST& candidates);
+	void Resolve(int first, int last);
+
+	// sort the balloons into the spatial hash
+	void BuildSpatialHash();
+	uint32_t GetBucket(int cellX, int cellY, int cellZ) const;
+	int GetCell(float value) const;
+};
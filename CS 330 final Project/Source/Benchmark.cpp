@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// fixed length benchmark runs - records the time of every rendered frame and
+// prints a summary report when the run is finished
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+#include "RenderStats.h"
+#include "GpuResourceTracker.h"
+#include "HitchDetector.h"
+
+#include <algorithm>
+#include <iostream>
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+/***********************************************************
+ *  Benchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Benchmark::Benchmark(int totalFrames)
+{
+	m_totalFrames = totalFrames;
+	m_lastFrameTime = 0.0;
+	m_sceneObjects = -1;
+	m_scenePointLights = -1;
+	// reserve the memory up front so recording never allocates
+	m_frameTimes.reserve(totalFrames);
+}
+
+/***********************************************************
+ *  ~Benchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Benchmark::~Benchmark()
+{
+}
+
+/***********************************************************
+ *  FrameFinished()
+ *
+ *  This method is used to record the time taken by the frame
+ *  that was just presented.  The first frame only starts the
+ *  timing, since it includes the startup work.
+ ***********************************************************/
+void Benchmark::FrameFinished()
+{
+	double currentTime = glfwGetTime();
+
+	if ((m_lastFrameTime > 0.0) && (m_frameTimes.size() < (size_t)m_totalFrames))
+	{
+		m_frameTimes.push_back((currentTime - m_lastFrameTime) * 1000.0);
+	}
+
+	m_lastFrameTime = currentTime;
+}
+
+/***********************************************************
+ *  IsFinished()
+ *
+ *  This method returns whether all frames have been rendered.
+ ***********************************************************/
+bool Benchmark::IsFinished() const
+{
+	return(m_frameTimes.size() >= (size_t)m_totalFrames);
+}
+
+/***********************************************************
+ *  GetFrameCount()
+ *
+ *  This method returns the number of measured frames.
+ ***********************************************************/
+int Benchmark::GetFrameCount() const
+{
+	return((int)m_frameTimes.size());
+}
+
+/***********************************************************
+ *  SetSceneSize()
+ *
+ *  This method is used to record the number of objects and
+ *  point lights in the scene being measured.
+ ***********************************************************/
+void Benchmark::SetSceneSize(int objects, int pointLights)
+{
+	m_sceneObjects = objects;
+	m_scenePointLights = pointLights;
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print the frame time summary,
+ *  including the percentiles that show stutter which the
+ *  average frame time hides.
+ ***********************************************************/
+void Benchmark::PrintReport() const
+{
+	if (m_frameTimes.empty())
+	{
+		std::cout << "BENCHMARK: no frames were measured" << std::endl;
+		return;
+	}
+
+	std::vector<double> sorted = m_frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (double frameTime : sorted)
+	{
+		total += frameTime;
+	}
+
+	size_t count = sorted.size();
+	double average = total / count;
+
+	std::cout << "BENCHMARK: frames:" << count
+		<< ", total ms:" << total
+		<< ", average ms:" << average
+		<< ", fps:" << (1000.0 / average) << std::endl;
+	std::cout << "BENCHMARK: min ms:" << sorted.front()
+		<< ", p50 ms:" << sorted[count / 2]
+		<< ", p95 ms:" << sorted[(count * 95) / 100]
+		<< ", p99 ms:" << sorted[(count * 99) / 100]
+		<< ", max ms:" << sorted.back() << std::endl;
+	std::cout << "BENCHMARK: hitches:" << HitchDetector::GetHitchCount() << std::endl;
+
+	// the amount of rendering work behind those frame times
+	RenderStats::PrintReport();
+	GpuResourceTracker::PrintMemoryReport();
+
+	// one line per run for plotting frame time and memory
+	// against the size of the scene
+	if (m_sceneObjects >= 0)
+	{
+		size_t gpuBytes = GpuResourceTracker::GetLiveBytes(GpuResourceTracker::RESOURCE_TEXTURE) +
+			GpuResourceTracker::GetLiveBytes(GpuResourceTracker::RESOURCE_BUFFER);
+		std::cout << "BENCHMARK: objects,point lights,average ms,p95 ms,p99 ms,GPU MB" << std::endl;
+		std::cout << "BENCHMARK: " << m_sceneObjects << "," << m_scenePointLights
+			<< "," << average << "," << sorted[(count * 95) / 100] << "," << sorted[(count * 99) / 100]
+			<< "," << (gpuBytes / (1024.0 * 1024.0)) << std::endl;
+	}
+}
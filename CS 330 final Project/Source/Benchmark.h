@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// fixed length benchmark runs - records the time of every rendered frame and
+// prints a summary report when the run is finished
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+/***********************************************************
+ *  Benchmark
+ *
+ *  This class runs the render loop for a fixed number of
+ *  frames and records how long each frame took.  Benchmark
+ *  runs advance the simulation by exactly one fixed step per
+ *  frame, so every run renders the same sequence of frames.
+ ***********************************************************/
+class Benchmark
+{
+public:
+	// constructor
+	Benchmark(int totalFrames);
+	// destructor
+	~Benchmark();
+
+	// call once after every presented frame
+	void FrameFinished();
+
+	// check whether all of the frames have been rendered
+	bool IsFinished() const;
+
+	// number of frames rendered so far
+	int GetFrameCount() const;
+
+	// record the size of the scene being measured, so runs with
+	// different sizes can be compared
+	void SetSceneSize(int objects, int pointLights);
+
+	// print the frame time summary to the console
+	void PrintReport() const;
+
+private:
+	// number of frames to render
+	int m_totalFrames;
+	// time the previous frame finished
+	double m_lastFrameTime;
+	// duration of every measured frame in milliseconds
+	std::vector<double> m_frameTimes;
+	// size of the measured scene, -1 when not known
+	int m_sceneObjects;
+	int m_scenePointLights;
+};
@@ -0,0 +1,852 @@
+///////////////////////////////////////////////////////////////////////////////
+// candleparticles.cpp
+// ============
+// CPU particles for the candle flame and smoke - structure of arrays storage,
+// AVX2 update kernels and one thread per emitter, streamed to the GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CandleParticles.h"
+#include "HitchDetector.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// the AVX2 kernel is built for x86 processors and only used when
+// the processor running the program has AVX2
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define PARTICLES_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PARTICLES_AVX2_FUNCTION
+#else
+#define PARTICLES_AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+/***********************************************************
+ *  EMITTER_SETTINGS
+ *
+ *  How one kind of particle is emitted and moves.  Colors
+ *  and sizes blend from start to end over the life of each
+ *  particle.
+ ***********************************************************/
+struct CandleParticles::EMITTER_SETTINGS
+{
+	const char* name;
+	glm::vec3 origin;
+	float originRadius;
+	float minRiseSpeed;
+	float maxRiseSpeed;
+	float sideSpeed;
+	float swirl;
+	float buoyancy;
+	float damping;
+	float minLifeSeconds;
+	float maxLifeSeconds;
+	float startHalfSize;
+	float endHalfSize;
+	glm::vec4 startColor;
+	glm::vec4 endColor;
+	// fraction of the life spent fading in
+	float fadeInFraction;
+	// additive blending for glowing particles
+	bool bAdditive;
+};
+
+// declaration of the global variables and defines
+namespace
+{
+	// the shader files of the particles
+	const char* const PARTICLE_VERTEX_SHADER_FILE = "shaders/particleVertexShader.glsl";
+	const char* const PARTICLE_FRAGMENT_SHADER_FILE = "shaders/particleFragmentShader.glsl";
+
+	// the flame sits on the wick, at the top of the candle, and
+	// the smoke rises from the tip of the flame
+	const CandleParticles::EMITTER_SETTINGS FLAME_SETTINGS =
+	{
+		"flame", glm::vec3(0.0f, 8.35f, 0.0f), 0.03f,
+		0.3f, 0.6f, 0.08f, 0.6f, 1.5f, 3.0f,
+		0.3f, 0.7f, 0.07f, 0.01f,
+		glm::vec4(1.0f, 0.9f, 0.6f, 0.9f), glm::vec4(1.0f, 0.3f, 0.05f, 0.0f),
+		0.0f, true
+	};
+	const CandleParticles::EMITTER_SETTINGS SMOKE_SETTINGS =
+	{
+		"smoke", glm::vec3(0.0f, 8.85f, 0.0f), 0.05f,
+		0.3f, 0.5f, 0.15f, 0.4f, 0.4f, 0.8f,
+		2.0f, 4.0f, 0.05f, 0.4f,
+		glm::vec4(0.35f, 0.35f, 0.35f, 0.25f), glm::vec4(0.5f, 0.5f, 0.5f, 0.0f),
+		0.15f, false
+	};
+
+	// floats of one instance - position, half size and color
+	const int INSTANCE_FLOATS = 8;
+	const size_t INSTANCE_BYTES = INSTANCE_FLOATS * sizeof(float);
+	// sections of the persistently mapped buffer
+	const int MAPPED_SECTIONS = 3;
+	// time of one wait for the GPU to finish with a section
+	const GLuint64 FENCE_TIMEOUT_NS = 1000000000;
+	// time one update of all the particles should stay under
+	const double UPDATE_BUDGET_MS = 0.5;
+
+	/***********************************************************
+	 *  NextRandom()
+	 *
+	 *  This function returns a number from 0 up to 1 and moves
+	 *  the xorshift state on.
+	 ***********************************************************/
+	float NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return((state >> 8) / 16777216.0f);
+	}
+
+	/***********************************************************
+	 *  HasPersistentMapping()
+	 *
+	 *  This function returns whether the context has OpenGL 4.4
+	 *  buffer storage, which persistent mapping needs.
+	 ***********************************************************/
+	bool HasPersistentMapping()
+	{
+#ifdef __APPLE__
+		return(false);
+#else
+		GLint majorVersion = 0;
+		GLint minorVersion = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+		glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+		return((majorVersion > 4) || ((majorVersion == 4) && (minorVersion >= 4)));
+#endif
+	}
+
+	/***********************************************************
+	 *  HasAVX2()
+	 *
+	 *  This function returns whether the processor has AVX2
+	 *  and the operating system saves the AVX registers.
+	 ***********************************************************/
+	bool HasAVX2()
+	{
+#if defined(PARTICLES_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool bOSSavesAVX = ((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) &&
+			((_xgetbv(0) & 6) == 6);
+		__cpuidex(info, 7, 0);
+		return(bOSSavesAVX && ((info[1] & (1 << 5)) != 0));
+#elif defined(PARTICLES_X86)
+		return(__builtin_cpu_supports("avx2") != 0);
+#else
+		return(false);
+#endif
+	}
+
+	/***********************************************************
+	 *  SimulateScalar()
+	 *
+	 *  This function moves the particles from the passed in
+	 *  index to the end, one at a time.
+	 ***********************************************************/
+	void SimulateScalar(
+		float* positionX, float* positionY, float* positionZ,
+		float* velocityX, float* velocityY, float* velocityZ,
+		const float* swirlX, const float* swirlZ, float* age,
+		int first, int count, float elapsedSeconds, float buoyancy, float damping)
+	{
+		for (int i = first; i < count; i++)
+		{
+			velocityX[i] = (velocityX[i] + swirlX[i] * elapsedSeconds) * damping;
+			velocityY[i] = (velocityY[i] + buoyancy * elapsedSeconds) * damping;
+			velocityZ[i] = (velocityZ[i] + swirlZ[i] * elapsedSeconds) * damping;
+			positionX[i] += velocityX[i] * elapsedSeconds;
+			positionY[i] += velocityY[i] * elapsedSeconds;
+			positionZ[i] += velocityZ[i] * elapsedSeconds;
+			age[i] += elapsedSeconds;
+		}
+	}
+
+#ifdef PARTICLES_X86
+	/***********************************************************
+	 *  SimulateAVX2()
+	 *
+	 *  This function moves the particles eight at a time, and
+	 *  returns the index of the first particle left over for
+	 *  the scalar loop.
+	 ***********************************************************/
+	PARTICLES_AVX2_FUNCTION int SimulateAVX2(
+		float* positionX, float* positionY, float* positionZ,
+		float* velocityX, float* velocityY, float* velocityZ,
+		const float* swirlX, const float* swirlZ, float* age,
+		int count, float elapsedSeconds, float buoyancy, float damping)
+	{
+		const __m256 step = _mm256_set1_ps(elapsedSeconds);
+		const __m256 rise = _mm256_set1_ps(buoyancy * elapsedSeconds);
+		const __m256 damp = _mm256_set1_ps(damping);
+
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 vx = _mm256_loadu_ps(velocityX + i);
+			__m256 vy = _mm256_loadu_ps(velocityY + i);
+			__m256 vz = _mm256_loadu_ps(velocityZ + i);
+			vx = _mm256_mul_ps(_mm256_add_ps(vx, _mm256_mul_ps(_mm256_loadu_ps(swirlX + i), step)), damp);
+			vy = _mm256_mul_ps(_mm256_add_ps(vy, rise), damp);
+			vz = _mm256_mul_ps(_mm256_add_ps(vz, _mm256_mul_ps(_mm256_loadu_ps(swirlZ + i), step)), damp);
+			_mm256_storeu_ps(velocityX + i, vx);
+			_mm256_storeu_ps(velocityY + i, vy);
+			_mm256_storeu_ps(velocityZ + i, vz);
+
+			_mm256_storeu_ps(positionX + i, _mm256_add_ps(_mm256_loadu_ps(positionX + i), _mm256_mul_ps(vx, step)));
+			_mm256_storeu_ps(positionY + i, _mm256_add_ps(_mm256_loadu_ps(positionY + i), _mm256_mul_ps(vy, step)));
+			_mm256_storeu_ps(positionZ + i, _mm256_add_ps(_mm256_loadu_ps(positionZ + i), _mm256_mul_ps(vz, step)));
+			_mm256_storeu_ps(age + i, _mm256_add_ps(_mm256_loadu_ps(age + i), step));
+		}
+
+		return(i);
+	}
+
+	/***********************************************************
+	 *  WriteInstancesAVX2()
+	 *
+	 *  This function works out the size and color of eight
+	 *  particles at a time and writes them out as instances,
+	 *  turning the eight arrays of values around into eight
+	 *  instances in registers.  It returns the index of the
+	 *  first particle left over for the scalar loop.
+	 ***********************************************************/
+	PARTICLES_AVX2_FUNCTION int WriteInstancesAVX2(
+		const float* positionX, const float* positionY, const float* positionZ,
+		const float* age, const float* inverseLife, int count,
+		const CandleParticles::EMITTER_SETTINGS& settings, float* pInstances)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 startSize = _mm256_set1_ps(settings.startHalfSize);
+		const __m256 sizeRange = _mm256_set1_ps(settings.endHalfSize - settings.startHalfSize);
+		const __m256 startR = _mm256_set1_ps(settings.startColor.r);
+		const __m256 startG = _mm256_set1_ps(settings.startColor.g);
+		const __m256 startB = _mm256_set1_ps(settings.startColor.b);
+		const __m256 startA = _mm256_set1_ps(settings.startColor.a);
+		const __m256 rangeR = _mm256_set1_ps(settings.endColor.r - settings.startColor.r);
+		const __m256 rangeG = _mm256_set1_ps(settings.endColor.g - settings.startColor.g);
+		const __m256 rangeB = _mm256_set1_ps(settings.endColor.b - settings.startColor.b);
+		const __m256 rangeA = _mm256_set1_ps(settings.endColor.a - settings.startColor.a);
+		const bool bFadeIn = (settings.fadeInFraction > 0.0f);
+		const __m256 fadeInScale = _mm256_set1_ps(bFadeIn ? (1.0f / settings.fadeInFraction) : 0.0f);
+
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 t = _mm256_mul_ps(_mm256_loadu_ps(age + i), _mm256_loadu_ps(inverseLife + i));
+			__m256 size = _mm256_add_ps(startSize, _mm256_mul_ps(sizeRange, t));
+			__m256 r = _mm256_add_ps(startR, _mm256_mul_ps(rangeR, t));
+			__m256 g = _mm256_add_ps(startG, _mm256_mul_ps(rangeG, t));
+			__m256 b = _mm256_add_ps(startB, _mm256_mul_ps(rangeB, t));
+			__m256 a = _mm256_add_ps(startA, _mm256_mul_ps(rangeA, t));
+			if (true == bFadeIn)
+			{
+				a = _mm256_mul_ps(a, _mm256_min_ps(_mm256_mul_ps(t, fadeInScale), one));
+			}
+
+			// turn the eight values of eight particles around into
+			// the eight floats of each instance
+			__m256 x = _mm256_loadu_ps(positionX + i);
+			__m256 y = _mm256_loadu_ps(positionY + i);
+			__m256 z = _mm256_loadu_ps(positionZ + i);
+			__m256 t0 = _mm256_unpacklo_ps(x, y);
+			__m256 t1 = _mm256_unpackhi_ps(x, y);
+			__m256 t2 = _mm256_unpacklo_ps(z, size);
+			__m256 t3 = _mm256_unpackhi_ps(z, size);
+			__m256 t4 = _mm256_unpacklo_ps(r, g);
+			__m256 t5 = _mm256_unpackhi_ps(r, g);
+			__m256 t6 = _mm256_unpacklo_ps(b, a);
+			__m256 t7 = _mm256_unpackhi_ps(b, a);
+			__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+			float* pOut = pInstances + (size_t)i * INSTANCE_FLOATS;
+			_mm256_storeu_ps(pOut, _mm256_permute2f128_ps(s0, s4, 0x20));
+			_mm256_storeu_ps(pOut + 8, _mm256_permute2f128_ps(s1, s5, 0x20));
+			_mm256_storeu_ps(pOut + 16, _mm256_permute2f128_ps(s2, s6, 0x20));
+			_mm256_storeu_ps(pOut + 24, _mm256_permute2f128_ps(s3, s7, 0x20));
+			_mm256_storeu_ps(pOut + 32, _mm256_permute2f128_ps(s0, s4, 0x31));
+			_mm256_storeu_ps(pOut + 40, _mm256_permute2f128_ps(s1, s5, 0x31));
+			_mm256_storeu_ps(pOut + 48, _mm256_permute2f128_ps(s2, s6, 0x31));
+			_mm256_storeu_ps(pOut + 56, _mm256_permute2f128_ps(s3, s7, 0x31));
+		}
+
+		return(i);
+	}
+#endif
+}
+
+/***********************************************************
+ *  CandleParticles()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CandleParticles::CandleParticles(int capacity, bool bForceScalar)
+{
+	m_capacity = capacity;
+	m_bUseAVX2 = (false == bForceScalar) && HasAVX2();
+	m_time = 0.0f;
+	m_flicker = 1.0f;
+	m_flickerRandom = 0x2545F491u;
+	m_pMappedInstances = NULL;
+	m_sectionCount = 1;
+	m_drawSection = 0;
+	for (int i = 0; i < MAPPED_SECTIONS; i++)
+	{
+		m_sectionFences[i] = NULL;
+	}
+	m_vertexArray = 0;
+	m_viewLocation = -1;
+	m_projectionLocation = -1;
+	m_workGeneration = 0;
+	m_pendingWorkers = 0;
+	m_workSeconds = 0.0f;
+	m_bShutdown = false;
+	m_totalUpdateMs = 0.0;
+	m_maxUpdateMs = 0.0;
+	m_updateCount = 0;
+	m_overBudgetCount = 0;
+
+	// the flame and the smoke share the capacity
+	const EMITTER_SETTINGS* settings[TOTAL_EMITTERS] = { &FLAME_SETTINGS, &SMOKE_SETTINGS };
+	int firstInstance = 0;
+	for (int i = 0; i < TOTAL_EMITTERS; i++)
+	{
+		PARTICLE_EMITTER& emitter = m_emitters[i];
+		emitter.pSettings = settings[i];
+		emitter.capacity = (i == 0) ? capacity / 2 : capacity - capacity / 2;
+		emitter.count = 0;
+		emitter.pendingParticles = 0.0f;
+		emitter.randomState = 0x9E3779B9u * (i + 1);
+		emitter.firstInstance = firstInstance;
+		emitter.pInstances = NULL;
+		emitter.drawCount = 0;
+		firstInstance += emitter.capacity;
+
+		std::vector<float>* arrays[] =
+		{
+			&emitter.positionX, &emitter.positionY, &emitter.positionZ,
+			&emitter.velocityX, &emitter.velocityY, &emitter.velocityZ,
+			&emitter.swirlX, &emitter.swirlZ, &emitter.age, &emitter.inverseLife
+		};
+		for (std::vector<float>* values : arrays)
+		{
+			values->assign(emitter.capacity, 0.0f);
+		}
+	}
+}
+
+/***********************************************************
+ *  ~CandleParticles()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CandleParticles::~CandleParticles()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_bShutdown = true;
+	}
+	m_workReady.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	for (int i = 0; i < MAPPED_SECTIONS; i++)
+	{
+		if (NULL != m_sectionFences[i])
+		{
+			glDeleteSync((GLsync)m_sectionFences[i]);
+			m_sectionFences[i] = NULL;
+		}
+	}
+	if (NULL != m_pMappedInstances)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer.Get());
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_pMappedInstances = NULL;
+	}
+	if (0 != m_vertexArray)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		m_vertexArray = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to build the shader program and the
+ *  instance buffer, and to start the emitter threads.
+ ***********************************************************/
+bool CandleParticles::Initialize()
+{
+	TRACE_SCOPE("CandleParticles::Initialize");
+
+	if (m_renderProgram.LoadGraphics(PARTICLE_VERTEX_SHADER_FILE, PARTICLE_FRAGMENT_SHADER_FILE) == false)
+	{
+		return(false);
+	}
+	m_viewLocation = m_renderProgram.GetUniformLocation("view");
+	m_projectionLocation = m_renderProgram.GetUniformLocation("projection");
+
+	// with buffer storage the buffer stays mapped for the whole
+	// run and is written in turn a section at a time - otherwise
+	// the instances are copied and uploaded every update
+	size_t sectionBytes = (size_t)m_capacity * INSTANCE_BYTES;
+	m_instanceBuffer.Create("CandleParticles instances", GPU_RESOURCE_SITE);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer.Get());
+	if (HasPersistentMapping() == true)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		m_sectionCount = MAPPED_SECTIONS;
+		glBufferStorage(GL_ARRAY_BUFFER, sectionBytes * m_sectionCount, NULL, flags);
+		m_pMappedInstances = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, sectionBytes * m_sectionCount, flags);
+	}
+	if (NULL == m_pMappedInstances)
+	{
+		m_sectionCount = 1;
+		glBufferData(GL_ARRAY_BUFFER, sectionBytes, NULL, GL_STREAM_DRAW);
+		m_stagingInstances.assign((size_t)m_capacity * INSTANCE_FLOATS, 0.0f);
+	}
+	m_instanceBuffer.SetByteSize(sectionBytes * m_sectionCount);
+
+	// the billboard corners come from the vertex index, and the
+	// instance values step once per instance
+	glGenVertexArrays(1, &m_vertexArray);
+	glBindVertexArray(m_vertexArray);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisor(0, 1);
+	glVertexAttribDivisor(1, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the first emitter is updated on the calling thread
+	for (int i = 1; i < TOTAL_EMITTERS; i++)
+	{
+		m_workers.push_back(std::thread(&CandleParticles::WorkerLoop, this, i));
+	}
+
+	std::cout << "INFO: candle particles ready for " << m_capacity << " particles, "
+		<< (m_bUseAVX2 ? "AVX2" : "scalar") << " update, "
+		<< ((NULL != m_pMappedInstances) ? "persistently mapped" : "uploaded") << " instances" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to simulate the flame and the smoke
+ *  forward.  Every emitter is updated at the same time on
+ *  its own thread, and writes its instances into the next
+ *  section of the instance buffer once the GPU has finished
+ *  drawing from it.
+ ***********************************************************/
+void CandleParticles::Update(float elapsedSeconds)
+{
+	if ((0 == m_vertexArray) || (elapsedSeconds <= 0.0f))
+	{
+		return;
+	}
+
+	TRACE_SCOPE("CandleParticles::Update");
+	HITCH_PHASE("CandleParticles");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// the flame flickers with two wobbles and a little noise
+	m_time += elapsedSeconds;
+	m_flicker = 0.85f +
+		0.08f * std::sin(m_time * 10.7f) +
+		0.05f * std::sin(m_time * 23.3f + 0.7f) +
+		0.04f * NextRandom(m_flickerRandom);
+
+	int section = (m_drawSection + 1) % m_sectionCount;
+	float* pSection = NULL;
+	if (NULL != m_pMappedInstances)
+	{
+		// wait until the GPU has drawn the last use of the section -
+		// the section is never written while the fence is unsignalled,
+		// so a wait that times out is waited on again, and a wait that
+		// fails waits for the whole GPU instead
+		if (NULL != m_sectionFences[section])
+		{
+			GLenum waitResult = glClientWaitSync((GLsync)m_sectionFences[section], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+			while (waitResult == GL_TIMEOUT_EXPIRED)
+			{
+				waitResult = glClientWaitSync((GLsync)m_sectionFences[section], 0, FENCE_TIMEOUT_NS);
+			}
+			if (waitResult == GL_WAIT_FAILED)
+			{
+				glFinish();
+			}
+			glDeleteSync((GLsync)m_sectionFences[section]);
+			m_sectionFences[section] = NULL;
+		}
+		pSection = m_pMappedInstances + (size_t)section * m_capacity * INSTANCE_FLOATS;
+	}
+	else
+	{
+		pSection = m_stagingInstances.data();
+	}
+	for (PARTICLE_EMITTER& emitter : m_emitters)
+	{
+		emitter.pInstances = pSection + (size_t)emitter.firstInstance * INSTANCE_FLOATS;
+	}
+
+	// start the emitter threads, update the first emitter here,
+	// and wait for the rest
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_workSeconds = elapsedSeconds;
+		m_pendingWorkers = (int)m_workers.size();
+		m_workGeneration++;
+	}
+	m_workReady.notify_all();
+	UpdateEmitter(m_emitters[0], elapsedSeconds);
+	{
+		std::unique_lock<std::mutex> lock(m_workMutex);
+		m_workDone.wait(lock, [this]() { return(0 == m_pendingWorkers); });
+	}
+
+	if (NULL == m_pMappedInstances)
+	{
+		// orphan the old storage so the upload never waits for
+		// the GPU to finish drawing from it
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer.Get());
+		glBufferData(GL_ARRAY_BUFFER, (size_t)m_capacity * INSTANCE_BYTES, NULL, GL_STREAM_DRAW);
+		for (const PARTICLE_EMITTER& emitter : m_emitters)
+		{
+			glBufferSubData(GL_ARRAY_BUFFER,
+				(size_t)emitter.firstInstance * INSTANCE_BYTES,
+				(size_t)emitter.drawCount * INSTANCE_BYTES,
+				emitter.pInstances);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	m_drawSection = section;
+
+	double updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_totalUpdateMs += updateMs;
+	m_maxUpdateMs = (updateMs > m_maxUpdateMs) ? updateMs : m_maxUpdateMs;
+	m_updateCount++;
+	if (updateMs > UPDATE_BUDGET_MS)
+	{
+		m_overBudgetCount++;
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is the loop of one emitter thread - it waits
+ *  for an update to start, updates its emitter and reports
+ *  back, until the particles are destroyed.
+ ***********************************************************/
+void CandleParticles::WorkerLoop(int emitterIndex)
+{
+	TraceRecorder::SetThreadName("candle particles");
+
+	uint64_t lastGeneration = 0;
+	while (true)
+	{
+		float elapsedSeconds = 0.0f;
+		{
+			std::unique_lock<std::mutex> lock(m_workMutex);
+			m_workReady.wait(lock, [&]() { return(m_bShutdown || (m_workGeneration != lastGeneration)); });
+			if (true == m_bShutdown)
+			{
+				return;
+			}
+			lastGeneration = m_workGeneration;
+			elapsedSeconds = m_workSeconds;
+		}
+
+		UpdateEmitter(m_emitters[emitterIndex], elapsedSeconds);
+
+		{
+			std::lock_guard<std::mutex> lock(m_workMutex);
+			m_pendingWorkers--;
+		}
+		m_workDone.notify_one();
+	}
+}
+
+/***********************************************************
+ *  UpdateEmitter()
+ *
+ *  This method is used to move the particles of an emitter,
+ *  retire the ones that have lived out their life, emit new
+ *  ones and write out the instances to draw.
+ ***********************************************************/
+void CandleParticles::UpdateEmitter(PARTICLE_EMITTER& emitter, float elapsedSeconds)
+{
+	TRACE_SCOPE("CandleParticles::UpdateEmitter");
+
+	const EMITTER_SETTINGS& settings = *emitter.pSettings;
+	float damping = std::exp(-settings.damping * elapsedSeconds);
+
+	int first = 0;
+#ifdef PARTICLES_X86
+	if (true == m_bUseAVX2)
+	{
+		first = SimulateAVX2(
+			emitter.positionX.data(), emitter.positionY.data(), emitter.positionZ.data(),
+			emitter.velocityX.data(), emitter.velocityY.data(), emitter.velocityZ.data(),
+			emitter.swirlX.data(), emitter.swirlZ.data(), emitter.age.data(),
+			emitter.count, elapsedSeconds, settings.buoyancy, damping);
+	}
+#endif
+	SimulateScalar(
+		emitter.positionX.data(), emitter.positionY.data(), emitter.positionZ.data(),
+		emitter.velocityX.data(), emitter.velocityY.data(), emitter.velocityZ.data(),
+		emitter.swirlX.data(), emitter.swirlZ.data(), emitter.age.data(),
+		first, emitter.count, elapsedSeconds, settings.buoyancy, damping);
+
+	RemoveDeadParticles(emitter);
+	EmitParticles(emitter, elapsedSeconds);
+	WriteInstances(emitter);
+}
+
+/***********************************************************
+ *  RemoveDeadParticles()
+ *
+ *  This method is used to retire the particles that have
+ *  lived out their life, by moving the last particle into
+ *  each free place so the arrays stay packed.
+ ***********************************************************/
+void CandleParticles::RemoveDeadParticles(PARTICLE_EMITTER& emitter)
+{
+	int i = 0;
+	while (i < emitter.count)
+	{
+		if ((emitter.age[i] * emitter.inverseLife[i]) < 1.0f)
+		{
+			i++;
+			continue;
+		}
+
+		int last = --emitter.count;
+		emitter.positionX[i] = emitter.positionX[last];
+		emitter.positionY[i] = emitter.positionY[last];
+		emitter.positionZ[i] = emitter.positionZ[last];
+		emitter.velocityX[i] = emitter.velocityX[last];
+		emitter.velocityY[i] = emitter.velocityY[last];
+		emitter.velocityZ[i] = emitter.velocityZ[last];
+		emitter.swirlX[i] = emitter.swirlX[last];
+		emitter.swirlZ[i] = emitter.swirlZ[last];
+		emitter.age[i] = emitter.age[last];
+		emitter.inverseLife[i] = emitter.inverseLife[last];
+	}
+}
+
+/***********************************************************
+ *  EmitParticles()
+ *
+ *  This method is used to emit new particles at the rate
+ *  that keeps the emitter about full.
+ ***********************************************************/
+void CandleParticles::EmitParticles(PARTICLE_EMITTER& emitter, float elapsedSeconds)
+{
+	const EMITTER_SETTINGS& settings = *emitter.pSettings;
+	float averageLife = 0.5f * (settings.minLifeSeconds + settings.maxLifeSeconds);
+
+	emitter.pendingParticles += (emitter.capacity / averageLife) * elapsedSeconds;
+	int newParticles = (int)emitter.pendingParticles;
+	emitter.pendingParticles -= (float)newParticles;
+
+	uint32_t& random = emitter.randomState;
+	for (int n = 0; (n < newParticles) && (emitter.count < emitter.capacity); n++)
+	{
+		int i = emitter.count++;
+
+		// a point on the disc around the origin
+		float angle = NextRandom(random) * 6.2831853f;
+		float radius = settings.originRadius * std::sqrt(NextRandom(random));
+		emitter.positionX[i] = settings.origin.x + radius * std::cos(angle);
+		emitter.positionY[i] = settings.origin.y;
+		emitter.positionZ[i] = settings.origin.z + radius * std::sin(angle);
+
+		emitter.velocityX[i] = (NextRandom(random) - 0.5f) * 2.0f * settings.sideSpeed;
+		emitter.velocityY[i] = settings.minRiseSpeed + (settings.maxRiseSpeed - settings.minRiseSpeed) * NextRandom(random);
+		emitter.velocityZ[i] = (NextRandom(random) - 0.5f) * 2.0f * settings.sideSpeed;
+		emitter.swirlX[i] = (NextRandom(random) - 0.5f) * 2.0f * settings.swirl;
+		emitter.swirlZ[i] = (NextRandom(random) - 0.5f) * 2.0f * settings.swirl;
+
+		emitter.age[i] = 0.0f;
+		emitter.inverseLife[i] = 1.0f /
+			(settings.minLifeSeconds + (settings.maxLifeSeconds - settings.minLifeSeconds) * NextRandom(random));
+	}
+}
+
+/***********************************************************
+ *  WriteInstances()
+ *
+ *  This method is used to write the position, size and color
+ *  of every particle into the instances to draw, eight at a
+ *  time with AVX2 when the processor has it.
+ ***********************************************************/
+void CandleParticles::WriteInstances(PARTICLE_EMITTER& emitter)
+{
+	const EMITTER_SETTINGS& settings = *emitter.pSettings;
+
+	int first = 0;
+#ifdef PARTICLES_X86
+	if (true == m_bUseAVX2)
+	{
+		first = WriteInstancesAVX2(
+			emitter.positionX.data(), emitter.positionY.data(), emitter.positionZ.data(),
+			emitter.age.data(), emitter.inverseLife.data(), emitter.count,
+			settings, emitter.pInstances);
+	}
+#endif
+
+	float* pInstance = emitter.pInstances + (size_t)first * INSTANCE_FLOATS;
+	for (int i = first; i < emitter.count; i++)
+	{
+		float t = emitter.age[i] * emitter.inverseLife[i];
+		glm::vec4 color = settings.startColor + (settings.endColor - settings.startColor) * t;
+		if ((settings.fadeInFraction > 0.0f) && (t < settings.fadeInFraction))
+		{
+			color.a *= t / settings.fadeInFraction;
+		}
+
+		pInstance[0] = emitter.positionX[i];
+		pInstance[1] = emitter.positionY[i];
+		pInstance[2] = emitter.positionZ[i];
+		pInstance[3] = settings.startHalfSize + (settings.endHalfSize - settings.startHalfSize) * t;
+		pInstance[4] = color.r;
+		pInstance[5] = color.g;
+		pInstance[6] = color.b;
+		pInstance[7] = color.a;
+		pInstance += INSTANCE_FLOATS;
+	}
+
+	emitter.drawCount = emitter.count;
+}
+
+/***********************************************************
+ *  BindInstances()
+ *
+ *  This method is used to point the instance values at the
+ *  instances of an emitter in a section of the buffer.
+ ***********************************************************/
+void CandleParticles::BindInstances(int section, int firstInstance)
+{
+	size_t offset = ((size_t)section * m_capacity + firstInstance) * INSTANCE_BYTES;
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, INSTANCE_BYTES, (const void*)offset);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, INSTANCE_BYTES, (const void*)(offset + 4 * sizeof(float)));
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used to draw the smoke and then the flame
+ *  as billboards, one instanced draw each.  The particles do
+ *  not write depth, so they never hide each other.
+ ***********************************************************/
+void CandleParticles::Render(const glm::mat4& view, const glm::mat4& projection)
+{
+	if (0 == m_vertexArray)
+	{
+		return;
+	}
+
+	TRACE_SCOPE("CandleParticles::Render");
+
+	GLint sceneProgram = 0;
+	GLint sceneVertexArray = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &sceneProgram);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &sceneVertexArray);
+
+	m_renderProgram.Use();
+	glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(m_projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
+	RenderStats::Count(RenderStats::UNIFORM_UPDATES, 2);
+
+	glBindVertexArray(m_vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer.Get());
+	glDepthMask(GL_FALSE);
+
+	for (int i = TOTAL_EMITTERS - 1; i >= 0; i--)
+	{
+		const PARTICLE_EMITTER& emitter = m_emitters[i];
+		if (0 == emitter.drawCount)
+		{
+			continue;
+		}
+
+		glBlendFunc(GL_SRC_ALPHA, emitter.pSettings->bAdditive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+		BindInstances((NULL != m_pMappedInstances) ? m_drawSection : 0, emitter.firstInstance);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, emitter.drawCount);
+		RenderStats::Count(RenderStats::DRAW_CALLS);
+	}
+
+	// put back the scene state
+	glDepthMask(GL_TRUE);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(sceneVertexArray);
+	glUseProgram(sceneProgram);
+	RenderStats::Count(RenderStats::PROGRAM_SWITCHES);
+
+	// the section can be written again once the GPU is done
+	if (NULL != m_pMappedInstances)
+	{
+		if (NULL != m_sectionFences[m_drawSection])
+		{
+			glDeleteSync((GLsync)m_sectionFences[m_drawSection]);
+		}
+		m_sectionFences[m_drawSection] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print the average and slowest
+ *  update times.
+ ***********************************************************/
+void CandleParticles::PrintReport() const
+{
+	if (0 == m_updateCount)
+	{
+		return;
+	}
+
+	int liveParticles = 0;
+	for (const PARTICLE_EMITTER& emitter : m_emitters)
+	{
+		liveParticles += emitter.count;
+	}
+
+	std::cout << "PARTICLES: live:" << liveParticles
+		<< ", updates:" << m_updateCount
+		<< ", average ms:" << (m_totalUpdateMs / m_updateCount)
+		<< ", max ms:" << m_maxUpdateMs
+		<< ", budget ms:" << UPDATE_BUDGET_MS
+		<< ", over budget:" << m_overBudgetCount
+		<< ", kernel:" << (m_bUseAVX2 ? "AVX2" : "scalar") << std::endl;
+}
@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// candleparticles.h
+// ============
+// CPU particles for the candle flame and smoke - structure of arrays storage,
+// AVX2 update kernels and one thread per emitter, streamed to the GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GpuResourceTracker.h"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  CandleParticles
+ *
+ *  This class simulates the candle flame and its smoke on
+ *  the CPU, for OpenGL contexts without compute shaders.
+ *  Each emitter keeps its particles as separate arrays of
+ *  each value, so the update runs eight particles at a time
+ *  with AVX2 when the processor has it, and each emitter is
+ *  updated on its own thread.  The threads write the draw
+ *  values straight into a persistently mapped buffer when
+ *  the context has OpenGL 4.4, and into a copy that is
+ *  uploaded otherwise.  The flicker of the flame is also
+ *  worked out here, for the candle light.
+ ***********************************************************/
+class CandleParticles
+{
+public:
+	// constructor
+	CandleParticles(int capacity, bool bForceScalar);
+	// destructor
+	~CandleParticles();
+
+	// build the shader program and the instance buffer, and
+	// start the emitter threads
+	bool Initialize();
+
+	// simulate the flame and smoke forward by the passed in time
+	// and write out the values to draw
+	void Update(float elapsedSeconds);
+	// draw the particles written by the last update
+	void Render(const glm::mat4& view, const glm::mat4& projection);
+
+	// brightness of the flame, around 1, for the candle light
+	float GetFlicker() const { return(m_flicker); }
+
+	// print the update times
+	void PrintReport() const;
+
+	// how one kind of particle is emitted and moves
+	struct EMITTER_SETTINGS;
+
+private:
+	// the particles of one emitter, one array per value
+	struct PARTICLE_EMITTER
+	{
+		const EMITTER_SETTINGS* pSettings;
+		int capacity;
+		int count;
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+		std::vector<float> velocityX;
+		std::vector<float> velocityY;
+		std::vector<float> velocityZ;
+		std::vector<float> swirlX;
+		std::vector<float> swirlZ;
+		std::vector<float> age;
+		std::vector<float> inverseLife;
+		// fraction of a particle carried over to the next update
+		float pendingParticles;
+		uint32_t randomState;
+		// first instance of the emitter in the instance buffer,
+		// and where the current update writes its instances
+		int firstInstance;
+		float* pInstances;
+		// number of instances written by the last update
+		int drawCount;
+	};
+
+	static const int TOTAL_EMITTERS = 2;
+
+	PARTICLE_EMITTER m_emitters[TOTAL_EMITTERS];
+	int m_capacity;
+	bool m_bUseAVX2;
+	float m_time;
+	float m_flicker;
+	uint32_t m_flickerRandom;
+
+	// the instance buffer is split into sections that are written
+	// in turn, so the CPU never writes what the GPU is reading
+	GLBufferHandle m_instanceBuffer;
+	float* m_pMappedInstances;
+	std::vector<float> m_stagingInstances;
+	int m_sectionCount;
+	int m_drawSection;
+	void* m_sectionFences[3];
+	uint32_t m_vertexArray;
+
+	ShaderProgram m_renderProgram;
+	int m_viewLocation;
+	int m_projectionLocation;
+
+	// the emitter threads, one for every emitter after the
+	// first, which is updated on the calling thread
+	std::vector<std::thread> m_workers;
+	std::mutex m_workMutex;
+	std::condition_variable m_workReady;
+	std::condition_variable m_workDone;
+	uint64_t m_workGeneration;
+	int m_pendingWorkers;
+	float m_workSeconds;
+	bool m_bShutdown;
+
+	// update timing
+	double m_totalUpdateMs;
+	double m_maxUpdateMs;
+	int m_updateCount;
+	int m_overBudgetCount;
+
+	// the loop of one emitter thread
+	void WorkerLoop(int emitterIndex);
+	// move, retire, emit and write out one emitter
+	void UpdateEmitter(PARTICLE_EMITTER& emitter, float elapsedSeconds);
+	void RemoveDeadParticles(PARTICLE_EMITTER& emitter);
+	void EmitParticles(PARTICLE_EMITTER& emitter, float elapsedSeconds);
+	void WriteInstances(PARTICLE_EMITTER& emitter);
+	// point the instance values at a section of the buffer
+	void BindInstances(int section, int firstInstance);
+};
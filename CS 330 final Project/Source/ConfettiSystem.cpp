@@ -0,0 +1,337 @@
+///////////////////////////////////////////////////////////////////////////////
+// confettisystem.cpp
+// ============
+// GPU confetti - a particle system that is emitted, simulated, packed and
+// drawn entirely by compute shaders and indirect commands
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ConfettiSystem.h"
+#include "HitchDetector.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the shader files of the confetti
+	const char* const CONFETTI_COMPUTE_SHADER_FILE = "shaders/confettiComputeShader.glsl";
+	const char* const CONFETTI_VERTEX_SHADER_FILE = "shaders/confettiVertexShader.glsl";
+	const char* const CONFETTI_FRAGMENT_SHADER_FILE = "shaders/confettiFragmentShader.glsl";
+
+	// the buffer bindings used by the shaders
+	const GLuint SOURCE_BINDING = 0;
+	const GLuint TARGET_BINDING = 1;
+	const GLuint CONTROL_BINDING = 2;
+
+	// threads per group of the update and emit passes - this
+	// must match GROUP_SIZE in the compute shader
+	const unsigned int GROUP_SIZE = 256;
+
+	// the layout of one particle and of the control buffer in
+	// the shaders
+	const size_t PARTICLE_BYTES = 4 * 4 * sizeof(float);
+	struct CONTROL_BLOCK
+	{
+		GLuint dispatchCommand[4];
+		GLuint drawCommand[4];
+		GLuint sourceCount;
+		GLuint targetCount;
+		GLuint padding[2];
+	};
+	// byte offsets of the indirect commands in the control buffer
+	const GLintptr DISPATCH_COMMAND_OFFSET = 0;
+	const GLintptr DRAW_COMMAND_OFFSET = 4 * sizeof(GLuint);
+
+	// how the confetti moves
+	const glm::vec3 CONFETTI_GRAVITY = glm::vec3(0.0f, -9.8f, 0.0f);
+	const glm::vec3 CONFETTI_WIND = glm::vec3(0.4f, -0.6f, 0.1f);
+	const float CONFETTI_DRAG = 2.5f;
+	const float CONFETTI_FLOOR_HEIGHT = 0.01f;
+	const float CONFETTI_SPEED = 9.0f;
+	const float CONFETTI_LIFE_SECONDS = 8.0f;
+}
+
+/***********************************************************
+ *  ConfettiSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ConfettiSystem::ConfettiSystem(int capacity)
+{
+	m_capacity = capacity;
+	m_time = 0.0f;
+	m_emitSerial = 0;
+	m_sourceBuffer = 0;
+	m_emitterCount = 0;
+	m_vertexArray = 0;
+	m_uniforms = { -1, -1, -1, -1, -1, -1, -1 };
+}
+
+/***********************************************************
+ *  ~ConfettiSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ConfettiSystem::~ConfettiSystem()
+{
+	if (0 != m_vertexArray)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		m_vertexArray = 0;
+	}
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method returns whether the OpenGL context has the
+ *  compute shaders and storage buffers of OpenGL 4.3.  The
+ *  macOS contexts stop at OpenGL 4.1.
+ ***********************************************************/
+bool ConfettiSystem::IsSupported()
+{
+#ifdef __APPLE__
+	return(false);
+#else
+	GLint majorVersion = 0;
+	GLint minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+	return((majorVersion > 4) || ((majorVersion == 4) && (minorVersion >= 3)));
+#endif
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to build the programs of the passes
+ *  and to create the particle buffers.  The buffers are
+ *  never read or written by the CPU after this.
+ ***********************************************************/
+bool ConfettiSystem::Initialize()
+{
+	TRACE_SCOPE("ConfettiSystem::Initialize");
+
+	if ((m_preparePass.LoadCompute(CONFETTI_COMPUTE_SHADER_FILE, "#define PASS_PREPARE") == false) ||
+		(m_updatePass.LoadCompute(CONFETTI_COMPUTE_SHADER_FILE, "#define PASS_UPDATE") == false) ||
+		(m_emitPass.LoadCompute(CONFETTI_COMPUTE_SHADER_FILE, "#define PASS_EMIT") == false) ||
+		(m_finishPass.LoadCompute(CONFETTI_COMPUTE_SHADER_FILE, "#define PASS_FINISH") == false) ||
+		(m_renderProgram.LoadGraphics(CONFETTI_VERTEX_SHADER_FILE, CONFETTI_FRAGMENT_SHADER_FILE) == false))
+	{
+		return(false);
+	}
+
+	// the values that never change are set once
+	glProgramUniform3fv(m_updatePass.Get(), m_updatePass.GetUniformLocation("gravity"), 1, glm::value_ptr(CONFETTI_GRAVITY));
+	glProgramUniform3fv(m_updatePass.Get(), m_updatePass.GetUniformLocation("wind"), 1, glm::value_ptr(CONFETTI_WIND));
+	glProgramUniform1f(m_updatePass.Get(), m_updatePass.GetUniformLocation("drag"), CONFETTI_DRAG);
+	glProgramUniform1f(m_updatePass.Get(), m_updatePass.GetUniformLocation("floorHeight"), CONFETTI_FLOOR_HEIGHT);
+	glProgramUniform1ui(m_emitPass.Get(), m_emitPass.GetUniformLocation("capacity"), (GLuint)m_capacity);
+	glProgramUniform1f(m_emitPass.Get(), m_emitPass.GetUniformLocation("emitSpeed"), CONFETTI_SPEED);
+	glProgramUniform1f(m_emitPass.Get(), m_emitPass.GetUniformLocation("emitLife"), CONFETTI_LIFE_SECONDS);
+	glProgramUniform1ui(m_finishPass.Get(), m_finishPass.GetUniformLocation("capacity"), (GLuint)m_capacity);
+
+	m_uniforms.deltaTime = m_updatePass.GetUniformLocation("deltaTime");
+	m_uniforms.time = m_updatePass.GetUniformLocation("time");
+	m_uniforms.emitCount = m_emitPass.GetUniformLocation("emitCount");
+	m_uniforms.emitSeed = m_emitPass.GetUniformLocation("emitSeed");
+	m_uniforms.emitPosition = m_emitPass.GetUniformLocation("emitPosition");
+	m_uniforms.view = m_renderProgram.GetUniformLocation("view");
+	m_uniforms.projection = m_renderProgram.GetUniformLocation("projection");
+
+	// the particle buffers start with nothing alive
+	size_t particleBytes = (size_t)m_capacity * PARTICLE_BYTES;
+	for (int i = 0; i < 2; i++)
+	{
+		m_particleBuffers[i].Create("ConfettiSystem particles", GPU_RESOURCE_SITE);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleBuffers[i].Get());
+		glBufferData(GL_SHADER_STORAGE_BUFFER, particleBytes, NULL, GL_DYNAMIC_COPY);
+		m_particleBuffers[i].SetByteSize(particleBytes);
+	}
+
+	CONTROL_BLOCK control = {};
+	control.drawCommand[0] = 4;
+	m_controlBuffer.Create("ConfettiSystem control", GPU_RESOURCE_SITE);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_controlBuffer.Get());
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(control), &control, GL_DYNAMIC_COPY);
+	m_controlBuffer.SetByteSize(sizeof(control));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// the billboard corners come from the vertex index, so the
+	// vertex array has no attributes
+	glGenVertexArrays(1, &m_vertexArray);
+
+	std::cout << "INFO: GPU confetti ready for " << m_capacity << " particles, MB:"
+		<< ((particleBytes * 2) / (1024.0 * 1024.0)) << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  AddEmitter()
+ *
+ *  This method is used to add a place that emits confetti.
+ ***********************************************************/
+bool ConfettiSystem::AddEmitter(
+	glm::vec3 position,
+	float particlesPerSecond,
+	int burstCount,
+	float burstIntervalSeconds)
+{
+	if (m_emitterCount >= MAX_EMITTERS)
+	{
+		return(false);
+	}
+
+	EMITTER& emitter = m_emitters[m_emitterCount++];
+	emitter.position = position;
+	emitter.particlesPerSecond = particlesPerSecond;
+	emitter.burstCount = burstCount;
+	emitter.burstIntervalSeconds = burstIntervalSeconds;
+	emitter.pendingParticles = 0.0f;
+	emitter.burstTimer = 0.0f;
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to simulate the confetti forward.
+ *  The prepare pass sizes the update pass from the count of
+ *  living particles, the update pass moves and packs them
+ *  into the other buffer, the emit passes add the new
+ *  particles after them, and the finish pass records the
+ *  new count and the draw command.  The barriers make each
+ *  pass see the writes of the one before.
+ ***********************************************************/
+void ConfettiSystem::Update(float elapsedSeconds)
+{
+	if ((0 == m_vertexArray) || (elapsedSeconds <= 0.0f))
+	{
+		return;
+	}
+
+	TRACE_SCOPE("ConfettiSystem::Update");
+	HITCH_PHASE("Confetti");
+
+	m_time += elapsedSeconds;
+
+	// the passes set their own program, so the scene program is
+	// put back afterwards
+	GLint sceneProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &sceneProgram);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SOURCE_BINDING, m_particleBuffers[m_sourceBuffer].Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TARGET_BINDING, m_particleBuffers[1 - m_sourceBuffer].Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CONTROL_BINDING, m_controlBuffer.Get());
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_controlBuffer.Get());
+
+	m_preparePass.Use();
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+	m_updatePass.Use();
+	glUniform1f(m_uniforms.deltaTime, elapsedSeconds);
+	glUniform1f(m_uniforms.time, m_time);
+	glDispatchComputeIndirect(DISPATCH_COMMAND_OFFSET);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	m_emitPass.Use();
+	for (int i = 0; i < m_emitterCount; i++)
+	{
+		EMITTER& emitter = m_emitters[i];
+
+		// the steady stream carries the fraction of a particle
+		// over to the next step
+		emitter.pendingParticles += emitter.particlesPerSecond * elapsedSeconds;
+		unsigned int count = (unsigned int)emitter.pendingParticles;
+		emitter.pendingParticles -= (float)count;
+
+		if (emitter.burstIntervalSeconds > 0.0f)
+		{
+			emitter.burstTimer += elapsedSeconds;
+			if (emitter.burstTimer >= emitter.burstIntervalSeconds)
+			{
+				emitter.burstTimer -= emitter.burstIntervalSeconds;
+				count += (unsigned int)emitter.burstCount;
+			}
+		}
+
+		Emit(emitter.position, count);
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	m_finishPass.Use();
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	glUseProgram(sceneProgram);
+	RenderStats::Count(RenderStats::PROGRAM_SWITCHES);
+
+	// the packed buffer holds the particles from now on
+	m_sourceBuffer = 1 - m_sourceBuffer;
+}
+
+/***********************************************************
+ *  Emit()
+ *
+ *  This method is used to run one emit pass.  Only the count
+ *  and the position are sent - the particles themselves are
+ *  made up in the shader from the seed.
+ ***********************************************************/
+void ConfettiSystem::Emit(const glm::vec3& position, unsigned int count)
+{
+	if (0 == count)
+	{
+		return;
+	}
+
+	glUniform1ui(m_uniforms.emitCount, count);
+	glUniform1ui(m_uniforms.emitSeed, ++m_emitSerial * 0x9E3779B9u);
+	glUniform3fv(m_uniforms.emitPosition, 1, glm::value_ptr(position));
+	glDispatchCompute((count + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used to draw every living particle as a
+ *  billboard, with one instanced draw whose instance count
+ *  was written by the finish pass.
+ ***********************************************************/
+void ConfettiSystem::Render(const glm::mat4& view, const glm::mat4& projection)
+{
+	if (0 == m_vertexArray)
+	{
+		return;
+	}
+
+	TRACE_SCOPE("ConfettiSystem::Render");
+
+	GLint sceneProgram = 0;
+	GLint sceneVertexArray = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &sceneProgram);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &sceneVertexArray);
+
+	m_renderProgram.Use();
+	glUniformMatrix4fv(m_uniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(m_uniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+	RenderStats::Count(RenderStats::UNIFORM_UPDATES, 2);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SOURCE_BINDING, m_particleBuffers[m_sourceBuffer].Get());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_controlBuffer.Get());
+	glBindVertexArray(m_vertexArray);
+	glDrawArraysIndirect(GL_TRIANGLE_STRIP, (const void*)DRAW_COMMAND_OFFSET);
+	RenderStats::Count(RenderStats::DRAW_CALLS);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(sceneVertexArray);
+	glUseProgram(sceneProgram);
+	RenderStats::Count(RenderStats::PROGRAM_SWITCHES);
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// confettisystem.h
+// ============
+// GPU confetti - a particle system that is emitted, simulated, packed and
+// drawn entirely by compute shaders and indirect commands
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GpuResourceTracker.h"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ConfettiSystem
+ *
+ *  This class runs confetti on the GPU.  The particles live
+ *  in two shader storage buffers that swap roles every step
+ *  - the update pass copies the living particles of one into
+ *  the other, packed together, and the emit passes add new
+ *  particles after them.  The counts and the indirect
+ *  dispatch and draw commands are written by the shaders as
+ *  well, so the CPU only issues dispatches and one instanced
+ *  draw, and never touches a particle.  It needs OpenGL 4.3
+ *  for compute shaders.
+ ***********************************************************/
+class ConfettiSystem
+{
+public:
+	// constructor
+	ConfettiSystem(int capacity);
+	// destructor
+	~ConfettiSystem();
+
+	// check whether the OpenGL context has compute shaders
+	static bool IsSupported();
+
+	// build the shader programs and the particle buffers
+	bool Initialize();
+
+	// add a place that emits confetti - a steady stream of the
+	// passed in particles per second, and a burst of the passed
+	// in count every interval when the interval is positive
+	bool AddEmitter(
+		glm::vec3 position,
+		float particlesPerSecond,
+		int burstCount,
+		float burstIntervalSeconds);
+
+	// simulate the confetti forward by the passed in time
+	void Update(float elapsedSeconds);
+	// draw the confetti with the view of the last prepared frame
+	void Render(const glm::mat4& view, const glm::mat4& projection);
+
+private:
+	// the most emitters that can be added
+	static const int MAX_EMITTERS = 8;
+
+	struct EMITTER
+	{
+		glm::vec3 position;
+		float particlesPerSecond;
+		int burstCount;
+		float burstIntervalSeconds;
+		// fractions of a particle and of an interval carried over
+		float pendingParticles;
+		float burstTimer;
+	};
+
+	// most particles that can be alive at once
+	int m_capacity;
+	// seconds of simulation so far
+	float m_time;
+	// number of emit passes so far, which seeds the next one
+	unsigned int m_emitSerial;
+	// the buffer that holds the living particles
+	int m_sourceBuffer;
+
+	EMITTER m_emitters[MAX_EMITTERS];
+	int m_emitterCount;
+
+	// the particle buffers, and the counts and commands
+	GLBufferHandle m_particleBuffers[2];
+	GLBufferHandle m_controlBuffer;
+	// the empty vertex array the billboards are drawn with
+	uint32_t m_vertexArray;
+
+	// the locations of the uniforms set every step - the rest
+	// are set once when the programs are built
+	struct UNIFORM_LOCATIONS
+	{
+		int deltaTime;
+		int time;
+		int emitCount;
+		int emitSeed;
+		int emitPosition;
+		int view;
+		int projection;
+	};
+	UNIFORM_LOCATIONS m_uniforms;
+
+	ShaderProgram m_preparePass;
+	ShaderProgram m_updatePass;
+	ShaderProgram m_emitPass;
+	ShaderProgram m_finishPass;
+	ShaderProgram m_renderProgram;
+
+	// run one emit pass
+	void Emit(const glm::vec3& position, unsigned int count);
+};
@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// watch files for changes on disk - inotify on Linux, and polling of the file
+// times everywhere else
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <chrono>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// seconds between checks of the file times when polling
+	const double POLL_INTERVAL_SECONDS = 0.25;
+
+	/***********************************************************
+	 *  GetSeconds()
+	 *
+	 *  This function returns a steady time in seconds.
+	 ***********************************************************/
+	double GetSeconds()
+	{
+		return(std::chrono::duration<double>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+}
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_lastPollTime = 0.0;
+	m_notifyHandle = -1;
+
+#ifdef __linux__
+	m_notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (m_notifyHandle >= 0)
+	{
+		close(m_notifyHandle);
+		m_notifyHandle = -1;
+	}
+#endif
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used to start watching a file.  With
+ *  inotify the directory of the file is watched, since a
+ *  file that is replaced by a rename gets a new inode.
+ ***********************************************************/
+void FileWatcher::AddFile(const std::string& filename)
+{
+	if (m_files.find(filename) != m_files.end())
+	{
+		return;
+	}
+
+	WATCHED_FILE state = { 0, 0 };
+	ReadFileState(filename, state);
+	m_files[filename] = state;
+
+#ifdef __linux__
+	if (m_notifyHandle >= 0)
+	{
+		std::string directory = GetDirectory(filename);
+		int watch = inotify_add_watch(m_notifyHandle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watch >= 0)
+		{
+			m_watchedDirectories[watch] = directory;
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to stop watching every file.
+ ***********************************************************/
+void FileWatcher::Clear()
+{
+#ifdef __linux__
+	for (const std::pair<const int, std::string>& directory : m_watchedDirectories)
+	{
+		inotify_rm_watch(m_notifyHandle, directory.first);
+	}
+#endif
+	m_watchedDirectories.clear();
+	m_files.clear();
+}
+
+/***********************************************************
+ *  Poll()
+ *
+ *  This method is used to find the watched files that have
+ *  been written since the last call.  Each changed file is
+ *  added to the list once, however many times it was
+ *  written.  It never blocks.
+ ***********************************************************/
+bool FileWatcher::Poll(std::vector<std::string>& changedFiles)
+{
+	size_t firstChange = changedFiles.size();
+
+#ifdef __linux__
+	if (m_notifyHandle >= 0)
+	{
+		// the events are variable length records, aligned for
+		// the event struct
+		alignas(struct inotify_event) char buffer[4096];
+		ssize_t length = 0;
+		while ((length = read(m_notifyHandle, buffer, sizeof(buffer))) > 0)
+		{
+			ssize_t offset = 0;
+			while (offset < length)
+			{
+				const struct inotify_event* pEvent = (const struct inotify_event*)(buffer + offset);
+				offset += sizeof(struct inotify_event) + pEvent->len;
+
+				std::map<int, std::string>::const_iterator directory = m_watchedDirectories.find(pEvent->wd);
+				if ((directory == m_watchedDirectories.end()) || (pEvent->len == 0))
+				{
+					continue;
+				}
+
+				std::string filename = pEvent->name;
+				if (directory->second != ".")
+				{
+					filename = directory->second + "/" + pEvent->name;
+				}
+				if (m_files.find(filename) == m_files.end())
+				{
+					continue;
+				}
+
+				bool bListed = false;
+				for (size_t i = firstChange; i < changedFiles.size(); i++)
+				{
+					if (changedFiles[i] == filename)
+					{
+						bListed = true;
+					}
+				}
+				if (false == bListed)
+				{
+					changedFiles.push_back(filename);
+				}
+			}
+		}
+
+		return(changedFiles.size() > firstChange);
+	}
+#endif
+
+	// without inotify, check the file times a few times a second
+	double now = GetSeconds();
+	if ((now - m_lastPollTime) < POLL_INTERVAL_SECONDS)
+	{
+		return(false);
+	}
+	m_lastPollTime = now;
+
+	for (std::pair<const std::string, WATCHED_FILE>& file : m_files)
+	{
+		WATCHED_FILE state = { 0, 0 };
+		if (false == ReadFileState(file.first, state))
+		{
+			// the file may be part way through being replaced
+			continue;
+		}
+
+		if ((state.modifiedTime != file.second.modifiedTime) || (state.size != file.second.size))
+		{
+			file.second = state;
+			changedFiles.push_back(file.first);
+		}
+	}
+
+	return(changedFiles.size() > firstChange);
+}
+
+/***********************************************************
+ *  ReadFileState()
+ *
+ *  This method is used to read the modified time and size
+ *  of a file.  It returns false if the file cannot be read.
+ ***********************************************************/
+bool FileWatcher::ReadFileState(const std::string& filename, WATCHED_FILE& state)
+{
+	struct stat fileStat;
+	if (stat(filename.c_str(), &fileStat) != 0)
+	{
+		return(false);
+	}
+
+	state.modifiedTime = (long long)fileStat.st_mtime;
+	state.size = (long long)fileStat.st_size;
+	return(true);
+}
+
+/***********************************************************
+ *  GetDirectory()
+ *
+ *  This method returns the directory part of a file name,
+ *  without the trailing separator, or "." for a bare name.
+ ***********************************************************/
+std::string FileWatcher::GetDirectory(const std::string& filename)
+{
+	size_t separator = filename.find_last_of("/\\");
+	if (separator == std::string::npos)
+	{
+		return(".");
+	}
+
+	return(filename.substr(0, separator));
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// watch files for changes on disk - inotify on Linux, and polling of the file
+// times everywhere else
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class reports the watched files that have been
+ *  written since the last call to Poll().  On Linux the
+ *  directories of the files are watched with inotify, which
+ *  costs nothing until a file is written.  Elsewhere the
+ *  modified time and size of every file are checked a few
+ *  times a second.  Editors that save by writing a new file
+ *  and renaming it over the old one are caught either way.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// start watching a file - watching it again does nothing
+	void AddFile(const std::string& filename);
+	// stop watching every file
+	void Clear();
+
+	// add the watched files written since the last call to the
+	// passed in list - returns true if there were any
+	bool Poll(std::vector<std::string>& changedFiles);
+
+private:
+	struct WATCHED_FILE
+	{
+		long long modifiedTime;
+		long long size;
+	};
+
+	// the watched files and their last known state
+	std::map<std::string, WATCHED_FILE> m_files;
+	// seconds of the last time the files were checked
+	double m_lastPollTime;
+
+	// the inotify instance and the watched directories by
+	// watch descriptor
+	int m_notifyHandle;
+	std::map<int, std::string> m_watchedDirectories;
+
+	// read the modified time and size of a file
+	static bool ReadFileState(const std::string& filename, WATCHED_FILE& state);
+	// the directory part of a file name, or "." for none
+	static std::string GetDirectory(const std::string& filename);
+};
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// per-frame linear arena - transient data for one frame is carved out of a
+// block allocated once at startup and released all at once when the frame ends
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+
+#include <cstdint>
+#include <iostream>
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena(size_t capacityBytes)
+{
+	m_pMemory = new unsigned char[capacityBytes];
+	m_capacity = capacityBytes;
+	m_offset = 0;
+	m_peak = 0;
+	m_bReportedFull = false;
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	delete[] m_pMemory;
+	m_pMemory = NULL;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used to carve the passed in number of
+ *  bytes out of the arena, aligned to the passed in power
+ *  of two.
+ ***********************************************************/
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	uintptr_t base = (uintptr_t)m_pMemory;
+	uintptr_t start = (base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	size_t end = (size_t)(start - base) + bytes;
+
+	if (end > m_capacity)
+	{
+		if (false == m_bReportedFull)
+		{
+			std::cerr << "ERROR: the frame arena is full - increase its capacity" << std::endl;
+			m_bReportedFull = true;
+		}
+		return(NULL);
+	}
+
+	m_offset = end;
+	if (m_offset > m_peak)
+	{
+		m_peak = m_offset;
+	}
+
+	return((void*)start);
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used to release everything allocated
+ *  during the frame.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	m_offset = 0;
+}
+
+/***********************************************************
+ *  GetUsedBytes()
+ *
+ *  This method returns the bytes in use this frame.
+ ***********************************************************/
+size_t FrameArena::GetUsedBytes() const
+{
+	return(m_offset);
+}
+
+/***********************************************************
+ *  GetPeakBytes()
+ *
+ *  This method returns the most bytes used by any frame.
+ ***********************************************************/
+size_t FrameArena::GetPeakBytes() const
+{
+	return(m_peak);
+}
+
+/***********************************************************
+ *  GetCapacity()
+ *
+ *  This method returns the size of the arena in bytes.
+ ***********************************************************/
+size_t FrameArena::GetCapacity() const
+{
+	return(m_capacity);
+}
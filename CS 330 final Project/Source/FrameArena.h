@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// per-frame linear arena - transient data for one frame is carved out of a
+// block allocated once at startup and released all at once when the frame ends
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class hands out memory for data that only lives for
+ *  the current frame.  Allocating only moves an offset, and
+ *  Reset() releases everything at once, so the render path
+ *  never calls the heap.  Destructors are not run, so only
+ *  plain data such as vectors and matrices belongs here.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena(size_t capacityBytes);
+	// destructor
+	~FrameArena();
+
+	// carve out memory for this frame - returns NULL when the
+	// arena is full, which means the capacity is too small
+	void* Allocate(size_t bytes, size_t alignment);
+
+	// carve out an array of plain data for this frame
+	template <typename T>
+	T* AllocateArray(size_t count)
+	{
+		return(static_cast<T*>(Allocate(sizeof(T) * count, alignof(T))));
+	}
+
+	// release everything allocated during the frame
+	void Reset();
+
+	// bytes in use this frame, the most used by any frame, and
+	// the size of the arena
+	size_t GetUsedBytes() const;
+	size_t GetPeakBytes() const;
+	size_t GetCapacity() const;
+
+private:
+	FrameArena(const FrameArena&);
+	FrameArena& operator=(const FrameArena&);
+
+	// the memory block and its size
+	unsigned char* m_pMemory;
+	size_t m_capacity;
+	// offset of the next free byte
+	size_t m_offset;
+	// highest offset reached by any frame
+	size_t m_peak;
+	// true once running out of space has been reported
+	bool m_bReportedFull;
+};
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+// framescheduler.cpp
+// ============
+// decide when a new frame actually needs to be rendered - tracks what has
+// changed since the last presented frame and idles the render loop otherwise
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameScheduler.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// default longest time to block waiting for window events -
+	// this bounds how late a change posted without an event
+	// can be noticed
+	const double DEFAULT_IDLE_TIMEOUT = 0.5;
+}
+
+/***********************************************************
+ *  FrameScheduler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameScheduler::FrameScheduler()
+{
+	m_bOnDemand = false;
+	m_idleTimeout = DEFAULT_IDLE_TIMEOUT;
+	// the very first frame always needs to be drawn
+	m_dirtyReasons = DIRTY_WINDOW;
+	m_bAnimating = false;
+	m_bInputActive = false;
+	m_idleWakeups = 0;
+}
+
+/***********************************************************
+ *  ~FrameScheduler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameScheduler::~FrameScheduler()
+{
+}
+
+/***********************************************************
+ *  SetOnDemand()
+ *
+ *  This method is used to turn the on-demand redraw mode
+ *  on or off.  When it is off, every loop iteration renders.
+ ***********************************************************/
+void FrameScheduler::SetOnDemand(bool bOnDemand)
+{
+	m_bOnDemand = bOnDemand;
+	m_dirtyReasons |= DIRTY_WINDOW;
+}
+
+/***********************************************************
+ *  IsOnDemand()
+ *
+ *  This method returns whether on-demand redraw is enabled.
+ ***********************************************************/
+bool FrameScheduler::IsOnDemand() const
+{
+	return(m_bOnDemand);
+}
+
+/***********************************************************
+ *  SetIdleTimeout()
+ *
+ *  This method is used to set the longest time, in seconds,
+ *  that the loop blocks while waiting for window events.
+ ***********************************************************/
+void FrameScheduler::SetIdleTimeout(double seconds)
+{
+	if (seconds > 0.0)
+	{
+		m_idleTimeout = seconds;
+	}
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used to flag that the next frame needs to
+ *  be rendered.  If the loop is currently blocked waiting
+ *  for events, an empty event is posted to wake it up so
+ *  changes made from worker threads are picked up at once.
+ ***********************************************************/
+void FrameScheduler::MarkDirty(unsigned int reasons)
+{
+	if (reasons == DIRTY_NONE)
+	{
+		return;
+	}
+
+	unsigned int previous = m_dirtyReasons.fetch_or(reasons);
+	if ((previous == DIRTY_NONE) && (true == m_bOnDemand))
+	{
+		glfwPostEmptyEvent();
+	}
+}
+
+/***********************************************************
+ *  SetAnimating()
+ *
+ *  This method is used to keep the loop rendering every
+ *  frame while something in the scene is animating.
+ ***********************************************************/
+void FrameScheduler::SetAnimating(bool bAnimating)
+{
+	bool bWasAnimating = m_bAnimating.exchange(bAnimating);
+	if ((bAnimating == true) && (bWasAnimating == false))
+	{
+		MarkDirty(DIRTY_ANIMATION);
+	}
+}
+
+/***********************************************************
+ *  SetInputActive()
+ *
+ *  This method is used to keep the loop rendering every
+ *  frame while a key that moves the camera is held down.
+ *  Held keys do not produce a steady stream of events, so
+ *  the loop must not block waiting for one.
+ ***********************************************************/
+void FrameScheduler::SetInputActive(bool bInputActive)
+{
+	m_bInputActive = bInputActive;
+}
+
+/***********************************************************
+ *  NeedsRedraw()
+ *
+ *  This method returns whether the next loop iteration needs
+ *  to render and present a new frame.
+ ***********************************************************/
+bool FrameScheduler::NeedsRedraw() const
+{
+	if (false == m_bOnDemand)
+	{
+		return(true);
+	}
+
+	return((m_dirtyReasons.load() != DIRTY_NONE) ||
+		(true == m_bAnimating.load()) ||
+		(true == m_bInputActive));
+}
+
+/***********************************************************
+ *  ProcessEvents()
+ *
+ *  This method is used to process the pending window events.
+ *  When nothing needs to be redrawn in on-demand mode it
+ *  blocks until an event arrives or the idle timeout passes,
+ *  instead of spinning through identical frames.
+ ***********************************************************/
+void FrameScheduler::ProcessEvents()
+{
+	if (true == NeedsRedraw())
+	{
+		glfwPollEvents();
+		return;
+	}
+
+	glfwWaitEventsTimeout(m_idleTimeout);
+	if (false == NeedsRedraw())
+	{
+		m_idleWakeups++;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to take and clear the dirty state for
+ *  the frame that is about to be rendered.  After that frame
+ *  is presented, the front buffer keeps showing it until
+ *  something is marked dirty again.
+ ***********************************************************/
+unsigned int FrameScheduler::BeginFrame()
+{
+	return(m_dirtyReasons.exchange(DIRTY_NONE));
+}
+
+/***********************************************************
+ *  GetIdleWakeups()
+ *
+ *  This method returns how many times the loop woke up
+ *  without anything to redraw.
+ ***********************************************************/
+unsigned long long FrameScheduler::GetIdleWakeups() const
+{
+	return(m_idleWakeups);
+}
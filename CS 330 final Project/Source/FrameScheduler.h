@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// framescheduler.h
+// ============
+// decide when a new frame actually needs to be rendered - tracks what has
+// changed since the last presented frame and idles the render loop otherwise
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+
+/***********************************************************
+ *  FrameScheduler
+ *
+ *  This class keeps track of the reasons the scene needs to
+ *  be redrawn.  In on-demand mode the render loop only draws
+ *  a new frame when something is dirty, and otherwise blocks
+ *  waiting for window events so the last presented frame
+ *  stays on screen without burning CPU or GPU time.
+ ***********************************************************/
+class FrameScheduler
+{
+public:
+	// constructor
+	FrameScheduler();
+	// destructor
+	~FrameScheduler();
+
+	// the reasons a frame can be marked dirty - these can be
+	// combined together as bit flags
+	enum DIRTY_REASON
+	{
+		DIRTY_NONE = 0,
+		DIRTY_INPUT = 1 << 0,
+		DIRTY_CAMERA = 1 << 1,
+		DIRTY_ANIMATION = 1 << 2,
+		DIRTY_ASSETS = 1 << 3,
+		DIRTY_WINDOW = 1 << 4
+	};
+
+	// turn the on-demand (event driven) redraw mode on or off
+	void SetOnDemand(bool bOnDemand);
+	bool IsOnDemand() const;
+
+	// set the longest time to block while waiting for events
+	void SetIdleTimeout(double seconds);
+
+	// flag that the next frame needs to be rendered - this is
+	// safe to call from any thread
+	void MarkDirty(unsigned int reasons);
+
+	// keep rendering every frame while an animation is running
+	void SetAnimating(bool bAnimating);
+
+	// keep rendering every frame while input is held down
+	void SetInputActive(bool bInputActive);
+
+	// check whether the next loop iteration needs to render
+	bool NeedsRedraw() const;
+
+	// process pending window events, blocking when nothing
+	// needs to be redrawn in on-demand mode
+	void ProcessEvents();
+
+	// take the dirty state for the frame about to be rendered -
+	// anything marked dirty while it renders causes another frame
+	unsigned int BeginFrame();
+
+	// number of loop iterations that skipped rendering
+	unsigned long long GetIdleWakeups() const;
+
+private:
+	// true when the event driven redraw mode is enabled
+	bool m_bOnDemand;
+	// longest time to block in the event wait, in seconds
+	double m_idleTimeout;
+	// the combined dirty reasons since the last frame
+	std::atomic<unsigned int> m_dirtyReasons;
+	// true while something is animating continuously
+	std::atomic<bool> m_bAnimating;
+	// true while a key that moves the camera is held down
+	bool m_bInputActive;
+	// number of wakeups that did not need a redraw
+	unsigned long long m_idleWakeups;
+};
@@ -0,0 +1,395 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresourcetracker.cpp
+// ============
+// GPU memory accounting - records every tracked OpenGL object with its owner,
+// creation site and size, and reports the live memory and any leaks
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuResourceTracker.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <iostream>
+#include <map>
+#include <mutex>
+
+// declaration of the global variables and defines
+namespace
+{
+	struct RESOURCE_RECORD
+	{
+		std::string owner;
+		const char* file;
+		int line;
+		size_t bytes;
+	};
+
+	// the live objects of each category by OpenGL object ID -
+	// objects may be created on loader threads, so access is
+	// guarded by the mutex
+	std::mutex g_TrackerMutex;
+	std::map<uint32_t, RESOURCE_RECORD> g_LiveResources[GpuResourceTracker::TOTAL_CATEGORIES];
+	size_t g_LiveBytes[GpuResourceTracker::TOTAL_CATEGORIES] = { 0 };
+	size_t g_PeakBytes[GpuResourceTracker::TOTAL_CATEGORIES] = { 0 };
+
+	const char* g_CategoryNames[GpuResourceTracker::TOTAL_CATEGORIES] =
+	{
+		"textures",
+		"buffers"
+	};
+
+	const double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+}
+
+/***********************************************************
+ *  Track()
+ *
+ *  This method is used to record a newly created object.
+ ***********************************************************/
+void GpuResourceTracker::Track(
+	RESOURCE_CATEGORY category,
+	uint32_t objectID,
+	const std::string& owner,
+	const char* file,
+	int line)
+{
+	RESOURCE_RECORD record;
+	record.owner = owner;
+	record.file = file;
+	record.line = line;
+	record.bytes = 0;
+
+	std::lock_guard<std::mutex> lock(g_TrackerMutex);
+	g_LiveResources[category][objectID] = record;
+}
+
+/***********************************************************
+ *  SetByteSize()
+ *
+ *  This method is used to update the number of bytes of
+ *  GPU memory held by a recorded object.
+ ***********************************************************/
+void GpuResourceTracker::SetByteSize(RESOURCE_CATEGORY category, uint32_t objectID, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerMutex);
+
+	std::map<uint32_t, RESOURCE_RECORD>::iterator found = g_LiveResources[category].find(objectID);
+	if (found == g_LiveResources[category].end())
+	{
+		return;
+	}
+
+	g_LiveBytes[category] -= found->second.bytes;
+	g_LiveBytes[category] += bytes;
+	found->second.bytes = bytes;
+	if (g_LiveBytes[category] > g_PeakBytes[category])
+	{
+		g_PeakBytes[category] = g_LiveBytes[category];
+	}
+}
+
+/***********************************************************
+ *  Untrack()
+ *
+ *  This method is used to forget an object once it has been
+ *  deleted.
+ ***********************************************************/
+void GpuResourceTracker::Untrack(RESOURCE_CATEGORY category, uint32_t objectID)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerMutex);
+
+	std::map<uint32_t, RESOURCE_RECORD>::iterator found = g_LiveResources[category].find(objectID);
+	if (found == g_LiveResources[category].end())
+	{
+		return;
+	}
+
+	g_LiveBytes[category] -= found->second.bytes;
+	g_LiveResources[category].erase(found);
+}
+
+/***********************************************************
+ *  GetLiveCount()
+ *
+ *  This method returns the number of live objects in the
+ *  passed in category.
+ ***********************************************************/
+size_t GpuResourceTracker::GetLiveCount(RESOURCE_CATEGORY category)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerMutex);
+	return(g_LiveResources[category].size());
+}
+
+/***********************************************************
+ *  GetLiveBytes()
+ *
+ *  This method returns the bytes of GPU memory held by the
+ *  live objects in the passed in category.
+ ***********************************************************/
+size_t GpuResourceTracker::GetLiveBytes(RESOURCE_CATEGORY category)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerMutex);
+	return(g_LiveBytes[category]);
+}
+
+/***********************************************************
+ *  PrintMemoryReport()
+ *
+ *  This method is used to print the live and peak GPU memory
+ *  of every category.
+ ***********************************************************/
+void GpuResourceTracker::PrintMemoryReport()
+{
+	std::lock_guard<std::mutex> lock(g_TrackerMutex);
+
+	size_t totalBytes = 0;
+	for (int i = 0; i < TOTAL_CATEGORIES; i++)
+	{
+		std::cout << "GPU MEMORY: " << g_CategoryNames[i]
+			<< " - live:" << g_LiveResources[i].size()
+			<< ", MB:" << (g_LiveBytes[i] / BYTES_PER_MEGABYTE)
+			<< ", peak MB:" << (g_PeakBytes[i] / BYTES_PER_MEGABYTE) << std::endl;
+		totalBytes += g_LiveBytes[i];
+	}
+	std::cout << "GPU MEMORY: total MB:" << (totalBytes / BYTES_PER_MEGABYTE) << std::endl;
+}
+
+/***********************************************************
+ *  PrintLeakReport()
+ *
+ *  This method is used to print every object that is still
+ *  alive, with where it was created and who owns it.  It is
+ *  called at exit, once everything should have been freed.
+ ***********************************************************/
+size_t GpuResourceTracker::PrintLeakReport()
+{
+	std::lock_guard<std::mutex> lock(g_TrackerMutex);
+
+	size_t leakedObjects = 0;
+	size_t leakedBytes = 0;
+	for (int i = 0; i < TOTAL_CATEGORIES; i++)
+	{
+		for (const std::pair<const uint32_t, RESOURCE_RECORD>& resource : g_LiveResources[i])
+		{
+			std::cerr << "ERROR: leaked " << g_CategoryNames[i] << " object " << resource.first
+				<< " owned by \"" << resource.second.owner << "\", "
+				<< resource.second.bytes << " bytes, created at "
+				<< resource.second.file << ":" << resource.second.line << std::endl;
+			leakedObjects++;
+		}
+		leakedBytes += g_LiveBytes[i];
+	}
+
+	if (leakedObjects > 0)
+	{
+		std::cerr << "ERROR: " << leakedObjects << " GPU objects leaked, MB:"
+			<< (leakedBytes / BYTES_PER_MEGABYTE) << std::endl;
+	}
+	else
+	{
+		std::cout << "INFO: no GPU objects leaked" << std::endl;
+	}
+
+	return(leakedObjects);
+}
+
+/***********************************************************
+ *  GetTextureBytes()
+ *
+ *  This method returns the bytes of a 2D texture, adding
+ *  every mipmap level down to 1x1 when requested.
+ ***********************************************************/
+size_t GpuResourceTracker::GetTextureBytes(int width, int height, int bytesPerPixel, bool bMipmapped)
+{
+	size_t bytes = 0;
+	while ((width > 0) && (height > 0))
+	{
+		bytes += (size_t)width * height * bytesPerPixel;
+		if ((false == bMipmapped) || ((width == 1) && (height == 1)))
+		{
+			break;
+		}
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+
+	return(bytes);
+}
+
+/***********************************************************
+ *  GLTextureHandle()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLTextureHandle::GLTextureHandle()
+{
+	m_textureID = 0;
+}
+
+/***********************************************************
+ *  ~GLTextureHandle()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GLTextureHandle::~GLTextureHandle()
+{
+	Reset();
+}
+
+/***********************************************************
+ *  GLTextureHandle(GLTextureHandle&&)
+ *
+ *  The move constructor - the texture changes owner handle.
+ ***********************************************************/
+GLTextureHandle::GLTextureHandle(GLTextureHandle&& other)
+{
+	m_textureID = other.m_textureID;
+	other.m_textureID = 0;
+}
+
+/***********************************************************
+ *  operator=(GLTextureHandle&&)
+ *
+ *  The move assignment - frees the current texture first.
+ ***********************************************************/
+GLTextureHandle& GLTextureHandle::operator=(GLTextureHandle&& other)
+{
+	if (this != &other)
+	{
+		Reset();
+		m_textureID = other.m_textureID;
+		other.m_textureID = 0;
+	}
+	return(*this);
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create a new texture object and
+ *  record it with its owner and creation site.
+ ***********************************************************/
+void GLTextureHandle::Create(const std::string& owner, const char* file, int line)
+{
+	Reset();
+	glGenTextures(1, &m_textureID);
+	GpuResourceTracker::Track(GpuResourceTracker::RESOURCE_TEXTURE, m_textureID, owner, file, line);
+}
+
+/***********************************************************
+ *  SetByteSize()
+ *
+ *  This method is used to record the GPU memory held by the
+ *  texture once its storage has been allocated.
+ ***********************************************************/
+void GLTextureHandle::SetByteSize(size_t bytes)
+{
+	if (m_textureID != 0)
+	{
+		GpuResourceTracker::SetByteSize(GpuResourceTracker::RESOURCE_TEXTURE, m_textureID, bytes);
+	}
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used to delete the texture object.
+ ***********************************************************/
+void GLTextureHandle::Reset()
+{
+	if (m_textureID != 0)
+	{
+		GpuResourceTracker::Untrack(GpuResourceTracker::RESOURCE_TEXTURE, m_textureID);
+		glDeleteTextures(1, &m_textureID);
+		m_textureID = 0;
+	}
+}
+
+/***********************************************************
+ *  GLBufferHandle()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLBufferHandle::GLBufferHandle()
+{
+	m_bufferID = 0;
+}
+
+/***********************************************************
+ *  ~GLBufferHandle()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GLBufferHandle::~GLBufferHandle()
+{
+	Reset();
+}
+
+/***********************************************************
+ *  GLBufferHandle(GLBufferHandle&&)
+ *
+ *  The move constructor - the buffer changes owner handle.
+ ***********************************************************/
+GLBufferHandle::GLBufferHandle(GLBufferHandle&& other)
+{
+	m_bufferID = other.m_bufferID;
+	other.m_bufferID = 0;
+}
+
+/***********************************************************
+ *  operator=(GLBufferHandle&&)
+ *
+ *  The move assignment - frees the current buffer first.
+ ***********************************************************/
+GLBufferHandle& GLBufferHandle::operator=(GLBufferHandle&& other)
+{
+	if (this != &other)
+	{
+		Reset();
+		m_bufferID = other.m_bufferID;
+		other.m_bufferID = 0;
+	}
+	return(*this);
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create a new buffer object and
+ *  record it with its owner and creation site.
+ ***********************************************************/
+void GLBufferHandle::Create(const std::string& owner, const char* file, int line)
+{
+	Reset();
+	glGenBuffers(1, &m_bufferID);
+	GpuResourceTracker::Track(GpuResourceTracker::RESOURCE_BUFFER, m_bufferID, owner, file, line);
+}
+
+/***********************************************************
+ *  SetByteSize()
+ *
+ *  This method is used to record the GPU memory held by the
+ *  buffer once its storage has been allocated.
+ ***********************************************************/
+void GLBufferHandle::SetByteSize(size_t bytes)
+{
+	if (m_bufferID != 0)
+	{
+		GpuResourceTracker::SetByteSize(GpuResourceTracker::RESOURCE_BUFFER, m_bufferID, bytes);
+	}
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used to delete the buffer object.
+ ***********************************************************/
+void GLBufferHandle::Reset()
+{
+	if (m_bufferID != 0)
+	{
+		GpuResourceTracker::Untrack(GpuResourceTracker::RESOURCE_BUFFER, m_bufferID);
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+	}
+}
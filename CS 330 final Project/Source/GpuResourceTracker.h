@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresourcetracker.h
+// ============
+// GPU memory accounting - records every tracked OpenGL object with its owner,
+// creation site and size, and reports the live memory and any leaks
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// the source location passed to the handle Create() methods
+#define GPU_RESOURCE_SITE __FILE__, __LINE__
+
+/***********************************************************
+ *  GpuResourceTracker
+ *
+ *  This class keeps a record of the OpenGL objects that are
+ *  alive - their category, owner, creation site and the
+ *  number of bytes of GPU memory they hold.  The handle
+ *  classes below register and unregister their objects, so
+ *  anything still recorded at exit has leaked.
+ ***********************************************************/
+class GpuResourceTracker
+{
+public:
+	// the kinds of OpenGL objects that are tracked
+	enum RESOURCE_CATEGORY
+	{
+		RESOURCE_TEXTURE = 0,
+		RESOURCE_BUFFER,
+		TOTAL_CATEGORIES
+	};
+
+	// record a newly created object
+	static void Track(
+		RESOURCE_CATEGORY category,
+		uint32_t objectID,
+		const std::string& owner,
+		const char* file,
+		int line);
+	// update the GPU memory size of a recorded object
+	static void SetByteSize(RESOURCE_CATEGORY category, uint32_t objectID, size_t bytes);
+	// forget an object that has been deleted
+	static void Untrack(RESOURCE_CATEGORY category, uint32_t objectID);
+
+	// number of live objects and bytes held in a category
+	static size_t GetLiveCount(RESOURCE_CATEGORY category);
+	static size_t GetLiveBytes(RESOURCE_CATEGORY category);
+
+	// print the live memory for each category
+	static void PrintMemoryReport();
+	// print every object that is still alive - returns the
+	// number of leaked objects
+	static size_t PrintLeakReport();
+
+	// bytes of a 2D texture with the passed in size, including
+	// the full mipmap chain when requested
+	static size_t GetTextureBytes(int width, int height, int bytesPerPixel, bool bMipmapped);
+};
+
+/***********************************************************
+ *  GLTextureHandle
+ *
+ *  This class owns one OpenGL texture object.  The texture
+ *  is deleted and unregistered when the handle is reset or
+ *  destroyed.  Handles can be moved but not copied.
+ ***********************************************************/
+class GLTextureHandle
+{
+public:
+	// constructor
+	GLTextureHandle();
+	// destructor
+	~GLTextureHandle();
+
+	GLTextureHandle(GLTextureHandle&& other);
+	GLTextureHandle& operator=(GLTextureHandle&& other);
+
+	// create a new texture object, freeing any previous one
+	void Create(const std::string& owner, const char* file, int line);
+	// record the GPU memory the texture holds
+	void SetByteSize(size_t bytes);
+	// delete the texture object
+	void Reset();
+
+	// the OpenGL texture object, 0 when empty
+	uint32_t Get() const { return(m_textureID); }
+
+private:
+	GLTextureHandle(const GLTextureHandle&);
+	GLTextureHandle& operator=(const GLTextureHandle&);
+
+	uint32_t m_textureID;
+};
+
+/***********************************************************
+ *  GLBufferHandle
+ *
+ *  This class owns one OpenGL buffer object.  The buffer is
+ *  deleted and unregistered when the handle is reset or
+ *  destroyed.  Handles can be moved but not copied.
+ ***********************************************************/
+class GLBufferHandle
+{
+public:
+	// constructor
+	GLBufferHandle();
+	// destructor
+	~GLBufferHandle();
+
+	GLBufferHandle(GLBufferHandle&& other);
+	GLBufferHandle& operator=(GLBufferHandle&& other);
+
+	// create a new buffer object, freeing any previous one
+	void Create(const std::string& owner, const char* file, int line);
+	// record the GPU memory the buffer holds
+	void SetByteSize(size_t bytes);
+	// delete the buffer object
+	void Reset();
+
+	// the OpenGL buffer object, 0 when empty
+	uint32_t Get() const { return(m_bufferID); }
+
+private:
+	GLBufferHandle(const GLBufferHandle&);
+	GLBufferHandle& operator=(const GLBufferHandle&);
+
+	uint32_t m_bufferID;
+};
@@ -0,0 +1,535 @@
+///////////////////////////////////////////////////////////////////////////////
+// hitchdetector.cpp
+// ============
+// frame hitch detection - flags frames that run over the frame budget or well
+// over the recent median, and logs which phase of the frame was to blame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HitchDetector.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// limits on what is recorded for one frame
+	const int MAX_PHASES = 48;
+	const int MAX_FRAME_ACTIVITIES = 8;
+	// number of asset loads and shader compiles that can be in
+	// flight at once
+	const int MAX_ACTIVITIES = 32;
+	// frames waiting on their GPU time - one timer query each
+	const int TOTAL_QUERIES = 4;
+	// number of recent frames the median is taken over, and the
+	// number needed before the median limit is used
+	const int MEDIAN_WINDOW = 120;
+	const int MIN_MEDIAN_FRAMES = 30;
+
+	struct PHASE_RECORD
+	{
+		const char* name;
+		int depth;
+		uint64_t startNs;
+		double ms;
+	};
+
+	struct ACTIVITY_RECORD
+	{
+		HitchDetector::ACTIVITY_TYPE type;
+		const char* name;
+	};
+
+	struct FRAME_RECORD
+	{
+		int frameIndex;
+		double cpuMs;
+		double gpuMs;
+		PHASE_RECORD phases[MAX_PHASES];
+		int phaseCount;
+		ACTIVITY_RECORD activities[MAX_FRAME_ACTIVITIES];
+		int activityCount;
+		int droppedActivities;
+		bool bPending;
+	};
+
+	struct ACTIVE_SLOT
+	{
+		HitchDetector::ACTIVITY_TYPE type;
+		const char* name;
+		bool bActive;
+	};
+
+	// limits, 0 meaning off
+	double g_BudgetMs = 1000.0 / 30.0;
+	double g_MedianMultiple = 2.0;
+
+	// frame records, each paired with the timer query of the
+	// same index
+	FRAME_RECORD g_Frames[TOTAL_QUERIES];
+	GLuint g_TimerQueries[TOTAL_QUERIES] = { 0 };
+	bool g_bQueriesCreated = false;
+	int g_CurrentFrame = 0;
+	bool g_bInFrame = false;
+	int g_PhaseDepth = 0;
+	uint64_t g_FrameStartNs = 0;
+
+	// times of the recent frames for the median
+	double g_History[MEDIAN_WINDOW] = { 0.0 };
+	double g_SortedHistory[MEDIAN_WINDOW] = { 0.0 };
+	int g_HistoryCount = 0;
+	int g_HistoryNext = 0;
+	int g_HitchCount = 0;
+
+	// asset loads and shader compiles in flight - they can start
+	// and end on any thread, so they are guarded by the mutex
+	// along with the activity list of the current frame
+	std::mutex g_ActivityMutex;
+	ACTIVE_SLOT g_ActiveSlots[MAX_ACTIVITIES];
+	bool g_bCollectingActivities = false;
+
+	const char* g_ActivityNames[HitchDetector::TOTAL_ACTIVITY_TYPES] =
+	{
+		"asset load",
+		"shader compile"
+	};
+
+	/***********************************************************
+	 *  NowNs()
+	 *
+	 *  This function returns the current time in nanoseconds.
+	 ***********************************************************/
+	uint64_t NowNs()
+	{
+		return((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	/***********************************************************
+	 *  AddFrameActivity()
+	 *
+	 *  This function adds an activity to the list of the frame
+	 *  being rendered.  The activity mutex must be held.
+	 ***********************************************************/
+	void AddFrameActivity(HitchDetector::ACTIVITY_TYPE type, const char* name)
+	{
+		FRAME_RECORD& frame = g_Frames[g_CurrentFrame];
+		if (frame.activityCount < MAX_FRAME_ACTIVITIES)
+		{
+			frame.activities[frame.activityCount].type = type;
+			frame.activities[frame.activityCount].name = name;
+			frame.activityCount++;
+		}
+		else
+		{
+			frame.droppedActivities++;
+		}
+	}
+
+	/***********************************************************
+	 *  GetMedianMs()
+	 *
+	 *  This function returns the median of the recent frame
+	 *  times, or 0 when too few frames have been measured.
+	 ***********************************************************/
+	double GetMedianMs()
+	{
+		if (g_HistoryCount < MIN_MEDIAN_FRAMES)
+		{
+			return(0.0);
+		}
+
+		std::copy(g_History, g_History + g_HistoryCount, g_SortedHistory);
+		double* middle = g_SortedHistory + (g_HistoryCount / 2);
+		std::nth_element(g_SortedHistory, middle, g_SortedHistory + g_HistoryCount);
+		return(*middle);
+	}
+
+	/***********************************************************
+	 *  LogHitch()
+	 *
+	 *  This function writes a flagged frame to the log - the
+	 *  slowest phase first, then every phase and the work that
+	 *  was in flight.
+	 ***********************************************************/
+	void LogHitch(const FRAME_RECORD& frame, double frameMs, double medianMs)
+	{
+		// find the slowest top level phase, counting the GPU time
+		// as a phase of its own, and the slowest phase within it
+		int slowestPhase = -1;
+		double slowestMs = frame.gpuMs;
+		for (int i = 0; i < frame.phaseCount; i++)
+		{
+			if ((frame.phases[i].depth == 0) && (frame.phases[i].ms > slowestMs))
+			{
+				slowestPhase = i;
+				slowestMs = frame.phases[i].ms;
+			}
+		}
+		int slowestChild = -1;
+		if (slowestPhase >= 0)
+		{
+			for (int i = slowestPhase + 1; (i < frame.phaseCount) && (frame.phases[i].depth > 0); i++)
+			{
+				if ((frame.phases[i].depth == 1) &&
+					((slowestChild < 0) || (frame.phases[i].ms > frame.phases[slowestChild].ms)))
+				{
+					slowestChild = i;
+				}
+			}
+		}
+
+		std::ostringstream log;
+		log << std::fixed << std::setprecision(2);
+		log << "HITCH: frame " << frame.frameIndex << " took " << frameMs << " ms (budget ";
+		if (g_BudgetMs > 0.0)
+		{
+			log << g_BudgetMs << " ms";
+		}
+		else
+		{
+			log << "off";
+		}
+		log << ", median " << medianMs << " ms) - slowest phase: ";
+		if (slowestPhase < 0)
+		{
+			log << "GPU " << frame.gpuMs << " ms";
+		}
+		else
+		{
+			log << frame.phases[slowestPhase].name;
+			if (slowestChild >= 0)
+			{
+				log << " > " << frame.phases[slowestChild].name;
+			}
+			log << " " << slowestMs << " ms";
+		}
+		log << "\n";
+
+		for (int i = 0; i < frame.phaseCount; i++)
+		{
+			log << "HITCH:   " << std::string(frame.phases[i].depth * 2, ' ')
+				<< frame.phases[i].name << " " << frame.phases[i].ms << " ms\n";
+		}
+		log << "HITCH:   GPU " << frame.gpuMs << " ms\n";
+
+		if (frame.activityCount == 0)
+		{
+			log << "HITCH:   no asset loads or shader compiles in flight\n";
+		}
+		for (int i = 0; i < frame.activityCount; i++)
+		{
+			log << "HITCH:   in flight: " << g_ActivityNames[frame.activities[i].type]
+				<< " " << frame.activities[i].name << "\n";
+		}
+		if (frame.droppedActivities > 0)
+		{
+			log << "HITCH:   in flight: " << frame.droppedActivities << " more\n";
+		}
+
+		std::cout << log.str() << std::flush;
+	}
+
+	/***********************************************************
+	 *  EvaluateFrame()
+	 *
+	 *  This function reads the GPU time of a finished frame,
+	 *  decides whether the frame was a hitch, and adds it to
+	 *  the recent frame times.
+	 ***********************************************************/
+	void EvaluateFrame(int frameSlot)
+	{
+		FRAME_RECORD& frame = g_Frames[frameSlot];
+
+		GLuint64 gpuNs = 0;
+		glGetQueryObjectui64v(g_TimerQueries[frameSlot], GL_QUERY_RESULT, &gpuNs);
+		frame.gpuMs = gpuNs / 1000000.0;
+		frame.bPending = false;
+
+		// the CPU and GPU run side by side, so the frame took as
+		// long as the slower of the two
+		double frameMs = std::max(frame.cpuMs, frame.gpuMs);
+		double medianMs = GetMedianMs();
+
+		bool bHitch = false;
+		if ((g_BudgetMs > 0.0) && (frameMs > g_BudgetMs))
+		{
+			bHitch = true;
+		}
+		if ((g_MedianMultiple > 0.0) && (medianMs > 0.0) && (frameMs > medianMs * g_MedianMultiple))
+		{
+			bHitch = true;
+		}
+		if (true == bHitch)
+		{
+			g_HitchCount++;
+			LogHitch(frame, frameMs, medianMs);
+		}
+
+		g_History[g_HistoryNext] = frameMs;
+		g_HistoryNext = (g_HistoryNext + 1) % MEDIAN_WINDOW;
+		if (g_HistoryCount < MEDIAN_WINDOW)
+		{
+			g_HistoryCount++;
+		}
+	}
+}
+
+/***********************************************************
+ *  Configure()
+ *
+ *  This method is used to set the hitch limits.
+ ***********************************************************/
+void HitchDetector::Configure(double budgetMs, double medianMultiple)
+{
+	g_BudgetMs = budgetMs;
+	g_MedianMultiple = medianMultiple;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to start timing a frame on the CPU
+ *  and the GPU.
+ ***********************************************************/
+void HitchDetector::BeginFrame(int frameIndex)
+{
+	if (false == g_bQueriesCreated)
+	{
+		glGenQueries(TOTAL_QUERIES, g_TimerQueries);
+		g_bQueriesCreated = true;
+	}
+
+	// if every query is still in flight, wait for the oldest one
+	if (true == g_Frames[g_CurrentFrame].bPending)
+	{
+		EvaluateFrame(g_CurrentFrame);
+	}
+
+	FRAME_RECORD& frame = g_Frames[g_CurrentFrame];
+	frame.frameIndex = frameIndex;
+	frame.cpuMs = 0.0;
+	frame.gpuMs = 0.0;
+	frame.phaseCount = 0;
+	g_PhaseDepth = 0;
+
+	// the frame starts with the work that is already in flight
+	{
+		std::lock_guard<std::mutex> lock(g_ActivityMutex);
+		frame.activityCount = 0;
+		frame.droppedActivities = 0;
+		for (int i = 0; i < MAX_ACTIVITIES; i++)
+		{
+			if (true == g_ActiveSlots[i].bActive)
+			{
+				AddFrameActivity(g_ActiveSlots[i].type, g_ActiveSlots[i].name);
+			}
+		}
+		g_bCollectingActivities = true;
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, g_TimerQueries[g_CurrentFrame]);
+	g_bInFrame = true;
+	g_FrameStartNs = NowNs();
+}
+
+/***********************************************************
+ *  CancelFrame()
+ *
+ *  This method is used to drop a frame that was started but
+ *  not rendered.  Its query is reused by the next frame.
+ ***********************************************************/
+void HitchDetector::CancelFrame()
+{
+	if (false == g_bInFrame)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	g_bInFrame = false;
+
+	std::lock_guard<std::mutex> lock(g_ActivityMutex);
+	g_bCollectingActivities = false;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to finish timing a frame.  The frame
+ *  is checked for a hitch once its GPU time is available.
+ ***********************************************************/
+void HitchDetector::EndFrame()
+{
+	if (false == g_bInFrame)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	g_bInFrame = false;
+
+	{
+		std::lock_guard<std::mutex> lock(g_ActivityMutex);
+		g_bCollectingActivities = false;
+	}
+
+	FRAME_RECORD& frame = g_Frames[g_CurrentFrame];
+	frame.cpuMs = (NowNs() - g_FrameStartNs) / 1000000.0;
+	frame.bPending = true;
+	g_CurrentFrame = (g_CurrentFrame + 1) % TOTAL_QUERIES;
+
+	// check the finished frames in order, starting with the oldest
+	for (int i = 0; i < TOTAL_QUERIES; i++)
+	{
+		int frameSlot = (g_CurrentFrame + i) % TOTAL_QUERIES;
+		if (false == g_Frames[frameSlot].bPending)
+		{
+			continue;
+		}
+
+		GLint bAvailable = GL_FALSE;
+		glGetQueryObjectiv(g_TimerQueries[frameSlot], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable == GL_FALSE)
+		{
+			break;
+		}
+		EvaluateFrame(frameSlot);
+	}
+}
+
+/***********************************************************
+ *  Flush()
+ *
+ *  This method is used to check every frame that is still
+ *  waiting on its GPU time.
+ ***********************************************************/
+void HitchDetector::Flush()
+{
+	for (int i = 0; i < TOTAL_QUERIES; i++)
+	{
+		int frameSlot = (g_CurrentFrame + i) % TOTAL_QUERIES;
+		if (true == g_Frames[frameSlot].bPending)
+		{
+			EvaluateFrame(frameSlot);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetHitchCount()
+ *
+ *  This method returns the number of flagged frames.
+ ***********************************************************/
+int HitchDetector::GetHitchCount()
+{
+	return(g_HitchCount);
+}
+
+/***********************************************************
+ *  BeginPhase()
+ *
+ *  This method is used to start timing a phase of the frame.
+ *  It returns the phase index, or -1 when no frame is being
+ *  timed or the phase list is full.
+ ***********************************************************/
+int HitchDetector::BeginPhase(const char* name)
+{
+	FRAME_RECORD& frame = g_Frames[g_CurrentFrame];
+	if ((false == g_bInFrame) || (frame.phaseCount >= MAX_PHASES))
+	{
+		return(-1);
+	}
+
+	PHASE_RECORD& phase = frame.phases[frame.phaseCount];
+	phase.name = name;
+	phase.depth = g_PhaseDepth;
+	phase.ms = 0.0;
+	phase.startNs = NowNs();
+	g_PhaseDepth++;
+
+	return(frame.phaseCount++);
+}
+
+/***********************************************************
+ *  EndPhase()
+ *
+ *  This method is used to finish timing a phase.
+ ***********************************************************/
+void HitchDetector::EndPhase(int phaseIndex)
+{
+	if ((phaseIndex < 0) || (false == g_bInFrame))
+	{
+		return;
+	}
+
+	PHASE_RECORD& phase = g_Frames[g_CurrentFrame].phases[phaseIndex];
+	phase.ms = (NowNs() - phase.startNs) / 1000000.0;
+	g_PhaseDepth--;
+}
+
+/***********************************************************
+ *  BeginActivity()
+ *
+ *  This method is used to mark an asset load or a shader
+ *  compile as in flight.  It returns the activity index, or
+ *  -1 when too many are in flight to record.
+ ***********************************************************/
+int HitchDetector::BeginActivity(ACTIVITY_TYPE type, const char* name)
+{
+	std::lock_guard<std::mutex> lock(g_ActivityMutex);
+
+	for (int i = 0; i < MAX_ACTIVITIES; i++)
+	{
+		if (false == g_ActiveSlots[i].bActive)
+		{
+			g_ActiveSlots[i].type = type;
+			g_ActiveSlots[i].name = name;
+			g_ActiveSlots[i].bActive = true;
+
+			if (true == g_bCollectingActivities)
+			{
+				AddFrameActivity(type, name);
+			}
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  EndActivity()
+ *
+ *  This method is used to mark an activity as finished.
+ ***********************************************************/
+void HitchDetector::EndActivity(int activityIndex)
+{
+	if (activityIndex < 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(g_ActivityMutex);
+	g_ActiveSlots[activityIndex].bActive = false;
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used to free the OpenGL query objects.
+ ***********************************************************/
+void HitchDetector::Shutdown()
+{
+	if (true == g_bQueriesCreated)
+	{
+		glDeleteQueries(TOTAL_QUERIES, g_TimerQueries);
+		g_bQueriesCreated = false;
+	}
+}
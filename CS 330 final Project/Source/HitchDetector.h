@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// hitchdetector.h
+// ============
+// frame hitch detection - flags frames that run over the frame budget or well
+// over the recent median, and logs which phase of the frame was to blame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#define HITCH_CONCAT_INNER(a, b) a##b
+#define HITCH_CONCAT(a, b) HITCH_CONCAT_INNER(a, b)
+// time the enclosing scope as a phase of the current frame - main
+// thread only, and the name must stay valid for the whole run
+#define HITCH_PHASE(name) HitchPhase HITCH_CONCAT(hitchPhase, __LINE__)(name)
+
+/***********************************************************
+ *  HitchDetector
+ *
+ *  This class times the phases of every rendered frame and
+ *  the GPU work of the frame.  Once the GPU time of a frame
+ *  is known, the frame is compared with the frame budget and
+ *  with the median of the recent frames.  A frame over either
+ *  limit is logged with the time of every phase, the phase
+ *  that took the longest, and the asset loads and shader
+ *  compiles that were in flight while it was rendered.
+ ***********************************************************/
+class HitchDetector
+{
+public:
+	// the kinds of background work reported with a hitch
+	enum ACTIVITY_TYPE
+	{
+		ACTIVITY_ASSET_LOAD = 0,
+		ACTIVITY_SHADER_COMPILE,
+		TOTAL_ACTIVITY_TYPES
+	};
+
+	// set the limits - a frame is a hitch when it takes longer
+	// than the budget, or longer than the median of the recent
+	// frames times the multiple; 0 turns a limit off
+	static void Configure(double budgetMs, double medianMultiple);
+
+	// call around every rendered frame - CancelFrame() drops a
+	// frame that was started but turned out not to need drawing
+	static void BeginFrame(int frameIndex);
+	static void CancelFrame();
+	static void EndFrame();
+	// report every frame still waiting on its GPU time
+	static void Flush();
+
+	// number of frames flagged as hitches so far
+	static int GetHitchCount();
+
+	// used by HitchPhase
+	static int BeginPhase(const char* name);
+	static void EndPhase(int phaseIndex);
+
+	// used by HitchActivity
+	static int BeginActivity(ACTIVITY_TYPE type, const char* name);
+	static void EndActivity(int activityIndex);
+
+	// free the OpenGL query objects
+	static void Shutdown();
+};
+
+/***********************************************************
+ *  HitchPhase
+ *
+ *  This class times one phase of the current frame, from its
+ *  construction to its destruction.  Phases can be nested.
+ ***********************************************************/
+class HitchPhase
+{
+public:
+	// constructor
+	HitchPhase(const char* name)
+	{
+		m_phaseIndex = HitchDetector::BeginPhase(name);
+	}
+	// destructor
+	~HitchPhase()
+	{
+		HitchDetector::EndPhase(m_phaseIndex);
+	}
+
+private:
+	int m_phaseIndex;
+};
+
+/***********************************************************
+ *  HitchSteps
+ *
+ *  This class times a run of back to back phases, such as
+ *  the parts of a scene - each call to Next() ends the
+ *  previous step and starts the next one, and the last step
+ *  ends with End() or when the object is destroyed.
+ ***********************************************************/
+class HitchSteps
+{
+public:
+	// constructor
+	HitchSteps()
+	{
+		m_phaseIndex = -1;
+	}
+	// destructor
+	~HitchSteps()
+	{
+		HitchDetector::EndPhase(m_phaseIndex);
+	}
+
+	// start the next step - the name must stay valid for the
+	// whole run
+	void Next(const char* name)
+	{
+		HitchDetector::EndPhase(m_phaseIndex);
+		m_phaseIndex = HitchDetector::BeginPhase(name);
+	}
+	// end the current step
+	void End()
+	{
+		HitchDetector::EndPhase(m_phaseIndex);
+		m_phaseIndex = -1;
+	}
+
+private:
+	int m_phaseIndex;
+};
+
+/***********************************************************
+ *  HitchActivity
+ *
+ *  This class marks an asset load or shader compile as in
+ *  flight from its construction to its destruction.  It can
+ *  be used on any thread, and the name must stay valid for
+ *  the whole run.
+ ***********************************************************/
+class HitchActivity
+{
+public:
+	// constructor
+	HitchActivity(HitchDetector::ACTIVITY_TYPE type, const char* name)
+	{
+		m_activityIndex = HitchDetector::BeginActivity(type, name);
+	}
+	// destructor
+	~HitchActivity()
+	{
+		HitchDetector::EndActivity(m_activityIndex);
+	}
+
+private:
+	int m_activityIndex;
+};
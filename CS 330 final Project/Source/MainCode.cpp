@@ -9,6 +9,9 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <fstream>          // shader file prefetching
+#include <thread>           // hardware_concurrency
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -23,6 +26,28 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "FrameScheduler.h"
+#include "SimulationClock.h"
+#include "Benchmark.h"
+#include "RenderStats.h"
+#include "GpuResourceTracker.h"
+#include "HitchDetector.h"
+#include "AllocationTracker.h"
+#include "StartupPipeline.h"
+#include "TraceRecorder.h"
+#include "SceneReloader.h"
+#include "StressScene.h"
+#include "ConfettiSystem.h"
+#include "CandleParticles.h"
+#include "BalloonPhysics.h"
+#include "AnimationSystem.h"
+#include "WorldStreamer.h"
+#include "AssetManager.h"
+#include "TextureResidency.h"
+#include "AssetPack.h"
+#include "AssetPacker.h"
+#include "AssetFileReader.h"
+#include "TextureReloader.h"
 
 // Namespace for declaring global variables
 namespace
@@ -39,12 +64,128 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame scheduler object for deciding when a frame needs to be redrawn
+	FrameScheduler* g_FrameScheduler = nullptr;
+	// simulation clock object for advancing the scene in fixed time steps
+	SimulationClock* g_SimulationClock = nullptr;
+	// benchmark object for timing a fixed number of frames
+	Benchmark* g_Benchmark = nullptr;
+	// startup pipeline object, kept until the first frame is presented
+	StartupPipeline* g_StartupPipeline = nullptr;
+	// scene reloader object for applying edits to the scene files
+	SceneReloader* g_SceneReloader = nullptr;
+	// texture reloader object for uploading edited texture files
+	TextureReloader* g_TextureReloader = nullptr;
+	// confetti object for the particles simulated on the GPU
+	ConfettiSystem* g_Confetti = nullptr;
+	// candle particles object for the flame and smoke simulated
+	// on the CPU
+	CandleParticles* g_CandleParticles = nullptr;
+	// balloon physics object for the floating balloons
+	BalloonPhysics* g_BalloonPhysics = nullptr;
+	// animation object for the keyframe animation of the scene
+	AnimationSystem* g_Animation = nullptr;
+	// world streamer object for the chunks of the venue
+	WorldStreamer* g_WorldStreamer = nullptr;
+	// asset manager object for loading the textures in the
+	// background
+	AssetManager* g_AssetManager = nullptr;
+	// texture residency object for keeping only the texture levels
+	// the feedback pass sees
+	TextureResidency* g_TextureResidency = nullptr;
+	// asset pack object for the mapped pack file the assets are
+	// read from
+	AssetPack* g_AssetPack = nullptr;
+
+	// the shader code files
+	const char* const VERTEX_SHADER_FILE = "shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_FILE = "shaders/fragmentShader.glsl";
+	const char* const FEEDBACK_FRAGMENT_SHADER_FILE = "shaders/feedbackFragmentShader.glsl";
+
+	// length of one fixed simulation step in seconds
+	const double SIMULATION_STEP_SECONDS = 1.0 / 120.0;
+
+	// command line options
+	// only redraw the scene when something has changed
+	bool g_bOnDemandRedraw = false;
+	// number of frames to render in benchmark mode, 0 when off
+	int g_BenchmarkFrames = 0;
+	// file to write the Chrome trace to, empty when not tracing
+	const char* g_TraceFilename = nullptr;
+	// range of frames to trace, -1 meaning no limit
+	int g_TraceFirstFrame = -1;
+	int g_TraceLastFrame = -1;
+	// frame time limits for flagging hitches, 0 meaning off
+	double g_HitchBudgetMs = 1000.0 / 30.0;
+	double g_HitchMedianMultiple = 2.0;
+	// fail the run if a steady-state frame allocates from the heap
+	bool g_bCheckAllocations = false;
+	// scene description file to load and watch, null when off
+	const char* g_SceneFilename = nullptr;
+	// render a generated stress scene of this size and seed
+	// in place of the party scene
+	bool g_bStressScene = false;
+	STRESS_SCENE_PARAMS g_StressScene = { 0, 0, 0, 0, 1 };
+	// most confetti particles alive at once, 0 when off
+	int g_ConfettiParticles = 0;
+	// candle flame and smoke particles, 0 when off
+	int g_CandleParticleCount = 0;
+	// update the candle particles without AVX2, for comparison
+	bool g_bCandleScalar = false;
+	// balloons added around the room for the balloon physics, -1
+	// when the physics is off
+	int g_ExtraBalloons = -1;
+	// threads for the balloon physics, 0 to pick from the processors
+	int g_BalloonThreads = 0;
+	// animation file to play, null when off
+	const char* g_AnimationFilename = nullptr;
+	// bob every object of the loaded scene, to load test the
+	// animation
+	bool g_bBobObjects = false;
+	// chunks across and deep of the streamed venue, 0 when off
+	int g_VenueColumns = 0;
+	int g_VenueRows = 0;
+	// most texture memory the venue chunks may hold, in megabytes
+	int g_StreamBudgetMB = 384;
+	// draw the first frames with placeholder textures and load
+	// the scene textures in the background
+	bool g_bAsyncAssets = false;
+	// mip levels uploaded per frame by the asset manager, in
+	// kilobytes, 0 to upload each texture whole
+	int g_MipUploadKB = 0;
+	// most memory the scene textures may hold, in megabytes, 0
+	// when the texture residency is off
+	int g_TextureBudgetMB = 0;
+	// pack the small scene textures into shared atlas pages
+	bool g_bTextureAtlas = false;
+	// asset pack file to read the assets from, null when off
+	const char* g_PackFilename = nullptr;
+	// manifest and asset pack file to build instead of running,
+	// null when off, and whether to compress the pack
+	const char* g_PackManifestFilename = nullptr;
+	const char* g_BuildPackFilename = nullptr;
+	bool g_bCompressPack = false;
+	// read the scene texture files as one batch before decoding
+	// them from memory
+	bool g_bBatchReads = false;
+	// share one texture between tags whose images have the same
+	// pixels
+	bool g_bDedupeTextures = false;
+	// watch the texture files and upload them again when edited
+	bool g_bWatchTextures = false;
+
+	// frames that may allocate while lazily created objects, such
+	// as query objects, come into existence
+	const int ALLOCATION_WARMUP_FRAMES = 3;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool ParseCommandLine(int argc, char* argv[]);
+bool RunStartupPipeline();
+bool PrefetchFile(const char* filename);
 
 
 /***********************************************************
@@ -55,41 +196,319 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	// if the command line has unknown options, then terminate the application
+	if (ParseCommandLine(argc, argv) == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
+	// build the asset pack for deployment and stop
+	if (NULL != g_BuildPackFilename)
+	{
+		bool bBuilt = BuildAssetPack(g_PackManifestFilename, g_BuildPackFilename, g_bCompressPack);
+		return(bBuilt ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// start tracing before anything else so startup is captured
+	if (NULL != g_TraceFilename)
+	{
+		TraceRecorder::Start(g_TraceFilename, g_TraceFirstFrame, g_TraceLastFrame);
+		TraceRecorder::SetThreadName("main");
+	}
+
+	// the assets in the pack are read from its mapping from here
+	// on, so the loaders open no files of their own for them
+	if (NULL != g_PackFilename)
+	{
+		g_AssetPack = new AssetPack();
+		if (g_AssetPack->Open(g_PackFilename) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		AssetPack::Mount(g_AssetPack);
+	}
+
+	// flag frames that run over the frame budget or well over
+	// the recent median, and log what they were doing
+	HitchDetector::Configure(g_HitchBudgetMs, g_HitchMedianMultiple);
+
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
+	// try to create a new scene manager object - the 3D scene is
+	// prepared by the startup pipeline
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetTextureAtlas(g_bTextureAtlas);
+	g_SceneManager->SetTextureDeduplication(g_bDedupeTextures);
 
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	// try to create a new frame scheduler object for deciding when to redraw
+	g_FrameScheduler = new FrameScheduler();
+	g_FrameScheduler->SetOnDemand(g_bOnDemandRedraw);
+	g_ViewManager->SetFrameScheduler(g_FrameScheduler);
+	// try to create a new simulation clock object for fixed time steps
+	g_SimulationClock = new SimulationClock(SIMULATION_STEP_SECONDS);
 
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
+	// initialize GLFW, GLEW and the window, and load the shaders and
+	// the 3D scene - if any of it fails, terminate the application
+	if (RunStartupPipeline() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
+	// edited texture files are decoded in the background and
+	// uploaded over the live textures
+	if (true == g_bWatchTextures)
+	{
+		g_TextureReloader = new TextureReloader(g_SceneManager, g_FrameScheduler);
+		if (g_TextureReloader->Start() == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
 
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
+	// load the scene description file over the startup scene and
+	// apply any edits made to it, or its files, while running
+	if (NULL != g_SceneFilename)
+	{
+		g_SceneReloader = new SceneReloader(g_SceneManager, g_ShaderManager, g_FrameScheduler);
+		g_SceneReloader->SetTextureReloader(g_TextureReloader);
+		if (g_SceneReloader->Start(g_SceneFilename, VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+
+	// replace the startup scene with a generated one of the
+	// requested size
+	if (true == g_bStressScene)
+	{
+		SCENE_DESCRIPTION stressScene;
+		GenerateStressScene(g_StressScene, stressScene);
+		g_SceneManager->ApplySceneDescription(stressScene);
+	}
+
+	// the streamed venue replaces the scene, chunk by chunk around
+	// the camera
+	if (g_VenueColumns > 0)
+	{
+		g_SceneManager->ApplySceneDescription(SCENE_DESCRIPTION());
+		g_WorldStreamer = new WorldStreamer(g_SceneManager, g_VenueColumns, g_VenueRows,
+			(size_t)g_StreamBudgetMB * 1024 * 1024, g_StressScene.seed);
+		g_WorldStreamer->Start();
+		// chunks arrive while the camera is still
+		g_FrameScheduler->SetAnimating(true);
+	}
+
+	// confetti rains over the cake and bursts from the balloon -
+	// it needs compute shaders, so older contexts go without
+	if (g_ConfettiParticles > 0)
+	{
+		if (ConfettiSystem::IsSupported() == false)
+		{
+			std::cout << "INFO: confetti needs OpenGL 4.3 compute shaders and is turned off" << std::endl;
+		}
+		else
+		{
+			g_Confetti = new ConfettiSystem(g_ConfettiParticles);
+			if (g_Confetti->Initialize() == false)
+			{
+				return(EXIT_FAILURE);
+			}
+			g_Confetti->AddEmitter(glm::vec3(0.0f, 9.0f, 0.0f), g_ConfettiParticles / 10.0f, 0, 0.0f);
+			g_Confetti->AddEmitter(glm::vec3(4.0f, 12.0f, -4.0f), 0.0f, g_ConfettiParticles / 8, 4.0f);
+			// the confetti moves every frame
+			g_FrameScheduler->SetAnimating(true);
+		}
+	}
+
+	// the candle flame and smoke run on the CPU, so they work on
+	// every context
+	if (g_CandleParticleCount > 0)
+	{
+		g_CandleParticles = new CandleParticles(g_CandleParticleCount, g_bCandleScalar);
+		if (g_CandleParticles->Initialize() == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		// the flame moves every frame
+		g_FrameScheduler->SetAnimating(true);
+	}
+
+	// the balloons of the scene float on their strings, joined by
+	// any extra balloons tied around the room
+	if (g_ExtraBalloons >= 0)
+	{
+		g_BalloonPhysics = new BalloonPhysics(g_BalloonThreads);
+		const SceneManager::BALLOON_POSE* poses = g_SceneManager->GetBalloonPoses();
+		for (int i = 0; i < g_SceneManager->GetBalloonCount(); i++)
+		{
+			g_BalloonPhysics->AddBalloon(poses[i].position, poses[i].radius, poses[i].anchor,
+				glm::length(poses[i].position - poses[i].anchor));
+		}
+		g_BalloonPhysics->AddRoomBalloons(g_ExtraBalloons, g_StressScene.seed);
+		g_BalloonPhysics->Start();
+		g_SceneManager->SetBalloonPoses(g_BalloonPhysics->GetPoses(), g_BalloonPhysics->GetBalloonCount());
+		// the balloons drift every frame
+		g_FrameScheduler->SetAnimating(true);
+	}
+
+	// keyframe animation is bound to the scene once it is loaded
+	if ((NULL != g_AnimationFilename) || (true == g_bBobObjects))
+	{
+		g_Animation = new AnimationSystem(g_SceneManager);
+		if ((NULL != g_AnimationFilename) && (g_Animation->LoadFile(g_AnimationFilename) == false))
+		{
+			return(EXIT_FAILURE);
+		}
+		if (true == g_bBobObjects)
+		{
+			g_Animation->AddObjectBobbing(0.25f, 3.0f);
+		}
+		// the animation plays every frame
+		g_FrameScheduler->SetAnimating(true);
+	}
+
+	// the scene textures keep only the levels the feedback pass
+	// sees them at, within the texture budget
+	if (g_TextureBudgetMB > 0)
+	{
+		g_TextureResidency = new TextureResidency(g_SceneManager, g_ShaderManager,
+			(size_t)g_TextureBudgetMB * 1024 * 1024);
+		if (g_TextureResidency->Initialize(VERTEX_SHADER_FILE, FEEDBACK_FRAGMENT_SHADER_FILE) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+
+	// in benchmark mode, render a fixed number of frames and report
+	if (g_BenchmarkFrames > 0)
+	{
+		g_Benchmark = new Benchmark(g_BenchmarkFrames);
+		if (true == g_bStressScene)
+		{
+			g_Benchmark->SetSceneSize(
+				g_SceneManager->GetSceneObjectCount(),
+				g_SceneManager->GetScenePointLightCount());
+		}
+	}
+
+	// number of frames presented so far
+	int frameIndex = 0;
+	// number of steady-state frames that allocated from the heap
+	int allocatingFrames = 0;
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		// query the latest GLFW events - in on-demand mode this
+		// blocks until something needs to be redrawn
+		{
+			TRACE_SCOPE("ProcessEvents");
+			g_FrameScheduler->ProcessEvents();
+		}
+
+		// apply any changes made to the watched scene files
+		if (NULL != g_SceneReloader)
+		{
+			g_SceneReloader->Update();
+		}
+		if (NULL != g_TextureReloader)
+		{
+			g_TextureReloader->Update();
+		}
+
+		// the hitch timing starts after the events, since waiting
+		// for events in on-demand mode is idle time, not work
+		HitchDetector::BeginFrame(frameIndex);
+		uint64_t frameStartAllocations = AllocationTracker::GetThreadAllocations();
+
+		// process the keyboard input for moving the camera
+		{
+			HITCH_PHASE("Input");
+			g_ViewManager->ProcessInput();
+		}
+
+		// when nothing has changed, the last presented frame is
+		// still on the screen so there is nothing to render - the
+		// idle time is not simulated once rendering starts again
+		if (g_FrameScheduler->NeedsRedraw() == false)
+		{
+			HitchDetector::CancelFrame();
+			g_SimulationClock->Reset();
+			continue;
+		}
+		g_FrameScheduler->BeginFrame();
+		TraceRecorder::BeginFrame(frameIndex);
+		TRACE_SCOPE("Frame");
+		RenderStats::BeginFrame();
+
+		// advance the simulation in fixed steps - benchmark runs use
+		// exactly one step per frame so every run is the same
+		HitchSteps frameSteps;
+		// swap in the textures that have finished loading
+		if (NULL != g_AssetManager)
+		{
+			frameSteps.Next("AssetSwaps");
+			g_AssetManager->Update();
+		}
+		// put back or drop texture levels for the last feedback
+		// pass, once the textures have all been loaded
+		bool bTexturesLoaded = (NULL == g_AssetManager) || (g_AssetManager->IsIdle());
+		if ((NULL != g_TextureResidency) && (true == bTexturesLoaded))
+		{
+			frameSteps.Next("TextureResidency");
+			g_TextureResidency->Update();
+		}
+		frameSteps.Next("Simulation");
+		int simulationSteps = 0;
+		if (NULL != g_Benchmark)
+		{
+			simulationSteps = g_SimulationClock->AdvanceBy(g_SimulationClock->GetStepSeconds());
+		}
+		else
+		{
+			simulationSteps = g_SimulationClock->Advance();
+		}
+		for (int i = 0; i < simulationSteps; i++)
+		{
+			g_ViewManager->UpdateCamera(g_SimulationClock->GetStepSeconds());
+			if (NULL != g_BalloonPhysics)
+			{
+				g_BalloonPhysics->Step(g_SimulationClock->GetStepSeconds());
+			}
+		}
+		if ((NULL != g_BalloonPhysics) && (simulationSteps > 0))
+		{
+			g_SceneManager->SetBalloonPoses(g_BalloonPhysics->GetPoses(), g_BalloonPhysics->GetBalloonCount());
+		}
+		// the confetti takes all of the steps in one go, since each
+		// update is a few dispatches whatever the time step
+		if (NULL != g_Confetti)
+		{
+			g_Confetti->Update(simulationSteps * g_SimulationClock->GetStepSeconds());
+		}
+		// the candle particles also take the steps in one go, and
+		// the candle light flickers with the flame
+		if (NULL != g_CandleParticles)
+		{
+			g_CandleParticles->Update(simulationSteps * g_SimulationClock->GetStepSeconds());
+			g_SceneManager->SetCandleFlicker(g_CandleParticles->GetFlicker());
+		}
+		// the animation writes only the values that changed
+		if (NULL != g_Animation)
+		{
+			g_Animation->Update(simulationSteps * g_SimulationClock->GetStepSeconds());
+		}
+		// the venue follows the camera once it has moved
+		if (NULL != g_WorldStreamer)
+		{
+			frameSteps.Next("WorldStreaming");
+			g_WorldStreamer->Update(g_ViewManager->GetCameraPosition(), g_ViewManager->GetCameraVelocity());
+		}
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
@@ -98,20 +517,170 @@ int main(int argc, char* argv[])
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		frameSteps.Next("PrepareSceneView");
+		g_ViewManager->PrepareSceneView(g_SimulationClock->GetInterpolationAlpha());
+		if ((NULL != g_TextureResidency) && (true == bTexturesLoaded))
+		{
+			frameSteps.Next("TextureFeedback");
+			g_TextureResidency->RenderFeedback(frameIndex,
+				g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+		}
 
 		// refresh the 3D scene
+		frameSteps.Next("RenderScene");
 		g_SceneManager->RenderScene();
+		if (NULL != g_WorldStreamer)
+		{
+			frameSteps.Next("WorldChunks");
+			g_WorldStreamer->Render();
+		}
+		if (NULL != g_Confetti)
+		{
+			frameSteps.Next("Confetti");
+			g_Confetti->Render(g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+		}
+		if (NULL != g_CandleParticles)
+		{
+			frameSteps.Next("CandleParticles");
+			g_CandleParticles->Render(g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+		}
 
+		RenderStats::EndFrame();
 
 		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		{
+			TRACE_SCOPE("SwapBuffers");
+			frameSteps.Next("SwapBuffers");
+			glfwSwapBuffers(g_Window);
+		}
+		frameSteps.End();
+
+		// once warmed up, rendering a frame must not allocate
+		uint64_t frameAllocations = AllocationTracker::GetThreadAllocations() - frameStartAllocations;
+		if ((true == g_bCheckAllocations) && (frameIndex >= ALLOCATION_WARMUP_FRAMES) && (frameAllocations > 0))
+		{
+			std::cerr << "ERROR: frame " << frameIndex << " made " << frameAllocations << " heap allocations" << std::endl;
+			allocatingFrames++;
+		}
+
+		HitchDetector::EndFrame();
+		frameIndex++;
+
+		// report how long it took to get the first frame on screen
+		if (NULL != g_StartupPipeline)
+		{
+			g_StartupPipeline->MarkEvent("first frame presented");
+			g_StartupPipeline->PrintTimeline();
+			delete g_StartupPipeline;
+			g_StartupPipeline = NULL;
+		}
+
+		if (NULL != g_Benchmark)
+		{
+			g_Benchmark->FrameFinished();
+			if (g_Benchmark->IsFinished() == true)
+			{
+				glfwSetWindowShouldClose(g_Window, true);
+			}
+		}
+	}
+
+	// check the last frames for hitches before reporting
+	HitchDetector::Flush();
+
+	if (NULL != g_Benchmark)
+	{
+		g_Benchmark->PrintReport();
+	}
+	if (NULL != g_CandleParticles)
+	{
+		g_CandleParticles->PrintReport();
+	}
+	if (NULL != g_BalloonPhysics)
+	{
+		g_BalloonPhysics->PrintReport();
+	}
+	if (NULL != g_Animation)
+	{
+		g_Animation->PrintReport();
+	}
+	if (NULL != g_WorldStreamer)
+	{
+		g_WorldStreamer->PrintReport();
+	}
+	if (NULL != g_AssetManager)
+	{
+		g_AssetManager->PrintReport();
+	}
+	if (NULL != g_TextureResidency)
+	{
+		g_TextureResidency->PrintReport();
+	}
+	if (NULL != g_TextureReloader)
+	{
+		g_TextureReloader->PrintReport();
+	}
+	if (true == g_bDedupeTextures)
+	{
+		std::cout << "INFO: texture deduplication - shared textures:" << g_SceneManager->GetSharedTextureCount()
+			<< ", MB saved:" << (g_SceneManager->GetDeduplicatedBytes() / (1024.0 * 1024.0)) << std::endl;
+	}
+
+	RenderStats::Shutdown();
+	HitchDetector::Shutdown();
 
-		// query the latest GLFW events
-		glfwPollEvents();
+	// write out the recorded trace zones
+	if (NULL != g_TraceFilename)
+	{
+		TraceRecorder::Stop();
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_TextureResidency)
+	{
+		delete g_TextureResidency;
+		g_TextureResidency = NULL;
+	}
+	if (NULL != g_AssetManager)
+	{
+		delete g_AssetManager;
+		g_AssetManager = NULL;
+	}
+	if (NULL != g_WorldStreamer)
+	{
+		delete g_WorldStreamer;
+		g_WorldStreamer = NULL;
+	}
+	if (NULL != g_Animation)
+	{
+		delete g_Animation;
+		g_Animation = NULL;
+	}
+	if (NULL != g_BalloonPhysics)
+	{
+		delete g_BalloonPhysics;
+		g_BalloonPhysics = NULL;
+	}
+	if (NULL != g_CandleParticles)
+	{
+		delete g_CandleParticles;
+		g_CandleParticles = NULL;
+	}
+	if (NULL != g_Confetti)
+	{
+		delete g_Confetti;
+		g_Confetti = NULL;
+	}
+	if (NULL != g_SceneReloader)
+	{
+		delete g_SceneReloader;
+		g_SceneReloader = NULL;
+	}
+	if (NULL != g_TextureReloader)
+	{
+		delete g_TextureReloader;
+		g_TextureReloader = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -127,11 +696,246 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_FrameScheduler)
+	{
+		delete g_FrameScheduler;
+		g_FrameScheduler = NULL;
+	}
+	if (NULL != g_SimulationClock)
+	{
+		delete g_SimulationClock;
+		g_SimulationClock = NULL;
+	}
+	if (NULL != g_Benchmark)
+	{
+		delete g_Benchmark;
+		g_Benchmark = NULL;
+	}
+	// the pack goes last, as the images loaded from it are freed
+	// by the objects above
+	if (NULL != g_AssetPack)
+	{
+		AssetPack::Mount(NULL);
+		delete g_AssetPack;
+		g_AssetPack = NULL;
+	}
+
+	// every GPU object should have been freed with its owner by now
+	GpuResourceTracker::PrintLeakReport();
+
+	if (true == g_bCheckAllocations)
+	{
+		if (allocatingFrames > 0)
+		{
+			std::cerr << "ERROR: " << allocatingFrames << " steady-state frames allocated from the heap" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+		std::cout << "INFO: no steady-state frame allocated from the heap" << std::endl;
+	}
 
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	RunStartupPipeline()
+ *
+ *  This function is used to bring up the application as a
+ *  dependency graph instead of one step after another.  The
+ *  image files are decoded, the shader files are read and
+ *  the materials are defined on worker threads while GLFW,
+ *  the window and GLEW are initialized on the main thread.
+ *  Only the steps that need the OpenGL context run on the
+ *  main thread once it exists.
+ ***********************************************************/
+bool RunStartupPipeline()
+{
+	g_StartupPipeline = new StartupPipeline();
+	StartupPipeline& pipeline = *g_StartupPipeline;
+
+	// scene texture files read by the batch, one for each texture
+	std::vector<ASSET_FILE_BUFFER> textureFiles;
+
+	// GLFW and the OpenGL context must be set up on the main thread
+	int initGLFW = pipeline.AddTask("InitializeGLFW", StartupPipeline::MAIN_THREAD,
+		[]() { return(InitializeGLFW()); });
+	int createWindow = pipeline.AddTask("CreateDisplayWindow", StartupPipeline::MAIN_THREAD,
+		[]()
+		{
+			// try to create the main display window
+			g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+			return(NULL != g_Window);
+		},
+		{ initGLFW });
+	int initGLEW = pipeline.AddTask("InitializeGLEW", StartupPipeline::MAIN_THREAD,
+		[]() { return(InitializeGLEW()); },
+		{ createWindow });
+
+	// reading the shader files ahead of time means compiling them
+	// only has to wait for the OpenGL context, not the disk - any
+	// read error is reported again when the shaders are loaded
+	int readShaders = pipeline.AddTask("ReadShaderFiles", StartupPipeline::WORKER_THREAD,
+		[]()
+		{
+			PrefetchFile(VERTEX_SHADER_FILE);
+			PrefetchFile(FRAGMENT_SHADER_FILE);
+			return(true);
+		});
+	int loadShaders = pipeline.AddTask("LoadShaders", StartupPipeline::MAIN_THREAD,
+		[]()
+		{
+			// load the shader code from the external GLSL files
+			TRACE_SCOPE("LoadShaders");
+			HitchActivity activity(HitchDetector::ACTIVITY_SHADER_COMPILE, "LoadShaders");
+			g_ShaderManager->LoadShaders(
+				VERTEX_SHADER_FILE,
+				FRAGMENT_SHADER_FILE);
+			g_ShaderManager->use();
+			RenderStats::Count(RenderStats::PROGRAM_SWITCHES);
+			return(true);
+		},
+		{ initGLEW, readShaders });
+
+	if (true == g_bAsyncAssets)
+	{
+		// the scene textures start as placeholders and are loaded
+		// after startup, so the first frame does not wait for them
+		pipeline.AddTask("RequestSceneTextures", StartupPipeline::MAIN_THREAD,
+			[]()
+			{
+				g_AssetManager = new AssetManager(g_SceneManager, g_FrameScheduler,
+					(size_t)g_MipUploadKB * 1024);
+				if (g_AssetManager->Start(g_Window) == false)
+				{
+					// load them the slow way instead
+					delete g_AssetManager;
+					g_AssetManager = NULL;
+					g_SceneManager->LoadSceneTextures();
+					return(true);
+				}
+				for (int i = 0; i < g_SceneManager->GetSceneTextureCount(); i++)
+				{
+					g_AssetManager->RequestTexture(
+						g_SceneManager->GetSceneTextureFile(i),
+						g_SceneManager->GetSceneTextureTag(i));
+				}
+				return(true);
+			},
+			{ initGLEW });
+	}
+	else
+	{
+		// the texture files are read in one batch, so the decoding
+		// tasks wait on one round of file reads rather than each
+		// making its own - files the mounted pack holds are left to
+		// the pack
+		std::vector<int> decodeDependencies;
+		if (true == g_bBatchReads)
+		{
+			decodeDependencies.push_back(pipeline.AddTask("ReadSceneTextureFiles", StartupPipeline::WORKER_THREAD,
+				[&textureFiles]()
+				{
+					std::vector<std::string> filenames;
+					for (int i = 0; i < g_SceneManager->GetSceneTextureCount(); i++)
+					{
+						const char* filename = g_SceneManager->GetSceneTextureFile(i);
+						bool bPacked = (NULL != AssetPack::GetMounted()) &&
+							(NULL != AssetPack::GetMounted()->Find(filename));
+						filenames.push_back(bPacked ? std::string() : std::string(filename));
+					}
+					AssetFileReader::ReadFiles(filenames, textureFiles);
+					return(true);
+				}));
+		}
+
+		// decoding the image files is the slowest part of startup, so
+		// every texture is decoded on its own worker task
+		std::vector<int> uploadDependencies;
+		uploadDependencies.push_back(initGLEW);
+		for (int i = 0; i < g_SceneManager->GetSceneTextureCount(); i++)
+		{
+			uploadDependencies.push_back(pipeline.AddTask(
+				"DecodeSceneTexture " + std::to_string(i), StartupPipeline::WORKER_THREAD,
+				[i, &textureFiles]()
+				{
+					// a missing texture is not fatal, the object is
+					// simply drawn without it
+					if (((size_t)i < textureFiles.size()) && (true == textureFiles[i].bLoaded))
+					{
+						g_SceneManager->DecodeSceneTexture(i, textureFiles[i].data, textureFiles[i].size);
+						AssetFileReader::FreeBuffer(textureFiles[i]);
+					}
+					else
+					{
+						g_SceneManager->DecodeSceneTexture(i);
+					}
+					return(true);
+				},
+				decodeDependencies));
+		}
+		pipeline.AddTask("UploadSceneTextures", StartupPipeline::MAIN_THREAD,
+			[]() { g_SceneManager->UploadSceneTextures(); return(true); },
+			uploadDependencies);
+	}
+
+	pipeline.AddTask("DefineObjectMaterials", StartupPipeline::WORKER_THREAD,
+		[]() { g_SceneManager->DefineObjectMaterials(); return(true); });
+	pipeline.AddTask("SetupSceneLights", StartupPipeline::MAIN_THREAD,
+		[]() { g_SceneManager->SetupSceneLights(); return(true); },
+		{ loadShaders });
+	// the shape meshes build their vertex data and OpenGL buffers
+	// in the same call, so they are loaded on the main thread
+	pipeline.AddTask("LoadSceneMeshes", StartupPipeline::MAIN_THREAD,
+		[]() { g_SceneManager->LoadSceneMeshes(); return(true); },
+		{ initGLEW });
+
+	// leave one core for the main thread
+	int workerCount = (int)std::thread::hardware_concurrency() - 1;
+	if (workerCount < 1)
+	{
+		workerCount = 1;
+	}
+
+	bool bStarted = pipeline.Run(workerCount);
+
+	// free any file the decoding did not get to
+	for (ASSET_FILE_BUFFER& buffer : textureFiles)
+	{
+		AssetFileReader::FreeBuffer(buffer);
+	}
+
+	if (false == bStarted)
+	{
+		pipeline.PrintTimeline();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *	PrefetchFile()
+ *
+ *  This function is used to read a whole file so that it is
+ *  in the operating system file cache when it is needed.
+ ***********************************************************/
+bool PrefetchFile(const char* filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Could not read file:" << filename << std::endl;
+		return(false);
+	}
+
+	char buffer[16384];
+	while (file.read(buffer, sizeof(buffer)) || (file.gcount() > 0))
+	{
+	}
+
+	return(true);
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
@@ -183,5 +987,358 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Successfully Initialized\n";
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
+	return(true);
+}
+
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the options passed on the
+ *  command line.
+ *
+ *  --on-demand          only redraw when input, the camera,
+ *                       an animation or an asset reload
+ *                       changes the scene, and idle between
+ *  --benchmark <frames> render a fixed number of frames with
+ *                       one simulation step each, print the
+ *                       frame time report and exit
+ *  --trace <file>       record trace zones and write them as
+ *                       Chrome trace-event JSON at exit
+ *  --trace-frames <first> <last>
+ *                       only trace startup and this range of
+ *                       frames, counting from 0
+ *  --hitch-budget <ms>  log frames slower than this, 0 for off
+ *  --hitch-multiple <x> log frames slower than this many times
+ *                       the recent median frame, 0 for off
+ *  --check-allocations  report every frame after the first few
+ *                       that allocates from the heap, and exit
+ *                       with a failure if any did
+ *  --scene <file>       load a scene description file over the
+ *                       built in scene, and apply edits to it,
+ *                       its textures and the shaders while the
+ *                       program runs
+ *  --stress <tables> <balloons> <presents> <lights>
+ *                       render a generated party scene of this
+ *                       size instead - with --benchmark, the
+ *                       report ends with a line for plotting
+ *  --seed <n>           seed for the stress scene layout
+ *  --confetti <count>   simulate up to this many confetti
+ *                       particles on the GPU - needs OpenGL 4.3
+ *  --candle <count>     simulate up to this many candle flame
+ *                       and smoke particles on the CPU
+ *  --candle-scalar      update the candle particles without
+ *                       AVX2, to compare the two
+ *  --balloons <extra>   float the balloons with the balloon
+ *                       physics, adding this many more tied
+ *                       around the room, placed by --seed
+ *  --balloon-threads <n>
+ *                       threads for the balloon physics, 0 to
+ *                       use one for each processor
+ *  --animate <file>     play the keyframe animation file on
+ *                       the scene
+ *  --bob-objects        bob every object of the loaded scene
+ *                       up and down, to load test the animation
+ *  --venue <columns> <rows>
+ *                       stream a venue of this many party
+ *                       chunks around the camera instead of the
+ *                       scene, laid out by --seed
+ *  --stream-budget <MB> most texture memory the venue chunks
+ *                       may hold, 384 by default
+ *  --async-assets       show the scene straight away with
+ *                       placeholder textures, and load the
+ *                       scene textures on a background thread
+ *  --stream-mips <KB>   load the textures as --async-assets
+ *                       does, uploading their mip levels
+ *                       smallest first, this many kilobytes
+ *                       a frame
+ *  --texture-budget <MB>
+ *                       keep only the scene texture levels a
+ *                       feedback pass sees, dropping the least
+ *                       recently seen levels to stay within
+ *                       this many megabytes
+ *  --atlas-textures     pack the scene textures of up to
+ *                       1008x1008 into shared atlas pages
+ *  --pack <file>        read the assets the asset pack file
+ *                       holds from its memory mapping
+ *  --build-pack <manifest> <file>
+ *                       write the files listed in the manifest
+ *                       into an asset pack file, and exit
+ *  --compress-pack      compress the asset pack being built
+ *                       with zstd - needs ASSET_PACK_ZSTD
+ *  --batch-reads        read the scene texture files as one
+ *                       batch and decode them from memory -
+ *                       with io_uring on Linux builds that
+ *                       define ASSET_IO_URING
+ *  --dedupe-textures    share one texture between the texture
+ *                       tags whose images have the same pixels,
+ *                       and report the memory saved
+ *  --watch-textures     decode the texture files that are
+ *                       edited while running and upload them
+ *                       over the live textures
+ ***********************************************************/
+bool ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			g_bOnDemandRedraw = true;
+		}
+		else if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+		{
+			g_TraceFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--trace-frames") == 0) && (i + 2 < argc))
+		{
+			g_TraceFirstFrame = atoi(argv[++i]);
+			g_TraceLastFrame = atoi(argv[++i]);
+			if ((g_TraceFirstFrame < 0) || (g_TraceLastFrame < g_TraceFirstFrame))
+			{
+				std::cerr << "The trace frame range is not valid" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			g_SceneFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--stress") == 0) && (i + 4 < argc))
+		{
+			g_StressScene.tables = atoi(argv[++i]);
+			g_StressScene.balloons = atoi(argv[++i]);
+			g_StressScene.presents = atoi(argv[++i]);
+			g_StressScene.pointLights = atoi(argv[++i]);
+			if ((g_StressScene.tables < 0) || (g_StressScene.balloons < 0) ||
+				(g_StressScene.presents < 0) || (g_StressScene.pointLights < 0))
+			{
+				std::cerr << "The stress scene counts must not be negative" << std::endl;
+				return(false);
+			}
+			g_bStressScene = true;
+		}
+		else if ((strcmp(argv[i], "--confetti") == 0) && (i + 1 < argc))
+		{
+			g_ConfettiParticles = atoi(argv[++i]);
+			if (g_ConfettiParticles <= 0)
+			{
+				std::cerr << "The confetti particle count must be positive" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--candle") == 0) && (i + 1 < argc))
+		{
+			g_CandleParticleCount = atoi(argv[++i]);
+			if (g_CandleParticleCount <= 0)
+			{
+				std::cerr << "The candle particle count must be positive" << std::endl;
+				return(false);
+			}
+		}
+		else if (strcmp(argv[i], "--candle-scalar") == 0)
+		{
+			g_bCandleScalar = true;
+		}
+		else if ((strcmp(argv[i], "--balloons") == 0) && (i + 1 < argc))
+		{
+			g_ExtraBalloons = atoi(argv[++i]);
+			if (g_ExtraBalloons < 0)
+			{
+				std::cerr << "The extra balloon count must not be negative" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--balloon-threads") == 0) && (i + 1 < argc))
+		{
+			g_BalloonThreads = atoi(argv[++i]);
+			if (g_BalloonThreads < 0)
+			{
+				std::cerr << "The balloon thread count must not be negative" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--animate") == 0) && (i + 1 < argc))
+		{
+			g_AnimationFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--bob-objects") == 0)
+		{
+			g_bBobObjects = true;
+		}
+		else if ((strcmp(argv[i], "--venue") == 0) && (i + 2 < argc))
+		{
+			g_VenueColumns = atoi(argv[++i]);
+			g_VenueRows = atoi(argv[++i]);
+			if ((g_VenueColumns <= 0) || (g_VenueRows <= 0))
+			{
+				std::cerr << "The venue chunk counts must be positive" << std::endl;
+				return(false);
+			}
+		}
+		else if (strcmp(argv[i], "--async-assets") == 0)
+		{
+			g_bAsyncAssets = true;
+		}
+		else if ((strcmp(argv[i], "--stream-mips") == 0) && (i + 1 < argc))
+		{
+			g_MipUploadKB = atoi(argv[++i]);
+			if (g_MipUploadKB <= 0)
+			{
+				std::cerr << "The mip upload size must be positive" << std::endl;
+				return(false);
+			}
+			g_bAsyncAssets = true;
+		}
+		else if ((strcmp(argv[i], "--pack") == 0) && (i + 1 < argc))
+		{
+			g_PackFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--build-pack") == 0) && (i + 2 < argc))
+		{
+			g_PackManifestFilename = argv[++i];
+			g_BuildPackFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--compress-pack") == 0)
+		{
+			g_bCompressPack = true;
+		}
+		else if (strcmp(argv[i], "--batch-reads") == 0)
+		{
+			g_bBatchReads = true;
+		}
+		else if (strcmp(argv[i], "--watch-textures") == 0)
+		{
+			g_bWatchTextures = true;
+		}
+		else if (strcmp(argv[i], "--dedupe-textures") == 0)
+		{
+			g_bDedupeTextures = true;
+		}
+		else if (strcmp(argv[i], "--atlas-textures") == 0)
+		{
+			g_bTextureAtlas = true;
+		}
+		else if ((strcmp(argv[i], "--texture-budget") == 0) && (i + 1 < argc))
+		{
+			g_TextureBudgetMB = atoi(argv[++i]);
+			if (g_TextureBudgetMB <= 0)
+			{
+				std::cerr << "The texture budget must be positive" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--stream-budget") == 0) && (i + 1 < argc))
+		{
+			g_StreamBudgetMB = atoi(argv[++i]);
+			if (g_StreamBudgetMB <= 0)
+			{
+				std::cerr << "The stream budget must be positive" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc))
+		{
+			g_StressScene.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--check-allocations") == 0)
+		{
+			g_bCheckAllocations = true;
+		}
+		else if ((strcmp(argv[i], "--hitch-budget") == 0) && (i + 1 < argc))
+		{
+			g_HitchBudgetMs = atof(argv[++i]);
+			if (g_HitchBudgetMs < 0.0)
+			{
+				std::cerr << "The hitch budget must not be negative" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--hitch-multiple") == 0) && (i + 1 < argc))
+		{
+			g_HitchMedianMultiple = atof(argv[++i]);
+			if (g_HitchMedianMultiple < 0.0)
+			{
+				std::cerr << "The hitch median multiple must not be negative" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--benchmark") == 0) && (i + 1 < argc))
+		{
+			g_BenchmarkFrames = atoi(argv[++i]);
+			if (g_BenchmarkFrames <= 0)
+			{
+				std::cerr << "The benchmark frame count must be positive" << std::endl;
+				return(false);
+			}
+		}
+		else
+		{
+			std::cerr << "Unknown command line option: " << argv[i] << std::endl;
+			return(false);
+		}
+	}
+
+	// the stress scene replaces the scene, so there is no scene
+	// file to apply edits to
+	if ((true == g_bStressScene) && (NULL != g_SceneFilename))
+	{
+		std::cerr << "The --stress and --scene options cannot be used together" << std::endl;
+		return(false);
+	}
+
+	// the venue replaces the scene as well
+	if ((g_VenueColumns > 0) && ((true == g_bStressScene) || (NULL != g_SceneFilename)))
+	{
+		std::cerr << "The --venue option cannot be used with --stress or --scene" << std::endl;
+		return(false);
+	}
+
+	// the atlas is packed from the decoded scene textures, which
+	// the asset manager loads one at a time instead
+	if ((true == g_bTextureAtlas) && (true == g_bAsyncAssets))
+	{
+		std::cerr << "The --atlas-textures option cannot be used with --async-assets or --stream-mips" << std::endl;
+		return(false);
+	}
+
+	// the texture residency rebuilds whole textures by slot, and
+	// its feedback pass samples them without the atlas rectangles
+	if ((true == g_bTextureAtlas) && (g_TextureBudgetMB > 0))
+	{
+		std::cerr << "The --atlas-textures option cannot be used with --texture-budget" << std::endl;
+		return(false);
+	}
+
+	// the asset manager reads and decodes its textures one at a
+	// time on its own thread
+	if ((true == g_bBatchReads) && (true == g_bAsyncAssets))
+	{
+		std::cerr << "The --batch-reads option cannot be used with --async-assets or --stream-mips" << std::endl;
+		return(false);
+	}
+
+	// the shared textures are found as the decoded images are
+	// uploaded, which the asset manager and the atlas do their own
+	// way, and the texture residency rebuilds textures per tag
+	if ((true == g_bDedupeTextures) &&
+		((true == g_bAsyncAssets) || (true == g_bTextureAtlas) || (g_TextureBudgetMB > 0)))
+	{
+		std::cerr << "The --dedupe-textures option cannot be used with --async-assets, --stream-mips, --atlas-textures or --texture-budget" << std::endl;
+		return(false);
+	}
+
+	// the asset manager and the texture residency swap their own
+	// textures into the slots, which a reload would replace
+	if ((true == g_bWatchTextures) && ((true == g_bAsyncAssets) || (g_TextureBudgetMB > 0)))
+	{
+		std::cerr << "The --watch-textures option cannot be used with --async-assets, --stream-mips or --texture-budget" << std::endl;
+		return(false);
+	}
+
+	// a benchmark has to render every frame to be measured
+	if (g_BenchmarkFrames > 0)
+	{
+		g_bOnDemandRedraw = false;
+	}
+
 	return(true);
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.cpp
+// ============
+// per-frame and cumulative counters for the rendering work - draws, triangles,
+// uniform updates, texture binds and shader program switches
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStats.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <iostream>
+
+// counters for the frame being rendered
+unsigned long long RenderStats::s_currentFrame[RenderStats::TOTAL_COUNTERS] = { 0 };
+
+// declaration of the global variables and defines
+namespace
+{
+	// counters for the last finished frame and the whole run
+	unsigned long long g_LastFrame[RenderStats::TOTAL_COUNTERS] = { 0 };
+	unsigned long long g_Totals[RenderStats::TOTAL_COUNTERS] = { 0 };
+	unsigned long long g_FrameCount = 0;
+
+	const char* g_CounterNames[RenderStats::TOTAL_COUNTERS] =
+	{
+		"draws",
+		"triangles",
+		"uniform updates",
+		"texture binds",
+		"program switches"
+	};
+
+	// primitive count queries - a few are kept in flight so the
+	// results are read without waiting on the GPU
+	const int TOTAL_QUERIES = 4;
+	GLuint g_PrimitiveQueries[TOTAL_QUERIES] = { 0 };
+	bool g_bQueryPending[TOTAL_QUERIES] = { false };
+	int g_CurrentQuery = 0;
+	bool g_bQueriesCreated = false;
+
+	/***********************************************************
+	 *  CollectQueryResults()
+	 *
+	 *  This function reads every finished primitive query and
+	 *  adds its result to the triangle counters.
+	 ***********************************************************/
+	void CollectQueryResults()
+	{
+		for (int i = 0; i < TOTAL_QUERIES; i++)
+		{
+			// start with the oldest query so results arrive in order
+			int query = (g_CurrentQuery + i) % TOTAL_QUERIES;
+			if (g_bQueryPending[query] == false)
+			{
+				continue;
+			}
+
+			GLint bAvailable = GL_FALSE;
+			glGetQueryObjectiv(g_PrimitiveQueries[query], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+			if (bAvailable == GL_FALSE)
+			{
+				break;
+			}
+
+			GLuint primitives = 0;
+			glGetQueryObjectuiv(g_PrimitiveQueries[query], GL_QUERY_RESULT, &primitives);
+			g_LastFrame[RenderStats::TRIANGLES] = primitives;
+			g_Totals[RenderStats::TRIANGLES] += primitives;
+			g_bQueryPending[query] = false;
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to start counting a new frame.  Work
+ *  issued between frames, such as the startup, is counted
+ *  as part of the next frame.
+ ***********************************************************/
+void RenderStats::BeginFrame()
+{
+	if (false == g_bQueriesCreated)
+	{
+		glGenQueries(TOTAL_QUERIES, g_PrimitiveQueries);
+		g_bQueriesCreated = true;
+	}
+
+	// if every query is still in flight, wait for the oldest one
+	// rather than dropping a frame from the triangle count
+	if (true == g_bQueryPending[g_CurrentQuery])
+	{
+		GLuint primitives = 0;
+		glGetQueryObjectuiv(g_PrimitiveQueries[g_CurrentQuery], GL_QUERY_RESULT, &primitives);
+		g_LastFrame[TRIANGLES] = primitives;
+		g_Totals[TRIANGLES] += primitives;
+		g_bQueryPending[g_CurrentQuery] = false;
+	}
+
+	glBeginQuery(GL_PRIMITIVES_GENERATED, g_PrimitiveQueries[g_CurrentQuery]);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to finish counting the current frame
+ *  and add it to the totals.
+ ***********************************************************/
+void RenderStats::EndFrame()
+{
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	g_bQueryPending[g_CurrentQuery] = true;
+	g_CurrentQuery = (g_CurrentQuery + 1) % TOTAL_QUERIES;
+
+	for (int i = 0; i < TOTAL_COUNTERS; i++)
+	{
+		// the triangles come from the queries instead
+		if (i == TRIANGLES)
+		{
+			continue;
+		}
+		g_LastFrame[i] = s_currentFrame[i];
+		g_Totals[i] += s_currentFrame[i];
+		s_currentFrame[i] = 0;
+	}
+	g_FrameCount++;
+
+	CollectQueryResults();
+}
+
+/***********************************************************
+ *  GetLastFrame()
+ *
+ *  This method returns the counter value of the last
+ *  finished frame.
+ ***********************************************************/
+unsigned long long RenderStats::GetLastFrame(COUNTER counter)
+{
+	return(g_LastFrame[counter]);
+}
+
+/***********************************************************
+ *  GetTotal()
+ *
+ *  This method returns the counter value for the whole run.
+ ***********************************************************/
+unsigned long long RenderStats::GetTotal(COUNTER counter)
+{
+	return(g_Totals[counter]);
+}
+
+/***********************************************************
+ *  GetFrameCount()
+ *
+ *  This method returns the number of finished frames.
+ ***********************************************************/
+unsigned long long RenderStats::GetFrameCount()
+{
+	return(g_FrameCount);
+}
+
+/***********************************************************
+ *  GetCounterName()
+ *
+ *  This method returns the display name of a counter.
+ ***********************************************************/
+const char* RenderStats::GetCounterName(COUNTER counter)
+{
+	return(g_CounterNames[counter]);
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print every counter for the last
+ *  frame, for the whole run and as a per frame average.
+ ***********************************************************/
+void RenderStats::PrintReport()
+{
+	// make sure every outstanding triangle count is included
+	for (int i = 0; i < TOTAL_QUERIES; i++)
+	{
+		if (true == g_bQueryPending[i])
+		{
+			GLuint primitives = 0;
+			glGetQueryObjectuiv(g_PrimitiveQueries[i], GL_QUERY_RESULT, &primitives);
+			g_Totals[TRIANGLES] += primitives;
+			g_bQueryPending[i] = false;
+		}
+	}
+
+	std::cout << "RENDER STATS: frames:" << g_FrameCount << std::endl;
+	for (int i = 0; i < TOTAL_COUNTERS; i++)
+	{
+		double average = 0.0;
+		if (g_FrameCount > 0)
+		{
+			average = (double)g_Totals[i] / g_FrameCount;
+		}
+
+		std::cout << "RENDER STATS: " << g_CounterNames[i]
+			<< " - last frame:" << g_LastFrame[i]
+			<< ", total:" << g_Totals[i]
+			<< ", per frame:" << average << std::endl;
+	}
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used to free the OpenGL query objects.
+ ***********************************************************/
+void RenderStats::Shutdown()
+{
+	if (true == g_bQueriesCreated)
+	{
+		glDeleteQueries(TOTAL_QUERIES, g_PrimitiveQueries);
+		g_bQueriesCreated = false;
+	}
+}
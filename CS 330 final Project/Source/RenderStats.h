@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.h
+// ============
+// per-frame and cumulative counters for the rendering work - draws, triangles,
+// uniform updates, texture binds and shader program switches
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  RenderStats
+ *
+ *  This class keeps count of the rendering work issued each
+ *  frame.  The counters are incremented wherever the work is
+ *  issued, and the totals of the previous frame and of the
+ *  whole run can be queried at any time.  The triangle count
+ *  comes from an OpenGL query, so it is what the GPU actually
+ *  processed and arrives a couple of frames late.
+ ***********************************************************/
+class RenderStats
+{
+public:
+	// the kinds of work that are counted
+	enum COUNTER
+	{
+		// one per shape mesh draw - a shape mesh may issue more
+		// than one OpenGL draw command internally
+		DRAW_CALLS = 0,
+		TRIANGLES,
+		UNIFORM_UPDATES,
+		// texture selections for the next draw, plus bindings
+		// of textures to texture units
+		TEXTURE_BINDS,
+		PROGRAM_SWITCHES,
+		TOTAL_COUNTERS
+	};
+
+	// add to a counter for the current frame
+	static void Count(COUNTER counter, unsigned int amount = 1)
+	{
+		s_currentFrame[counter] += amount;
+	}
+
+	// call at the start and end of every rendered frame
+	static void BeginFrame();
+	static void EndFrame();
+
+	// counter value for the last finished frame
+	static unsigned long long GetLastFrame(COUNTER counter);
+	// counter value for the whole run
+	static unsigned long long GetTotal(COUNTER counter);
+	// number of finished frames
+	static unsigned long long GetFrameCount();
+	// display name of a counter
+	static const char* GetCounterName(COUNTER counter);
+
+	// print the last frame, total and per frame average values
+	static void PrintReport();
+
+	// free the OpenGL query objects
+	static void Shutdown();
+
+private:
+	// counters for the frame being rendered
+	static unsigned long long s_currentFrame[TOTAL_COUNTERS];
+};
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcetag.cpp
+// ============
+// compile-time hashed resource tags - texture and material names become
+// 64-bit FNV-1a keys, so looking one up is a single integer compare
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResourceTag.h"
+
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the registered names by hash - resources can be created on
+	// worker threads, so access is guarded by the mutex
+	std::mutex g_RegistryMutex;
+	std::unordered_map<uint64_t, std::string> g_RegisteredNames;
+}
+
+/***********************************************************
+ *  FromString()
+ *
+ *  This method returns the tag of a name that is only known
+ *  at runtime, such as a name read from a file.
+ ***********************************************************/
+ResourceTag ResourceTag::FromString(const std::string& name)
+{
+	return(ResourceTag(Hash(name.c_str()), NULL));
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used to hash the name of a newly created
+ *  resource and remember the name.  Registering the same
+ *  name again is fine, but a different name with the same
+ *  hash is reported and the registration fails.
+ ***********************************************************/
+bool ResourceTag::Register(const std::string& name, ResourceTag& tag)
+{
+	tag = ResourceTag(Hash(name.c_str()), NULL);
+
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	std::unordered_map<uint64_t, std::string>::iterator found = g_RegisteredNames.find(tag.m_hash);
+	if (found == g_RegisteredNames.end())
+	{
+		g_RegisteredNames[tag.m_hash] = name;
+		return(true);
+	}
+
+	if (found->second != name)
+	{
+		std::cerr << "ERROR: resource tag \"" << name << "\" has the same hash as \""
+			<< found->second << "\" - rename one of them" << std::endl;
+		tag = ResourceTag();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetName()
+ *
+ *  This method returns the name of the tag for logging - the
+ *  registered name, or the literal it was made from in debug
+ *  builds, or a placeholder when neither is known.
+ ***********************************************************/
+const char* ResourceTag::GetName() const
+{
+	{
+		std::lock_guard<std::mutex> lock(g_RegistryMutex);
+		std::unordered_map<uint64_t, std::string>::const_iterator found = g_RegisteredNames.find(m_hash);
+		if (found != g_RegisteredNames.end())
+		{
+			return(found->second.c_str());
+		}
+	}
+
+#ifndef NDEBUG
+	if (NULL != m_name)
+	{
+		return(m_name);
+	}
+#endif
+
+	return("<unregistered tag>");
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcetag.h
+// ============
+// compile-time hashed resource tags - texture and material names become
+// 64-bit FNV-1a keys, so looking one up is a single integer compare
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// hash a string literal into a tag at compile time
+#define TAG(text) ResourceTag(std::integral_constant<uint64_t, ResourceTag::Hash(text)>::value, text)
+
+/***********************************************************
+ *  ResourceTag
+ *
+ *  This class holds the 64-bit FNV-1a hash of a resource
+ *  name.  Tags written with TAG("name") are hashed by the
+ *  compiler, and tags read from data are hashed with
+ *  FromString().  Names are registered when the resource is
+ *  created, which catches two names with the same hash, and
+ *  lets a tag be turned back into its name for logging.
+ *  Debug builds also keep the text of each TAG() literal.
+ ***********************************************************/
+class ResourceTag
+{
+public:
+	// constructors
+	constexpr ResourceTag()
+		: m_hash(0)
+#ifndef NDEBUG
+		, m_name(nullptr)
+#endif
+	{
+	}
+	constexpr ResourceTag(uint64_t hash, const char* name)
+		: m_hash(hash)
+#ifndef NDEBUG
+		, m_name(name)
+#endif
+	{
+		(void)name;
+	}
+
+	// the 64-bit FNV-1a hash of a string
+	static constexpr uint64_t Hash(const char* text)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (const char* p = text; *p != '\0'; p++)
+		{
+			hash ^= (uint64_t)(unsigned char)*p;
+			hash *= 1099511628211ULL;
+		}
+		return(hash);
+	}
+
+	// hash a name that is only known at runtime
+	static ResourceTag FromString(const std::string& name);
+
+	// hash and register the name of a newly created resource -
+	// returns false if a different name has the same hash
+	static bool Register(const std::string& name, ResourceTag& tag);
+
+	// the name of the tag, for logging
+	const char* GetName() const;
+
+	constexpr uint64_t GetHash() const { return(m_hash); }
+	constexpr bool IsValid() const { return(m_hash != 0); }
+	constexpr bool operator==(const ResourceTag& other) const { return(m_hash == other.m_hash); }
+	constexpr bool operator!=(const ResourceTag& other) const { return(m_hash != other.m_hash); }
+
+private:
+	uint64_t m_hash;
+#ifndef NDEBUG
+	// the literal the tag was made from, when it is known
+	const char* m_name;
+#endif
+};
@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenedescription.cpp
+// ============
+// scene description files - the textures, materials and objects of a scene
+// as plain text, so a scene can be changed without rebuilding
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneDescription.h"
+#include "AssetPack.h"
+
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	struct MESH_NAME
+	{
+		const char* name;
+		SceneManager::SHAPE_MESH mesh;
+	};
+
+	const MESH_NAME g_MeshNames[] =
+	{
+		{ "plane", SceneManager::MESH_PLANE },
+		{ "box", SceneManager::MESH_BOX },
+		{ "cone", SceneManager::MESH_CONE },
+		{ "cylinder", SceneManager::MESH_CYLINDER },
+		{ "sphere", SceneManager::MESH_SPHERE },
+		{ "pyramid4", SceneManager::MESH_PYRAMID4 }
+	};
+
+	/***********************************************************
+	 *  ReadVec3()
+	 *
+	 *  This function reads three numbers from the line.
+	 ***********************************************************/
+	bool ReadVec3(std::istringstream& line, glm::vec3& value)
+	{
+		line >> value.x >> value.y >> value.z;
+		return(!line.fail());
+	}
+
+	/***********************************************************
+	 *  ReadKeyword()
+	 *
+	 *  This function reads the next word and checks that it is
+	 *  the expected keyword.
+	 ***********************************************************/
+	bool ReadKeyword(std::istringstream& line, const char* keyword)
+	{
+		std::string word;
+		line >> word;
+		return(!line.fail() && (word == keyword));
+	}
+
+	/***********************************************************
+	 *  ReadObject()
+	 *
+	 *  This function reads the fields of an object entry.
+	 ***********************************************************/
+	bool ReadObject(std::istringstream& line, SCENE_OBJECT_DESC& object)
+	{
+		std::string meshName;
+		line >> object.name >> meshName;
+		if (line.fail())
+		{
+			return(false);
+		}
+
+		bool bFoundMesh = false;
+		for (const MESH_NAME& mesh : g_MeshNames)
+		{
+			if (meshName == mesh.name)
+			{
+				object.mesh = mesh.mesh;
+				bFoundMesh = true;
+			}
+		}
+		if (false == bFoundMesh)
+		{
+			return(false);
+		}
+
+		if (!ReadVec3(line, object.scale) ||
+			!ReadVec3(line, object.rotation) ||
+			!ReadVec3(line, object.position))
+		{
+			return(false);
+		}
+
+		// either a texture or a color
+		std::string surface;
+		line >> surface;
+		object.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		if (surface == "texture")
+		{
+			line >> object.texture;
+		}
+		else if (surface == "color")
+		{
+			object.texture.clear();
+			line >> object.color.r >> object.color.g >> object.color.b >> object.color.a;
+		}
+		else
+		{
+			return(false);
+		}
+
+		if (!ReadKeyword(line, "uv"))
+		{
+			return(false);
+		}
+		line >> object.uvScale.x >> object.uvScale.y;
+
+		if (!ReadKeyword(line, "material"))
+		{
+			return(false);
+		}
+		line >> object.material;
+		if (object.material == "-")
+		{
+			object.material.clear();
+		}
+
+		return(!line.fail());
+	}
+}
+
+/***********************************************************
+ *  LoadSceneDescription()
+ *
+ *  This function is used to read a scene description file
+ *  into the passed in description.  A file read from disk
+ *  skips the mounted asset pack, which holds the file as it
+ *  was packed.
+ ***********************************************************/
+bool LoadSceneDescription(const char* filename, SCENE_DESCRIPTION& scene, bool bFromDisk)
+{
+	std::string contents;
+	bool bRead = (true == bFromDisk) ?
+		AssetPack::ReadDiskTextFile(filename, contents) :
+		AssetPack::ReadTextFile(filename, contents);
+	if (false == bRead)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+	std::istringstream file(contents);
+
+	scene.textures.clear();
+	scene.materials.clear();
+	scene.objects.clear();
+	scene.lights.clear();
+
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(file, text))
+	{
+		lineNumber++;
+
+		// strip comments
+		size_t comment = text.find('#');
+		if (comment != std::string::npos)
+		{
+			text.erase(comment);
+		}
+
+		std::istringstream line(text);
+		std::string entry;
+		if (!(line >> entry))
+		{
+			continue;
+		}
+
+		bool bValid = false;
+		if (entry == "texture")
+		{
+			SCENE_TEXTURE_DESC texture;
+			line >> texture.tag >> texture.filename;
+			bValid = !line.fail();
+			scene.textures.push_back(texture);
+		}
+		else if (entry == "material")
+		{
+			SCENE_MATERIAL_DESC material;
+			line >> material.tag;
+			bValid = !line.fail() &&
+				ReadVec3(line, material.diffuseColor) &&
+				ReadVec3(line, material.specularColor);
+			line >> material.shininess;
+			bValid = bValid && !line.fail();
+			scene.materials.push_back(material);
+		}
+		else if (entry == "object")
+		{
+			SCENE_OBJECT_DESC object;
+			bValid = ReadObject(line, object);
+			for (const SCENE_OBJECT_DESC& other : scene.objects)
+			{
+				if (other.name == object.name)
+				{
+					bValid = false;
+				}
+			}
+			scene.objects.push_back(object);
+		}
+		else if (entry == "light")
+		{
+			SCENE_LIGHT_DESC light;
+			bValid = ReadVec3(line, light.position) &&
+				ReadVec3(line, light.ambientColor) &&
+				ReadVec3(line, light.diffuseColor) &&
+				ReadVec3(line, light.specularColor);
+			scene.lights.push_back(light);
+		}
+
+		if (false == bValid)
+		{
+			std::cout << "Could not read scene file:" << filename << ", line:" << lineNumber << std::endl;
+			return(false);
+		}
+	}
+
+	return(true);
+}
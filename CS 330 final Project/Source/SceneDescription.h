@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenedescription.h
+// ============
+// scene description files - the textures, materials and objects of a scene
+// as plain text, so a scene can be changed without rebuilding
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  Scene description file format
+ *
+ *  One entry per line, with # starting a comment:
+ *
+ *  texture <tag> <image file>
+ *  material <tag> <diffuse r g b> <specular r g b> <shininess>
+ *  object <name> <mesh> <scale x y z> <rotation x y z>
+ *         <position x y z> texture <tag> | color <r g b a>
+ *         uv <u v> material <tag> | material -
+ *  light <position x y z> <ambient r g b> <diffuse r g b>
+ *        <specular r g b>
+ *
+ *  The mesh is plane, box, cone, cylinder, sphere or
+ *  pyramid4, rotations are in degrees, and "material -"
+ *  keeps the material of the previous object.  Objects are
+ *  drawn in file order and their names must be unique.
+ *  Lights are point lights - a scene that lists none keeps
+ *  the built in lights.
+ ***********************************************************/
+struct SCENE_TEXTURE_DESC
+{
+	std::string tag;
+	std::string filename;
+};
+
+struct SCENE_MATERIAL_DESC
+{
+	std::string tag;
+	glm::vec3 diffuseColor;
+	glm::vec3 specularColor;
+	float shininess;
+};
+
+struct SCENE_OBJECT_DESC
+{
+	std::string name;
+	SceneManager::SHAPE_MESH mesh;
+	glm::vec3 scale;
+	glm::vec3 rotation;
+	glm::vec3 position;
+	// texture tag, or empty to draw with the color
+	std::string texture;
+	glm::vec4 color;
+	glm::vec2 uvScale;
+	// material tag, or empty to keep the previous material
+	std::string material;
+};
+
+struct SCENE_LIGHT_DESC
+{
+	glm::vec3 position;
+	glm::vec3 ambientColor;
+	glm::vec3 diffuseColor;
+	glm::vec3 specularColor;
+};
+
+struct SCENE_DESCRIPTION
+{
+	std::vector<SCENE_TEXTURE_DESC> textures;
+	std::vector<SCENE_MATERIAL_DESC> materials;
+	std::vector<SCENE_OBJECT_DESC> objects;
+	std::vector<SCENE_LIGHT_DESC> lights;
+};
+
+// read a scene description file, from disk even when the mounted
+// asset pack holds it if asked - returns false and reports the
+// line of the first error if the file cannot be read
+bool LoadSceneDescription(const char* filename, SCENE_DESCRIPTION& scene, bool bFromDisk = false);
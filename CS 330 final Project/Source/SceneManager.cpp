@@ -23,6 +23,13 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "AssetPack.h"
+#include "RenderStats.h"
+#include "HitchDetector.h"
+#include "TraceRecorder.h"
+#include "BakedScene.h"
+#include "SceneDescription.h"
+#include "TextureAtlas.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -31,15 +38,186 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
 
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	// the shader uniform names - the shader manager takes names
+	// as strings, so they are built once here instead of as a
+	// temporary string on every call
+	const std::string g_ModelName = "model";
+	const std::string g_ColorValueName = "objectColor";
+	const std::string g_TextureValueName = "objectTexture";
+	const std::string g_UseTextureName = "bUseTexture";
+	const std::string g_UseLightingName = "bUseLighting";
+	const std::string g_UVScaleName = "UVscale";
+	const std::string g_AtlasRectName = "atlasRect";
+	const std::string g_MaterialDiffuseName = "material.diffuseColor";
+	const std::string g_MaterialSpecularName = "material.specularColor";
+	const std::string g_MaterialShininessName = "material.shininess";
+	const std::string g_CandleAmbientName = "pointLights[0].ambient";
+	const std::string g_CandleDiffuseName = "pointLights[0].diffuse";
+	const std::string g_CandleSpecularName = "pointLights[0].specular";
+
+	// the warm colors of the candle light, scaled by the flicker
+	// of the flame when candle particles are running
+	const glm::vec3 CANDLE_AMBIENT_COLOR(0.3f, 0.15f, 0.05f);
+	const glm::vec3 CANDLE_DIFFUSE_COLOR(1.0f, 0.6f, 0.2f);
+	const glm::vec3 CANDLE_SPECULAR_COLOR(1.0f, 0.8f, 0.5f);
+
+	// size of the arena for data that only lives for one frame
+	const size_t FRAME_ARENA_BYTES = 64 * 1024;
+
+	// number of texture slots in m_textureIDs
+	const int MAX_TEXTURE_SLOTS = 16;
+
+	// the scene textures small enough for two to fit across a page
+	// with their borders are packed into atlas pages.  The
+	// rectangles start on multiples of the alignment, which is
+	// also the width of the border around each texture, so the
+	// first mip levels of a page keep the textures apart.
+	const int ATLAS_PAGE_SIZE = 2048;
+	const int ATLAS_ALIGNMENT = 8;
+	const int ATLAS_MAX_TEXTURE_SIZE = ATLAS_PAGE_SIZE / 2 - 2 * ATLAS_ALIGNMENT;
+	// the atlas rectangle of a texture that has a whole texture
+	// of its own
+	const glm::vec4 FULL_TEXTURE_RECT(0.0f, 0.0f, 1.0f, 1.0f);
+
+	// number of point lights the shader has - this must match
+	// TOTAL_POINT_LIGHTS in the fragment shader
+	const int MAX_POINT_LIGHTS = 16;
+
+	// the image files loaded as scene textures and the tags
+	// used to refer to them - they are bound to texture slots
+	// in this order, and up to 16 textures can be loaded
+	struct SCENE_TEXTURE
+	{
+		const char* filename;
+		const char* tag;
+	};
+	const SCENE_TEXTURE g_SceneTextures[] =
+	{
+		{ "textures/Party_hat.jpg", "Party" },
+		{ "textures/blue_party.jpg", "Blue" },
+		{ "textures/Check_floor.jpg", "Floor" },
+		{ "textures/table.jpg", "Table" },
+		{ "textures/Plate.jpg", "Plate" },
+		{ "textures/top_frosting.png", "Frost" },
+		{ "textures/frosting_sides.png", "Frost_sides" },
+		{ "textures/Purple_balloon.png", "balloon" },
+		{ "textures/red_present.jpg", "present" }
+	};
+	const int TOTAL_SCENE_TEXTURES = sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]);
+
+	// the balloon of the party scene floats over the table, tied to
+	// it by its string
+	const glm::vec3 PARTY_BALLOON_POSITION(4.0f, 12.0f, -4.0f);
+	const glm::vec3 PARTY_BALLOON_ANCHOR(4.0f, 4.2f, -4.0f);
+	const float PARTY_BALLOON_RADIUS = 2.0f;
+	// balloons are taller than they are wide, with the knot just
+	// under the bottom
+	const float BALLOON_HEIGHT_SCALE = 1.25f;
+	const float BALLOON_KNOT_OFFSET = 1.275f;
+	const float BALLOON_KNOT_SCALE = 0.15f;
+	const float BALLOON_STRING_WIDTH = 0.025f;
+
+	/***********************************************************
+	 *  BuildModelMatrix()
+	 *
+	 *  This function returns the model matrix for the passed in
+	 *  scale, rotations in degrees and position.
+	 ***********************************************************/
+	glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ)
+	{
+		// variables for this function
+		glm::mat4 scale;
+		glm::mat4 rotationX;
+		glm::mat4 rotationY;
+		glm::mat4 rotationZ;
+		glm::mat4 translation;
+
+		// set the scale value in the transform buffer
+		scale = glm::scale(scaleXYZ);
+		// set the rotation values in the transform buffer
+		rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+		rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+		rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+		// set the translation value in the transform buffer
+		translation = glm::translate(positionXYZ);
+
+		return(translation * rotationZ * rotationY * rotationX * scale);
+	}
+
+	/***********************************************************
+	 *  BuildAlignedMatrix()
+	 *
+	 *  This function returns the model matrix for the passed in
+	 *  scale and position, turned so the Y axis of the mesh
+	 *  points along the passed in unit direction.
+	 ***********************************************************/
+	glm::mat4 BuildAlignedMatrix(
+		glm::vec3 scaleXYZ,
+		glm::vec3 axisY,
+		glm::vec3 positionXYZ)
+	{
+		glm::vec3 reference = (std::fabs(axisY.z) < 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		glm::vec3 axisX = glm::normalize(glm::cross(axisY, reference));
+		glm::vec3 axisZ = glm::cross(axisX, axisY);
+
+		glm::mat4 model(1.0f);
+		model[0] = glm::vec4(axisX * scaleXYZ.x, 0.0f);
+		model[1] = glm::vec4(axisY * scaleXYZ.y, 0.0f);
+		model[2] = glm::vec4(axisZ * scaleXYZ.z, 0.0f);
+		model[3] = glm::vec4(positionXYZ, 1.0f);
+		return(model);
+	}
+
+	/***********************************************************
+	 *  HashImagePixels()
+	 *
+	 *  This function returns a 64-bit hash of the size, the
+	 *  channels and the pixels of a decoded image, mixing eight
+	 *  bytes at a time so a large texture hashes quickly.  It
+	 *  never returns 0, which marks a texture as not hashed.
+	 ***********************************************************/
+	uint64_t HashImagePixels(const unsigned char* pixels, int width, int height, int colorChannels)
+	{
+		const uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+		uint64_t hash = ((uint64_t)width << 40) ^ ((uint64_t)height << 16) ^ (uint64_t)colorChannels;
+		hash *= MULTIPLIER;
+
+		size_t size = (size_t)width * height * colorChannels;
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			uint64_t word;
+			memcpy(&word, pixels + i, 8);
+			hash ^= word * MULTIPLIER;
+			hash = ((hash << 31) | (hash >> 33)) * 0xBF58476D1CE4E5B9ULL;
+		}
+		for (; i < size; i++)
+		{
+			hash ^= pixels[i];
+			hash *= 1099511628211ULL;
+		}
+
+		// spread the last words over every bit
+		hash ^= hash >> 31;
+		hash *= 0x94D049BB133111EBULL;
+		hash ^= hash >> 29;
+		return((0 == hash) ? 1 : hash);
+	}
 }
 
 /***********************************************************
@@ -51,6 +229,39 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
+	m_pFrameArena = new FrameArena(FRAME_ARENA_BYTES);
+	m_loadedTextures = 0;
+	m_bSceneFileLoaded = false;
+	m_bBalloonPhysics = false;
+	m_bTextureAtlas = false;
+	m_bDedupeTextures = false;
+	for (int i = 0; i < MAX_TEXTURE_SLOTS; i++)
+	{
+		m_textureIDs[i].contentHash = 0;
+		m_textureIDs[i].contentBytes = 0;
+		m_textureIDs[i].references = 0;
+		m_textureIDs[i].width = 0;
+		m_textureIDs[i].height = 0;
+		m_textureIDs[i].colorChannels = 0;
+	}
+
+	BALLOON_POSE partyBalloon = { PARTY_BALLOON_POSITION, PARTY_BALLOON_ANCHOR, PARTY_BALLOON_RADIUS };
+	m_balloonPoses.assign(1, partyBalloon);
+
+	for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+	{
+		std::string light = "pointLights[" + std::to_string(i) + "]";
+		m_lightUniformNames.push_back(light + ".position");
+		m_lightUniformNames.push_back(light + ".diffuse");
+		m_lightUniformNames.push_back(light + ".specular");
+	}
+
+	DECODED_IMAGE emptyImage = { NULL, 0, 0, 0 };
+	m_decodedImages.assign(TOTAL_SCENE_TEXTURES, emptyImage);
+
+	// indicate to always flip images vertically when loaded - this
+	// is set once here, before any decoding threads are started
+	stbi_set_flip_vertically_on_load(true);
 }
 
 /***********************************************************
@@ -60,9 +271,24 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
  ***********************************************************/
 SceneManager::~SceneManager()
 {
+	// free any decoded images that were never uploaded
+	for (DECODED_IMAGE& image : m_decodedImages)
+	{
+		if (NULL != image.pixels)
+		{
+			AssetPack::FreeImagePixels(image.pixels);
+			image.pixels = NULL;
+		}
+	}
+
+	// free the scene textures while the OpenGL context still exists
+	DestroyGLTextures();
+
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_pFrameArena;
+	m_pFrameArena = NULL;
 }
 
 /***********************************************************
@@ -75,68 +301,296 @@ SceneManager::~SceneManager()
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
+	TRACE_SCOPE("CreateGLTexture");
 
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
+	DECODED_IMAGE image = { NULL, 0, 0, 0 };
 
 	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
+	if (DecodeTextureImage(filename, image) == false)
+	{
+		return false;
+	}
+
+	return(UploadGLTexture(image, tag));
+}
+
+/***********************************************************
+ *  DecodeTextureImage()
+ *
+ *  This method is used for reading and decoding an image
+ *  file into memory.  It makes no OpenGL calls, so it can
+ *  run on a worker thread while the OpenGL context is still
+ *  being created.  An image file edited while the program
+ *  runs is read from disk, as the mounted asset pack holds
+ *  the image as it was packed.
+ ***********************************************************/
+bool SceneManager::DecodeTextureImage(const char* filename, DECODED_IMAGE& image, bool bFromDisk)
+{
+	TRACE_SCOPE("DecodeTextureImage");
+	HitchActivity activity(HitchDetector::ACTIVITY_ASSET_LOAD, filename);
+
+	// try to parse the image data from the specified image file -
+	// either way the pixels are freed with AssetPack::FreeImagePixels()
+	if (true == bFromDisk)
+	{
+		image.pixels = stbi_load(
+			filename,
+			&image.width,
+			&image.height,
+			&image.colorChannels,
+			0);
+	}
+	else
+	{
+		image.pixels = AssetPack::LoadImagePixels(
+			filename,
+			&image.width,
+			&image.height,
+			&image.colorChannels,
+			0);
+	}
 
 	// if the image was successfully read from the image file
-	if (image)
+	if (image.pixels)
 	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
+		std::cout << "Successfully loaded image:" << filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.colorChannels << std::endl;
+		return true;
+	}
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
+	std::cout << "Could not load image:" << filename << std::endl;
 
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// Error loading the image
+	return false;
+}
 
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+/***********************************************************
+ *  DecodeTextureImage()
+ *
+ *  This method is used for decoding the bytes of an image
+ *  file that were read into memory ahead of time, such as by
+ *  a batch of file reads.  It makes no OpenGL calls and
+ *  reads no files.
+ ***********************************************************/
+bool SceneManager::DecodeTextureImage(
+	const char* filename,
+	const unsigned char* fileData,
+	size_t fileSize,
+	DECODED_IMAGE& image)
+{
+	TRACE_SCOPE("DecodeTextureImage");
+	HitchActivity activity(HitchDetector::ACTIVITY_ASSET_LOAD, filename);
+
+	// the pixels are freed with AssetPack::FreeImagePixels(), which
+	// hands pixels that are not from the pack to stbi_image_free()
+	image.pixels = stbi_load_from_memory(
+		fileData,
+		(int)fileSize,
+		&image.width,
+		&image.height,
+		&image.colorChannels,
+		0);
+
+	if (image.pixels)
+	{
+		std::cout << "Successfully loaded image:" << filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.colorChannels << std::endl;
+		return true;
+	}
+
+	std::cout << "Could not load image:" << filename << std::endl;
+	return false;
+}
+
+/***********************************************************
+ *  UploadGLTexture()
+ *
+ *  This method is used for configuring the texture mapping
+ *  parameters in OpenGL, uploading the decoded image data,
+ *  generating the mipmaps, and loading the texture into the
+ *  passed in texture slot, or the first free slot when the
+ *  slot is -1.  Uploading into a slot that is in use replaces
+ *  its texture with a new one.  The decoded image data is
+ *  freed afterwards, unless it is to be kept for another
+ *  upload.
+ ***********************************************************/
+bool SceneManager::UploadGLTexture(DECODED_IMAGE& image, std::string tag, int slot, bool bKeepPixels)
+{
+	TRACE_SCOPE("UploadGLTexture");
+
+	if (NULL == image.pixels)
+	{
+		return false;
+	}
+
+	// if the loaded image is not in a supported format
+	if ((image.colorChannels != 3) && (image.colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << image.colorChannels << " channels" << std::endl;
+		if (false == bKeepPixels)
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
+			AssetPack::FreeImagePixels(image.pixels);
+			image.pixels = NULL;
 		}
+		return false;
+	}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+	// textures are looked up by the hash of their tag, so the tag
+	// must not collide with another name or be loaded in another
+	// slot
+	ResourceTag key;
+	int loadedSlot = -1;
+	if (ResourceTag::Register(tag, key) == true)
+	{
+		loadedSlot = FindTextureSlot(key);
+	}
+	if ((false == key.IsValid()) || ((loadedSlot >= 0) && (loadedSlot != slot)))
+	{
+		std::cout << "Could not register texture tag:" << tag << std::endl;
+		if (false == bKeepPixels)
+		{
+			AssetPack::FreeImagePixels(image.pixels);
+			image.pixels = NULL;
+		}
+		return false;
+	}
+
+	// a new tag whose pixels match a loaded texture shares that
+	// texture instead of uploading a copy of it
+	uint64_t contentHash = 0;
+	if (true == m_bDedupeTextures)
+	{
+		contentHash = HashImagePixels(image.pixels, image.width, image.height, image.colorChannels);
+		int duplicate = (slot < 0) ? FindDuplicateTexture(contentHash) : -1;
+		if (duplicate >= 0)
+		{
+			TEXTURE_ALIAS alias;
+			alias.tag = tag;
+			alias.key = key;
+			alias.slot = duplicate;
+			m_textureAliases.push_back(alias);
+			m_textureIDs[duplicate].references++;
+			std::cout << "INFO: texture " << tag << " shares the texture of " << m_textureIDs[duplicate].tag << std::endl;
+
+			if (false == bKeepPixels)
+			{
+				AssetPack::FreeImagePixels(image.pixels);
+				image.pixels = NULL;
+			}
+			return true;
+		}
+	}
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	// find the first free slot
+	for (int i = 0; (slot < 0) && (i < MAX_TEXTURE_SLOTS); i++)
+	{
+		if (0 == m_textureIDs[i].texture.Get())
+		{
+			slot = i;
+		}
+	}
+	if ((slot < 0) || (slot >= MAX_TEXTURE_SLOTS))
+	{
+		std::cout << "No free texture slot for texture:" << tag << std::endl;
+		if (false == bKeepPixels)
+		{
+			AssetPack::FreeImagePixels(image.pixels);
+			image.pixels = NULL;
+		}
+		return false;
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	// the texture handle records the texture with the resource
+	// tracker and deletes it when the texture is destroyed
+	GLTextureHandle& texture = m_textureIDs[slot].texture;
+	texture.Create(tag, GPU_RESOURCE_SITE);
+	glBindTexture(GL_TEXTURE_2D, texture.Get());
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// if the loaded image is in RGB format
+	if (image.colorChannels == 3)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels);
+	// if the loaded image is in RGBA format - it supports transparency
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+	texture.SetByteSize(GpuResourceTracker::GetTextureBytes(
+		image.width, image.height, image.colorChannels, true));
+
+	// free the image data from local memory
+	if (false == bKeepPixels)
+	{
+		AssetPack::FreeImagePixels(image.pixels);
+		image.pixels = NULL;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+
+	// register the loaded texture and associate it with the special tag string -
+	// a texture replaced in place keeps the tags that share it
+	m_textureIDs[slot].tag = tag;
+	m_textureIDs[slot].key = key;
+	m_textureIDs[slot].contentHash = contentHash;
+	m_textureIDs[slot].contentBytes = GpuResourceTracker::GetTextureBytes(
+		image.width, image.height, image.colorChannels, true);
+	if (m_textureIDs[slot].references < 1)
+	{
+		m_textureIDs[slot].references = 1;
+	}
+	m_textureIDs[slot].width = image.width;
+	m_textureIDs[slot].height = image.height;
+	m_textureIDs[slot].colorChannels = image.colorChannels;
+	if (slot >= m_loadedTextures)
+	{
+		m_loadedTextures = slot + 1;
+	}
 
-		return true;
+	return true;
+}
+
+/***********************************************************
+ *  UpdateTextureInPlace()
+ *
+ *  This method is used for copying a changed image over the
+ *  texture in a slot and remaking its mipmaps, keeping the
+ *  texture object, so nothing that refers to it has to
+ *  change.  It returns false, touching nothing, when the
+ *  image does not have the size and channels of the image the
+ *  texture was made from.
+ ***********************************************************/
+bool SceneManager::UpdateTextureInPlace(int slot, const DECODED_IMAGE& image)
+{
+	TEXTURE_INFO& info = m_textureIDs[slot];
+	if ((NULL == image.pixels) || (0 == info.texture.Get()) ||
+		(image.width != info.width) || (image.height != info.height) ||
+		(image.colorChannels != info.colorChannels))
+	{
+		return(false);
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// the texture stays bound to the unit of its slot
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, info.texture.Get());
+	// rows of RGB images are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height,
+		(image.colorChannels == 4) ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, image.pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glActiveTexture(GL_TEXTURE0);
+	RenderStats::Count(RenderStats::TEXTURE_BINDS);
+
+	if (true == m_bDedupeTextures)
+	{
+		info.contentHash = HashImagePixels(image.pixels, image.width, image.height, image.colorChannels);
+	}
 
-	// Error loading the image
-	return false;
+	return(true);
 }
 
 /***********************************************************
@@ -151,8 +605,9 @@ void SceneManager::BindGLTextures()
 	{
 		// bind textures on corresponding texture units
 		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].texture.Get());
 	}
+	RenderStats::Count(RenderStats::TEXTURE_BINDS, m_loadedTextures);
 }
 
 /***********************************************************
@@ -165,7 +620,76 @@ void SceneManager::DestroyGLTextures()
 {
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_textureIDs[i].texture.Reset();
+		m_textureIDs[i].tag.clear();
+		m_textureIDs[i].key = ResourceTag();
+		m_textureIDs[i].filename.clear();
+		m_textureIDs[i].contentHash = 0;
+		m_textureIDs[i].contentBytes = 0;
+		m_textureIDs[i].references = 0;
+		m_textureIDs[i].width = 0;
+		m_textureIDs[i].height = 0;
+		m_textureIDs[i].colorChannels = 0;
+	}
+	m_loadedTextures = 0;
+	m_atlasEntries.clear();
+	m_textureAliases.clear();
+}
+
+/***********************************************************
+ *  DestroyGLTexture()
+ *
+ *  This method is used for freeing the texture in one slot.
+ *  The slot is left free for the next texture to be loaded.
+ ***********************************************************/
+void SceneManager::DestroyGLTexture(int slot)
+{
+	if ((slot < 0) || (slot >= m_loadedTextures))
+	{
+		return;
+	}
+
+	m_textureIDs[slot].texture.Reset();
+	m_textureIDs[slot].tag.clear();
+	m_textureIDs[slot].key = ResourceTag();
+	m_textureIDs[slot].filename.clear();
+	m_textureIDs[slot].contentHash = 0;
+	m_textureIDs[slot].contentBytes = 0;
+	m_textureIDs[slot].references = 0;
+	m_textureIDs[slot].width = 0;
+	m_textureIDs[slot].height = 0;
+	m_textureIDs[slot].colorChannels = 0;
+
+	// the tags sharing the texture go with it
+	for (size_t i = 0; i < m_textureAliases.size();)
+	{
+		if (m_textureAliases[i].slot == slot)
+		{
+			m_textureAliases.erase(m_textureAliases.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// the textures packed into an atlas page go with it
+	for (size_t i = 0; i < m_atlasEntries.size();)
+	{
+		if (m_atlasEntries[i].pageSlot == slot)
+		{
+			m_atlasEntries.erase(m_atlasEntries.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// only bind the slots up to the last one in use
+	while ((m_loadedTextures > 0) && (0 == m_textureIDs[m_loadedTextures - 1].texture.Get()))
+	{
+		m_loadedTextures--;
 	}
 }
 
@@ -175,7 +699,7 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(ResourceTag tag)
 {
 	int textureID = -1;
 	int index = 0;
@@ -183,15 +707,22 @@ int SceneManager::FindTextureID(std::string tag)
 
 	while ((index < m_loadedTextures) && (bFound == false))
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		if ((m_textureIDs[index].key == tag) && (0 != m_textureIDs[index].texture.Get()))
 		{
-			textureID = m_textureIDs[index].ID;
+			textureID = m_textureIDs[index].texture.Get();
 			bFound = true;
 		}
 		else
 			index++;
 	}
 
+	// a tag may share the texture of another slot
+	int alias = (bFound == false) ? FindTextureAlias(tag) : -1;
+	if (alias >= 0)
+	{
+		textureID = m_textureIDs[m_textureAliases[alias].slot].texture.Get();
+	}
+
 	return(textureID);
 }
 
@@ -201,7 +732,7 @@ int SceneManager::FindTextureID(std::string tag)
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(ResourceTag tag)
 {
 	int textureSlot = -1;
 	int index = 0;
@@ -209,7 +740,7 @@ int SceneManager::FindTextureSlot(std::string tag)
 
 	while ((index < m_loadedTextures) && (bFound == false))
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		if ((m_textureIDs[index].key == tag) && (0 != m_textureIDs[index].texture.Get()))
 		{
 			textureSlot = index;
 			bFound = true;
@@ -218,16 +749,176 @@ int SceneManager::FindTextureSlot(std::string tag)
 			index++;
 	}
 
+	// a tag may share the texture of another slot
+	int alias = (bFound == false) ? FindTextureAlias(tag) : -1;
+	if (alias >= 0)
+	{
+		textureSlot = m_textureAliases[alias].slot;
+	}
+
 	return(textureSlot);
 }
 
+/***********************************************************
+ *  FindTextureAlias()
+ *
+ *  This method is used for getting the index of the alias
+ *  with the passed in tag, or -1 when the tag does not share
+ *  the texture of another slot.
+ ***********************************************************/
+int SceneManager::FindTextureAlias(ResourceTag tag) const
+{
+	for (int i = 0; i < (int)m_textureAliases.size(); i++)
+	{
+		if (m_textureAliases[i].key == tag)
+		{
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  FindDuplicateTexture()
+ *
+ *  This method is used for getting the slot of a loaded
+ *  texture whose decoded image had the passed in content
+ *  hash, or -1 when there is none.
+ ***********************************************************/
+int SceneManager::FindDuplicateTexture(uint64_t contentHash) const
+{
+	for (int i = 0; (0 != contentHash) && (i < m_loadedTextures); i++)
+	{
+		if ((m_textureIDs[i].contentHash == contentHash) && (0 != m_textureIDs[i].texture.Get()))
+		{
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  GetReloadFilename()
+ *
+ *  This method is used for keeping a copy of an image
+ *  filename that stays valid for the whole run, since the
+ *  hitch detector reports the loads by name frames later.
+ *  Each file is copied once, however often it is reloaded.
+ ***********************************************************/
+const char* SceneManager::GetReloadFilename(const std::string& filename)
+{
+	return(m_reloadFilenames.insert(filename).first->c_str());
+}
+
+/***********************************************************
+ *  SetTextureFile()
+ *
+ *  This method is used for remembering the image file that a
+ *  loaded texture tag came from, whether the tag has a slot
+ *  of its own or shares one, so the texture can be reloaded.
+ ***********************************************************/
+void SceneManager::SetTextureFile(ResourceTag tag, const std::string& filename)
+{
+	int alias = FindTextureAlias(tag);
+	if (alias >= 0)
+	{
+		m_textureAliases[alias].filename = filename;
+		return;
+	}
+
+	int slot = FindTextureSlot(tag);
+	if (slot >= 0)
+	{
+		m_textureIDs[slot].filename = filename;
+	}
+}
+
+/***********************************************************
+ *  UnshareTexture()
+ *
+ *  This method is used for taking a tag off a texture it
+ *  shares with other tags, before the tag is loaded from
+ *  another image.  An alias lets go of the texture it uses,
+ *  and the tag of a shared slot hands the slot to one of its
+ *  aliases, so the other tags keep drawing with the texture.
+ *  It returns the slot the tag still has to itself, to
+ *  replace in place, or -1 when the tag is to be loaded into
+ *  a new slot.
+ ***********************************************************/
+int SceneManager::UnshareTexture(ResourceTag tag)
+{
+	int alias = FindTextureAlias(tag);
+	if (alias >= 0)
+	{
+		m_textureIDs[m_textureAliases[alias].slot].references--;
+		m_textureAliases.erase(m_textureAliases.begin() + alias);
+		return(-1);
+	}
+
+	int slot = FindTextureSlot(tag);
+	if ((slot >= 0) && (true == PromoteTextureAlias(slot)))
+	{
+		return(-1);
+	}
+
+	return(slot);
+}
+
+/***********************************************************
+ *  PromoteTextureAlias()
+ *
+ *  This method is used for handing the slot of a shared
+ *  texture over to the first tag that shares it, when the
+ *  tag of the slot lets go of the texture.  It returns false
+ *  when no other tag shares the texture.
+ ***********************************************************/
+bool SceneManager::PromoteTextureAlias(int slot)
+{
+	for (size_t i = 0; i < m_textureAliases.size(); i++)
+	{
+		if (m_textureAliases[i].slot == slot)
+		{
+			m_textureIDs[slot].tag = m_textureAliases[i].tag;
+			m_textureIDs[slot].key = m_textureAliases[i].key;
+			m_textureIDs[slot].filename = m_textureAliases[i].filename;
+			m_textureIDs[slot].references--;
+			m_textureAliases.erase(m_textureAliases.begin() + i);
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  FindAtlasEntry()
+ *
+ *  This method is used for getting the index of the texture
+ *  packed into an atlas page under the passed in tag, or -1
+ *  when no packed texture has the tag.
+ ***********************************************************/
+int SceneManager::FindAtlasEntry(ResourceTag tag) const
+{
+	for (int i = 0; i < (int)m_atlasEntries.size(); i++)
+	{
+		if (m_atlasEntries[i].key == tag)
+		{
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
 /***********************************************************
  *  FindMaterial()
  *
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(ResourceTag tag, OBJECT_MATERIAL& material)
 {
 	if (m_objectMaterials.size() == 0)
 	{
@@ -238,7 +929,7 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 	bool bFound = false;
 	while ((index < m_objectMaterials.size()) && (bFound == false))
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		if (m_objectMaterials[index].key == tag)
 		{
 			bFound = true;
 			material.diffuseColor = m_objectMaterials[index].diffuseColor;
@@ -251,7 +942,7 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 		}
 	}
 
-	return(true);
+	return(bFound);
 }
 
 /***********************************************************
@@ -269,26 +960,14 @@ void SceneManager::SetTransformations(
 {
 	// variables for this method
 	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+
+	modelView = BuildModelMatrix(
+		scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 
 	if (NULL != m_pShaderManager)
 	{
 		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES);
 	}
 }
 
@@ -316,6 +995,7 @@ void SceneManager::SetShaderColor(
 	{
 		m_pShaderManager->setIntValue(g_UseTextureName, false);
 		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES, 2);
 	}
 }
 
@@ -326,7 +1006,7 @@ void SceneManager::SetShaderColor(
  *  associated with the passed in ID into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	ResourceTag textureTag)
 {
 	if (NULL != m_pShaderManager)
 	{
@@ -334,7 +1014,32 @@ void SceneManager::SetShaderTexture(
 
 		int textureID = -1;
 		textureID = FindTextureSlot(textureTag);
+
+		// a texture packed into an atlas page is sampled from the
+		// page, inside its rectangle
+		if (false == m_atlasEntries.empty())
+		{
+			glm::vec4 atlasRect = FULL_TEXTURE_RECT;
+			int entry = (textureID < 0) ? FindAtlasEntry(textureTag) : -1;
+			if (entry >= 0)
+			{
+				textureID = m_atlasEntries[entry].pageSlot;
+				atlasRect = m_atlasEntries[entry].uvRect;
+			}
+			m_pShaderManager->setVec4Value(g_AtlasRectName, atlasRect);
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+		}
+#ifndef NDEBUG
+		if ((textureID < 0) && (m_missingTextureTag != textureTag))
+		{
+			// report each missing texture once, by name
+			std::cout << "No texture is loaded with the tag:" << textureTag.GetName() << std::endl;
+			m_missingTextureTag = textureTag;
+		}
+#endif
 		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES, 2);
+		RenderStats::Count(RenderStats::TEXTURE_BINDS);
 	}
 }
 
@@ -348,7 +1053,8 @@ void SceneManager::SetTextureUVScale(float u, float v)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_pShaderManager->setVec2Value(g_UVScaleName, glm::vec2(u, v));
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES);
 	}
 }
 /***********************************************************
@@ -361,59 +1067,476 @@ void SceneManager::SetTextureUVScale(float u, float v)
  ***********************************************************/
 void SceneManager::LoadSceneTextures()
 {
-	/*** STUDENTS - add the code BELOW for loading the textures that ***/
-	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
-	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
-	/*** the OpenGL Sample for help.                                 ***/
+	TRACE_SCOPE("LoadSceneTextures");
+
+	/*** STUDENTS - add the textures that will be used for mapping ***/
+	/*** to objects in the 3D scene to the g_SceneTextures table at ***/
+	/*** the top of this file. Up to 16 textures can be loaded per  ***/
+	/*** scene. Refer to the code in the OpenGL Sample for help.    ***/
 
 	//5-2 assignment
-	bool bReturn = false;
-
-	bReturn = CreateGLTexture(
-		"textures/Party_hat.jpg",
-		"Party");
-	bReturn = CreateGLTexture(
-		"textures/blue_party.jpg",
-		"Blue");
-	bReturn = CreateGLTexture(
-		"textures/Check_floor.jpg",
-		"Floor");
-	bReturn = CreateGLTexture(
-		"textures/table.jpg",
-		"Table");
-	bReturn = CreateGLTexture(
-		"textures/Plate.jpg",
-		"Plate");
-	bReturn = CreateGLTexture(
-		"textures/top_frosting.png",
-		"Frost");
-	bReturn = CreateGLTexture(
-		"textures/frosting_sides.png",
-		"Frost_sides");
-	bReturn = CreateGLTexture(
-		"textures/Purple_balloon.png",
-		"balloon");
-	bReturn = CreateGLTexture(
-		"textures/red_present.jpg",
-		"present");
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
-	BindGLTextures();
+	for (int i = 0; i < TOTAL_SCENE_TEXTURES; i++)
+	{
+		DecodeSceneTexture(i);
+	}
+
+	UploadSceneTextures();
 }
 
 /***********************************************************
- *  DefineObjectMaterials()
+ *  GetSceneTextureCount()
  *
- *  This method is used for configuring the various material
- *  settings for all of the objects within the 3D scene.
- * 
- * ADDED FOR 6-3
+ *  This method returns the number of scene texture files.
  ***********************************************************/
-void SceneManager::DefineObjectMaterials()
+int SceneManager::GetSceneTextureCount() const
 {
+	return(TOTAL_SCENE_TEXTURES);
+}
 
-	OBJECT_MATERIAL candleMaterial;
+/***********************************************************
+ *  DecodeSceneTexture()
+ *
+ *  This method is used for decoding one of the scene texture
+ *  files into memory.  It makes no OpenGL calls and every
+ *  index has its own storage, so different textures can be
+ *  decoded on different threads at the same time.
+ ***********************************************************/
+bool SceneManager::DecodeSceneTexture(int index)
+{
+	if ((index < 0) || (index >= TOTAL_SCENE_TEXTURES))
+	{
+		return false;
+	}
+
+	return(DecodeTextureImage(g_SceneTextures[index].filename, m_decodedImages[index]));
+}
+
+/***********************************************************
+ *  DecodeSceneTexture()
+ *
+ *  This method is used for decoding one of the scene texture
+ *  files from the bytes of the file, read into memory ahead
+ *  of time.  Like the method above, it can run on any thread.
+ ***********************************************************/
+bool SceneManager::DecodeSceneTexture(int index, const unsigned char* fileData, size_t fileSize)
+{
+	if ((index < 0) || (index >= TOTAL_SCENE_TEXTURES))
+	{
+		return false;
+	}
+
+	return(DecodeTextureImage(g_SceneTextures[index].filename, fileData, fileSize, m_decodedImages[index]));
+}
+
+/***********************************************************
+ *  UploadSceneTextures()
+ *
+ *  This method is used for uploading all of the decoded
+ *  scene textures to OpenGL, in table order, and binding
+ *  them to texture slots.  It must run on the thread that
+ *  owns the OpenGL context.
+ ***********************************************************/
+void SceneManager::UploadSceneTextures()
+{
+	TRACE_SCOPE("UploadSceneTextures");
+
+	// the small textures go into atlas pages first, and the rest
+	// are uploaded on their own
+	if (true == m_bTextureAtlas)
+	{
+		UploadTextureAtlas();
+	}
+
+	for (int i = 0; i < TOTAL_SCENE_TEXTURES; i++)
+	{
+		if (NULL == m_decodedImages[i].pixels)
+		{
+			continue;
+		}
+
+		UploadGLTexture(m_decodedImages[i], g_SceneTextures[i].tag);
+
+		// remember the file so the texture can be reloaded
+		SetTextureFile(ResourceTag::FromString(g_SceneTextures[i].tag), g_SceneTextures[i].filename);
+	}
+
+	// after the texture image data is loaded into memory, the
+	// loaded textures need to be bound to texture slots - there
+	// are a total of 16 available slots for scene textures
+	BindGLTextures();
+}
+
+/***********************************************************
+ *  SetTextureAtlas()
+ *
+ *  This method is used for choosing whether the small scene
+ *  textures are packed into atlas pages when the scene
+ *  textures are uploaded.
+ ***********************************************************/
+void SceneManager::SetTextureAtlas(bool bTextureAtlas)
+{
+	m_bTextureAtlas = bTextureAtlas;
+}
+
+/***********************************************************
+ *  SetTextureDeduplication()
+ *
+ *  This method is used for choosing whether a texture tag
+ *  whose decoded image has the same pixels as a loaded
+ *  texture shares that texture, rather than uploading a copy.
+ ***********************************************************/
+void SceneManager::SetTextureDeduplication(bool bDedupeTextures)
+{
+	m_bDedupeTextures = bDedupeTextures;
+}
+
+/***********************************************************
+ *  GetSharedTextureCount()
+ *
+ *  This method returns the number of texture tags that share
+ *  the texture of another tag.
+ ***********************************************************/
+int SceneManager::GetSharedTextureCount() const
+{
+	return((int)m_textureAliases.size());
+}
+
+/***********************************************************
+ *  GetDeduplicatedBytes()
+ *
+ *  This method returns the GPU bytes the tags sharing the
+ *  texture of another tag would have taken up with textures
+ *  of their own.
+ ***********************************************************/
+size_t SceneManager::GetDeduplicatedBytes() const
+{
+	size_t bytes = 0;
+	for (const TEXTURE_ALIAS& alias : m_textureAliases)
+	{
+		bytes += m_textureIDs[alias.slot].contentBytes;
+	}
+
+	return(bytes);
+}
+
+/***********************************************************
+ *  UploadTextureAtlas()
+ *
+ *  This method is used for packing the decoded scene textures
+ *  small enough to share a page into atlas pages, tallest
+ *  first, and uploading each page into a texture slot of its
+ *  own.  The decoded images of the packed textures are freed;
+ *  a texture that does not fit, or whose page finds no free
+ *  slot, is left to be uploaded on its own.
+ ***********************************************************/
+void SceneManager::UploadTextureAtlas()
+{
+	TRACE_SCOPE("UploadTextureAtlas");
+
+	std::vector<int> packOrder;
+	for (int i = 0; i < TOTAL_SCENE_TEXTURES; i++)
+	{
+		const DECODED_IMAGE& image = m_decodedImages[i];
+		if ((NULL != image.pixels) &&
+			((image.colorChannels == 3) || (image.colorChannels == 4)) &&
+			(image.width <= ATLAS_MAX_TEXTURE_SIZE) && (image.height <= ATLAS_MAX_TEXTURE_SIZE))
+		{
+			packOrder.push_back(i);
+		}
+	}
+	std::sort(packOrder.begin(), packOrder.end(),
+		[this](int a, int b) { return(m_decodedImages[a].height > m_decodedImages[b].height); });
+
+	TextureAtlas atlas(ATLAS_PAGE_SIZE, ATLAS_ALIGNMENT);
+	std::vector<TextureAtlas::ATLAS_RECT> rects(packOrder.size());
+	std::vector<bool> bPacked(packOrder.size(), false);
+	for (size_t i = 0; i < packOrder.size(); i++)
+	{
+		const DECODED_IMAGE& image = m_decodedImages[packOrder[i]];
+		bPacked[i] = atlas.Add(image.pixels, image.width, image.height, image.colorChannels, rects[i]);
+	}
+	if (0 == atlas.GetPageCount())
+	{
+		return;
+	}
+
+	// only the mip levels that keep the textures apart are made
+	int mipLevels = atlas.GetMipLevels();
+	size_t pageBytes = 0;
+	for (int level = 0; level < mipLevels; level++)
+	{
+		pageBytes += GpuResourceTracker::GetTextureBytes(
+			ATLAS_PAGE_SIZE >> level, ATLAS_PAGE_SIZE >> level, 4, false);
+	}
+
+	std::vector<int> pageSlots(atlas.GetPageCount(), -1);
+	for (int page = 0; page < atlas.GetPageCount(); page++)
+	{
+		std::string tag = "atlas page " + std::to_string(page);
+		ResourceTag key;
+		if ((ResourceTag::Register(tag, key) == false) || (FindTextureSlot(key) >= 0))
+		{
+			std::cout << "Could not register texture tag:" << tag << std::endl;
+			continue;
+		}
+
+		int slot = -1;
+		for (int i = 0; (slot < 0) && (i < MAX_TEXTURE_SLOTS); i++)
+		{
+			if (0 == m_textureIDs[i].texture.Get())
+			{
+				slot = i;
+			}
+		}
+		if (slot < 0)
+		{
+			std::cout << "No free texture slot for texture:" << tag << std::endl;
+			break;
+		}
+
+		// the slot is bound to its texture unit for good
+		GLTextureHandle& texture = m_textureIDs[slot].texture;
+		texture.Create(tag, GPU_RESOURCE_SITE);
+		glActiveTexture(GL_TEXTURE0 + slot);
+		glBindTexture(GL_TEXTURE_2D, texture.Get());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, atlas.GetPagePixels(page));
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glActiveTexture(GL_TEXTURE0);
+		RenderStats::Count(RenderStats::TEXTURE_BINDS);
+		texture.SetByteSize(pageBytes);
+
+		m_textureIDs[slot].tag = tag;
+		m_textureIDs[slot].key = key;
+		m_textureIDs[slot].contentHash = 0;
+		m_textureIDs[slot].contentBytes = pageBytes;
+		m_textureIDs[slot].references = 1;
+		m_textureIDs[slot].width = 0;
+		m_textureIDs[slot].height = 0;
+		m_textureIDs[slot].colorChannels = 0;
+		if (slot >= m_loadedTextures)
+		{
+			m_loadedTextures = slot + 1;
+		}
+		pageSlots[page] = slot;
+	}
+
+	int packedTextures = 0;
+	for (size_t i = 0; i < packOrder.size(); i++)
+	{
+		int index = packOrder[i];
+		ATLAS_ENTRY entry;
+		entry.tag = g_SceneTextures[index].tag;
+		if ((false == bPacked[i]) || (pageSlots[rects[i].page] < 0) ||
+			(ResourceTag::Register(entry.tag, entry.key) == false) || (FindTextureSlot(entry.key) >= 0))
+		{
+			continue;
+		}
+		entry.filename = g_SceneTextures[index].filename;
+		entry.pageSlot = pageSlots[rects[i].page];
+		entry.x = rects[i].x;
+		entry.y = rects[i].y;
+		entry.width = rects[i].width;
+		entry.height = rects[i].height;
+		entry.uvRect = atlas.GetUVRect(rects[i]);
+		m_atlasEntries.push_back(entry);
+
+		AssetPack::FreeImagePixels(m_decodedImages[index].pixels);
+		m_decodedImages[index].pixels = NULL;
+		packedTextures++;
+	}
+
+	std::cout << "INFO: packed " << packedTextures << " textures into " << atlas.GetPageCount()
+		<< " atlas pages, page usage:" << (atlas.GetPageUsage() * 100.0) << "%" << std::endl;
+}
+
+/***********************************************************
+ *  GetSceneTextureFile()
+ *
+ *  This method returns the image file of one of the scene
+ *  textures, or NULL when the index is out of range.
+ ***********************************************************/
+const char* SceneManager::GetSceneTextureFile(int index) const
+{
+	if ((index < 0) || (index >= TOTAL_SCENE_TEXTURES))
+	{
+		return(NULL);
+	}
+
+	return(g_SceneTextures[index].filename);
+}
+
+/***********************************************************
+ *  GetSceneTextureTag()
+ *
+ *  This method returns the tag of one of the scene textures,
+ *  or NULL when the index is out of range.
+ ***********************************************************/
+const char* SceneManager::GetSceneTextureTag(int index) const
+{
+	if ((index < 0) || (index >= TOTAL_SCENE_TEXTURES))
+	{
+		return(NULL);
+	}
+
+	return(g_SceneTextures[index].tag);
+}
+
+/***********************************************************
+ *  CreatePlaceholderTexture()
+ *
+ *  This method is used for loading a 1x1 grey texture into
+ *  the first free texture slot under the passed in tag, so
+ *  the objects that use the tag can be drawn while the real
+ *  texture is loading.  It returns the slot, or -1 when the
+ *  tag cannot be registered or no slot is free.
+ ***********************************************************/
+int SceneManager::CreatePlaceholderTexture(const std::string& tag, const std::string& filename)
+{
+	const unsigned char placeholderPixel[4] = { 128, 128, 128, 255 };
+
+	ResourceTag key;
+	if ((ResourceTag::Register(tag, key) == false) || (FindTextureSlot(key) >= 0))
+	{
+		std::cout << "Could not register texture tag:" << tag << std::endl;
+		return(-1);
+	}
+
+	int slot = -1;
+	for (int i = 0; (slot < 0) && (i < MAX_TEXTURE_SLOTS); i++)
+	{
+		if (0 == m_textureIDs[i].texture.Get())
+		{
+			slot = i;
+		}
+	}
+	if (slot < 0)
+	{
+		std::cout << "No free texture slot for texture:" << tag << std::endl;
+		return(-1);
+	}
+
+	// the slot is bound to its texture unit for good
+	GLTextureHandle& texture = m_textureIDs[slot].texture;
+	texture.Create(tag + " placeholder", GPU_RESOURCE_SITE);
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, texture.Get());
+	glActiveTexture(GL_TEXTURE0);
+	RenderStats::Count(RenderStats::TEXTURE_BINDS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholderPixel);
+	texture.SetByteSize(GpuResourceTracker::GetTextureBytes(1, 1, 4, false));
+
+	m_textureIDs[slot].tag = tag;
+	m_textureIDs[slot].key = key;
+	m_textureIDs[slot].filename = filename;
+	m_textureIDs[slot].contentHash = 0;
+	m_textureIDs[slot].contentBytes = 0;
+	m_textureIDs[slot].references = 1;
+	m_textureIDs[slot].width = 0;
+	m_textureIDs[slot].height = 0;
+	m_textureIDs[slot].colorChannels = 0;
+	if (slot >= m_loadedTextures)
+	{
+		m_loadedTextures = slot + 1;
+	}
+
+	return(slot);
+}
+
+/***********************************************************
+ *  SwapInTexture()
+ *
+ *  This method is used for replacing the texture in a slot,
+ *  such as a placeholder, with a texture that has finished
+ *  loading.  The texture is taken from the passed in handle
+ *  and the old texture of the slot is freed.
+ ***********************************************************/
+bool SceneManager::SwapInTexture(int slot, GLTextureHandle& texture)
+{
+	if ((slot < 0) || (slot >= m_loadedTextures) || (0 == m_textureIDs[slot].texture.Get()))
+	{
+		return(false);
+	}
+
+	m_textureIDs[slot].texture = std::move(texture);
+	// the pixels of the new texture are not known
+	m_textureIDs[slot].contentHash = 0;
+	m_textureIDs[slot].width = 0;
+	m_textureIDs[slot].height = 0;
+	m_textureIDs[slot].colorChannels = 0;
+
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, m_textureIDs[slot].texture.Get());
+	glActiveTexture(GL_TEXTURE0);
+	RenderStats::Count(RenderStats::TEXTURE_BINDS);
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetSlotTexture()
+ *
+ *  This method returns the OpenGL texture in a slot, or 0
+ *  when the slot is empty or out of range.
+ ***********************************************************/
+uint32_t SceneManager::GetSlotTexture(int slot) const
+{
+	if ((slot < 0) || (slot >= m_loadedTextures))
+	{
+		return(0);
+	}
+
+	return(m_textureIDs[slot].texture.Get());
+}
+
+/***********************************************************
+ *  GetTextureSlot()
+ *
+ *  This method returns the slot of the texture loaded under
+ *  the passed in tag, or -1 when there is none.
+ ***********************************************************/
+int SceneManager::GetTextureSlot(const std::string& tag)
+{
+	return(FindTextureSlot(ResourceTag::FromString(tag)));
+}
+
+/***********************************************************
+ *  SetShaderManager()
+ *
+ *  This method is used to draw the scene with another shader
+ *  program that has the same uniforms, such as the texture
+ *  feedback shader.  It returns the previous shader manager
+ *  so it can be put back.
+ ***********************************************************/
+ShaderManager* SceneManager::SetShaderManager(ShaderManager* pShaderManager)
+{
+	ShaderManager* pPrevious = m_pShaderManager;
+	m_pShaderManager = pShaderManager;
+	return(pPrevious);
+}
+
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for configuring the various material
+ *  settings for all of the objects within the 3D scene.
+ * 
+ * ADDED FOR 6-3
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	TRACE_SCOPE("DefineObjectMaterials");
+
+	OBJECT_MATERIAL candleMaterial;
 	candleMaterial.tag = "Candle";
 	candleMaterial.diffuseColor = glm::vec3(1.0f, 0.85f, 0.5f);     // Warm yellow wax
 	candleMaterial.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);     // Subtle soft specular
@@ -463,6 +1586,11 @@ void SceneManager::DefineObjectMaterials()
 	ceramicMaterial.shininess = 48.0f;                            // Smooth glazed surface
 	m_objectMaterials.push_back(ceramicMaterial);
 
+	// materials are looked up by the hash of their tag
+	for (OBJECT_MATERIAL& material : m_objectMaterials)
+	{
+		ResourceTag::Register(material.tag, material.key);
+	}
 
 }
 
@@ -473,7 +1601,7 @@ void SceneManager::DefineObjectMaterials()
  *  into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	ResourceTag materialTag)
 {
 	if (m_objectMaterials.size() > 0)
 	{
@@ -483,13 +1611,48 @@ void SceneManager::SetShaderMaterial(
 		bReturn = FindMaterial(materialTag, material);
 		if (bReturn == true)
 		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_pShaderManager->setVec3Value(g_MaterialDiffuseName, material.diffuseColor);
+			m_pShaderManager->setVec3Value(g_MaterialSpecularName, material.specularColor);
+			m_pShaderManager->setFloatValue(g_MaterialShininessName, material.shininess);
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES, 3);
 		}
 	}
 }
 
+/***********************************************************
+ *  DrawShapeMesh()
+ *
+ *  This method is used for drawing one of the basic shape
+ *  meshes with the current shader settings, and counting
+ *  the draw in the render stats.
+ ***********************************************************/
+void SceneManager::DrawShapeMesh(SHAPE_MESH mesh)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CONE:
+		m_basicMeshes->DrawConeMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_PYRAMID4:
+		m_basicMeshes->DrawPyramid4Mesh();
+		break;
+	}
+
+	RenderStats::Count(RenderStats::DRAW_CALLS);
+}
+
 /**************************************************************/
 /*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
 /*** preparing and rendering their own 3D replicated scenes.***/
@@ -508,13 +1671,15 @@ void SceneManager::SetShaderMaterial(
 
 void SceneManager::SetupSceneLights()
 {
+	TRACE_SCOPE("SetupSceneLights");
+
 	// Enable lighting in the shader
 	m_pShaderManager->setBoolValue(g_UseLightingName, true);
 	// Point Light - Candle Flame (Main Focus)
 	m_pShaderManager->setVec3Value("pointLights[0].position", 0.0f, 8.3f, 0.0f);  // above candle
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.3f, 0.15f, 0.05f); // warm soft base
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 1.0f, 0.6f, 0.2f);   // flame orange
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 1.0f, 0.8f, 0.5f);  // warm spark
+	m_pShaderManager->setVec3Value(g_CandleAmbientName, CANDLE_AMBIENT_COLOR);   // warm soft base
+	m_pShaderManager->setVec3Value(g_CandleDiffuseName, CANDLE_DIFFUSE_COLOR);   // flame orange
+	m_pShaderManager->setVec3Value(g_CandleSpecularName, CANDLE_SPECULAR_COLOR); // warm spark
 	m_pShaderManager->setFloatValue("pointLights[0].constant", 1.0f);
 	m_pShaderManager->setFloatValue("pointLights[0].linear", 0.09f);
 	m_pShaderManager->setFloatValue("pointLights[0].quadratic", 0.032f);
@@ -537,8 +1702,11 @@ void SceneManager::SetupSceneLights()
 	m_pShaderManager->setFloatValue("pointLights[1].quadratic", 0.044f);
 	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
 
-
-
+	// a loaded scene description replaces the point lights
+	if (false == m_sceneLights.empty())
+	{
+		SetSceneLights();
+	}
 }
 
 
@@ -546,6 +1714,8 @@ void SceneManager::SetupSceneLights()
 void SceneManager::PrepareScene()
 
 {
+	TRACE_SCOPE("PrepareScene");
+
 	//5-3 assignment
 	LoadSceneTextures();
 
@@ -555,6 +1725,19 @@ void SceneManager::PrepareScene()
 	// 6-3 Assignment
 	DefineObjectMaterials();
 
+	LoadSceneMeshes();
+}
+
+/***********************************************************
+ *  LoadSceneMeshes()
+ *
+ *  This method is used for loading the basic shape meshes
+ *  used by the 3D scene into OpenGL memory.
+ ***********************************************************/
+void SceneManager::LoadSceneMeshes()
+{
+	TRACE_SCOPE("LoadSceneMeshes");
+
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
 	// in the rendered 3D scene
@@ -575,6 +1758,31 @@ void SceneManager::PrepareScene()
  ***********************************************************/
 void SceneManager::RenderScene()
 {
+	TRACE_SCOPE("RenderScene");
+	// everything allocated from the arena by the last frame is
+	// no longer in use
+	m_pFrameArena->Reset();
+
+#ifdef BAKED_SCENE
+	// fixed installations stream the scene baked at compile time
+	RenderBakedScene();
+	return;
+#endif
+	// a scene loaded from a scene description file replaces the
+	// scene below
+	if (true == m_bSceneFileLoaded)
+	{
+		RenderSceneObjects();
+		// balloons moved by the balloon physics float over any scene
+		if (true == m_bBalloonPhysics)
+		{
+			RenderBalloons();
+		}
+		return;
+	}
+	// time each part of the scene for the hitch log
+	HitchSteps sceneSteps;
+
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
 	float XrotationDegrees = 0.0f;
@@ -586,6 +1794,7 @@ void SceneManager::RenderScene()
 	/*** This same ordering of code should be used for transforming ***/
 	/*** and drawing all the basic 3D shapes.						***/
 	/******************************************************************/
+	sceneSteps.Next("Floor");
 	// set the XYZ scale for the mesh
 	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
 
@@ -606,15 +1815,16 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	//SetShaderColor(1, 1, 1, 1);
-	SetShaderTexture("Floor");
+	SetShaderTexture(TAG("Floor"));
 	SetTextureUVScale(2.50f, 2.50f);
 
 
 	// draw the mesh with transformation values
-	SetShaderMaterial("Ceramic");
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderMaterial(TAG("Ceramic"));
+	DrawShapeMesh(MESH_PLANE);
 	/****************************************************************/
 	//cone shape (party hat)
+	sceneSteps.Next("PartyHat");
 	scaleXYZ = glm::vec3(1.0f, 2.25f, 1.0f);               // size of  cone
 	positionXYZ = glm::vec3(5.0f, 4.36, -1.5f);            //moved to the side so its not on top of the cube
 	XrotationDegrees = 0.0f;
@@ -623,11 +1833,11 @@ void SceneManager::RenderScene()
 
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.9f, 0.9f, 0.4f, 1.0f);               //yellow base
-	SetShaderTexture("Party");
+	SetShaderTexture(TAG("Party"));
 	SetTextureUVScale(1.0f, 1.0f);
 
-	SetShaderMaterial("PaperHat");
-	m_basicMeshes->DrawConeMesh();
+	SetShaderMaterial(TAG("PaperHat"));
+	DrawShapeMesh(MESH_CONE);
 
 	//sphere for the top of the party hat
 	scaleXYZ = glm::vec3(0.25f, 0.25f, 0.25f);               // size of  cone
@@ -638,11 +1848,11 @@ void SceneManager::RenderScene()
 
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.25f, 0.35f, 0.6f, 1.0f);  // dark blue
-	SetShaderTexture("Blue");
+	SetShaderTexture(TAG("Blue"));
 	SetTextureUVScale(1.0f, 1.0f);
 
-	SetShaderMaterial("PaperHat");
-	m_basicMeshes->DrawSphereMesh();
+	SetShaderMaterial(TAG("PaperHat"));
+	DrawShapeMesh(MESH_SPHERE);
 
 	//Flat cube for napkin
 	scaleXYZ = glm::vec3(5.0f, 0.01f, 5.0);               //size of the napkin
@@ -653,14 +1863,15 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.25f, 0.35f, 0.6f, 1.0f); //dark blue
 
-	SetShaderTexture("Blue");
+	SetShaderTexture(TAG("Blue"));
 	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	DrawShapeMesh(MESH_BOX);
 	
 
 	//milestone 4-3: table top 
 
 	// Box for table top
+	sceneSteps.Next("Table");
 	scaleXYZ = glm::vec3(19.0f, 0.50f, 10.0f);            // size of the table top
 	positionXYZ = glm::vec3(0.0f, 4.0f, 0.0f);         // height above the legs
 
@@ -672,11 +1883,11 @@ void SceneManager::RenderScene()
 	
 	// SetShaderColor(0.4f, 0.2f, 0.1f, 1.0f);            //dark brown 
 
-	SetShaderTexture("Table");            
+	SetShaderTexture(TAG("Table"));            
 	SetTextureUVScale(3.0f, 3.0f);         
 
-	SetShaderMaterial("Wood");
-	m_basicMeshes->DrawBoxMesh();
+	SetShaderMaterial(TAG("Wood"));
+	DrawShapeMesh(MESH_BOX);
 
 	// 4 boxes to act as table legs: i combined all 4 shapes in order to keep code neat and readible 
 	scaleXYZ = glm::vec3(0.3f, 4.0f, 0.3f);  // leg size
@@ -687,27 +1898,34 @@ void SceneManager::RenderScene()
 	float legHeight = scaleXYZ.y;                 // uses the same height as the table
 	float legCenterY = legHeight / 2.0f;        // this will ensure that the legs dont go under the plane
 
-	// leg Postitions
-	std::vector<glm::vec3> legPositions = {
-		glm::vec3(-9.2f, legCenterY, -4.7f),
-		glm::vec3(9.2f, legCenterY, -4.7f),  
-		glm::vec3(-9.2f, legCenterY,  4.7f), 
-		glm::vec3(9.2f, legCenterY,  4.7f)   
-	};
+	// leg Postitions - taken from the frame arena so the frame
+	// does not allocate from the heap
+	const int TOTAL_LEGS = 4;
+	glm::vec3* legPositions = m_pFrameArena->AllocateArray<glm::vec3>(TOTAL_LEGS);
+	int legCount = 0;
+	if (NULL != legPositions)
+	{
+		legPositions[0] = glm::vec3(-9.2f, legCenterY, -4.7f);
+		legPositions[1] = glm::vec3(9.2f, legCenterY, -4.7f);
+		legPositions[2] = glm::vec3(-9.2f, legCenterY,  4.7f);
+		legPositions[3] = glm::vec3(9.2f, legCenterY,  4.7f);
+		legCount = TOTAL_LEGS;
+	}
 
-	for (const auto& pos : legPositions) {
-		positionXYZ = pos;
+	for (int leg = 0; leg < legCount; leg++) {
+		positionXYZ = legPositions[leg];
 		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 		//SetShaderColor(0.4f, 0.2f, 0.1f, 1.0f);
-		SetShaderTexture("Table");
+		SetShaderTexture(TAG("Table"));
 		SetTextureUVScale(1.0f, 1.0f);
 
-		SetShaderMaterial("Wood");
-		m_basicMeshes->DrawBoxMesh();
+		SetShaderMaterial(TAG("Wood"));
+		DrawShapeMesh(MESH_BOX);
 	}
 		//The rest of the Scene
 		
 		// cube shape (present)
+		sceneSteps.Next("Present");
 		scaleXYZ = glm::vec3(3.0f, 3.0f, 3.0f);            // size of cube
 		positionXYZ = glm::vec3(-6.0f, 5.76f, -2.0f);         // this is to ensure there is no clipping on the plane
 		XrotationDegrees = 0.0f;
@@ -716,107 +1934,1187 @@ void SceneManager::RenderScene()
 
 		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 		SetShaderColor(0.6f, 0.1f, 0.1f, 1.0f); //dark red
-		SetShaderTexture("present");
+		SetShaderTexture(TAG("present"));
 		SetTextureUVScale(0.20f, 0.50f);
 
-		SetShaderMaterial("WrappingPaper");
-		m_basicMeshes->DrawBoxMesh();
+		SetShaderMaterial(TAG("WrappingPaper"));
+		DrawShapeMesh(MESH_BOX);
+
+		// balloons with their knots and strings
+		sceneSteps.Next("Balloon");
+		RenderBalloons();
 
-		// Sphere shape (ballon)
-		scaleXYZ = glm::vec3(2.0f, 2.50f, 2.0f);                // it is taller on y to be able to create a ballon like shape
-		positionXYZ = glm::vec3(4.0f, 12.0f, -4.0f);            //this will ensure that it looks like its floating
+		// Cylinder (cake)
+		sceneSteps.Next("Cake");
+		scaleXYZ = glm::vec3(3.0f, 2.0f, 3.0f);                // thin and tall
+		positionXYZ = glm::vec3(0.0f, 4.33f, 0.0f);             // standing up
 		XrotationDegrees = 0.0f;
 		YrotationDegrees = 0.0f;
 		ZrotationDegrees = 0.0f;
 
 		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		SetShaderMaterial("Balloon"); 
-		SetShaderTexture("balloon");
-		SetTextureUVScale(1.0f, 1.0f);
-		// SetShaderColor(0.25f, 0.1f, 0.4f, 1.0f);                // dark purple
-		m_basicMeshes->DrawSphereMesh();
+		//SetShaderColor(1.0f, 0.7f, 0.8f, 1.0f); //light pink
 
+		SetShaderTexture(TAG("Frost_sides"));
+		SetShaderTexture(TAG("Cake"));
+		SetTextureUVScale(1.50f, 1.50f);
 
+		DrawShapeMesh(MESH_CYLINDER);
+		
+		// Cylinder top (icing texture)
+		scaleXYZ = glm::vec3(3.01f, 0.1f, 3.01f);                
+		positionXYZ = glm::vec3(0.0f, 6.18f, 0.0f);             
+		SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
+		SetShaderTexture(TAG("Frost"));    
+		SetShaderTexture(TAG("Cake"));
+		SetTextureUVScale(1.0f, 1.0f);                          
+		DrawShapeMesh(MESH_CYLINDER);
 
-		// Pyramid as balloon knot
-		scaleXYZ = glm::vec3(0.3f, 0.3f, 0.3f);                    //small to appear as a knot.
-		positionXYZ = glm::vec3(4.0f, 9.45f, -4.0f);                // put it on the base of the balloon
+		// Cylinder plate 
+		scaleXYZ = glm::vec3(3.5f, 0.1f, 3.5f);               // flatter cylinder to appear as a cake
+		positionXYZ = glm::vec3(0.0f, 4.33f, 0.0f);           //this will make it under the cake
 		XrotationDegrees = 0.0f;
 		YrotationDegrees = 0.0f;
 		ZrotationDegrees = 0.0f;
 
 		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		//SetShaderColor(0.2f, 0.01f, 0.5f, 1.0f);                  // slightly darker shade to contrast balloon
-		SetShaderTexture("balloon");
+		//SetShaderColor(0.85f, 0.85f, 0.85f, 1.0f);
+		SetShaderTexture(TAG("Plate"));
 		SetTextureUVScale(1.0f, 1.0f);
-		SetShaderMaterial("Balloon");
-		m_basicMeshes->DrawPyramid4Mesh();
 
-		// Balloon String (thin cylinder)
-		scaleXYZ = glm::vec3(0.025f, 10.0f, 0.05f);               // this will the illusion of string
-		positionXYZ = glm::vec3(4.0f, 4.2f, -4.0f);             // in the balloon a bit but it looks like its attached to the "knott"
+		SetShaderMaterial(TAG("Ceramic"));
+		DrawShapeMesh(MESH_CYLINDER);
+
+		// Cylinder (Candle)
+		scaleXYZ = glm::vec3(0.1f, 2.0f, 0.1f);               // thinner and shorter candle
+		positionXYZ = glm::vec3(0.0f, 6.33f, 0.0f);
 		XrotationDegrees = 0.0f;
 		YrotationDegrees = 0.0f;
 		ZrotationDegrees = 0.0f;
 
 		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		SetShaderColor(0.3f, 0.3f, 0.3f, 1.0f);                 // dark gray string
+		SetShaderColor(0.9f, 0.9f, 0.4f, 1.0f);               // yellow candle
+		SetShaderMaterial(TAG("Candle"));
+		DrawShapeMesh(MESH_CYLINDER);
 
-		m_basicMeshes->DrawCylinderMesh();
+		
 
-		// Cylinder (cake)
-		scaleXYZ = glm::vec3(3.0f, 2.0f, 3.0f);                // thin and tall
-		positionXYZ = glm::vec3(0.0f, 4.33f, 0.0f);             // standing up
-		XrotationDegrees = 0.0f;
-		YrotationDegrees = 0.0f;
-		ZrotationDegrees = 0.0f;
+		
+	}
 
-		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		//SetShaderColor(1.0f, 0.7f, 0.8f, 1.0f); //light pink
+/***********************************************************
+ *  RenderBakedScene()
+ *
+ *  This method is used for rendering the scene from the
+ *  draw packets baked at compile time.  Each packet already
+ *  holds its model matrix and the list of shader values it
+ *  changes, so only those values are sent before the draw.
+ ***********************************************************/
+void SceneManager::RenderBakedScene()
+{
+	TRACE_SCOPE("RenderBakedScene");
+	HITCH_PHASE("BakedScene");
 
-		SetShaderTexture("Frost_sides");
-		SetShaderTexture("Cake");
-		SetTextureUVScale(1.50f, 1.50f);
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
 
-		m_basicMeshes->DrawCylinderMesh();
-		
-		// Cylinder top (icing texture)
-		scaleXYZ = glm::vec3(3.01f, 0.1f, 3.01f);                
-		positionXYZ = glm::vec3(0.0f, 6.18f, 0.0f);             
-		SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-		SetShaderTexture("Frost");    
-		SetShaderTexture("Cake");
-		SetTextureUVScale(1.0f, 1.0f);                          
-		m_basicMeshes->DrawCylinderMesh();
+	for (size_t i = 0; i < BakedScene::TOTAL_PACKETS; i++)
+	{
+		const BakedScene::DRAW_PACKET& packet = BakedScene::DRAW_PACKETS.packets[i];
 
-		// Cylinder plate 
-		scaleXYZ = glm::vec3(3.5f, 0.1f, 3.5f);               // flatter cylinder to appear as a cake
-		positionXYZ = glm::vec3(0.0f, 4.33f, 0.0f);           //this will make it under the cake
-		XrotationDegrees = 0.0f;
-		YrotationDegrees = 0.0f;
-		ZrotationDegrees = 0.0f;
+		m_pShaderManager->setMat4Value(g_ModelName, glm::make_mat4(packet.model));
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES);
 
-		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		//SetShaderColor(0.85f, 0.85f, 0.85f, 1.0f);
-		SetShaderTexture("Plate");
-		SetTextureUVScale(1.0f, 1.0f);
+		if (packet.changes & BakedScene::CHANGE_TEXTURE_MODE)
+		{
+			m_pShaderManager->setIntValue(g_UseTextureName, packet.texture.IsValid());
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+		}
+		if (packet.changes & BakedScene::CHANGE_TEXTURE)
+		{
+			int textureSlot = FindTextureSlot(packet.texture);
+
+			// a texture packed into an atlas page is sampled from the
+			// page, inside its rectangle
+			if (false == m_atlasEntries.empty())
+			{
+				glm::vec4 atlasRect = FULL_TEXTURE_RECT;
+				int entry = (textureSlot < 0) ? FindAtlasEntry(packet.texture) : -1;
+				if (entry >= 0)
+				{
+					textureSlot = m_atlasEntries[entry].pageSlot;
+					atlasRect = m_atlasEntries[entry].uvRect;
+				}
+				m_pShaderManager->setVec4Value(g_AtlasRectName, atlasRect);
+				RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+			}
+
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+			RenderStats::Count(RenderStats::TEXTURE_BINDS);
+		}
+		if (packet.changes & BakedScene::CHANGE_COLOR)
+		{
+			m_pShaderManager->setVec4Value(g_ColorValueName, glm::make_vec4(packet.color));
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+		}
+		if (packet.changes & BakedScene::CHANGE_UV_SCALE)
+		{
+			m_pShaderManager->setVec2Value(g_UVScaleName, glm::make_vec2(packet.uvScale));
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+		}
+		if (packet.changes & BakedScene::CHANGE_MATERIAL)
+		{
+			SetShaderMaterial(packet.material);
+		}
 
-		SetShaderMaterial("Ceramic");
-		m_basicMeshes->DrawCylinderMesh();
+		DrawShapeMesh(packet.mesh);
+	}
+}
 
-		// Cylinder (Candle)
-		scaleXYZ = glm::vec3(0.1f, 2.0f, 0.1f);               // thinner and shorter candle
-		positionXYZ = glm::vec3(0.0f, 6.33f, 0.0f);
-		XrotationDegrees = 0.0f;
-		YrotationDegrees = 0.0f;
-		ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  RenderSceneObjects()
+ *
+ *  This method is used for rendering the objects of the
+ *  loaded scene description file, in file order.  Each model
+ *  matrix was built when the object was placed, so it is
+ *  sent to the shader as it is.
+ ***********************************************************/
+void SceneManager::RenderSceneObjects()
+{
+	TRACE_SCOPE("RenderSceneObjects");
+	HITCH_PHASE("SceneObjects");
 
-		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		SetShaderColor(0.9f, 0.9f, 0.4f, 1.0f);               // yellow candle
-		SetShaderMaterial("Candle");
-		m_basicMeshes->DrawCylinderMesh();
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
 
-		
+	for (const SCENE_OBJECT& object : m_sceneObjects)
+	{
+		m_pShaderManager->setMat4Value(g_ModelName, object.model);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES);
 
-		
+		if (true == object.texture.IsValid())
+		{
+			SetShaderTexture(object.texture);
+		}
+		else
+		{
+			SetShaderColor(object.color.r, object.color.g, object.color.b, object.color.a);
+		}
+		SetTextureUVScale(object.uvScale.x, object.uvScale.y);
+		if (true == object.material.IsValid())
+		{
+			SetShaderMaterial(object.material);
+		}
+
+		DrawShapeMesh(object.mesh);
+	}
+}
+
+/***********************************************************
+ *  ApplySceneDescription()
+ *
+ *  This method is used for bringing the live scene in line
+ *  with a scene description.  The textures, materials and
+ *  objects are compared with what is loaded, and only the
+ *  ones that differ are uploaded, changed or removed.  The
+ *  new images are read from disk when asked, for a scene
+ *  file edited while the program runs.
+ ***********************************************************/
+void SceneManager::ApplySceneDescription(const SCENE_DESCRIPTION& scene, bool bFromDisk)
+{
+	TRACE_SCOPE("ApplySceneDescription");
+	HitchActivity activity(HitchDetector::ACTIVITY_ASSET_LOAD, "ApplySceneDescription");
+
+	ApplySceneTextures(scene, bFromDisk);
+	ApplySceneMaterials(scene);
+	ApplySceneObjects(scene);
+	ApplySceneLights(scene);
+
+	m_bSceneFileLoaded = true;
+}
+
+/***********************************************************
+ *  ApplySceneTextures()
+ *
+ *  This method is used for loading the textures of a scene
+ *  description that are new or now come from another file,
+ *  and freeing the loaded textures it no longer lists.  The
+ *  other textures are left as they are.
+ ***********************************************************/
+void SceneManager::ApplySceneTextures(const SCENE_DESCRIPTION& scene, bool bFromDisk)
+{
+	int added = 0;
+	int changed = 0;
+	int removed = 0;
+
+	for (const SCENE_TEXTURE_DESC& textureDesc : scene.textures)
+	{
+		ResourceTag key = ResourceTag::FromString(textureDesc.tag);
+		int slot = FindTextureSlot(key);
+		int alias = FindTextureAlias(key);
+		const std::string& loadedFile = (alias >= 0) ? m_textureAliases[alias].filename :
+			((slot >= 0) ? m_textureIDs[slot].filename : textureDesc.filename);
+		if ((slot >= 0) && (loadedFile == textureDesc.filename))
+		{
+			continue;
+		}
+		// a texture packed into an atlas page stays there while it
+		// comes from the same file
+		int entry = (slot < 0) ? FindAtlasEntry(key) : -1;
+		if ((entry >= 0) && (m_atlasEntries[entry].filename == textureDesc.filename))
+		{
+			continue;
+		}
+
+		// a texture that now comes from another file is replaced
+		// in its slot, so the slot numbers of the others stay put -
+		// unless other tags share it, when the tag lets go of it
+		DECODED_IMAGE image = { NULL, 0, 0, 0 };
+		if (false == DecodeTextureImage(GetReloadFilename(textureDesc.filename), image, bFromDisk))
+		{
+			continue;
+		}
+		bool bChanged = (slot >= 0);
+		if (true == bChanged)
+		{
+			slot = UnshareTexture(key);
+		}
+		if (false == UploadGLTexture(image, textureDesc.tag, slot))
+		{
+			continue;
+		}
+
+		if (true == bChanged)
+		{
+			changed++;
+		}
+		else
+		{
+			added++;
+		}
+		SetTextureFile(key, textureDesc.filename);
+	}
+
+	// tags sharing a texture that the scene no longer lists, or
+	// now loads from another file, let go of it
+	for (size_t i = 0; i < m_textureAliases.size();)
+	{
+		bool bListed = false;
+		for (const SCENE_TEXTURE_DESC& textureDesc : scene.textures)
+		{
+			if ((textureDesc.tag == m_textureAliases[i].tag) && (textureDesc.filename == m_textureAliases[i].filename))
+			{
+				bListed = true;
+			}
+		}
+		if (false == bListed)
+		{
+			m_textureIDs[m_textureAliases[i].slot].references--;
+			m_textureAliases.erase(m_textureAliases.begin() + i);
+			removed++;
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// packed textures the scene no longer lists, or now loads
+	// from another file, are dropped from their pages
+	for (size_t i = 0; i < m_atlasEntries.size();)
+	{
+		bool bListed = false;
+		for (const SCENE_TEXTURE_DESC& textureDesc : scene.textures)
+		{
+			if ((textureDesc.tag == m_atlasEntries[i].tag) && (textureDesc.filename == m_atlasEntries[i].filename))
+			{
+				bListed = true;
+			}
+		}
+		if (false == bListed)
+		{
+			m_atlasEntries.erase(m_atlasEntries.begin() + i);
+			removed++;
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		if (0 == m_textureIDs[i].texture.Get())
+		{
+			continue;
+		}
+
+		// an atlas page is kept while it holds a listed texture
+		bool bListed = false;
+		for (const ATLAS_ENTRY& entry : m_atlasEntries)
+		{
+			if (entry.pageSlot == i)
+			{
+				bListed = true;
+			}
+		}
+		for (const SCENE_TEXTURE_DESC& textureDesc : scene.textures)
+		{
+			if (textureDesc.tag == m_textureIDs[i].tag)
+			{
+				bListed = true;
+			}
+		}
+		// a texture other tags share is handed to one of them
+		if (false == bListed)
+		{
+			if (false == PromoteTextureAlias(i))
+			{
+				DestroyGLTexture(i);
+			}
+			removed++;
+		}
+	}
+
+	if ((added + changed + removed) > 0)
+	{
+		BindGLTextures();
+		std::cout << "INFO: scene textures - added:" << added << ", changed:" << changed
+			<< ", removed:" << removed << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ApplySceneMaterials()
+ *
+ *  This method is used for adding the materials of a scene
+ *  description that are new, updating the ones whose values
+ *  differ, and removing the ones it no longer lists.
+ ***********************************************************/
+void SceneManager::ApplySceneMaterials(const SCENE_DESCRIPTION& scene)
+{
+	int added = 0;
+	int changed = 0;
+	int removed = 0;
+
+	for (const SCENE_MATERIAL_DESC& materialDesc : scene.materials)
+	{
+		ResourceTag key;
+		if (false == ResourceTag::Register(materialDesc.tag, key))
+		{
+			continue;
+		}
+
+		OBJECT_MATERIAL* pMaterial = NULL;
+		for (OBJECT_MATERIAL& material : m_objectMaterials)
+		{
+			if (material.key == key)
+			{
+				pMaterial = &material;
+			}
+		}
+
+		if (NULL == pMaterial)
+		{
+			OBJECT_MATERIAL material;
+			material.tag = materialDesc.tag;
+			material.key = key;
+			m_objectMaterials.push_back(material);
+			pMaterial = &m_objectMaterials.back();
+			added++;
+		}
+		else if ((pMaterial->diffuseColor != materialDesc.diffuseColor) ||
+			(pMaterial->specularColor != materialDesc.specularColor) ||
+			(pMaterial->shininess != materialDesc.shininess))
+		{
+			changed++;
+		}
+
+		pMaterial->diffuseColor = materialDesc.diffuseColor;
+		pMaterial->specularColor = materialDesc.specularColor;
+		pMaterial->shininess = materialDesc.shininess;
+	}
+
+	std::vector<OBJECT_MATERIAL>::iterator material = m_objectMaterials.begin();
+	while (material != m_objectMaterials.end())
+	{
+		bool bListed = false;
+		for (const SCENE_MATERIAL_DESC& materialDesc : scene.materials)
+		{
+			if (materialDesc.tag == material->tag)
+			{
+				bListed = true;
+			}
+		}
+
+		if (false == bListed)
+		{
+			material = m_objectMaterials.erase(material);
+			removed++;
+		}
+		else
+		{
+			material++;
+		}
+	}
+
+	if ((added + changed + removed) > 0)
+	{
+		std::cout << "INFO: scene materials - added:" << added << ", changed:" << changed
+			<< ", removed:" << removed << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ApplySceneObjects()
+ *
+ *  This method is used for placing the objects of a scene
+ *  description.  Objects are matched with the placed ones
+ *  by name, and the model matrix is only rebuilt for the
+ *  objects that are new or whose transform has changed.
+ ***********************************************************/
+void SceneManager::ApplySceneObjects(const SCENE_DESCRIPTION& scene)
+{
+	int added = 0;
+	int moved = 0;
+	int changed = 0;
+
+	std::vector<SCENE_OBJECT> objects;
+	objects.reserve(scene.objects.size());
+
+	for (const SCENE_OBJECT_DESC& objectDesc : scene.objects)
+	{
+		const SCENE_OBJECT* pPlaced = NULL;
+		for (const SCENE_OBJECT& placed : m_sceneObjects)
+		{
+			if (placed.name == objectDesc.name)
+			{
+				pPlaced = &placed;
+			}
+		}
+
+		SCENE_OBJECT object;
+		object.name = objectDesc.name;
+		object.mesh = objectDesc.mesh;
+		object.scale = objectDesc.scale;
+		object.rotation = objectDesc.rotation;
+		object.position = objectDesc.position;
+		object.texture = objectDesc.texture.empty() ? ResourceTag() : ResourceTag::FromString(objectDesc.texture);
+		object.color = objectDesc.color;
+		object.uvScale = objectDesc.uvScale;
+		object.material = objectDesc.material.empty() ? ResourceTag() : ResourceTag::FromString(objectDesc.material);
+
+		if ((NULL != pPlaced) &&
+			(pPlaced->scale == object.scale) &&
+			(pPlaced->rotation == object.rotation) &&
+			(pPlaced->position == object.position))
+		{
+			// the transform is unchanged, so keep its matrix
+			object.model = pPlaced->model;
+		}
+		else
+		{
+			object.model = BuildModelMatrix(
+				object.scale, object.rotation.x, object.rotation.y, object.rotation.z, object.position);
+			if (NULL != pPlaced)
+			{
+				moved++;
+			}
+			else
+			{
+				added++;
+			}
+		}
+
+		if ((NULL != pPlaced) &&
+			((pPlaced->mesh != object.mesh) ||
+			(pPlaced->texture != object.texture) ||
+			(pPlaced->color != object.color) ||
+			(pPlaced->uvScale != object.uvScale) ||
+			(pPlaced->material != object.material)))
+		{
+			changed++;
+		}
+
+		objects.push_back(object);
+	}
+
+	// every placed object that was not matched has been removed
+	int removed = (int)m_sceneObjects.size() - ((int)objects.size() - added);
+	m_sceneObjects.swap(objects);
+
+	if ((added + moved + changed + removed) > 0)
+	{
+		std::cout << "INFO: scene objects - added:" << added << ", moved:" << moved
+			<< ", changed:" << changed << ", removed:" << removed << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ReloadTextureFile()
+ *
+ *  This method is used for decoding an image file that has
+ *  changed on disk and uploading it again into the slots of
+ *  the textures that were loaded from it.  The file is read
+ *  from disk even when the mounted asset pack holds it.  It
+ *  returns false when no loaded texture uses the file.
+ ***********************************************************/
+bool SceneManager::ReloadTextureFile(const std::string& filename)
+{
+	TRACE_SCOPE("ReloadTextureFile");
+
+	DECODED_IMAGE image = { NULL, 0, 0, 0 };
+	if (false == DecodeTextureImage(GetReloadFilename(filename), image, true))
+	{
+		return(false);
+	}
+
+	return(ReloadTextureImage(filename, image));
+}
+
+/***********************************************************
+ *  ReloadTextureImage()
+ *
+ *  This method is used for uploading the decoded image of a
+ *  changed image file into the textures that were loaded
+ *  from it.  A texture whose image has kept its size and
+ *  channels is updated in place; otherwise a texture of the
+ *  new size is made and put in the slot of the old one.
+ *  Either way the slot numbers stay as they are, so draws
+ *  carry on with the new image.  It returns false when no
+ *  loaded texture uses the file.  The image data is freed.
+ ***********************************************************/
+bool SceneManager::ReloadTextureImage(const std::string& filename, DECODED_IMAGE& image)
+{
+	TRACE_SCOPE("ReloadTextureImage");
+
+	if (NULL == image.pixels)
+	{
+		return(false);
+	}
+
+	// the tags of the file that share a texture with tags of other
+	// files let go of it, so only they see the new image
+	std::vector<std::string> unsharedTags;
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		if ((0 == m_textureIDs[i].texture.Get()) || (m_textureIDs[i].references < 2))
+		{
+			continue;
+		}
+
+		bool bSlotChanged = (m_textureIDs[i].filename == filename);
+		bool bMixed = false;
+		for (const TEXTURE_ALIAS& alias : m_textureAliases)
+		{
+			if ((alias.slot == i) && ((alias.filename == filename) != bSlotChanged))
+			{
+				bMixed = true;
+			}
+		}
+		if (false == bMixed)
+		{
+			continue;
+		}
+
+		for (size_t a = 0; a < m_textureAliases.size();)
+		{
+			if ((m_textureAliases[a].slot == i) && (m_textureAliases[a].filename == filename))
+			{
+				unsharedTags.push_back(m_textureAliases[a].tag);
+				m_textureIDs[i].references--;
+				m_textureAliases.erase(m_textureAliases.begin() + a);
+			}
+			else
+			{
+				a++;
+			}
+		}
+		if (true == bSlotChanged)
+		{
+			unsharedTags.push_back(m_textureIDs[i].tag);
+			PromoteTextureAlias(i);
+		}
+	}
+
+	// a texture whose tags all use the file is replaced in place
+	bool bReloaded = false;
+	bool bReplaced = false;
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		if ((0 == m_textureIDs[i].texture.Get()) || (m_textureIDs[i].filename != filename))
+		{
+			continue;
+		}
+
+		if (true == UpdateTextureInPlace(i, image))
+		{
+			bReloaded = true;
+			continue;
+		}
+
+		// the tag is copied, as the upload assigns it back
+		std::string tag = m_textureIDs[i].tag;
+		if (true == UploadGLTexture(image, tag, i, true))
+		{
+			m_textureIDs[i].filename = filename;
+			bReloaded = true;
+			bReplaced = true;
+		}
+	}
+	for (const std::string& tag : unsharedTags)
+	{
+		if (true == UploadGLTexture(image, tag, -1, true))
+		{
+			SetTextureFile(ResourceTag::FromString(tag), filename);
+			bReloaded = true;
+			bReplaced = true;
+		}
+	}
+	for (ATLAS_ENTRY& entry : m_atlasEntries)
+	{
+		if ((entry.filename == filename) && (true == ReloadAtlasEntry(entry, image)))
+		{
+			bReloaded = true;
+		}
+	}
+
+	AssetPack::FreeImagePixels(image.pixels);
+	image.pixels = NULL;
+
+	if (true == bReloaded)
+	{
+		// new textures have to be bound to the units of their slots
+		if (true == bReplaced)
+		{
+			BindGLTextures();
+		}
+		std::cout << "INFO: reloaded texture:" << filename
+			<< ((true == bReplaced) ? ", into a new texture" : ", in place") << std::endl;
+	}
+
+	return(bReloaded);
+}
+
+/***********************************************************
+ *  GetTextureFiles()
+ *
+ *  This method is used for listing the image files that the
+ *  loaded textures came from, each file once.
+ ***********************************************************/
+void SceneManager::GetTextureFiles(std::vector<std::string>& filenames) const
+{
+	filenames.clear();
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		if ((0 != m_textureIDs[i].texture.Get()) && (false == m_textureIDs[i].filename.empty()))
+		{
+			filenames.push_back(m_textureIDs[i].filename);
+		}
+	}
+	for (const TEXTURE_ALIAS& alias : m_textureAliases)
+	{
+		if (false == alias.filename.empty())
+		{
+			filenames.push_back(alias.filename);
+		}
+	}
+	for (const ATLAS_ENTRY& entry : m_atlasEntries)
+	{
+		filenames.push_back(entry.filename);
+	}
+
+	std::sort(filenames.begin(), filenames.end());
+	filenames.erase(std::unique(filenames.begin(), filenames.end()), filenames.end());
+}
+
+/***********************************************************
+ *  ReloadAtlasEntry()
+ *
+ *  This method is used for copying the changed image of
+ *  a packed texture, with its border, over its rectangle in
+ *  the atlas page and remaking the mip levels of the page.
+ *  An image that has changed size no longer fits its
+ *  rectangle, so it is left as it was.
+ ***********************************************************/
+bool SceneManager::ReloadAtlasEntry(ATLAS_ENTRY& entry, const DECODED_IMAGE& image)
+{
+	if ((image.width != entry.width) || (image.height != entry.height) ||
+		((image.colorChannels != 3) && (image.colorChannels != 4)))
+	{
+		std::cout << "Could not reload texture:" << entry.filename
+			<< " - the size of a texture in an atlas page cannot change" << std::endl;
+		return(false);
+	}
+
+	int bordered = entry.width + 2 * ATLAS_ALIGNMENT;
+	int borderedHeight = entry.height + 2 * ATLAS_ALIGNMENT;
+	std::vector<unsigned char> pixels((size_t)bordered * borderedHeight * 4);
+	TextureAtlas::CopyWithBorder(image.pixels, image.width, image.height, image.colorChannels,
+		ATLAS_ALIGNMENT, pixels.data(), bordered);
+
+	glActiveTexture(GL_TEXTURE0 + entry.pageSlot);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, entry.x - ATLAS_ALIGNMENT, entry.y - ATLAS_ALIGNMENT,
+		bordered, borderedHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glActiveTexture(GL_TEXTURE0);
+	return(true);
+}
+
+/***********************************************************
+ *  ApplySceneLights()
+ *
+ *  This method is used for setting the point lights of a
+ *  scene description into the shader when they differ from
+ *  the lights in use.  A scene that lists no lights keeps
+ *  the lights it has.
+ ***********************************************************/
+void SceneManager::ApplySceneLights(const SCENE_DESCRIPTION& scene)
+{
+	if (scene.lights.empty())
+	{
+		return;
+	}
+
+	if ((int)scene.lights.size() > MAX_POINT_LIGHTS)
+	{
+		std::cout << "The scene has " << scene.lights.size() << " point lights, only the first "
+			<< MAX_POINT_LIGHTS << " are used" << std::endl;
+	}
+
+	std::vector<SCENE_LIGHT> lights;
+	for (size_t i = 0; (i < scene.lights.size()) && ((int)i < MAX_POINT_LIGHTS); i++)
+	{
+		SCENE_LIGHT light;
+		light.position = scene.lights[i].position;
+		light.ambientColor = scene.lights[i].ambientColor;
+		light.diffuseColor = scene.lights[i].diffuseColor;
+		light.specularColor = scene.lights[i].specularColor;
+		lights.push_back(light);
+	}
+
+	bool bChanged = (lights.size() != m_sceneLights.size());
+	for (size_t i = 0; (false == bChanged) && (i < lights.size()); i++)
+	{
+		bChanged = (lights[i].position != m_sceneLights[i].position) ||
+			(lights[i].ambientColor != m_sceneLights[i].ambientColor) ||
+			(lights[i].diffuseColor != m_sceneLights[i].diffuseColor) ||
+			(lights[i].specularColor != m_sceneLights[i].specularColor);
+	}
+
+	if (true == bChanged)
+	{
+		m_sceneLights.swap(lights);
+		SetSceneLights();
+		std::cout << "INFO: scene point lights:" << m_sceneLights.size() << std::endl;
+	}
+}
+
+/***********************************************************
+ *  SetSceneLights()
+ *
+ *  This method is used for setting the point lights of the
+ *  loaded scene description into the shader, and turning off
+ *  the rest of the point lights.
+ ***********************************************************/
+void SceneManager::SetSceneLights()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+	{
+		std::string light = "pointLights[" + std::to_string(i) + "]";
+		if (i < (int)m_sceneLights.size())
+		{
+			m_pShaderManager->setVec3Value(light + ".position", m_sceneLights[i].position);
+			m_pShaderManager->setVec3Value(light + ".ambient", m_sceneLights[i].ambientColor);
+			m_pShaderManager->setVec3Value(light + ".diffuse", m_sceneLights[i].diffuseColor);
+			m_pShaderManager->setVec3Value(light + ".specular", m_sceneLights[i].specularColor);
+			m_pShaderManager->setBoolValue(light + ".bActive", true);
+		}
+		else
+		{
+			m_pShaderManager->setBoolValue(light + ".bActive", false);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetSceneObjectCount()
+ *
+ *  This method returns the number of objects of the loaded
+ *  scene description.
+ ***********************************************************/
+int SceneManager::GetSceneObjectCount() const
+{
+	return((int)m_sceneObjects.size());
+}
+
+/***********************************************************
+ *  GetScenePointLightCount()
+ *
+ *  This method returns the number of point lights of the
+ *  loaded scene description.
+ ***********************************************************/
+int SceneManager::GetScenePointLightCount() const
+{
+	return((int)m_sceneLights.size());
+}
+
+/***********************************************************
+ *  SetCandleFlicker()
+ *
+ *  This method is used to scale the colors of the candle
+ *  light by the brightness of the flame, so the light
+ *  flickers with it.  Scenes with their own point lights are
+ *  left alone.
+ ***********************************************************/
+void SceneManager::SetCandleFlicker(float brightness)
+{
+	if ((NULL == m_pShaderManager) || (false == m_sceneLights.empty()))
+	{
+		return;
+	}
+
+	m_pShaderManager->setVec3Value(g_CandleAmbientName, CANDLE_AMBIENT_COLOR * brightness);
+	m_pShaderManager->setVec3Value(g_CandleDiffuseName, CANDLE_DIFFUSE_COLOR * brightness);
+	m_pShaderManager->setVec3Value(g_CandleSpecularName, CANDLE_SPECULAR_COLOR * brightness);
+	RenderStats::Count(RenderStats::UNIFORM_UPDATES, 3);
+}
+
+/***********************************************************
+ *  RenderBalloons()
+ *
+ *  This method is used for rendering the balloons at their
+ *  poses.  Each balloon and its knot lean along the string,
+ *  which runs from the anchor up to the knot.  The textured
+ *  balloons are drawn first and then all of the strings, so
+ *  the texture and color are each set once.
+ ***********************************************************/
+void SceneManager::RenderBalloons()
+{
+	TRACE_SCOPE("RenderBalloons");
+
+	if ((NULL == m_pShaderManager) || (true == m_balloonPoses.empty()))
+	{
+		return;
 	}
+
+	SetShaderMaterial(TAG("Balloon"));
+	SetShaderTexture(TAG("balloon"));
+	SetTextureUVScale(1.0f, 1.0f);
+	for (const BALLOON_POSE& pose : m_balloonPoses)
+	{
+		glm::vec3 offset = pose.position - pose.anchor;
+		float stringLength = glm::length(offset);
+		glm::vec3 direction = (stringLength > 0.0f) ? offset / stringLength : glm::vec3(0.0f, 1.0f, 0.0f);
+
+		m_pShaderManager->setMat4Value(g_ModelName, BuildAlignedMatrix(
+			glm::vec3(pose.radius, pose.radius * BALLOON_HEIGHT_SCALE, pose.radius), direction, pose.position));
+		DrawShapeMesh(MESH_SPHERE);
+
+		m_pShaderManager->setMat4Value(g_ModelName, BuildAlignedMatrix(
+			glm::vec3(pose.radius * BALLOON_KNOT_SCALE), direction,
+			pose.position - direction * (pose.radius * BALLOON_KNOT_OFFSET)));
+		DrawShapeMesh(MESH_PYRAMID4);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES, 2);
+	}
+
+	// dark gray strings from the anchors up to the knots
+	SetShaderColor(0.3f, 0.3f, 0.3f, 1.0f);
+	for (const BALLOON_POSE& pose : m_balloonPoses)
+	{
+		glm::vec3 offset = pose.position - pose.anchor;
+		float stringLength = glm::length(offset);
+		glm::vec3 direction = (stringLength > 0.0f) ? offset / stringLength : glm::vec3(0.0f, 1.0f, 0.0f);
+
+		m_pShaderManager->setMat4Value(g_ModelName, BuildAlignedMatrix(
+			glm::vec3(BALLOON_STRING_WIDTH, stringLength - pose.radius * BALLOON_KNOT_OFFSET, BALLOON_STRING_WIDTH),
+			direction, pose.anchor));
+		DrawShapeMesh(MESH_CYLINDER);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+	}
+}
+
+/***********************************************************
+ *  GetBalloonCount()
+ *
+ *  This method returns the number of balloons to draw.
+ ***********************************************************/
+int SceneManager::GetBalloonCount() const
+{
+	return((int)m_balloonPoses.size());
+}
+
+/***********************************************************
+ *  GetBalloonPoses()
+ *
+ *  This method returns the poses of the balloons to draw.
+ ***********************************************************/
+const SceneManager::BALLOON_POSE* SceneManager::GetBalloonPoses() const
+{
+	return(m_balloonPoses.data());
+}
+
+/***********************************************************
+ *  SetBalloonPoses()
+ *
+ *  This method is used for setting the poses of the balloons
+ *  moved by the balloon physics.  The storage is kept from
+ *  step to step, so only a change in the number of balloons
+ *  allocates.
+ ***********************************************************/
+void SceneManager::SetBalloonPoses(const BALLOON_POSE* poses, int count)
+{
+	m_balloonPoses.assign(poses, poses + count);
+	m_bBalloonPhysics = true;
+}
+
+/***********************************************************
+ *  FindAnimationTarget()
+ *
+ *  This method returns the index of the object, balloon,
+ *  light or material that an animation channel drives.  The
+ *  objects are found by name and the materials by tag, while
+ *  balloons and lights are numbered from 0.
+ ***********************************************************/
+int SceneManager::FindAnimationTarget(ANIMATED_PROPERTY property, const std::string& name) const
+{
+	int target = -1;
+
+	switch (property)
+	{
+	case ANIMATE_OBJECT_POSITION:
+	case ANIMATE_OBJECT_ROTATION:
+	case ANIMATE_OBJECT_SCALE:
+		for (size_t i = 0; (i < m_sceneObjects.size()) && (target < 0); i++)
+		{
+			if (m_sceneObjects[i].name == name)
+			{
+				target = (int)i;
+			}
+		}
+		break;
+	case ANIMATE_BALLOON_POSITION:
+		target = atoi(name.c_str());
+		target = ((target >= 0) && (target < (int)m_balloonPoses.size())) ? target : -1;
+		break;
+	case ANIMATE_LIGHT_POSITION:
+	case ANIMATE_LIGHT_DIFFUSE:
+	case ANIMATE_LIGHT_SPECULAR:
+		target = atoi(name.c_str());
+		target = ((target >= 0) && (target < MAX_POINT_LIGHTS)) ? target : -1;
+		break;
+	case ANIMATE_MATERIAL_DIFFUSE:
+	case ANIMATE_MATERIAL_SPECULAR:
+		for (size_t i = 0; (i < m_objectMaterials.size()) && (target < 0); i++)
+		{
+			if (m_objectMaterials[i].tag == name)
+			{
+				target = (int)i;
+			}
+		}
+		break;
+	}
+
+	return(target);
+}
+
+/***********************************************************
+ *  GetAnimatedValue()
+ *
+ *  This method is used for reading the current value of an
+ *  animation target, so a channel can animate around it.
+ *  Lights are only ever written, so they have no value to
+ *  read.
+ ***********************************************************/
+bool SceneManager::GetAnimatedValue(ANIMATED_PROPERTY property, int target, glm::vec3& value) const
+{
+	if (target < 0)
+	{
+		return(false);
+	}
+
+	switch (property)
+	{
+	case ANIMATE_OBJECT_POSITION:
+	case ANIMATE_OBJECT_ROTATION:
+	case ANIMATE_OBJECT_SCALE:
+		if (target < (int)m_sceneObjects.size())
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[target];
+			value = (property == ANIMATE_OBJECT_POSITION) ? object.position :
+				((property == ANIMATE_OBJECT_ROTATION) ? object.rotation : object.scale);
+			return(true);
+		}
+		break;
+	case ANIMATE_BALLOON_POSITION:
+		if (target < (int)m_balloonPoses.size())
+		{
+			value = m_balloonPoses[target].position;
+			return(true);
+		}
+		break;
+	case ANIMATE_MATERIAL_DIFFUSE:
+	case ANIMATE_MATERIAL_SPECULAR:
+		if (target < (int)m_objectMaterials.size())
+		{
+			value = (property == ANIMATE_MATERIAL_DIFFUSE) ?
+				m_objectMaterials[target].diffuseColor : m_objectMaterials[target].specularColor;
+			return(true);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  SetAnimatedValue()
+ *
+ *  This method is used for writing an animated value into
+ *  the scene.  A moved object has its model matrix rebuilt
+ *  straight away, and a light is set into the shader, so the
+ *  bound program must be the scene program.  Targets that
+ *  have gone, such as objects removed by a reload, are
+ *  skipped.
+ ***********************************************************/
+void SceneManager::SetAnimatedValue(ANIMATED_PROPERTY property, int target, const glm::vec3& value)
+{
+	if (target < 0)
+	{
+		return;
+	}
+
+	switch (property)
+	{
+	case ANIMATE_OBJECT_POSITION:
+	case ANIMATE_OBJECT_ROTATION:
+	case ANIMATE_OBJECT_SCALE:
+		if (target < (int)m_sceneObjects.size())
+		{
+			SCENE_OBJECT& object = m_sceneObjects[target];
+			if (property == ANIMATE_OBJECT_POSITION)
+			{
+				object.position = value;
+			}
+			else if (property == ANIMATE_OBJECT_ROTATION)
+			{
+				object.rotation = value;
+			}
+			else
+			{
+				object.scale = value;
+			}
+			object.model = BuildModelMatrix(
+				object.scale, object.rotation.x, object.rotation.y, object.rotation.z, object.position);
+		}
+		break;
+	case ANIMATE_BALLOON_POSITION:
+		if (target < (int)m_balloonPoses.size())
+		{
+			m_balloonPoses[target].position = value;
+		}
+		break;
+	case ANIMATE_LIGHT_POSITION:
+	case ANIMATE_LIGHT_DIFFUSE:
+	case ANIMATE_LIGHT_SPECULAR:
+		if ((NULL != m_pShaderManager) && (target < MAX_POINT_LIGHTS))
+		{
+			int field = property - ANIMATE_LIGHT_POSITION;
+			m_pShaderManager->setVec3Value(m_lightUniformNames[target * 3 + field], value);
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+		}
+		break;
+	case ANIMATE_MATERIAL_DIFFUSE:
+	case ANIMATE_MATERIAL_SPECULAR:
+		if (target < (int)m_objectMaterials.size())
+		{
+			if (property == ANIMATE_MATERIAL_DIFFUSE)
+			{
+				m_objectMaterials[target].diffuseColor = value;
+			}
+			else
+			{
+				m_objectMaterials[target].specularColor = value;
+			}
+		}
+		break;
+	}
+}
+
+/***********************************************************
+ *  RenderStreamedObjects()
+ *
+ *  This method is used for rendering the objects of a world
+ *  chunk loaded by the world streamer.  The chunk textures
+ *  are not in the texture slots, so each one is bound to a
+ *  unit of its own as it is needed.
+ ***********************************************************/
+void SceneManager::RenderStreamedObjects(
+	const STREAMED_OBJECT* objects,
+	int count,
+	const uint32_t* textureIDs,
+	const OBJECT_MATERIAL* materials)
+{
+	if ((NULL == m_pShaderManager) || (count <= 0))
+	{
+		return;
+	}
+
+	// the chunk textures are whole textures, not atlas pages
+	if (false == m_atlasEntries.empty())
+	{
+		m_pShaderManager->setVec4Value(g_AtlasRectName, FULL_TEXTURE_RECT);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+	}
+
+	glActiveTexture(GL_TEXTURE0 + SPARE_TEXTURE_UNIT);
+	uint32_t boundTexture = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const STREAMED_OBJECT& object = objects[i];
+		m_pShaderManager->setMat4Value(g_ModelName, object.model);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES);
+
+		if (object.texture >= 0)
+		{
+			if (textureIDs[object.texture] != boundTexture)
+			{
+				boundTexture = textureIDs[object.texture];
+				glBindTexture(GL_TEXTURE_2D, boundTexture);
+				RenderStats::Count(RenderStats::TEXTURE_BINDS);
+			}
+			m_pShaderManager->setIntValue(g_UseTextureName, true);
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, SPARE_TEXTURE_UNIT);
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES, 2);
+		}
+		else
+		{
+			SetShaderColor(object.color.r, object.color.g, object.color.b, object.color.a);
+		}
+		SetTextureUVScale(object.uvScale.x, object.uvScale.y);
+
+		if (object.material >= 0)
+		{
+			const OBJECT_MATERIAL& material = materials[object.material];
+			m_pShaderManager->setVec3Value(g_MaterialDiffuseName, material.diffuseColor);
+			m_pShaderManager->setVec3Value(g_MaterialSpecularName, material.specularColor);
+			m_pShaderManager->setFloatValue(g_MaterialShininessName, material.shininess);
+			RenderStats::Count(RenderStats::UNIFORM_UPDATES, 3);
+		}
+
+		DrawShapeMesh(object.mesh);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
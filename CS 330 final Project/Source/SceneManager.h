@@ -11,10 +11,16 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "GpuResourceTracker.h"
+#include "FrameArena.h"
+#include "ResourceTag.h"
 
+#include <set>
 #include <string>
 #include <vector>
 
+struct SCENE_DESCRIPTION;
+
 /***********************************************************
  *  SceneManager
  *
@@ -32,7 +38,22 @@ public:
 	struct TEXTURE_INFO
 	{
 		std::string tag;
-		uint32_t ID;
+		ResourceTag key;
+		GLTextureHandle texture;
+		// the image file the texture was loaded from
+		std::string filename;
+		// hash of the decoded pixels, 0 when not hashed, with the
+		// GPU bytes of the texture and the number of tags that use
+		// it - the tag of the slot and its aliases
+		uint64_t contentHash;
+		size_t contentBytes;
+		int references;
+		// the size and channels of the image in the texture, 0
+		// when they are not known, such as for a texture that was
+		// swapped in
+		int width;
+		int height;
+		int colorChannels;
 	};
 
 	struct OBJECT_MATERIAL
@@ -41,6 +62,121 @@ public:
 		glm::vec3 specularColor;
 		float shininess;
 		std::string tag;
+		ResourceTag key;
+	};
+
+	// the basic shape meshes that can be drawn
+	enum SHAPE_MESH
+	{
+		MESH_PLANE,
+		MESH_BOX,
+		MESH_CONE,
+		MESH_CYLINDER,
+		MESH_SPHERE,
+		MESH_PYRAMID4
+	};
+
+	// image pixels decoded from a file, waiting to be uploaded
+	struct DECODED_IMAGE
+	{
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+	};
+
+	// an object of a scene loaded from a scene description file,
+	// with its model matrix built once when it is placed
+	struct SCENE_OBJECT
+	{
+		std::string name;
+		SHAPE_MESH mesh;
+		glm::vec3 scale;
+		glm::vec3 rotation;
+		glm::vec3 position;
+		glm::mat4 model;
+		ResourceTag texture;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		ResourceTag material;
+	};
+
+	// a point light of a scene loaded from a scene description
+	struct SCENE_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+	};
+
+	// where a balloon floats - its center, the point its string
+	// is tied to, and its radius across
+	struct BALLOON_POSE
+	{
+		glm::vec3 position;
+		glm::vec3 anchor;
+		float radius;
+	};
+
+	// an object of a streamed world chunk - the texture and the
+	// material are numbers into the lists of its chunk, -1 for a
+	// plain color and for no material
+	struct STREAMED_OBJECT
+	{
+		glm::mat4 model;
+		SHAPE_MESH mesh;
+		int texture;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		int material;
+	};
+
+	// a scene texture packed into an atlas page - the page is
+	// loaded in a texture slot of its own, and the rectangle is
+	// the offset and size of the texture in the page
+	struct ATLAS_ENTRY
+	{
+		std::string tag;
+		ResourceTag key;
+		std::string filename;
+		int pageSlot;
+		int x;
+		int y;
+		int width;
+		int height;
+		glm::vec4 uvRect;
+	};
+
+	// a texture tag whose image has the same pixels as a loaded
+	// texture - it uses the texture of that slot rather than
+	// loading its own copy
+	struct TEXTURE_ALIAS
+	{
+		std::string tag;
+		ResourceTag key;
+		std::string filename;
+		int slot;
+	};
+
+	// texture unit after the units of the texture slots, for the
+	// textures of streamed world chunks and for binding textures
+	// while they are uploaded, so the slot units are left alone
+	static const int SPARE_TEXTURE_UNIT = 16;
+
+	// the scene values an animation channel can drive - each one
+	// is three numbers
+	enum ANIMATED_PROPERTY
+	{
+		ANIMATE_OBJECT_POSITION = 0,
+		ANIMATE_OBJECT_ROTATION,
+		ANIMATE_OBJECT_SCALE,
+		ANIMATE_BALLOON_POSITION,
+		ANIMATE_LIGHT_POSITION,
+		ANIMATE_LIGHT_DIFFUSE,
+		ANIMATE_LIGHT_SPECULAR,
+		ANIMATE_MATERIAL_DIFFUSE,
+		ANIMATE_MATERIAL_SPECULAR
 	};
 
 private:
@@ -48,24 +184,99 @@ private:
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
+	// pointer to the arena for data that only lives for one frame
+	FrameArena* m_pFrameArena;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// scene texture images decoded ahead of being uploaded
+	std::vector<DECODED_IMAGE> m_decodedImages;
+	// objects of the scene description file, when one is loaded
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// pack the small scene textures into atlas pages
+	bool m_bTextureAtlas;
+	// the textures packed into atlas pages
+	std::vector<ATLAS_ENTRY> m_atlasEntries;
+	// share one texture between the tags whose images have the
+	// same pixels
+	bool m_bDedupeTextures;
+	// the tags that share the texture of another slot
+	std::vector<TEXTURE_ALIAS> m_textureAliases;
+	// point lights of the scene description file, empty for the
+	// built in lights
+	std::vector<SCENE_LIGHT> m_sceneLights;
+	bool m_bSceneFileLoaded;
+	// the balloons to draw - the balloon of the party scene until
+	// the balloon physics sets its own
+	std::vector<BALLOON_POSE> m_balloonPoses;
+	bool m_bBalloonPhysics;
+	// the position, diffuse and specular uniform names of every
+	// point light, built once for the animated lights
+	std::vector<std::string> m_lightUniformNames;
+	// the image files read by the hot-reloads, kept once each so
+	// the hitch reports can name the loads
+	std::set<std::string> m_reloadFilenames;
+#ifndef NDEBUG
+	// the last texture tag reported as not loaded
+	ResourceTag m_missingTextureTag;
+#endif
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// decode a texture image file into memory, from disk even
+	// when the mounted asset pack holds it if asked - no OpenGL
+	// calls
+	bool DecodeTextureImage(const char* filename, DECODED_IMAGE& image, bool bFromDisk = false);
+	// decode the bytes of an image file already read into memory
+	bool DecodeTextureImage(
+		const char* filename,
+		const unsigned char* fileData,
+		size_t fileSize,
+		DECODED_IMAGE& image);
+	// convert decoded image data to OpenGL texture data - into
+	// the passed in slot, or the first free slot when it is -1 -
+	// and free the image data unless it is to be kept
+	bool UploadGLTexture(DECODED_IMAGE& image, std::string tag, int slot = -1, bool bKeepPixels = false);
+	// copy an image over the texture in a slot, when it has the
+	// size and channels of the image the texture was made from
+	bool UpdateTextureInPlace(int slot, const DECODED_IMAGE& image);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
+	// free the OpenGL texture in one slot
+	void DestroyGLTexture(int slot);
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(ResourceTag tag);
+	int FindTextureSlot(ResourceTag tag);
+	// find a tag sharing the texture of another slot, and a
+	// loaded texture with the passed in content hash
+	int FindTextureAlias(ResourceTag tag) const;
+	int FindDuplicateTexture(uint64_t contentHash) const;
+	// a copy of an image filename that stays valid for the run,
+	// made once for each file
+	const char* GetReloadFilename(const std::string& filename);
+	// remember the image file a loaded texture tag came from
+	void SetTextureFile(ResourceTag tag, const std::string& filename);
+	// take a tag off the texture it shares, so it can be loaded
+	// on its own - returns the slot the tag still has to itself,
+	// or -1 when it has none
+	int UnshareTexture(ResourceTag tag);
+	// hand the slot of a texture to the first of its aliases -
+	// returns false when it has none
+	bool PromoteTextureAlias(int slot);
+	// find a texture packed into an atlas page by tag
+	int FindAtlasEntry(ResourceTag tag) const;
+	// pack the decoded scene textures that are small enough into
+	// atlas pages and upload the pages
+	void UploadTextureAtlas();
+	// copy a changed image into its place in an atlas page
+	bool ReloadAtlasEntry(ATLAS_ENTRY& entry, const DECODED_IMAGE& image);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(ResourceTag tag, OBJECT_MATERIAL& material);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -85,7 +296,7 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		ResourceTag textureTag);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -93,7 +304,30 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		ResourceTag materialTag);
+
+	// draw one of the basic shape meshes
+	void DrawShapeMesh(SHAPE_MESH mesh);
+
+	// render the scene from the draw packets baked at compile
+	// time - used in place of RenderScene() when the build
+	// defines BAKED_SCENE
+	void RenderBakedScene();
+
+	// render the objects of the loaded scene description file
+	void RenderSceneObjects();
+
+	// render the balloons at their poses, with their strings
+	void RenderBalloons();
+
+	// bring the textures, materials and objects in line with a
+	// scene description, changing only what differs
+	void ApplySceneTextures(const SCENE_DESCRIPTION& scene, bool bFromDisk);
+	void ApplySceneMaterials(const SCENE_DESCRIPTION& scene);
+	void ApplySceneObjects(const SCENE_DESCRIPTION& scene);
+	void ApplySceneLights(const SCENE_DESCRIPTION& scene);
+	// set the point lights of the scene description into the shader
+	void SetSceneLights();
 
 public:
 
@@ -104,5 +338,86 @@ public:
 	void LoadSceneTextures(); // ADDED FROM 5-2
 	void SetupSceneLights(); // ADDED FROM 6-3
 	void DefineObjectMaterials(); //ADDED FROM 6-3
+	void LoadSceneMeshes();
+
+	// the startup pipeline splits LoadSceneTextures() into the
+	// decoding, which is safe to run on any thread, and the
+	// upload, which must run on the OpenGL context thread
+	int GetSceneTextureCount() const;
+	bool DecodeSceneTexture(int index);
+	// decode a scene texture from the bytes of its file, read
+	// into memory ahead of time
+	bool DecodeSceneTexture(int index, const unsigned char* fileData, size_t fileSize);
+	void UploadSceneTextures();
+	// pack the scene textures of up to 1008x1008 into shared
+	// atlas pages when they are uploaded - set before the upload
+	void SetTextureAtlas(bool bTextureAtlas);
+	// share one texture between tags whose decoded images have
+	// the same pixels - set before any texture is loaded
+	void SetTextureDeduplication(bool bDedupeTextures);
+	// number of tags sharing another texture, and the GPU bytes
+	// they would have taken with textures of their own
+	int GetSharedTextureCount() const;
+	size_t GetDeduplicatedBytes() const;
+
+	// asynchronous texture loading - a request puts a 1x1
+	// placeholder into a slot straight away, returning the slot,
+	// and the loaded texture is swapped into the slot once it is
+	// ready
+	const char* GetSceneTextureFile(int index) const;
+	const char* GetSceneTextureTag(int index) const;
+	int CreatePlaceholderTexture(const std::string& tag, const std::string& filename);
+	bool SwapInTexture(int slot, GLTextureHandle& texture);
+	// the texture in a slot, 0 when the slot is empty, and the
+	// slot of a texture tag, -1 when it is not loaded
+	uint32_t GetSlotTexture(int slot) const;
+	int GetTextureSlot(const std::string& tag);
+
+	// draw with another shader, such as the texture feedback
+	// shader - returns the shader that was in use
+	ShaderManager* SetShaderManager(ShaderManager* pShaderManager);
+
+	// scene hot-reload - apply a scene description to the live
+	// scene, changing only what differs from what is loaded and
+	// reading new images from disk if asked, and re-upload the
+	// textures loaded from an image file that has changed on disk
+	void ApplySceneDescription(const SCENE_DESCRIPTION& scene, bool bFromDisk = false);
+	bool ReloadTextureFile(const std::string& filename);
+	// texture hot-reload - upload an image file decoded ahead of
+	// time, on another thread, into the textures loaded from the
+	// file; the image data is freed
+	bool ReloadTextureImage(const std::string& filename, DECODED_IMAGE& image);
+	// the image files the loaded textures came from
+	void GetTextureFiles(std::vector<std::string>& filenames) const;
+
+	// number of objects and point lights of the loaded scene
+	// description, for the benchmark report
+	int GetSceneObjectCount() const;
+	int GetScenePointLightCount() const;
+
+	// scale the candle light by the flicker of the flame
+	void SetCandleFlicker(float brightness);
+
+	// the balloons of the scene - the balloon physics starts from
+	// these poses and sets the moved poses back every step
+	int GetBalloonCount() const;
+	const BALLOON_POSE* GetBalloonPoses() const;
+	void SetBalloonPoses(const BALLOON_POSE* poses, int count);
+
+	// render the objects of a streamed world chunk, with the
+	// textures and materials the chunk loaded for itself
+	void RenderStreamedObjects(
+		const STREAMED_OBJECT* objects,
+		int count,
+		const uint32_t* textureIDs,
+		const OBJECT_MATERIAL* materials);
+
+	// animation targets - find the object, balloon, light or
+	// material a channel drives, by object name, balloon or light
+	// number or material tag, -1 when there is none; then get
+	// and set its value.  Lights are only set, into the shader.
+	int FindAnimationTarget(ANIMATED_PROPERTY property, const std::string& name) const;
+	bool GetAnimatedValue(ANIMATED_PROPERTY property, int target, glm::vec3& value) const;
+	void SetAnimatedValue(ANIMATED_PROPERTY property, int target, const glm::vec3& value);
 
 };
\ No newline at end of file
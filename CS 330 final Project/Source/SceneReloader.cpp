@@ -0,0 +1,294 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenereloader.cpp
+// ============
+// scene hot-reload - watches the scene description, its textures and the
+// shaders, and applies only what changed to the running scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneReloader.h"
+#include "SceneManager.h"
+#include "ShaderManager.h"
+#include "FrameScheduler.h"
+#include "TextureReloader.h"
+#include "HitchDetector.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// longest time the loop blocks waiting for events in the
+	// on-demand mode, so changed files are still noticed
+	const double WATCH_IDLE_TIMEOUT_SECONDS = 0.25;
+
+	/***********************************************************
+	 *  IsProgramUsable()
+	 *
+	 *  This function is used to check that a shader program
+	 *  built from the shader files linked, and that the shaders
+	 *  still attached to it compiled.
+	 ***********************************************************/
+	bool IsProgramUsable(GLuint program)
+	{
+		if ((0 == program) || (glIsProgram(program) == GL_FALSE))
+		{
+			return(false);
+		}
+
+		GLuint shaders[2] = { 0, 0 };
+		GLsizei shaderCount = 0;
+		glGetAttachedShaders(program, 2, &shaderCount, shaders);
+		for (GLsizei i = 0; i < shaderCount; i++)
+		{
+			GLint bCompiled = GL_FALSE;
+			glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &bCompiled);
+			if (GL_FALSE == bCompiled)
+			{
+				return(false);
+			}
+		}
+
+		GLint bLinked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+		return(GL_FALSE != bLinked);
+	}
+}
+
+/***********************************************************
+ *  SceneReloader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneReloader::SceneReloader(
+	SceneManager* pSceneManager,
+	ShaderManager* pShaderManager,
+	FrameScheduler* pFrameScheduler)
+{
+	m_pSceneManager = pSceneManager;
+	m_pShaderManager = pShaderManager;
+	m_pFrameScheduler = pFrameScheduler;
+	m_pTextureReloader = NULL;
+}
+
+/***********************************************************
+ *  ~SceneReloader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneReloader::~SceneReloader()
+{
+	m_pSceneManager = NULL;
+	m_pShaderManager = NULL;
+	m_pFrameScheduler = NULL;
+	m_pTextureReloader = NULL;
+}
+
+/***********************************************************
+ *  SetTextureReloader()
+ *
+ *  This method is used to hand the image files of the scene
+ *  to a texture reloader, which decodes changed files on a
+ *  thread of its own instead of on the main thread.
+ ***********************************************************/
+void SceneReloader::SetTextureReloader(TextureReloader* pTextureReloader)
+{
+	m_pTextureReloader = pTextureReloader;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to load the scene file into the live
+ *  scene and start watching the files.  The startup scene
+ *  is already loaded, so only what the scene file changes
+ *  is loaded here.
+ ***********************************************************/
+bool SceneReloader::Start(
+	const char* sceneFilename,
+	const char* vertexShaderFilename,
+	const char* fragmentShaderFilename)
+{
+	m_sceneFilename = sceneFilename;
+	m_vertexShaderFilename = vertexShaderFilename;
+	m_fragmentShaderFilename = fragmentShaderFilename;
+
+	if (ReloadScene(false) == false)
+	{
+		return(false);
+	}
+
+	m_watcher.AddFile(m_sceneFilename);
+	m_watcher.AddFile(m_vertexShaderFilename);
+	m_watcher.AddFile(m_fragmentShaderFilename);
+
+	if (NULL != m_pFrameScheduler)
+	{
+		m_pFrameScheduler->SetIdleTimeout(WATCH_IDLE_TIMEOUT_SECONDS);
+	}
+
+	std::cout << "INFO: watching " << m_sceneFilename << " and its files for changes" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to apply the changes to the watched
+ *  files.  A changed scene file is applied as a whole before
+ *  any changed image files, since it may have stopped using
+ *  them, and the shaders are rebuilt once however many of
+ *  the shader files changed.
+ ***********************************************************/
+void SceneReloader::Update()
+{
+	std::vector<std::string> changedFiles;
+	if (m_watcher.Poll(changedFiles) == false)
+	{
+		return;
+	}
+
+	TRACE_SCOPE("SceneReloader::Update");
+
+	bool bSceneChanged = false;
+	bool bShadersChanged = false;
+	for (const std::string& filename : changedFiles)
+	{
+		if (filename == m_sceneFilename)
+		{
+			bSceneChanged = true;
+		}
+		else if ((filename == m_vertexShaderFilename) || (filename == m_fragmentShaderFilename))
+		{
+			bShadersChanged = true;
+		}
+	}
+
+	if (true == bShadersChanged)
+	{
+		ReloadShaders();
+	}
+	if (true == bSceneChanged)
+	{
+		ReloadScene(true);
+	}
+
+	for (const std::string& filename : changedFiles)
+	{
+		if ((filename != m_sceneFilename) &&
+			(filename != m_vertexShaderFilename) &&
+			(filename != m_fragmentShaderFilename))
+		{
+			m_pSceneManager->ReloadTextureFile(filename);
+		}
+	}
+
+	if (NULL != m_pFrameScheduler)
+	{
+		m_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_ASSETS);
+	}
+}
+
+/***********************************************************
+ *  ReloadScene()
+ *
+ *  This method is used to read the scene file and apply it
+ *  to the live scene.  A file with an error is reported and
+ *  the scene is left as it was, so a half saved edit does no
+ *  harm.  An edited scene file, and the new images it names,
+ *  are read from disk, as the mounted asset pack holds them
+ *  as they were packed.
+ ***********************************************************/
+bool SceneReloader::ReloadScene(bool bFromDisk)
+{
+	SCENE_DESCRIPTION scene;
+	if (LoadSceneDescription(m_sceneFilename.c_str(), scene, bFromDisk) == false)
+	{
+		return(false);
+	}
+
+	m_scene = scene;
+	m_pSceneManager->ApplySceneDescription(m_scene, bFromDisk);
+	WatchSceneTextures();
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used to compile and link the shader files
+ *  again.  The shader manager links the whole program from
+ *  both files, so either file changing rebuilds all of it.
+ *  The uniform values belong to the program, so the
+ *  lights are set up again in the new one - the view and the
+ *  per object values are set every frame anyway.
+ ***********************************************************/
+void SceneReloader::ReloadShaders()
+{
+	TRACE_SCOPE("ReloadShaders");
+	HitchActivity activity(HitchDetector::ACTIVITY_SHADER_COMPILE, "ReloadShaders");
+
+	// the shader manager builds a new program, so the old one
+	// is deleted once it has been replaced
+	GLuint previousProgram = m_pShaderManager->m_programID;
+	GLuint program = m_pShaderManager->LoadShaders(
+		m_vertexShaderFilename.c_str(),
+		m_fragmentShaderFilename.c_str());
+
+	// a shader saved with an error still gives a program, so the
+	// new program is kept only if its shaders compiled and it
+	// linked - otherwise the working one stays in use
+	if (IsProgramUsable(program) == false)
+	{
+		if ((0 != program) && (previousProgram != program))
+		{
+			glDeleteProgram(program);
+		}
+		m_pShaderManager->m_programID = previousProgram;
+		m_pShaderManager->use();
+		RenderStats::Count(RenderStats::PROGRAM_SWITCHES);
+
+		std::cout << "ERROR: could not reload shaders:" << m_vertexShaderFilename
+			<< ", " << m_fragmentShaderFilename << " - keeping the previous shaders" << std::endl;
+		return;
+	}
+
+	if ((0 != previousProgram) && (previousProgram != program))
+	{
+		glDeleteProgram(previousProgram);
+	}
+	m_pShaderManager->use();
+	RenderStats::Count(RenderStats::PROGRAM_SWITCHES);
+
+	m_pSceneManager->SetupSceneLights();
+
+	std::cout << "INFO: reloaded shaders:" << m_vertexShaderFilename
+		<< ", " << m_fragmentShaderFilename << std::endl;
+}
+
+/***********************************************************
+ *  WatchSceneTextures()
+ *
+ *  This method is used to watch the image files named by the
+ *  scene description, or to have the texture reloader watch
+ *  them.  Files that are already watched are skipped by the
+ *  watcher.
+ ***********************************************************/
+void SceneReloader::WatchSceneTextures()
+{
+	for (const SCENE_TEXTURE_DESC& texture : m_scene.textures)
+	{
+		if (NULL != m_pTextureReloader)
+		{
+			m_pTextureReloader->WatchFile(texture.filename);
+		}
+		else
+		{
+			m_watcher.AddFile(texture.filename);
+		}
+	}
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenereloader.h
+// ============
+// scene hot-reload - watches the scene description, its textures and the
+// shaders, and applies only what changed to the running scene
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FileWatcher.h"
+#include "SceneDescription.h"
+
+#include <string>
+
+class SceneManager;
+class ShaderManager;
+class FrameScheduler;
+class TextureReloader;
+
+/***********************************************************
+ *  SceneReloader
+ *
+ *  This class loads a scene description file into the scene
+ *  manager and then watches it, the image files it names and
+ *  the shader files.  When one of them is written, only that
+ *  part of the scene is updated - a changed image file is
+ *  uploaded again into its texture slot, a changed scene file
+ *  is compared with the live scene so only the objects,
+ *  materials and textures that differ are touched, and a
+ *  changed shader file rebuilds the shader program.  All of
+ *  it runs on the main thread, between frames.
+ ***********************************************************/
+class SceneReloader
+{
+public:
+	// constructor
+	SceneReloader(
+		SceneManager* pSceneManager,
+		ShaderManager* pShaderManager,
+		FrameScheduler* pFrameScheduler);
+	// destructor
+	~SceneReloader();
+
+	// load the scene file into the scene and start watching it,
+	// its textures and the shader files
+	bool Start(
+		const char* sceneFilename,
+		const char* vertexShaderFilename,
+		const char* fragmentShaderFilename);
+
+	// hand the image files of the scene to a texture reloader to
+	// watch and reload, rather than reloading them here - set
+	// before Start()
+	void SetTextureReloader(TextureReloader* pTextureReloader);
+
+	// apply the changes to the watched files - call once per
+	// loop iteration on the thread that owns the OpenGL context
+	void Update();
+
+private:
+	// the objects the changes are applied to
+	SceneManager* m_pSceneManager;
+	ShaderManager* m_pShaderManager;
+	FrameScheduler* m_pFrameScheduler;
+	TextureReloader* m_pTextureReloader;
+
+	// the watched files
+	FileWatcher m_watcher;
+	std::string m_sceneFilename;
+	std::string m_vertexShaderFilename;
+	std::string m_fragmentShaderFilename;
+	// the last scene description that was read without errors
+	SCENE_DESCRIPTION m_scene;
+
+	// read the scene file and apply it to the live scene - from
+	// disk, rather than the mounted asset pack, once it is edited
+	bool ReloadScene(bool bFromDisk);
+	// compile and link the shader files again, keeping the
+	// previous program when they do not build
+	void ReloadShaders();
+	// watch the image files of the current scene description
+	void WatchSceneTextures();
+};
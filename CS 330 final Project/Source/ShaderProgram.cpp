@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderprogram.cpp
+// ============
+// shader programs for the effects that draw outside the scene shader - builds
+// compute and graphics programs from GLSL files, with optional defines
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderProgram.h"
+#include "HitchDetector.h"
+#include "RenderStats.h"
+#include "AssetPack.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  ShaderProgram()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderProgram::ShaderProgram()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  ~ShaderProgram()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderProgram::~ShaderProgram()
+{
+	Reset();
+}
+
+/***********************************************************
+ *  LoadCompute()
+ *
+ *  This method is used to build a compute program from one
+ *  shader file.
+ ***********************************************************/
+bool ShaderProgram::LoadCompute(const char* computeFilename, const char* defines)
+{
+	HitchActivity activity(HitchDetector::ACTIVITY_SHADER_COMPILE, computeFilename);
+
+	GLuint shader = CompileStage(GL_COMPUTE_SHADER, computeFilename, defines);
+	if (0 == shader)
+	{
+		return(false);
+	}
+
+	bool bLinked = Link(&shader, 1, computeFilename);
+	glDeleteShader(shader);
+	return(bLinked);
+}
+
+/***********************************************************
+ *  LoadGraphics()
+ *
+ *  This method is used to build a program from a vertex and
+ *  a fragment shader file.
+ ***********************************************************/
+bool ShaderProgram::LoadGraphics(
+	const char* vertexFilename,
+	const char* fragmentFilename,
+	const char* defines)
+{
+	HitchActivity activity(HitchDetector::ACTIVITY_SHADER_COMPILE, vertexFilename);
+
+	GLuint shaders[2];
+	shaders[0] = CompileStage(GL_VERTEX_SHADER, vertexFilename, defines);
+	shaders[1] = CompileStage(GL_FRAGMENT_SHADER, fragmentFilename, defines);
+
+	bool bLinked = false;
+	if ((0 != shaders[0]) && (0 != shaders[1]))
+	{
+		bLinked = Link(shaders, 2, vertexFilename);
+	}
+
+	glDeleteShader(shaders[0]);
+	glDeleteShader(shaders[1]);
+	return(bLinked);
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used to delete the program.
+ ***********************************************************/
+void ShaderProgram::Reset()
+{
+	if (0 != m_programID)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+}
+
+/***********************************************************
+ *  Use()
+ *
+ *  This method is used to make the program the current one.
+ ***********************************************************/
+void ShaderProgram::Use() const
+{
+	glUseProgram(m_programID);
+	RenderStats::Count(RenderStats::PROGRAM_SWITCHES);
+}
+
+/***********************************************************
+ *  GetUniformLocation()
+ *
+ *  This method returns the location of a uniform.  Look the
+ *  locations up once after loading, not every frame.
+ ***********************************************************/
+int ShaderProgram::GetUniformLocation(const char* name) const
+{
+	return(glGetUniformLocation(m_programID, name));
+}
+
+/***********************************************************
+ *  ReadSource()
+ *
+ *  This method is used to read a shader file and place the
+ *  defines on the line after the #version line.
+ ***********************************************************/
+bool ShaderProgram::ReadSource(const char* filename, const char* defines, std::string& source)
+{
+	if (AssetPack::ReadTextFile(filename, source) == false)
+	{
+		std::cerr << "ERROR: could not read shader file:" << filename << std::endl;
+		return(false);
+	}
+
+	if ((NULL != defines) && (defines[0] != '\0'))
+	{
+		size_t versionEnd = 0;
+		if (source.compare(0, 8, "#version") == 0)
+		{
+			versionEnd = source.find('\n');
+			versionEnd = (versionEnd == std::string::npos) ? source.size() : versionEnd + 1;
+		}
+		source.insert(versionEnd, std::string(defines) + "\n");
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  CompileStage()
+ *
+ *  This method is used to compile one shader stage from a
+ *  file.  It returns the shader object, or 0 and reports the
+ *  compile log on failure.
+ ***********************************************************/
+uint32_t ShaderProgram::CompileStage(uint32_t stage, const char* filename, const char* defines)
+{
+	std::string source;
+	if (ReadSource(filename, defines, source) == false)
+	{
+		return(0);
+	}
+
+	GLuint shader = glCreateShader(stage);
+	const char* text = source.c_str();
+	glShaderSource(shader, 1, &text, NULL);
+	glCompileShader(shader);
+
+	GLint bCompiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+	if (GL_FALSE == bCompiled)
+	{
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		std::cerr << "ERROR: could not compile shader " << filename << " " << defines << std::endl << log << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	return(shader);
+}
+
+/***********************************************************
+ *  Link()
+ *
+ *  This method is used to link the compiled stages into a
+ *  new program, replacing the current one only once the new
+ *  one has linked.
+ ***********************************************************/
+bool ShaderProgram::Link(const uint32_t* shaders, int shaderCount, const char* name)
+{
+	GLuint program = glCreateProgram();
+	for (int i = 0; i < shaderCount; i++)
+	{
+		glAttachShader(program, shaders[i]);
+	}
+	glLinkProgram(program);
+
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+	if (GL_FALSE == bLinked)
+	{
+		char log[1024];
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		std::cerr << "ERROR: could not link shader program " << name << std::endl << log << std::endl;
+		glDeleteProgram(program);
+		return(false);
+	}
+
+	Reset();
+	m_programID = program;
+	return(true);
+}
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderprogram.h
+// ============
+// shader programs for the effects that draw outside the scene shader - builds
+// compute and graphics programs from GLSL files, with optional defines
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  ShaderProgram
+ *
+ *  This class owns one OpenGL shader program built from
+ *  GLSL files.  The passed in defines are placed after the
+ *  #version line, so one file can hold several variants of
+ *  a shader.  Compile and link errors are reported with the
+ *  file name, and the program is deleted when the object is
+ *  reset or destroyed.
+ ***********************************************************/
+class ShaderProgram
+{
+public:
+	// constructor
+	ShaderProgram();
+	// destructor
+	~ShaderProgram();
+
+	// build a compute program from one file
+	bool LoadCompute(const char* computeFilename, const char* defines = "");
+	// build a program from a vertex and a fragment shader file
+	bool LoadGraphics(
+		const char* vertexFilename,
+		const char* fragmentFilename,
+		const char* defines = "");
+	// delete the program
+	void Reset();
+
+	// make the program the current one
+	void Use() const;
+	// the location of a uniform, -1 when the program has none
+	int GetUniformLocation(const char* name) const;
+
+	// the OpenGL program object, 0 when empty
+	uint32_t Get() const { return(m_programID); }
+
+private:
+	ShaderProgram(const ShaderProgram&);
+	ShaderProgram& operator=(const ShaderProgram&);
+
+	uint32_t m_programID;
+
+	// read a shader file and add the defines to it
+	static bool ReadSource(const char* filename, const char* defines, std::string& source);
+	// compile one shader stage, 0 on failure
+	static uint32_t CompileStage(uint32_t stage, const char* filename, const char* defines);
+	// link the compiled stages into the program
+	bool Link(const uint32_t* shaders, int shaderCount, const char* name);
+};
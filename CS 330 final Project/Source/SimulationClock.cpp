@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+// simulationclock.cpp
+// ============
+// fixed timestep clock - turns the variable render frame time into a number
+// of fixed simulation steps plus an interpolation factor for rendering
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SimulationClock.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// default most steps simulated for one rendered frame - when
+	// the simulation falls further behind than this, the extra
+	// time is dropped instead of trying to catch up, which would
+	// make every following frame slower still
+	const int DEFAULT_MAX_STEPS_PER_FRAME = 8;
+	// longest frame time accepted before it is clamped
+	const double MAX_FRAME_SECONDS = 0.25;
+}
+
+/***********************************************************
+ *  SimulationClock()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SimulationClock::SimulationClock(double stepSeconds)
+{
+	m_stepSeconds = stepSeconds;
+	m_accumulator = 0.0;
+	m_lastTime = 0.0;
+	m_bStarted = false;
+	m_maxStepsPerFrame = DEFAULT_MAX_STEPS_PER_FRAME;
+	m_totalSteps = 0;
+	m_droppedSeconds = 0.0;
+}
+
+/***********************************************************
+ *  ~SimulationClock()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SimulationClock::~SimulationClock()
+{
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used to restart the timing from the
+ *  current time and drop any accumulated time.  It is called
+ *  after the render loop has been idle, so the idle time is
+ *  not simulated all at once.
+ ***********************************************************/
+void SimulationClock::Reset()
+{
+	m_lastTime = glfwGetTime();
+	m_bStarted = true;
+	m_accumulator = 0.0;
+}
+
+/***********************************************************
+ *  Advance()
+ *
+ *  This method is used to measure the real time since the
+ *  last call and return how many fixed steps need to be
+ *  simulated before rendering the next frame.
+ ***********************************************************/
+int SimulationClock::Advance()
+{
+	double currentTime = glfwGetTime();
+	double frameSeconds = 0.0;
+
+	if (true == m_bStarted)
+	{
+		frameSeconds = currentTime - m_lastTime;
+	}
+	m_lastTime = currentTime;
+	m_bStarted = true;
+
+	return(AdvanceBy(frameSeconds));
+}
+
+/***********************************************************
+ *  AdvanceBy()
+ *
+ *  This method is used to add the passed in frame time to
+ *  the accumulator and return how many fixed steps need to
+ *  be simulated.  Passing exactly one step per frame gives
+ *  fully deterministic runs, such as for benchmarking.
+ ***********************************************************/
+int SimulationClock::AdvanceBy(double frameSeconds)
+{
+	// a very long frame, like a debugger break or a window drag,
+	// should not be simulated in full
+	if (frameSeconds > MAX_FRAME_SECONDS)
+	{
+		m_droppedSeconds += frameSeconds - MAX_FRAME_SECONDS;
+		frameSeconds = MAX_FRAME_SECONDS;
+	}
+	if (frameSeconds < 0.0)
+	{
+		frameSeconds = 0.0;
+	}
+
+	m_accumulator += frameSeconds;
+
+	int steps = 0;
+	while (m_accumulator >= m_stepSeconds)
+	{
+		m_accumulator -= m_stepSeconds;
+		steps++;
+	}
+
+	// avoid the spiral of death - if the simulation cannot keep
+	// up, drop the extra steps and keep only the partial step
+	if (steps > m_maxStepsPerFrame)
+	{
+		m_droppedSeconds += (steps - m_maxStepsPerFrame) * m_stepSeconds;
+		steps = m_maxStepsPerFrame;
+	}
+
+	m_totalSteps += steps;
+
+	return(steps);
+}
+
+/***********************************************************
+ *  SetMaxStepsPerFrame()
+ *
+ *  This method is used to set the most fixed steps that are
+ *  simulated for one rendered frame.
+ ***********************************************************/
+void SimulationClock::SetMaxStepsPerFrame(int maxSteps)
+{
+	if (maxSteps > 0)
+	{
+		m_maxStepsPerFrame = maxSteps;
+	}
+}
+
+/***********************************************************
+ *  GetStepSeconds()
+ *
+ *  This method returns the length of one fixed step.
+ ***********************************************************/
+float SimulationClock::GetStepSeconds() const
+{
+	return((float)m_stepSeconds);
+}
+
+/***********************************************************
+ *  GetInterpolationAlpha()
+ *
+ *  This method returns how far the render time is between
+ *  the previous and the current simulation state.
+ ***********************************************************/
+float SimulationClock::GetInterpolationAlpha() const
+{
+	float alpha = (float)(m_accumulator / m_stepSeconds);
+
+	if (alpha > 1.0f)
+	{
+		alpha = 1.0f;
+	}
+
+	return(alpha);
+}
+
+/***********************************************************
+ *  GetSimulationTime()
+ *
+ *  This method returns the total simulated time in seconds.
+ ***********************************************************/
+double SimulationClock::GetSimulationTime() const
+{
+	return(m_totalSteps * m_stepSeconds);
+}
+
+/***********************************************************
+ *  GetDroppedSeconds()
+ *
+ *  This method returns the total real time that was dropped
+ *  because the simulation could not keep up.
+ ***********************************************************/
+double SimulationClock::GetDroppedSeconds() const
+{
+	return(m_droppedSeconds);
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// simulationclock.h
+// ============
+// fixed timestep clock - turns the variable render frame time into a number
+// of fixed simulation steps plus an interpolation factor for rendering
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  SimulationClock
+ *
+ *  This class accumulates the real time between rendered
+ *  frames and hands it out as whole fixed-size simulation
+ *  steps, so the simulation behaves the same at any frame
+ *  rate.  The leftover time is exposed as an interpolation
+ *  factor for blending the previous and current simulation
+ *  states when rendering.
+ ***********************************************************/
+class SimulationClock
+{
+public:
+	// constructor
+	SimulationClock(double stepSeconds);
+	// destructor
+	~SimulationClock();
+
+	// restart timing from now and drop any accumulated time
+	void Reset();
+
+	// measure the time since the last call and return the
+	// number of fixed steps that need to be simulated
+	int Advance();
+	// same as Advance() but with an explicit frame time
+	int AdvanceBy(double frameSeconds);
+
+	// set the most steps simulated for one rendered frame
+	void SetMaxStepsPerFrame(int maxSteps);
+
+	// length of one fixed simulation step in seconds
+	float GetStepSeconds() const;
+	// fraction of a step between the previous and current
+	// simulation states to use for rendering, 0.0 to 1.0
+	float GetInterpolationAlpha() const;
+	// total simulated time in seconds
+	double GetSimulationTime() const;
+	// total real time that was dropped to avoid falling behind
+	double GetDroppedSeconds() const;
+
+private:
+	// length of one fixed simulation step in seconds
+	double m_stepSeconds;
+	// real time that has not been simulated yet
+	double m_accumulator;
+	// time of the previous Advance() call
+	double m_lastTime;
+	// true once the first time has been measured
+	bool m_bStarted;
+	// most steps simulated for one rendered frame
+	int m_maxStepsPerFrame;
+	// total number of simulated steps
+	unsigned long long m_totalSteps;
+	// total real time that was dropped
+	double m_droppedSeconds;
+};
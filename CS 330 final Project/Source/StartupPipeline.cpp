@@ -0,0 +1,325 @@
+///////////////////////////////////////////////////////////////////////////////
+// startuppipeline.cpp
+// ============
+// run the application startup as a dependency graph - CPU only work such as
+// decoding images runs on worker threads while the window and OpenGL context
+// come up on the main thread
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StartupPipeline.h"
+#include "TraceRecorder.h"
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+/***********************************************************
+ *  StartupPipeline()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StartupPipeline::StartupPipeline()
+{
+	m_startTime = std::chrono::steady_clock::now();
+	m_finishedTasks = 0;
+}
+
+/***********************************************************
+ *  ~StartupPipeline()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StartupPipeline::~StartupPipeline()
+{
+}
+
+/***********************************************************
+ *  AddTask()
+ *
+ *  This method is used to add a startup task.  The task runs
+ *  on the requested kind of thread after all of the passed
+ *  in dependencies have finished successfully.
+ ***********************************************************/
+int StartupPipeline::AddTask(
+	const std::string& name,
+	TASK_THREAD thread,
+	std::function<bool()> work,
+	const std::vector<int>& dependencies)
+{
+	TASK task;
+	task.name = name;
+	task.thread = thread;
+	task.work = work;
+	task.remainingDependencies = (int)dependencies.size();
+	task.threadIndex = -1;
+	task.startMs = 0.0;
+	task.endMs = 0.0;
+	task.bSucceeded = false;
+	task.bSkipped = false;
+	task.traceName = TraceRecorder::InternName(name);
+
+	int taskIndex = (int)m_tasks.size();
+	m_tasks.push_back(task);
+
+	for (int dependency : dependencies)
+	{
+		m_tasks[dependency].dependents.push_back(taskIndex);
+	}
+
+	return(taskIndex);
+}
+
+/***********************************************************
+ *  ElapsedMs()
+ *
+ *  This method returns the milliseconds since the pipeline
+ *  was created.
+ ***********************************************************/
+double StartupPipeline::ElapsedMs() const
+{
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - m_startTime;
+	return(elapsed.count());
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used to run all of the startup tasks.  The
+ *  calling thread runs the main thread tasks as they become
+ *  ready, while the worker threads run everything else.  If
+ *  a task fails, every task depending on it is skipped.
+ ***********************************************************/
+bool StartupPipeline::Run(int workerCount)
+{
+	if (workerCount < 1)
+	{
+		workerCount = 1;
+	}
+
+	// queue every task that has no dependencies
+	for (int i = 0; i < (int)m_tasks.size(); i++)
+	{
+		if (m_tasks[i].remainingDependencies == 0)
+		{
+			if (m_tasks[i].thread == MAIN_THREAD)
+				m_mainReady.push_back(i);
+			else
+				m_workerReady.push_back(i);
+		}
+	}
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < workerCount; i++)
+	{
+		workers.push_back(std::thread(&StartupPipeline::WorkerLoop, this, i + 1));
+	}
+
+	// run the main thread tasks until every task is finished
+	while (true)
+	{
+		int taskIndex = -1;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_mainCondition.wait(lock, [this]()
+				{
+					return(!m_mainReady.empty() || (m_finishedTasks == (int)m_tasks.size()));
+				});
+			if (m_mainReady.empty())
+			{
+				break;
+			}
+			taskIndex = m_mainReady.front();
+			m_mainReady.pop_front();
+		}
+		ExecuteTask(taskIndex, 0);
+	}
+
+	// wake up the idle workers so they can see everything is done
+	m_workerCondition.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	bool bSucceeded = true;
+	for (const TASK& task : m_tasks)
+	{
+		if ((task.bSucceeded == false) && (task.bSkipped == false))
+		{
+			std::cerr << "ERROR: startup task failed: " << task.name << std::endl;
+			bSucceeded = false;
+		}
+		else if (task.bSkipped == true)
+		{
+			bSucceeded = false;
+		}
+	}
+
+	return(bSucceeded);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is the loop run by every worker thread - it
+ *  keeps taking ready worker tasks until all tasks are done.
+ ***********************************************************/
+void StartupPipeline::WorkerLoop(int threadIndex)
+{
+	TraceRecorder::SetThreadName(("startup worker " + std::to_string(threadIndex)).c_str());
+
+	while (true)
+	{
+		int taskIndex = -1;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workerCondition.wait(lock, [this]()
+				{
+					return(!m_workerReady.empty() || (m_finishedTasks == (int)m_tasks.size()));
+				});
+			if (m_workerReady.empty())
+			{
+				return;
+			}
+			taskIndex = m_workerReady.front();
+			m_workerReady.pop_front();
+		}
+		ExecuteTask(taskIndex, threadIndex);
+	}
+}
+
+/***********************************************************
+ *  ExecuteTask()
+ *
+ *  This method is used to run one task and record when it
+ *  started and ended.
+ ***********************************************************/
+void StartupPipeline::ExecuteTask(int taskIndex, int threadIndex)
+{
+	TASK& task = m_tasks[taskIndex];
+
+	task.threadIndex = threadIndex;
+	task.startMs = ElapsedMs();
+	bool bSucceeded = false;
+	{
+		TRACE_SCOPE(task.traceName);
+		bSucceeded = task.work();
+	}
+	task.endMs = ElapsedMs();
+
+	FinishTask(taskIndex, bSucceeded);
+}
+
+/***********************************************************
+ *  FinishTask()
+ *
+ *  This method is used to mark a task as finished and queue
+ *  the dependent tasks that are now ready.  The dependents
+ *  of a failed task are skipped, along with their own
+ *  dependents.
+ ***********************************************************/
+void StartupPipeline::FinishTask(int taskIndex, bool bSucceeded)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<int> finished;
+	m_tasks[taskIndex].bSucceeded = bSucceeded;
+	finished.push_back(taskIndex);
+
+	while (!finished.empty())
+	{
+		int index = finished.back();
+		finished.pop_back();
+		m_finishedTasks++;
+
+		bool bPassed = m_tasks[index].bSucceeded;
+		for (int dependent : m_tasks[index].dependents)
+		{
+			TASK& task = m_tasks[dependent];
+			if (task.bSkipped == true)
+			{
+				continue;
+			}
+			if (bPassed == false)
+			{
+				// skip the task once - it is finished from here on
+				task.bSkipped = true;
+				finished.push_back(dependent);
+				continue;
+			}
+
+			task.remainingDependencies--;
+			if (task.remainingDependencies == 0)
+			{
+				if (task.thread == MAIN_THREAD)
+					m_mainReady.push_back(dependent);
+				else
+					m_workerReady.push_back(dependent);
+			}
+		}
+	}
+
+	m_mainCondition.notify_one();
+	m_workerCondition.notify_all();
+}
+
+/***********************************************************
+ *  MarkEvent()
+ *
+ *  This method is used to record a named point in time on
+ *  the startup timeline.
+ ***********************************************************/
+void StartupPipeline::MarkEvent(const std::string& name)
+{
+	EVENT event;
+	event.name = name;
+	event.timeMs = ElapsedMs();
+	m_events.push_back(event);
+}
+
+/***********************************************************
+ *  PrintTimeline()
+ *
+ *  This method is used to print when every task ran and on
+ *  which thread, followed by the recorded events.
+ ***********************************************************/
+void StartupPipeline::PrintTimeline() const
+{
+	std::cout << "STARTUP: task timeline (ms since launch)" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (const TASK& task : m_tasks)
+	{
+		std::cout << "STARTUP: " << std::setw(9) << task.startMs
+			<< " - " << std::setw(9) << task.endMs
+			<< "  ";
+		if (task.threadIndex == 0)
+		{
+			std::cout << "main       ";
+		}
+		else if (task.threadIndex > 0)
+		{
+			std::cout << "worker " << std::setw(2) << task.threadIndex << "  ";
+		}
+		else
+		{
+			std::cout << "-          ";
+		}
+		std::cout << task.name;
+		if (task.bSkipped == true)
+		{
+			std::cout << " (skipped)";
+		}
+		else if (task.bSucceeded == false)
+		{
+			std::cout << " (failed)";
+		}
+		std::cout << std::endl;
+	}
+	for (const EVENT& event : m_events)
+	{
+		std::cout << "STARTUP: " << std::setw(9) << event.timeMs << "  " << event.name << std::endl;
+	}
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << std::setprecision(6);
+}
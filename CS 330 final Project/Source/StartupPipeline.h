@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// startuppipeline.h
+// ============
+// run the application startup as a dependency graph - CPU only work such as
+// decoding images runs on worker threads while the window and OpenGL context
+// come up on the main thread
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  StartupPipeline
+ *
+ *  This class runs a set of startup tasks in dependency
+ *  order.  Tasks that touch OpenGL or GLFW must run on the
+ *  main thread, while all other tasks are handed to worker
+ *  threads as soon as their dependencies are done.  The
+ *  start and end time of every task is recorded so the
+ *  startup timeline can be printed.
+ ***********************************************************/
+class StartupPipeline
+{
+public:
+	// constructor
+	StartupPipeline();
+	// destructor
+	~StartupPipeline();
+
+	// the thread a startup task must run on
+	enum TASK_THREAD
+	{
+		MAIN_THREAD,
+		WORKER_THREAD
+	};
+
+	// add a task that runs once all of its dependencies have
+	// finished - returns the task index to use as a dependency
+	int AddTask(
+		const std::string& name,
+		TASK_THREAD thread,
+		std::function<bool()> work,
+		const std::vector<int>& dependencies = std::vector<int>());
+
+	// run all of the tasks, returns false if any task failed
+	bool Run(int workerCount);
+
+	// record a named point in time on the timeline, such as the
+	// first presented frame
+	void MarkEvent(const std::string& name);
+
+	// print the recorded startup timeline to the console
+	void PrintTimeline() const;
+
+private:
+	struct TASK
+	{
+		std::string name;
+		TASK_THREAD thread;
+		std::function<bool()> work;
+		std::vector<int> dependents;
+		int remainingDependencies;
+		// 0 for the main thread, 1 and up for worker threads
+		int threadIndex;
+		double startMs;
+		double endMs;
+		bool bSucceeded;
+		bool bSkipped;
+		// copy of the name that stays valid for tracing
+		const char* traceName;
+	};
+
+	struct EVENT
+	{
+		std::string name;
+		double timeMs;
+	};
+
+	// all of the startup tasks
+	std::vector<TASK> m_tasks;
+	// named points in time
+	std::vector<EVENT> m_events;
+	// time the pipeline was created
+	std::chrono::steady_clock::time_point m_startTime;
+
+	// tasks ready to run on each kind of thread
+	std::deque<int> m_mainReady;
+	std::deque<int> m_workerReady;
+	// number of tasks that are finished or skipped
+	int m_finishedTasks;
+	// guards the ready queues and the task states while running
+	std::mutex m_mutex;
+	std::condition_variable m_mainCondition;
+	std::condition_variable m_workerCondition;
+
+	// milliseconds since the pipeline was created
+	double ElapsedMs() const;
+	// run one task and release the tasks that depend on it
+	void ExecuteTask(int taskIndex, int threadIndex);
+	// mark a task finished and queue its ready dependents
+	void FinishTask(int taskIndex, bool bSucceeded);
+	// the loop run by every worker thread
+	void WorkerLoop(int threadIndex);
+};
@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////
+// stressscene.cpp
+// ============
+// procedural stress scenes - party scenes of any size, laid out from a seed,
+// for measuring how the renderer scales with objects and lights
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StressScene.h"
+
+#include <cmath>
+#include <cstdint>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the textures and materials of the party scene
+	const SCENE_TEXTURE_DESC g_StressTextures[] =
+	{
+		{ "Party", "textures/Party_hat.jpg" },
+		{ "Floor", "textures/Check_floor.jpg" },
+		{ "Table", "textures/table.jpg" },
+		{ "balloon", "textures/Purple_balloon.png" },
+		{ "present", "textures/red_present.jpg" }
+	};
+
+	const SCENE_MATERIAL_DESC g_StressMaterials[] =
+	{
+		{ "Balloon", glm::vec3(0.4f, 0.1f, 0.6f), glm::vec3(0.3f, 0.2f, 0.5f), 16.0f },
+		{ "WrappingPaper", glm::vec3(0.7f, 0.0f, 0.0f), glm::vec3(1.0f, 0.9f, 0.3f), 64.0f },
+		{ "Wood", glm::vec3(0.4f, 0.25f, 0.1f), glm::vec3(0.05f, 0.05f, 0.05f), 4.0f },
+		{ "Ceramic", glm::vec3(0.9f, 0.9f, 0.95f), glm::vec3(0.9f, 0.9f, 0.9f), 48.0f }
+	};
+
+	// the spacing of the table grid - a table top is 19 by 10
+	const float TABLE_SPACING_X = 24.0f;
+	const float TABLE_SPACING_Z = 14.0f;
+	const float TABLE_TOP_HEIGHT = 4.25f;
+
+	/***********************************************************
+	 *  StressRandom
+	 *
+	 *  This class is a small xorshift random number generator.
+	 *  The standard distributions differ between libraries, so
+	 *  this keeps the layout the same on every platform.
+	 ***********************************************************/
+	class StressRandom
+	{
+	public:
+		// constructor
+		StressRandom(unsigned int seed)
+		{
+			// spread the bits of small seeds over the whole state,
+			// which must not be zero
+			m_state = ((uint64_t)seed + 0x9E3779B97F4A7C15ULL) * 0xBF58476D1CE4E5B9ULL;
+			m_state ^= m_state >> 31;
+			m_state |= 1;
+		}
+
+		// a number from min up to max
+		float Range(float min, float max)
+		{
+			m_state ^= m_state << 13;
+			m_state ^= m_state >> 7;
+			m_state ^= m_state << 17;
+			return(min + (max - min) * ((float)(m_state >> 40) / (float)(1 << 24)));
+		}
+
+	private:
+		uint64_t m_state;
+	};
+
+	/***********************************************************
+	 *  AddObject()
+	 *
+	 *  This function adds an object to the scene.
+	 ***********************************************************/
+	void AddObject(
+		SCENE_DESCRIPTION& scene,
+		const std::string& name,
+		SceneManager::SHAPE_MESH mesh,
+		glm::vec3 scale,
+		glm::vec3 rotation,
+		glm::vec3 position,
+		const char* texture,
+		glm::vec2 uvScale,
+		const char* material)
+	{
+		SCENE_OBJECT_DESC object;
+		object.name = name;
+		object.mesh = mesh;
+		object.scale = scale;
+		object.rotation = rotation;
+		object.position = position;
+		object.texture = (NULL != texture) ? texture : "";
+		object.color = glm::vec4(0.3f, 0.3f, 0.3f, 1.0f);
+		object.uvScale = uvScale;
+		object.material = (NULL != material) ? material : "";
+		scene.objects.push_back(object);
+	}
+}
+
+/***********************************************************
+ *  GenerateStressScene()
+ *
+ *  This function is used to build a party scene of the
+ *  requested size into the passed in scene description.
+ ***********************************************************/
+void GenerateStressScene(const STRESS_SCENE_PARAMS& params, SCENE_DESCRIPTION& scene)
+{
+	scene.textures.assign(std::begin(g_StressTextures), std::end(g_StressTextures));
+	scene.materials.assign(std::begin(g_StressMaterials), std::end(g_StressMaterials));
+	scene.objects.clear();
+	scene.lights.clear();
+
+	StressRandom random(params.seed);
+
+	// the tables are set out on a square grid centered on the
+	// origin, and the floor covers the grid
+	int columns = (int)std::ceil(std::sqrt((double)((params.tables > 0) ? params.tables : 1)));
+	int rows = (params.tables > 0) ? (params.tables + columns - 1) / columns : 1;
+	float halfWidth = columns * TABLE_SPACING_X * 0.5f;
+	float halfDepth = rows * TABLE_SPACING_Z * 0.5f;
+
+	AddObject(scene, "floor", SceneManager::MESH_PLANE,
+		glm::vec3(halfWidth, 1.0f, halfDepth), glm::vec3(0.0f), glm::vec3(0.0f),
+		"Floor", glm::vec2(columns * 2.5f, rows * 2.5f), "Ceramic");
+
+	const float legX[4] = { -9.2f, 9.2f, -9.2f, 9.2f };
+	const float legZ[4] = { -4.7f, -4.7f, 4.7f, 4.7f };
+	std::vector<glm::vec3> tableCenters;
+	for (int i = 0; i < params.tables; i++)
+	{
+		glm::vec3 center(
+			-halfWidth + ((i % columns) + 0.5f) * TABLE_SPACING_X,
+			0.0f,
+			-halfDepth + ((i / columns) + 0.5f) * TABLE_SPACING_Z);
+		tableCenters.push_back(center);
+
+		std::string name = "table_" + std::to_string(i);
+		AddObject(scene, name + "_top", SceneManager::MESH_BOX,
+			glm::vec3(19.0f, 0.5f, 10.0f), glm::vec3(0.0f), center + glm::vec3(0.0f, 4.0f, 0.0f),
+			"Table", glm::vec2(3.0f, 3.0f), "Wood");
+		for (int leg = 0; leg < 4; leg++)
+		{
+			AddObject(scene, name + "_leg_" + std::to_string(leg), SceneManager::MESH_BOX,
+				glm::vec3(0.3f, 4.0f, 0.3f), glm::vec3(0.0f), center + glm::vec3(legX[leg], 2.0f, legZ[leg]),
+				"Table", glm::vec2(1.0f, 1.0f), "Wood");
+		}
+	}
+
+	// presents sit on a random table, or on the floor when there
+	// are no tables
+	for (int i = 0; i < params.presents; i++)
+	{
+		float size = random.Range(1.0f, 3.0f);
+		glm::vec3 position;
+		if (false == tableCenters.empty())
+		{
+			int table = (int)random.Range(0.0f, (float)tableCenters.size()) % (int)tableCenters.size();
+			position = tableCenters[table] + glm::vec3(
+				random.Range(-8.0f, 8.0f), TABLE_TOP_HEIGHT + size * 0.5f, random.Range(-4.0f, 4.0f));
+		}
+		else
+		{
+			position = glm::vec3(
+				random.Range(-halfWidth, halfWidth), size * 0.5f, random.Range(-halfDepth, halfDepth));
+		}
+
+		AddObject(scene, "present_" + std::to_string(i), SceneManager::MESH_BOX,
+			glm::vec3(size), glm::vec3(0.0f, random.Range(-90.0f, 90.0f), 0.0f), position,
+			"present", glm::vec2(0.2f, 0.5f), "WrappingPaper");
+	}
+
+	// balloons float over the whole floor with their strings
+	// hanging below them
+	for (int i = 0; i < params.balloons; i++)
+	{
+		glm::vec3 position(
+			random.Range(-halfWidth, halfWidth), random.Range(10.0f, 16.0f), random.Range(-halfDepth, halfDepth));
+
+		std::string name = "balloon_" + std::to_string(i);
+		AddObject(scene, name, SceneManager::MESH_SPHERE,
+			glm::vec3(2.0f, 2.5f, 2.0f), glm::vec3(0.0f), position,
+			"balloon", glm::vec2(1.0f, 1.0f), "Balloon");
+		AddObject(scene, name + "_knot", SceneManager::MESH_PYRAMID4,
+			glm::vec3(0.3f), glm::vec3(0.0f), position - glm::vec3(0.0f, 2.55f, 0.0f),
+			"balloon", glm::vec2(1.0f, 1.0f), "Balloon");
+		AddObject(scene, name + "_string", SceneManager::MESH_CYLINDER,
+			glm::vec3(0.025f, position.y - 2.55f, 0.05f), glm::vec3(0.0f), glm::vec3(position.x, 0.0f, position.z),
+			NULL, glm::vec2(1.0f, 1.0f), NULL);
+	}
+
+	// the lights share out the brightness of one light, so the
+	// scene looks the same whatever the count and only the cost
+	// of shading changes
+	for (int i = 0; i < params.pointLights; i++)
+	{
+		float share = 1.0f / params.pointLights;
+		glm::vec3 color(random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f));
+
+		SCENE_LIGHT_DESC light;
+		light.position = glm::vec3(
+			random.Range(-halfWidth, halfWidth), random.Range(6.0f, 14.0f), random.Range(-halfDepth, halfDepth));
+		light.ambientColor = color * (0.2f * share);
+		light.diffuseColor = color * share;
+		light.specularColor = color * (0.5f * share);
+		scene.lights.push_back(light);
+	}
+}
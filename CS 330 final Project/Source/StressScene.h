@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////////////
+// stressscene.h
+// ============
+// procedural stress scenes - party scenes of any size, laid out from a seed,
+// for measuring how the renderer scales with objects and lights
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneDescription.h"
+
+// the size of a generated party scene
+struct STRESS_SCENE_PARAMS
+{
+	int tables;
+	int balloons;
+	int presents;
+	int pointLights;
+	unsigned int seed;
+};
+
+/***********************************************************
+ *  GenerateStressScene()
+ *
+ *  This function builds a party scene with the requested
+ *  number of tables, balloons, presents and point lights out
+ *  of the basic shape meshes and the scene textures.  The
+ *  tables are set out on a grid, and everything else is
+ *  placed from the seed, so the same parameters always give
+ *  the same scene.  Each table is 5 objects, each balloon 3,
+ *  each present 1, plus 1 for the floor.
+ ***********************************************************/
+void GenerateStressScene(const STRESS_SCENE_PARAMS& params, SCENE_DESCRIPTION& scene);
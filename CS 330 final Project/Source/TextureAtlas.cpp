@@ -0,0 +1,286 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureatlas.cpp
+// ============
+// texture atlas packing - places small images into shared atlas pages with
+// padding that keeps the mipmaps of neighbouring images apart
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <utility>
+
+/***********************************************************
+ *  TextureAtlas()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureAtlas::TextureAtlas(int pageSize, int alignment)
+{
+	m_pageSize = pageSize;
+	m_alignment = alignment;
+	m_usedArea = 0;
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used to pack an image into the first page
+ *  it fits in, at the lowest spot of that page's skyline, and
+ *  to copy it there with its border.  The rectangle is
+ *  rounded up to the alignment, so every rectangle starts on
+ *  a multiple of it.
+ ***********************************************************/
+bool TextureAtlas::Add(const unsigned char* pixels, int width, int height, int colorChannels, ATLAS_RECT& rect)
+{
+	int rectWidth = ((width + 2 * m_alignment + m_alignment - 1) / m_alignment) * m_alignment;
+	int rectHeight = ((height + 2 * m_alignment + m_alignment - 1) / m_alignment) * m_alignment;
+	if ((NULL == pixels) || (rectWidth > m_pageSize) || (rectHeight > m_pageSize) ||
+		((colorChannels != 3) && (colorChannels != 4)))
+	{
+		return(false);
+	}
+
+	int page = 0;
+	int node = -1;
+	int y = 0;
+	for (; page < (int)m_pages.size(); page++)
+	{
+		node = FindPosition(m_pages[page], rectWidth, rectHeight, y);
+		if (node >= 0)
+		{
+			break;
+		}
+	}
+	if (node < 0)
+	{
+		// a new page, with a flat skyline along its bottom
+		ATLAS_PAGE newPage;
+		SKYLINE_NODE bottom = { 0, 0, m_pageSize };
+		newPage.skyline.push_back(bottom);
+		newPage.pixels.assign((size_t)m_pageSize * m_pageSize * 4, 0);
+		m_pages.push_back(std::move(newPage));
+		page = (int)m_pages.size() - 1;
+		node = FindPosition(m_pages[page], rectWidth, rectHeight, y);
+	}
+
+	ATLAS_PAGE& atlasPage = m_pages[page];
+	int x = atlasPage.skyline[node].x;
+	PlaceRect(atlasPage, node, rectWidth, rectHeight, y);
+
+	CopyWithBorder(pixels, width, height, colorChannels, m_alignment,
+		&atlasPage.pixels[((size_t)y * m_pageSize + x) * 4], m_pageSize);
+	m_usedArea += (size_t)rectWidth * rectHeight;
+
+	rect.page = page;
+	rect.x = x + m_alignment;
+	rect.y = y + m_alignment;
+	rect.width = width;
+	rect.height = height;
+	return(true);
+}
+
+/***********************************************************
+ *  FindPosition()
+ *
+ *  This method is used to find where a rectangle sits lowest
+ *  on the skyline of a page.  A rectangle starting at a node
+ *  rests on the highest node it spans.  Ties go to the
+ *  narrower node, which leaves less wasted space under it.
+ ***********************************************************/
+int TextureAtlas::FindPosition(const ATLAS_PAGE& page, int width, int height, int& y) const
+{
+	int bestNode = -1;
+	int bestTop = m_pageSize + 1;
+	int bestWidth = m_pageSize + 1;
+
+	for (int i = 0; i < (int)page.skyline.size(); i++)
+	{
+		const SKYLINE_NODE& start = page.skyline[i];
+		if (start.x + width > m_pageSize)
+		{
+			break;
+		}
+
+		int restY = 0;
+		int spanned = 0;
+		for (int j = i; (j < (int)page.skyline.size()) && (spanned < width); j++)
+		{
+			restY = std::max(restY, page.skyline[j].y);
+			spanned += page.skyline[j].width;
+		}
+
+		int top = restY + height;
+		if ((top <= m_pageSize) &&
+			((top < bestTop) || ((top == bestTop) && (start.width < bestWidth))))
+		{
+			bestNode = i;
+			bestTop = top;
+			bestWidth = start.width;
+			y = restY;
+		}
+	}
+
+	return(bestNode);
+}
+
+/***********************************************************
+ *  PlaceRect()
+ *
+ *  This method is used to raise the skyline of a page over a
+ *  rectangle placed at a node.  The nodes it covers are cut
+ *  back or removed, and neighbours of the same height are
+ *  joined.
+ ***********************************************************/
+void TextureAtlas::PlaceRect(ATLAS_PAGE& page, int node, int width, int height, int y)
+{
+	std::vector<SKYLINE_NODE>& skyline = page.skyline;
+	SKYLINE_NODE placed = { skyline[node].x, y + height, width };
+	skyline.insert(skyline.begin() + node, placed);
+
+	// cut back the nodes under the new one
+	int right = placed.x + placed.width;
+	while ((node + 1 < (int)skyline.size()) && (skyline[node + 1].x < right))
+	{
+		SKYLINE_NODE& next = skyline[node + 1];
+		int overlap = right - next.x;
+		if (overlap >= next.width)
+		{
+			skyline.erase(skyline.begin() + node + 1);
+		}
+		else
+		{
+			next.x += overlap;
+			next.width -= overlap;
+			break;
+		}
+	}
+
+	// join the neighbours of the same height
+	for (int i = 0; i + 1 < (int)skyline.size();)
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+/***********************************************************
+ *  CopyWithBorder()
+ *
+ *  This function is used to copy an image into RGBA pixels,
+ *  surrounded by a border taken from the opposite edges of
+ *  the image, so filtering across the edge of the image
+ *  reads what GL_REPEAT would.
+ ***********************************************************/
+void TextureAtlas::CopyWithBorder(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	int colorChannels,
+	int border,
+	unsigned char* destination,
+	int destinationStride)
+{
+	for (int row = 0; row < height + 2 * border; row++)
+	{
+		int sourceRow = ((row - border) % height + height) % height;
+		const unsigned char* source = pixels + (size_t)sourceRow * width * colorChannels;
+		unsigned char* target = destination + (size_t)row * destinationStride * 4;
+		for (int column = 0; column < width + 2 * border; column++)
+		{
+			int sourceColumn = ((column - border) % width + width) % width;
+			const unsigned char* texel = source + (size_t)sourceColumn * colorChannels;
+			target[column * 4] = texel[0];
+			target[column * 4 + 1] = texel[1];
+			target[column * 4 + 2] = texel[2];
+			target[column * 4 + 3] = (colorChannels == 4) ? texel[3] : 255;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetPageCount()
+ *
+ *  This method returns the number of atlas pages.
+ ***********************************************************/
+int TextureAtlas::GetPageCount() const
+{
+	return((int)m_pages.size());
+}
+
+/***********************************************************
+ *  GetPageSize()
+ *
+ *  This method returns the width and height of the pages.
+ ***********************************************************/
+int TextureAtlas::GetPageSize() const
+{
+	return(m_pageSize);
+}
+
+/***********************************************************
+ *  GetPagePixels()
+ *
+ *  This method returns the RGBA pixels of a page.
+ ***********************************************************/
+const unsigned char* TextureAtlas::GetPagePixels(int page) const
+{
+	if ((page < 0) || (page >= (int)m_pages.size()))
+	{
+		return(NULL);
+	}
+	return(m_pages[page].pixels.data());
+}
+
+/***********************************************************
+ *  GetMipLevels()
+ *
+ *  This method returns the number of mip levels that keep
+ *  the images apart.  Every rectangle starts on a multiple of
+ *  the alignment, so down to the level where the alignment
+ *  is one texel no mip texel covers two images.
+ ***********************************************************/
+int TextureAtlas::GetMipLevels() const
+{
+	int levels = 1;
+	for (int alignment = m_alignment; alignment > 1; alignment /= 2)
+	{
+		levels++;
+	}
+	return(levels);
+}
+
+/***********************************************************
+ *  GetPageUsage()
+ *
+ *  This method returns the part of the page area covered by
+ *  the placed rectangles, from 0 to 1.
+ ***********************************************************/
+double TextureAtlas::GetPageUsage() const
+{
+	if (m_pages.empty())
+	{
+		return(0.0);
+	}
+	return((double)m_usedArea / ((double)m_pageSize * m_pageSize * m_pages.size()));
+}
+
+/***********************************************************
+ *  GetUVRect()
+ *
+ *  This method returns the offset and size of a placed image
+ *  in the texture coordinates of its page, as x, y, width
+ *  and height.
+ ***********************************************************/
+glm::vec4 TextureAtlas::GetUVRect(const ATLAS_RECT& rect) const
+{
+	float pageSize = (float)m_pageSize;
+	return(glm::vec4(rect.x / pageSize, rect.y / pageSize, rect.width / pageSize, rect.height / pageSize));
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureatlas.h
+// ============
+// texture atlas packing - places small images into shared atlas pages with
+// padding that keeps the mipmaps of neighbouring images apart
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TextureAtlas
+ *
+ *  This class packs images into square RGBA pages with a
+ *  skyline packer.  Every image is surrounded by a border of
+ *  its own texels, wrapped around as GL_REPEAT would, and its
+ *  rectangle starts on a multiple of the alignment.  The
+ *  border keeps filtering and the first few mip levels from
+ *  reading a neighbouring image, and the shader wraps the
+ *  texture coordinate inside the rectangle itself.
+ ***********************************************************/
+class TextureAtlas
+{
+public:
+	// where an image was placed - the position is of the image
+	// itself, inside its border
+	struct ATLAS_RECT
+	{
+		int page;
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	// constructor - the alignment is a power of two, and is also
+	// the width of the border
+	TextureAtlas(int pageSize, int alignment);
+
+	// pack an image with 3 or 4 color channels, adding a page
+	// when it does not fit in the ones there are - returns false
+	// when the image is too big for a page
+	bool Add(const unsigned char* pixels, int width, int height, int colorChannels, ATLAS_RECT& rect);
+
+	int GetPageCount() const;
+	int GetPageSize() const;
+	// the RGBA pixels of a page, bottom row first
+	const unsigned char* GetPagePixels(int page) const;
+	// number of mip levels that keep the images apart
+	int GetMipLevels() const;
+	// the part of the page covered by the placed images
+	double GetPageUsage() const;
+
+	// the offset and size of an image in texture coordinates
+	glm::vec4 GetUVRect(const ATLAS_RECT& rect) const;
+
+	// copy an image with its wrapped border into RGBA pixels -
+	// the destination is the bottom left of the border, and the
+	// stride is in pixels
+	static void CopyWithBorder(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int colorChannels,
+		int border,
+		unsigned char* destination,
+		int destinationStride);
+
+private:
+	// one step of the skyline - the top of the placed images
+	// from x to x + width
+	struct SKYLINE_NODE
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	struct ATLAS_PAGE
+	{
+		std::vector<SKYLINE_NODE> skyline;
+		std::vector<unsigned char> pixels;
+	};
+
+	int m_pageSize;
+	int m_alignment;
+	std::vector<ATLAS_PAGE> m_pages;
+	size_t m_usedArea;
+
+	// find the lowest spot on the skyline of a page for a
+	// rectangle, returning the node it starts at or -1
+	int FindPosition(const ATLAS_PAGE& page, int width, int height, int& y) const;
+	// raise the skyline of a page over a placed rectangle
+	void PlaceRect(ATLAS_PAGE& page, int node, int width, int height, int y);
+};
@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturereloader.cpp
+// ============
+// texture hot-reload - watches the image files of the loaded textures, decodes
+// the changed ones on a thread and uploads them over the live textures
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureReloader.h"
+#include "FrameScheduler.h"
+#include "HitchDetector.h"
+#include "TraceRecorder.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// longest time the loop blocks waiting for events in the
+	// on-demand mode, so changed files are still noticed
+	const double WATCH_IDLE_TIMEOUT_SECONDS = 0.25;
+}
+
+/***********************************************************
+ *  TextureReloader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureReloader::TextureReloader(SceneManager* pSceneManager, FrameScheduler* pFrameScheduler)
+{
+	m_pSceneManager = pSceneManager;
+	m_pFrameScheduler = pFrameScheduler;
+	m_bShutdown = false;
+	m_reloadCount = 0;
+	m_failedCount = 0;
+	m_maxDecodeMs = 0.0;
+	m_maxUploadMs = 0.0;
+}
+
+/***********************************************************
+ *  ~TextureReloader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureReloader::~TextureReloader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_decoderMutex);
+		m_bShutdown = true;
+	}
+	m_decoderReady.notify_all();
+	if (m_decoder.joinable())
+	{
+		m_decoder.join();
+	}
+
+	// free the images that were never uploaded
+	for (DECODED_FILE& decoded : m_decodedFiles)
+	{
+		if (NULL != decoded.image.pixels)
+		{
+			stbi_image_free(decoded.image.pixels);
+		}
+	}
+	m_decodedFiles.clear();
+
+	m_pSceneManager = NULL;
+	m_pFrameScheduler = NULL;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to start watching the image files of
+ *  the loaded textures and to start the decoder thread.
+ ***********************************************************/
+bool TextureReloader::Start()
+{
+	std::vector<std::string> filenames;
+	m_pSceneManager->GetTextureFiles(filenames);
+	for (const std::string& filename : filenames)
+	{
+		m_watcher.AddFile(filename);
+	}
+
+	if (NULL != m_pFrameScheduler)
+	{
+		m_pFrameScheduler->SetIdleTimeout(WATCH_IDLE_TIMEOUT_SECONDS);
+	}
+
+	m_decoder = std::thread(&TextureReloader::DecoderLoop, this);
+
+	std::cout << "INFO: watching " << filenames.size() << " texture files for changes" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  WatchFile()
+ *
+ *  This method is used to watch another image file.  Files
+ *  that are already watched are skipped by the watcher.
+ ***********************************************************/
+void TextureReloader::WatchFile(const std::string& filename)
+{
+	m_watcher.AddFile(filename);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to queue the changed files for the
+ *  decoder thread and to upload the images it has decoded.
+ *  A file written again before its decoding has started is
+ *  only decoded once.
+ ***********************************************************/
+void TextureReloader::Update()
+{
+	std::vector<std::string> changedFiles;
+	if (m_watcher.Poll(changedFiles) == true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_decoderMutex);
+			for (const std::string& filename : changedFiles)
+			{
+				if (std::find(m_requests.begin(), m_requests.end(), filename) == m_requests.end())
+				{
+					m_requests.push_back(filename);
+				}
+			}
+		}
+		m_decoderReady.notify_one();
+	}
+
+	std::vector<DECODED_FILE> decodedFiles;
+	{
+		std::lock_guard<std::mutex> lock(m_decoderMutex);
+		decodedFiles.swap(m_decodedFiles);
+	}
+	if (decodedFiles.empty())
+	{
+		return;
+	}
+
+	TRACE_SCOPE("TextureReloader::Update");
+	for (DECODED_FILE& decoded : decodedFiles)
+	{
+		// a file caught half written does not decode, and is
+		// decoded again when the write finishes
+		if (NULL == decoded.image.pixels)
+		{
+			std::cout << "Could not reload texture:" << decoded.filename << std::endl;
+			m_failedCount++;
+			continue;
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (m_pSceneManager->ReloadTextureImage(decoded.filename, decoded.image) == true)
+		{
+			m_reloadCount++;
+		}
+		double uploadMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+		m_maxUploadMs = std::max(m_maxUploadMs, uploadMs);
+		m_maxDecodeMs = std::max(m_maxDecodeMs, decoded.decodeMs);
+	}
+
+	if (NULL != m_pFrameScheduler)
+	{
+		m_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_ASSETS);
+	}
+}
+
+/***********************************************************
+ *  DecoderLoop()
+ *
+ *  This method runs on the decoder thread, decoding each
+ *  requested image file from disk and handing it back to
+ *  the main thread.
+ ***********************************************************/
+void TextureReloader::DecoderLoop()
+{
+	TraceRecorder::SetThreadName("texture reloader");
+
+	while (true)
+	{
+		std::string filename;
+		{
+			std::unique_lock<std::mutex> lock(m_decoderMutex);
+			m_decoderReady.wait(lock, [this]() { return(m_bShutdown || (false == m_requests.empty())); });
+			if (true == m_bShutdown)
+			{
+				break;
+			}
+			filename = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		DECODED_FILE decoded;
+		decoded.filename = filename;
+		{
+			TRACE_SCOPE("TextureReloader::Decode");
+			HitchActivity activity(HitchDetector::ACTIVITY_ASSET_LOAD, "TextureReloader::Decode");
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			decoded.image.pixels = stbi_load(
+				filename.c_str(),
+				&decoded.image.width,
+				&decoded.image.height,
+				&decoded.image.colorChannels,
+				0);
+			decoded.decodeMs = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_decoderMutex);
+			m_decodedFiles.push_back(decoded);
+		}
+		if (NULL != m_pFrameScheduler)
+		{
+			m_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_ASSETS);
+		}
+	}
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print how many textures were
+ *  reloaded and the longest decode and upload.
+ ***********************************************************/
+void TextureReloader::PrintReport() const
+{
+	std::cout << "TEXTURE RELOAD: reloaded:" << m_reloadCount
+		<< ", failed:" << m_failedCount
+		<< ", max decode ms:" << m_maxDecodeMs
+		<< ", max upload ms:" << m_maxUploadMs << std::endl;
+}
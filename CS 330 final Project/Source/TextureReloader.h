@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturereloader.h
+// ============
+// texture hot-reload - watches the image files of the loaded textures, decodes
+// the changed ones on a thread and uploads them over the live textures
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FileWatcher.h"
+#include "SceneManager.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FrameScheduler;
+
+/***********************************************************
+ *  TextureReloader
+ *
+ *  This class watches the image files in textures/ that the
+ *  scene textures were loaded from.  When one is written, the
+ *  file is decoded on the decoder thread, so the frames carry
+ *  on while a large image is decoded.  Once it is decoded, the
+ *  main thread uploads it between frames - in place over the
+ *  texture when the image has kept its size and channels, or
+ *  into a new texture put in the same slot when it has not.
+ *  The images are read from disk even when an asset pack is
+ *  mounted, since the pack holds the image as it was packed.
+ ***********************************************************/
+class TextureReloader
+{
+public:
+	// constructor
+	TextureReloader(SceneManager* pSceneManager, FrameScheduler* pFrameScheduler);
+	// destructor
+	~TextureReloader();
+
+	// start watching the image files of the loaded textures and
+	// start the decoder thread
+	bool Start();
+
+	// watch another image file, such as one named by a scene
+	// description loaded later
+	void WatchFile(const std::string& filename);
+
+	// hand the changed files to the decoder thread and upload
+	// the decoded images - call once per loop iteration on the
+	// thread that owns the OpenGL context
+	void Update();
+
+	// print the reload totals
+	void PrintReport() const;
+
+private:
+	// an image file decoded by the decoder thread, with no pixels
+	// when it could not be decoded
+	struct DECODED_FILE
+	{
+		std::string filename;
+		SceneManager::DECODED_IMAGE image;
+		double decodeMs;
+	};
+
+	SceneManager* m_pSceneManager;
+	FrameScheduler* m_pFrameScheduler;
+	FileWatcher m_watcher;
+
+	// the decoder thread and its queues
+	std::thread m_decoder;
+	mutable std::mutex m_decoderMutex;
+	std::condition_variable m_decoderReady;
+	std::deque<std::string> m_requests;
+	std::vector<DECODED_FILE> m_decodedFiles;
+	bool m_bShutdown;
+
+	// reload totals
+	int m_reloadCount;
+	int m_failedCount;
+	double m_maxDecodeMs;
+	double m_maxUploadMs;
+
+	// decode the requested files until shut down
+	void DecoderLoop();
+};
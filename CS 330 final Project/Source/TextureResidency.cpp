@@ -0,0 +1,682 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.cpp
+// ============
+// feedback driven texture residency - a small render of the scene records the
+// mip level every texture needs, and the levels nobody needs are evicted
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureResidency.h"
+#include "AssetManager.h"
+#include "AssetPack.h"
+#include "TraceRecorder.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the feedback target is this many times smaller than the
+	// window on each side
+	const int FEEDBACK_DOWNSCALE = 8;
+	// frames between feedback passes
+	const int FEEDBACK_INTERVAL = 8;
+	// number of texture slots the feedback shader knows about -
+	// this must match TOTAL_TEXTURE_SLOTS in the feedback shader
+	const int TOTAL_TEXTURE_SLOTS = 16;
+	// the levels at and below this size are always kept
+	const int MIN_RESIDENT_SIZE = 64;
+	// most bytes of a level being put back uploaded in one frame
+	const size_t UPLOAD_BYTES_PER_FRAME = 1024 * 1024;
+
+	// the uniform names are built once, so setting them does not
+	// allocate
+	const std::string g_TextureSizeNames[TOTAL_TEXTURE_SLOTS] =
+	{
+		"textureSizes[0]", "textureSizes[1]", "textureSizes[2]", "textureSizes[3]",
+		"textureSizes[4]", "textureSizes[5]", "textureSizes[6]", "textureSizes[7]",
+		"textureSizes[8]", "textureSizes[9]", "textureSizes[10]", "textureSizes[11]",
+		"textureSizes[12]", "textureSizes[13]", "textureSizes[14]", "textureSizes[15]"
+	};
+
+	const double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+}
+
+/***********************************************************
+ *  TextureResidency()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureResidency::TextureResidency(SceneManager* pSceneManager, ShaderManager* pSceneShaderManager, size_t budgetBytes)
+{
+	m_pSceneManager = pSceneManager;
+	m_pSceneShaderManager = pSceneShaderManager;
+	m_pFeedbackShaderManager = NULL;
+	m_budgetBytes = budgetBytes;
+	m_bDecoded = false;
+	m_bStarted = false;
+	m_framebuffer = 0;
+	m_depthBuffer = 0;
+	m_feedbackWidth = 0;
+	m_feedbackHeight = 0;
+	m_readbackFence = NULL;
+	m_passCount = 0;
+	m_passLevels.assign(TOTAL_TEXTURE_SLOTS, INT_MAX);
+	m_pendingSlot = -1;
+	m_pendingLevel = 0;
+	m_pendingRows = 0;
+	m_residentBytes = 0;
+	m_peakResidentBytes = 0;
+	m_fullChainBytes = 0;
+	m_levelChanges = 0;
+}
+
+/***********************************************************
+ *  ~TextureResidency()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureResidency::~TextureResidency()
+{
+	if (m_decoder.joinable())
+	{
+		m_decoder.join();
+	}
+
+	if (NULL != m_readbackFence)
+	{
+		glDeleteSync((GLsync)m_readbackFence);
+		m_readbackFence = NULL;
+	}
+	if (0 != m_framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (0 != m_depthBuffer)
+	{
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_depthBuffer = 0;
+	}
+
+	delete m_pFeedbackShaderManager;
+	m_pFeedbackShaderManager = NULL;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to build the feedback shader, which
+ *  is the scene vertex shader with the feedback fragment
+ *  shader, and to start decoding the copies of the scene
+ *  textures.
+ ***********************************************************/
+bool TextureResidency::Initialize(const char* vertexShaderFilename, const char* feedbackShaderFilename)
+{
+	// the kept levels are copied between textures on the GPU,
+	// which needs OpenGL 4.3
+	GLint majorVersion = 0;
+	GLint minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+	if ((majorVersion < 4) || ((majorVersion == 4) && (minorVersion < 3)))
+	{
+		std::cout << "ERROR: the texture residency needs OpenGL 4.3" << std::endl;
+		return(false);
+	}
+
+	m_pFeedbackShaderManager = new ShaderManager();
+	if (0 == m_pFeedbackShaderManager->LoadShaders(vertexShaderFilename, feedbackShaderFilename))
+	{
+		std::cout << "ERROR: could not load the texture feedback shader" << std::endl;
+		return(false);
+	}
+	m_pSceneShaderManager->use();
+
+	// the file names are read here, the decoding thread only
+	// touches its own copies
+	for (int i = 0; i < m_pSceneManager->GetSceneTextureCount(); i++)
+	{
+		RESIDENT_TEXTURE texture;
+		texture.tag = m_pSceneManager->GetSceneTextureTag(i);
+		texture.filename = m_pSceneManager->GetSceneTextureFile(i);
+		texture.slot = -1;
+		texture.textureID = 0;
+		texture.width = 0;
+		texture.height = 0;
+		texture.colorChannels = 0;
+		texture.residentLevel = 0;
+		texture.requiredLevel = 0;
+		texture.targetLevel = 0;
+		texture.tailLevel = 0;
+		texture.lastSeenPass = -1;
+		m_textures.push_back(texture);
+	}
+	m_decoder = std::thread(&TextureResidency::DecodeTextures, this);
+
+	std::cout << "INFO: keeping the sampled texture levels within "
+		<< (m_budgetBytes / BYTES_PER_MEGABYTE) << " MB" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  DecodeTextures()
+ *
+ *  This method is the work of the decoding thread - it
+ *  decodes every scene texture and builds its mip chain.
+ *  The levels that can be evicted are kept so they can be
+ *  put back, and the tail levels, which always stay in the
+ *  slot, are freed.
+ ***********************************************************/
+void TextureResidency::DecodeTextures()
+{
+	TraceRecorder::SetThreadName("texture residency");
+	TRACE_SCOPE("TextureResidency::DecodeTextures");
+
+	for (RESIDENT_TEXTURE& texture : m_textures)
+	{
+		unsigned char* pixels = AssetPack::LoadImagePixels(texture.filename.c_str(),
+			&texture.width, &texture.height, &texture.colorChannels, 0);
+		if (NULL == pixels)
+		{
+			continue;
+		}
+		if ((texture.colorChannels == 3) || (texture.colorChannels == 4))
+		{
+			BuildMipLevels(pixels, texture.width, texture.height, texture.colorChannels, texture.mipLevels);
+		}
+		AssetPack::FreeImagePixels(pixels);
+
+		int lastLevel = (int)texture.mipLevels.size() - 1;
+		while ((texture.tailLevel < lastLevel) &&
+			(std::max(texture.width >> texture.tailLevel, texture.height >> texture.tailLevel) > MIN_RESIDENT_SIZE))
+		{
+			texture.tailLevel++;
+		}
+		for (int level = texture.tailLevel; level <= lastLevel; level++)
+		{
+			std::vector<unsigned char>().swap(texture.mipLevels[level]);
+		}
+	}
+
+	m_bDecoded = true;
+}
+
+/***********************************************************
+ *  StartManaging()
+ *
+ *  This method is used to match the decoded copies with the
+ *  texture slots that hold them.  The slots start out with
+ *  every level resident.
+ ***********************************************************/
+void TextureResidency::StartManaging()
+{
+	m_decoder.join();
+	m_bStarted = true;
+
+	for (size_t i = 0; i < m_textures.size();)
+	{
+		RESIDENT_TEXTURE& texture = m_textures[i];
+		texture.slot = m_pSceneManager->GetTextureSlot(texture.tag);
+		texture.textureID = m_pSceneManager->GetSlotTexture(texture.slot);
+		if ((true == texture.mipLevels.empty()) || (texture.slot < 0) ||
+			(texture.slot >= TOTAL_TEXTURE_SLOTS) || (0 == texture.textureID))
+		{
+			m_textures[i] = std::move(m_textures.back());
+			m_textures.pop_back();
+			continue;
+		}
+
+		m_fullChainBytes += GetChainBytes(texture, 0);
+		m_residentBytes += GetChainBytes(texture, 0);
+		i++;
+	}
+	m_peakResidentBytes = m_residentBytes;
+}
+
+/***********************************************************
+ *  ResizeFeedbackTarget()
+ *
+ *  This method is used to make the feedback target and its
+ *  read back buffer the right size for the window.
+ ***********************************************************/
+bool TextureResidency::ResizeFeedbackTarget(int windowWidth, int windowHeight)
+{
+	int width = std::max(1, windowWidth / FEEDBACK_DOWNSCALE);
+	int height = std::max(1, windowHeight / FEEDBACK_DOWNSCALE);
+	if ((0 != m_framebuffer) && (width == m_feedbackWidth) && (height == m_feedbackHeight))
+	{
+		return(true);
+	}
+
+	if (0 == m_framebuffer)
+	{
+		glGenFramebuffers(1, &m_framebuffer);
+		glGenRenderbuffers(1, &m_depthBuffer);
+	}
+	m_feedbackWidth = width;
+	m_feedbackHeight = height;
+
+	glActiveTexture(GL_TEXTURE0 + SceneManager::SPARE_TEXTURE_UNIT);
+	m_feedbackTexture.Create("TextureResidency feedback", GPU_RESOURCE_SITE);
+	glBindTexture(GL_TEXTURE_2D, m_feedbackTexture.Get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	m_feedbackTexture.SetByteSize(GpuResourceTracker::GetTextureBytes(width, height, 4, false));
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_feedbackTexture.Get(), 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	size_t readbackBytes = (size_t)width * height * 4;
+	m_readbackBuffer.Create("TextureResidency readback", GPU_RESOURCE_SITE);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbackBuffer.Get());
+	glBufferData(GL_PIXEL_PACK_BUFFER, readbackBytes, NULL, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_readbackBuffer.SetByteSize(readbackBytes);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: the texture feedback target is not complete" << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  RenderFeedback()
+ *
+ *  This method is used to draw the scene into the feedback
+ *  target with the feedback shader, every few frames, and to
+ *  start reading it back into the pixel buffer.  The read
+ *  back is collected by Update() once its fence signals, so
+ *  the frame never waits for it.
+ ***********************************************************/
+void TextureResidency::RenderFeedback(int frameIndex, const glm::mat4& view, const glm::mat4& projection)
+{
+	if (false == m_bStarted)
+	{
+		if (false == m_bDecoded)
+		{
+			return;
+		}
+		StartManaging();
+	}
+	if ((NULL != m_readbackFence) || (0 != (frameIndex % FEEDBACK_INTERVAL)) || (true == m_textures.empty()))
+	{
+		return;
+	}
+
+	TRACE_SCOPE("TextureResidency::RenderFeedback");
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (ResizeFeedbackTarget(viewport[2], viewport[3]) == false)
+	{
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_feedbackWidth, m_feedbackHeight);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_BLEND);
+
+	m_pFeedbackShaderManager->use();
+	m_pFeedbackShaderManager->setMat4Value("view", view);
+	m_pFeedbackShaderManager->setMat4Value("projection", projection);
+	m_pFeedbackShaderManager->setFloatValue("feedbackLodBias", std::log2((float)FEEDBACK_DOWNSCALE));
+	for (const RESIDENT_TEXTURE& texture : m_textures)
+	{
+		m_pFeedbackShaderManager->setVec2Value(g_TextureSizeNames[texture.slot],
+			glm::vec2((float)texture.width, (float)texture.height));
+	}
+
+	// the scene draws itself with the feedback shader
+	ShaderManager* pSceneShaderManager = m_pSceneManager->SetShaderManager(m_pFeedbackShaderManager);
+	m_pSceneManager->RenderScene();
+	m_pSceneManager->SetShaderManager(pSceneShaderManager);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbackBuffer.Get());
+	glReadPixels(0, 0, m_feedbackWidth, m_feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	// put back the state of the scene pass
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glEnable(GL_BLEND);
+	m_pSceneShaderManager->use();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to collect a feedback pass once its
+ *  read back has finished, and to move one texture a step
+ *  toward its target level - dropping levels in one go, but
+ *  adding them back a level at a time, with the rows of each
+ *  level uploaded over as many frames as they need.
+ ***********************************************************/
+void TextureResidency::Update()
+{
+	if (false == m_bStarted)
+	{
+		return;
+	}
+
+	TRACE_SCOPE("TextureResidency::Update");
+
+	if (NULL != m_readbackFence)
+	{
+		GLenum status = glClientWaitSync((GLsync)m_readbackFence, 0, 0);
+		if ((status == GL_ALREADY_SIGNALED) || (status == GL_CONDITION_SATISFIED))
+		{
+			glDeleteSync((GLsync)m_readbackFence);
+			m_readbackFence = NULL;
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbackBuffer.Get());
+			const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+				(size_t)m_feedbackWidth * m_feedbackHeight * 4, GL_MAP_READ_BIT);
+			if (NULL != pixels)
+			{
+				ReadFeedback(pixels);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				ChooseTargetLevels();
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+	}
+
+	// the level being put back carries on where it stopped,
+	// unless its slot has been given another texture
+	if (0 != m_pendingTexture.Get())
+	{
+		for (RESIDENT_TEXTURE& texture : m_textures)
+		{
+			if ((texture.slot == m_pendingSlot) &&
+				(m_pSceneManager->GetSlotTexture(texture.slot) == texture.textureID))
+			{
+				UploadPendingRows(texture);
+				return;
+			}
+		}
+		m_pendingTexture.Reset();
+		m_pendingSlot = -1;
+	}
+
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		RESIDENT_TEXTURE& texture = m_textures[i];
+
+		// a slot given another texture, such as by a scene reload,
+		// is no longer managed
+		if (m_pSceneManager->GetSlotTexture(texture.slot) != texture.textureID)
+		{
+			m_residentBytes -= GetChainBytes(texture, texture.residentLevel);
+			m_fullChainBytes -= GetChainBytes(texture, 0);
+			m_textures[i] = std::move(m_textures.back());
+			m_textures.pop_back();
+			return;
+		}
+
+		if (texture.targetLevel > texture.residentLevel)
+		{
+			RebuildTexture(texture, texture.targetLevel);
+			return;
+		}
+		if (texture.targetLevel < texture.residentLevel)
+		{
+			RebuildTexture(texture, texture.residentLevel - 1);
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadFeedback()
+ *
+ *  This method is used to find the finest level each texture
+ *  slot was sampled at in the read back feedback pixels.
+ ***********************************************************/
+void TextureResidency::ReadFeedback(const unsigned char* pixels)
+{
+	TRACE_SCOPE("TextureResidency::ReadFeedback");
+
+	std::fill(m_passLevels.begin(), m_passLevels.end(), INT_MAX);
+	int pixelCount = m_feedbackWidth * m_feedbackHeight;
+	for (int i = 0; i < pixelCount; i++)
+	{
+		int slot = (int)pixels[i * 4] - 1;
+		if ((slot >= 0) && (slot < TOTAL_TEXTURE_SLOTS))
+		{
+			m_passLevels[slot] = std::min(m_passLevels[slot], (int)pixels[i * 4 + 1]);
+		}
+	}
+
+	m_passCount++;
+	for (RESIDENT_TEXTURE& texture : m_textures)
+	{
+		if (m_passLevels[texture.slot] != INT_MAX)
+		{
+			texture.requiredLevel = std::min(m_passLevels[texture.slot], (int)texture.mipLevels.size() - 1);
+			texture.lastSeenPass = m_passCount;
+		}
+	}
+}
+
+/***********************************************************
+ *  ChooseTargetLevels()
+ *
+ *  This method is used to choose the finest level to keep
+ *  for every texture.  Textures seen in the last pass get
+ *  the level they need, and everything else keeps what it
+ *  has.  While that is over the budget, the least recently
+ *  seen textures give up their top levels first - the levels
+ *  no pass needs, down to the small tail levels, before any
+ *  levels that are needed.
+ ***********************************************************/
+void TextureResidency::ChooseTargetLevels()
+{
+	size_t totalBytes = 0;
+	for (RESIDENT_TEXTURE& texture : m_textures)
+	{
+		if (texture.lastSeenPass == m_passCount)
+		{
+			texture.targetLevel = std::min(texture.requiredLevel, texture.residentLevel);
+		}
+		else
+		{
+			texture.targetLevel = texture.residentLevel;
+		}
+		totalBytes += GetChainBytes(texture, texture.targetLevel);
+	}
+
+	// first the unneeded levels, then the needed ones
+	for (int phase = 0; phase < 2; phase++)
+	{
+		while (totalBytes > m_budgetBytes)
+		{
+			RESIDENT_TEXTURE* pOldest = NULL;
+			for (RESIDENT_TEXTURE& texture : m_textures)
+			{
+				int floorLevel = texture.tailLevel;
+				if ((0 == phase) && (texture.lastSeenPass == m_passCount))
+				{
+					floorLevel = std::min(texture.requiredLevel, texture.tailLevel);
+				}
+				if ((texture.targetLevel < floorLevel) &&
+					((NULL == pOldest) || (texture.lastSeenPass < pOldest->lastSeenPass)))
+				{
+					pOldest = &texture;
+				}
+			}
+			if (NULL == pOldest)
+			{
+				break;
+			}
+
+			totalBytes -= GetChainBytes(*pOldest, pOldest->targetLevel);
+			pOldest->targetLevel++;
+			totalBytes += GetChainBytes(*pOldest, pOldest->targetLevel);
+		}
+	}
+}
+
+/***********************************************************
+ *  RebuildTexture()
+ *
+ *  This method is used to replace the texture in a slot with
+ *  one holding the chain from the passed in level down.  The
+ *  levels the slot already holds are copied on the GPU, so a
+ *  smaller chain is swapped in straight away.  A finer level
+ *  has to be uploaded, and is put back over the next frames
+ *  by UploadPendingRows() before the texture is swapped in.
+ ***********************************************************/
+bool TextureResidency::RebuildTexture(RESIDENT_TEXTURE& texture, int level)
+{
+	TRACE_SCOPE("TextureResidency::RebuildTexture");
+
+	GLint internalFormat = (texture.colorChannels == 4) ? GL_RGBA8 : GL_RGB8;
+	int lastLevel = (int)texture.mipLevels.size() - 1;
+
+	GLTextureHandle rebuilt;
+	rebuilt.Create(texture.tag, GPU_RESOURCE_SITE);
+	glActiveTexture(GL_TEXTURE0 + SceneManager::SPARE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, rebuilt.Get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel - level);
+	glTexStorage2D(GL_TEXTURE_2D, lastLevel - level + 1, internalFormat,
+		std::max(1, texture.width >> level), std::max(1, texture.height >> level));
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	rebuilt.SetByteSize(GetChainBytes(texture, level));
+
+	// the levels the slot already holds are copied without
+	// leaving the GPU
+	for (int i = std::max(level, texture.residentLevel); i <= lastLevel; i++)
+	{
+		glCopyImageSubData(
+			texture.textureID, GL_TEXTURE_2D, i - texture.residentLevel, 0, 0, 0,
+			rebuilt.Get(), GL_TEXTURE_2D, i - level, 0, 0, 0,
+			std::max(1, texture.width >> i), std::max(1, texture.height >> i), 1);
+	}
+
+	if (level >= texture.residentLevel)
+	{
+		return(SwapInRebuilt(texture, rebuilt, level));
+	}
+
+	m_pendingTexture = std::move(rebuilt);
+	m_pendingSlot = texture.slot;
+	m_pendingLevel = level;
+	m_pendingRows = 0;
+	UploadPendingRows(texture);
+	return(true);
+}
+
+/***********************************************************
+ *  UploadPendingRows()
+ *
+ *  This method is used to upload the next band of rows of
+ *  the level being put back, no more than a frame's worth of
+ *  bytes, and to swap the texture into the slot once every
+ *  row is uploaded.
+ ***********************************************************/
+void TextureResidency::UploadPendingRows(RESIDENT_TEXTURE& texture)
+{
+	TRACE_SCOPE("TextureResidency::UploadPendingRows");
+
+	GLenum format = (texture.colorChannels == 4) ? GL_RGBA : GL_RGB;
+	int width = std::max(1, texture.width >> m_pendingLevel);
+	int height = std::max(1, texture.height >> m_pendingLevel);
+	size_t rowBytes = (size_t)width * texture.colorChannels;
+	int rows = std::min(height - m_pendingRows, std::max(1, (int)(UPLOAD_BYTES_PER_FRAME / rowBytes)));
+
+	glActiveTexture(GL_TEXTURE0 + SceneManager::SPARE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_pendingTexture.Get());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_pendingRows, width, rows,
+		format, GL_UNSIGNED_BYTE, texture.mipLevels[m_pendingLevel].data() + (size_t)m_pendingRows * rowBytes);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_pendingRows += rows;
+	if (m_pendingRows >= height)
+	{
+		SwapInRebuilt(texture, m_pendingTexture, m_pendingLevel);
+		m_pendingTexture.Reset();
+		m_pendingSlot = -1;
+	}
+}
+
+/***********************************************************
+ *  SwapInRebuilt()
+ *
+ *  This method is used to put a rebuilt texture into the
+ *  slot of a managed texture and count its new level.
+ ***********************************************************/
+bool TextureResidency::SwapInRebuilt(RESIDENT_TEXTURE& texture, GLTextureHandle& rebuilt, int level)
+{
+	uint32_t textureID = rebuilt.Get();
+	if (m_pSceneManager->SwapInTexture(texture.slot, rebuilt) == false)
+	{
+		return(false);
+	}
+
+	m_residentBytes -= GetChainBytes(texture, texture.residentLevel);
+	m_residentBytes += GetChainBytes(texture, level);
+	m_peakResidentBytes = std::max(m_peakResidentBytes, m_residentBytes);
+	texture.textureID = textureID;
+	texture.residentLevel = level;
+	m_levelChanges++;
+	return(true);
+}
+
+/***********************************************************
+ *  GetChainBytes()
+ *
+ *  This method returns the video memory of a texture whose
+ *  finest level is the passed in one.
+ ***********************************************************/
+size_t TextureResidency::GetChainBytes(const RESIDENT_TEXTURE& texture, int level) const
+{
+	return(GpuResourceTracker::GetTextureBytes(
+		std::max(1, texture.width >> level), std::max(1, texture.height >> level), texture.colorChannels, true));
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print the texture memory kept
+ *  against the memory of the whole chains.
+ ***********************************************************/
+void TextureResidency::PrintReport() const
+{
+	std::cout << "RESIDENCY: textures:" << m_textures.size()
+		<< ", feedback passes:" << m_passCount
+		<< ", level changes:" << m_levelChanges
+		<< ", resident MB:" << (m_residentBytes / BYTES_PER_MEGABYTE)
+		<< ", peak MB:" << (m_peakResidentBytes / BYTES_PER_MEGABYTE)
+		<< ", full chains MB:" << (m_fullChainBytes / BYTES_PER_MEGABYTE)
+		<< ", budget MB:" << (m_budgetBytes / BYTES_PER_MEGABYTE) << std::endl;
+}
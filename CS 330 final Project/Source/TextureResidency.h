@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.h
+// ============
+// feedback driven texture residency - a small render of the scene records the
+// mip level every texture needs, and the levels nobody needs are evicted
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "GpuResourceTracker.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureResidency
+ *
+ *  This class keeps only the mip levels of the scene
+ *  textures that are actually sampled in video memory.
+ *  Every few frames, the scene is drawn into a small target
+ *  with a feedback shader that writes the texture slot and
+ *  the mip level each pixel needs.  The target is read back
+ *  through a pixel buffer without stalling, and the finest
+ *  level seen for each texture becomes its required level.
+ *  A texture is rebuilt with a smaller chain when its top
+ *  levels are not needed, and rebuilt finer, a level at a
+ *  time, when they are needed again.  The levels the slot
+ *  already holds are copied on the GPU, so only a level
+ *  being put back is uploaded - a band of rows a frame,
+ *  from the copy of the levels that can be evicted kept in
+ *  system memory.  When the textures do not fit the budget,
+ *  the least recently seen ones lose their levels first.
+ ***********************************************************/
+class TextureResidency
+{
+public:
+	// constructor
+	TextureResidency(SceneManager* pSceneManager, ShaderManager* pSceneShaderManager, size_t budgetBytes);
+	// destructor
+	~TextureResidency();
+
+	// load the feedback shader and start decoding the copies of
+	// the scene textures on a thread
+	bool Initialize(const char* vertexShaderFilename, const char* feedbackShaderFilename);
+
+	// draw the feedback pass when one is due - call after the
+	// view is prepared and before the scene is drawn
+	void RenderFeedback(int frameIndex, const glm::mat4& view, const glm::mat4& projection);
+
+	// read back a finished feedback pass and move the textures
+	// toward the levels they need
+	void Update();
+
+	// print the residency totals
+	void PrintReport() const;
+
+private:
+	// a scene texture whose levels are managed
+	struct RESIDENT_TEXTURE
+	{
+		std::string tag;
+		std::string filename;
+		int slot;
+		// the texture last put into the slot
+		uint32_t textureID;
+		int width;
+		int height;
+		int colorChannels;
+		// one entry per level of the chain - the levels finer than
+		// the tail are kept in system memory to put them back, and
+		// the tail levels, which are never evicted, are left empty
+		std::vector<std::vector<unsigned char> > mipLevels;
+		// finest level in video memory, the finest level the last
+		// feedback asked for, and the level to move toward
+		int residentLevel;
+		int requiredLevel;
+		int targetLevel;
+		// smallest level ever kept
+		int tailLevel;
+		// the feedback pass the texture was last seen in
+		int lastSeenPass;
+	};
+
+	SceneManager* m_pSceneManager;
+	ShaderManager* m_pSceneShaderManager;
+	// the scene shader program with the feedback fragment shader
+	ShaderManager* m_pFeedbackShaderManager;
+	size_t m_budgetBytes;
+
+	// the decoded scene textures, filled in by the decoding thread
+	std::vector<RESIDENT_TEXTURE> m_textures;
+	std::thread m_decoder;
+	std::atomic<bool> m_bDecoded;
+	bool m_bStarted;
+
+	// the feedback target and its read back
+	uint32_t m_framebuffer;
+	uint32_t m_depthBuffer;
+	GLTextureHandle m_feedbackTexture;
+	GLBufferHandle m_readbackBuffer;
+	int m_feedbackWidth;
+	int m_feedbackHeight;
+	void* m_readbackFence;
+	int m_passCount;
+	std::vector<int> m_passLevels;
+
+	// a finer level being put back - the new texture is swapped
+	// into the slot once all of the rows have been uploaded
+	GLTextureHandle m_pendingTexture;
+	int m_pendingSlot;
+	int m_pendingLevel;
+	int m_pendingRows;
+
+	// residency totals
+	size_t m_residentBytes;
+	size_t m_peakResidentBytes;
+	size_t m_fullChainBytes;
+	int m_levelChanges;
+
+	// the work of the decoding thread
+	void DecodeTextures();
+	// take over the slots once the copies are decoded
+	void StartManaging();
+	// make the feedback target match the window
+	bool ResizeFeedbackTarget(int windowWidth, int windowHeight);
+	// turn the read back pixels into required levels
+	void ReadFeedback(const unsigned char* pixels);
+	// choose the level of every texture within the budget
+	void ChooseTargetLevels();
+	// rebuild one texture with its chain from the passed in level
+	bool RebuildTexture(RESIDENT_TEXTURE& texture, int level);
+	// upload the next rows of the level being put back
+	void UploadPendingRows(RESIDENT_TEXTURE& texture);
+	// put a rebuilt texture into the slot of a texture
+	bool SwapInRebuilt(RESIDENT_TEXTURE& texture, GLTextureHandle& rebuilt, int level);
+	// bytes of a texture whose finest level is the passed in one
+	size_t GetChainBytes(const RESIDENT_TEXTURE& texture, int level) const;
+};
@@ -0,0 +1,323 @@
+///////////////////////////////////////////////////////////////////////////////
+// tracerecorder.cpp
+// ============
+// lightweight zone tracing - records named, timed scopes on every thread and
+// exports them as a Chrome trace-event JSON file (chrome://tracing, Perfetto)
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TraceRecorder.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	// number of zones each thread can record - zones beyond this
+	// are counted and dropped rather than growing the buffer
+	const uint32_t ZONES_PER_THREAD = 1 << 16;
+
+	struct TRACE_ZONE
+	{
+		const char* name;
+		uint64_t startNs;
+		uint64_t endNs;
+	};
+
+	// the zones recorded by one thread - only the owning thread
+	// writes to it, and the exporter reads the zones it has
+	// published.  A buffer lives until the program exits, so a
+	// thread still tracing when recording stops never writes
+	// into freed memory.
+	struct THREAD_BUFFER
+	{
+		TRACE_ZONE zones[ZONES_PER_THREAD];
+		std::atomic<uint32_t> zoneCount;
+		std::atomic<uint32_t> droppedZones;
+		int threadID;
+		std::string threadName;
+	};
+
+	// all of the thread buffers, guarded by the registry mutex -
+	// the mutex is only taken once per thread, on its first zone
+	std::mutex g_RegistryMutex;
+	std::vector<THREAD_BUFFER*> g_ThreadBuffers;
+
+	// frees the thread buffers when the program exits, after
+	// every thread that wrote to them has finished
+	struct THREAD_BUFFER_CLEANUP
+	{
+		~THREAD_BUFFER_CLEANUP()
+		{
+			for (THREAD_BUFFER* pBuffer : g_ThreadBuffers)
+			{
+				delete pBuffer;
+			}
+			g_ThreadBuffers.clear();
+		}
+	};
+	THREAD_BUFFER_CLEANUP g_ThreadBufferCleanup;
+	// names built at runtime - a deque never moves its elements
+	std::deque<std::string> g_InternedNames;
+
+	// the buffer of the calling thread
+	thread_local THREAD_BUFFER* t_pThreadBuffer = nullptr;
+
+	// true between Start() and Stop()
+	std::atomic<bool> g_bRecording(false);
+	// true while zones are being captured
+	std::atomic<bool> g_bCapturing(false);
+	// the range of frames to capture, -1 meaning no limit
+	int g_FirstFrame = -1;
+	int g_LastFrame = -1;
+	// the file the trace is written to
+	std::string g_TraceFilename;
+	// the time all zone times are measured from
+	std::chrono::steady_clock::time_point g_Epoch = std::chrono::steady_clock::now();
+
+	/***********************************************************
+	 *  GetThreadBuffer()
+	 *
+	 *  This function returns the buffer of the calling thread,
+	 *  creating and registering it on first use.
+	 ***********************************************************/
+	THREAD_BUFFER* GetThreadBuffer()
+	{
+		if (nullptr == t_pThreadBuffer)
+		{
+			THREAD_BUFFER* pBuffer = new THREAD_BUFFER();
+			pBuffer->zoneCount = 0;
+			pBuffer->droppedZones = 0;
+
+			std::lock_guard<std::mutex> lock(g_RegistryMutex);
+			pBuffer->threadID = (int)g_ThreadBuffers.size() + 1;
+			pBuffer->threadName = "thread " + std::to_string(pBuffer->threadID);
+			g_ThreadBuffers.push_back(pBuffer);
+			t_pThreadBuffer = pBuffer;
+		}
+
+		return(t_pThreadBuffer);
+	}
+
+	/***********************************************************
+	 *  WriteJSONString()
+	 *
+	 *  This function writes a quoted and escaped JSON string.
+	 ***********************************************************/
+	void WriteJSONString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* p = text; *p != '\0'; p++)
+		{
+			if ((*p == '"') || (*p == '\\'))
+			{
+				stream << '\\' << *p;
+			}
+			else if ((unsigned char)*p < 0x20)
+			{
+				stream << ' ';
+			}
+			else
+			{
+				stream << *p;
+			}
+		}
+		stream << '"';
+	}
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to start recording.  Zones are
+ *  captured from now until the first BeginFrame() call, and
+ *  then only for the frames within the passed in range.
+ ***********************************************************/
+void TraceRecorder::Start(const char* filename, int firstFrame, int lastFrame)
+{
+	g_TraceFilename = filename;
+	g_FirstFrame = firstFrame;
+	g_LastFrame = lastFrame;
+	g_Epoch = std::chrono::steady_clock::now();
+	g_bRecording = true;
+	g_bCapturing = true;
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used to stop recording and write all of
+ *  the recorded zones to the trace file.  Threads can still
+ *  be tracing - a zone they finish while the file is being
+ *  written is left out, and the buffers are kept, so they
+ *  can never write into freed memory.
+ ***********************************************************/
+bool TraceRecorder::Stop()
+{
+	if (false == g_bRecording)
+	{
+		return(false);
+	}
+	g_bCapturing = false;
+	g_bRecording = false;
+
+	std::ofstream file(g_TraceFilename.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << "Could not write trace file:" << g_TraceFilename << std::endl;
+		return(false);
+	}
+
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	size_t totalZones = 0;
+	size_t droppedZones = 0;
+	bool bFirst = true;
+
+	file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	file << std::fixed << std::setprecision(3);
+	for (THREAD_BUFFER* pBuffer : g_ThreadBuffers)
+	{
+		// name the thread in the timeline
+		if (!bFirst)
+		{
+			file << ",\n";
+		}
+		bFirst = false;
+		file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << pBuffer->threadID << ",\"args\":{\"name\":";
+		WriteJSONString(file, pBuffer->threadName.c_str());
+		file << "}}";
+
+		uint32_t zoneCount = pBuffer->zoneCount.load(std::memory_order_acquire);
+		for (uint32_t i = 0; i < zoneCount; i++)
+		{
+			const TRACE_ZONE& zone = pBuffer->zones[i];
+			// complete events, with the times in microseconds
+			file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << pBuffer->threadID << ",\"name\":";
+			WriteJSONString(file, zone.name);
+			file << ",\"ts\":" << (zone.startNs / 1000.0)
+				<< ",\"dur\":" << ((zone.endNs - zone.startNs) / 1000.0) << "}";
+		}
+
+		totalZones += zoneCount;
+		droppedZones += pBuffer->droppedZones.load(std::memory_order_relaxed);
+	}
+	file << "\n]}\n";
+
+	std::cout << "INFO: wrote " << totalZones << " trace zones to " << g_TraceFilename;
+	if (droppedZones > 0)
+	{
+		std::cout << " (" << droppedZones << " dropped, buffers full)";
+	}
+	std::cout << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to tell the recorder that a new frame
+ *  is starting, so capturing follows the frame range.
+ ***********************************************************/
+void TraceRecorder::BeginFrame(int frameIndex)
+{
+	if (false == g_bRecording)
+	{
+		return;
+	}
+
+	bool bCapture =
+		((g_FirstFrame < 0) || (frameIndex >= g_FirstFrame)) &&
+		((g_LastFrame < 0) || (frameIndex <= g_LastFrame));
+	g_bCapturing.store(bCapture, std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  IsCapturing()
+ *
+ *  This method returns whether zones are being captured.
+ ***********************************************************/
+bool TraceRecorder::IsCapturing()
+{
+	return(g_bCapturing.load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  SetThreadName()
+ *
+ *  This method is used to name the calling thread in the
+ *  exported timeline.
+ ***********************************************************/
+void TraceRecorder::SetThreadName(const char* name)
+{
+	if (false == g_bRecording)
+	{
+		return;
+	}
+
+	THREAD_BUFFER* pBuffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	pBuffer->threadName = name;
+}
+
+/***********************************************************
+ *  InternName()
+ *
+ *  This method is used to keep a copy of a name built at
+ *  runtime so it stays valid as a zone name.
+ ***********************************************************/
+const char* TraceRecorder::InternName(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	g_InternedNames.push_back(name);
+	return(g_InternedNames.back().c_str());
+}
+
+/***********************************************************
+ *  NowNs()
+ *
+ *  This method returns the nanoseconds since recording
+ *  started.  It never returns zero, which marks a zone that
+ *  started while capturing was off.
+ ***********************************************************/
+uint64_t TraceRecorder::NowNs()
+{
+	return((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - g_Epoch).count() + 1);
+}
+
+/***********************************************************
+ *  WriteZone()
+ *
+ *  This method is used to record a finished zone into the
+ *  buffer of the calling thread.  Only this thread writes to
+ *  the buffer, so no lock is needed - the count is published
+ *  after the zone so the exporter never sees a partial zone.
+ ***********************************************************/
+void TraceRecorder::WriteZone(const char* name, uint64_t startNs, uint64_t endNs)
+{
+	if (false == g_bRecording.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	THREAD_BUFFER* pBuffer = GetThreadBuffer();
+	uint32_t index = pBuffer->zoneCount.load(std::memory_order_relaxed);
+	if (index >= ZONES_PER_THREAD)
+	{
+		pBuffer->droppedZones.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	pBuffer->zones[index].name = name;
+	pBuffer->zones[index].startNs = startNs;
+	pBuffer->zones[index].endNs = endNs;
+	pBuffer->zoneCount.store(index + 1, std::memory_order_release);
+}
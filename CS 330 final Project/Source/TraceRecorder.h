@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// tracerecorder.h
+// ============
+// lightweight zone tracing - records named, timed scopes on every thread and
+// exports them as a Chrome trace-event JSON file (chrome://tracing, Perfetto)
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// trace zones can be compiled out entirely by defining DISABLE_TRACING
+#ifndef DISABLE_TRACING
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// time the enclosing scope - the name must stay valid for the
+// whole run, such as a string literal
+#define TRACE_SCOPE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+// time the enclosing function
+#define TRACE_FUNCTION() TRACE_SCOPE(__FUNCTION__)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_FUNCTION()
+#endif
+
+/***********************************************************
+ *  TraceRecorder
+ *
+ *  This class collects trace zones from every thread.  Each
+ *  thread writes into its own fixed size buffer, so recording
+ *  a zone never takes a lock or allocates memory.  The zones
+ *  are written out as a Chrome trace-event JSON file when
+ *  the recording is stopped.
+ ***********************************************************/
+class TraceRecorder
+{
+public:
+	// start recording - zones are captured during startup and
+	// for the frames in the passed in range, -1 meaning no limit
+	static void Start(const char* filename, int firstFrame, int lastFrame);
+	// stop recording and write the trace file
+	static bool Stop();
+
+	// tell the recorder a new frame is starting
+	static void BeginFrame(int frameIndex);
+
+	// check whether zones are being captured right now
+	static bool IsCapturing();
+
+	// name the calling thread in the exported timeline
+	static void SetThreadName(const char* name);
+
+	// keep a copy of a name built at runtime, for use as a zone
+	// name - call this during setup, not every frame
+	static const char* InternName(const std::string& name);
+
+	// current trace time in nanoseconds
+	static uint64_t NowNs();
+
+	// record a finished zone on the calling thread
+	static void WriteZone(const char* name, uint64_t startNs, uint64_t endNs);
+};
+
+/***********************************************************
+ *  TraceZone
+ *
+ *  This class records the time between its construction and
+ *  its destruction as one trace zone.
+ ***********************************************************/
+class TraceZone
+{
+public:
+	// constructor
+	TraceZone(const char* name)
+	{
+		m_name = name;
+		m_startNs = TraceRecorder::IsCapturing() ? TraceRecorder::NowNs() : 0;
+	}
+	// destructor
+	~TraceZone()
+	{
+		if (m_startNs != 0)
+		{
+			TraceRecorder::WriteZone(m_name, m_startNs, TraceRecorder::NowNs());
+		}
+	}
+
+private:
+	const char* m_name;
+	uint64_t m_startNs;
+};
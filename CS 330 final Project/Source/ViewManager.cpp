@@ -8,6 +8,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "FrameScheduler.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
 #include "camera.h"
 
 // GLM Math Header inclusions
@@ -22,8 +25,14 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
+	// width over height of the window framebuffer, kept up to date
+	// as the window is resized
+	float g_AspectRatio = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
+	// the shader uniform names, built once rather than as a
+	// temporary string on every frame
+	const std::string g_ViewName = "view";
+	const std::string g_ProjectionName = "projection";
+	const std::string g_ViewPositionName = "viewPosition";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -34,9 +43,23 @@ namespace
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
 
-	// time between current frame and last frame
-	float gDeltaTime = 0.0f; 
-	float gLastFrame = 0.0f;
+	// camera movement keys currently held down - these are sampled
+	// every loop iteration and applied in fixed simulation steps
+	bool gMoveForward = false;
+	bool gMoveBackward = false;
+	bool gMoveLeft = false;
+	bool gMoveRight = false;
+	bool gMoveUp = false;
+	bool gMoveDown = false;
+
+	// camera position before the latest simulation step, used to
+	// interpolate the rendered view between simulation steps
+	glm::vec3 gPreviousPosition;
+	// camera velocity over the latest simulation step
+	glm::vec3 gCameraVelocity(0.0f, 0.0f, 0.0f);
+
+	// frame scheduler that is told when input changes the view
+	FrameScheduler* g_pFrameScheduler = nullptr;
 
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
@@ -54,12 +77,15 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.5f, 5.5f, 10.0f);
 	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
+	gPreviousPosition = g_pCamera->Position;
 }
 /***********************************************************
  *  ~ViewManager()
@@ -101,6 +127,16 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	}
 	glfwMakeContextCurrent(window);
 
+	// the framebuffer can be larger than the window on high DPI
+	// displays, so the aspect ratio starts from its real size
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	if ((framebufferWidth > 0) && (framebufferHeight > 0))
+	{
+		g_AspectRatio = (float)framebufferWidth / (float)framebufferHeight;
+	}
+
 	// tell GLFW to capture all mouse events
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -110,6 +146,10 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
 
+	// these callbacks are used to redraw when the window is damaged or resized
+	glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+
 	// enable blending for supporting tranparent rendering
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -147,6 +187,11 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 
 	// move the 3D camera according to the calculated offsets
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+
+	if (g_pFrameScheduler != nullptr)
+	{
+		g_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_INPUT | FrameScheduler::DIRTY_CAMERA);
+	}
 }
 
 void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset)
@@ -155,6 +200,60 @@ void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, doub
 	{
 		g_pCamera->ProcessMouseScroll(static_cast<float>(yoffset));
 	}
+
+	if (g_pFrameScheduler != nullptr)
+	{
+		g_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_INPUT | FrameScheduler::DIRTY_CAMERA);
+	}
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the contents of the window are damaged and need to be
+ *  redrawn, such as after being uncovered.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	if (g_pFrameScheduler != nullptr)
+	{
+		g_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_WINDOW);
+	}
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the size of the window framebuffer changes, to resize the
+ *  viewport and the aspect ratio of the projection with it.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	// a minimized window has no framebuffer, so the viewport and
+	// the aspect ratio are left as they were until it comes back
+	if ((width > 0) && (height > 0))
+	{
+		glViewport(0, 0, width, height);
+		g_AspectRatio = (float)width / (float)height;
+	}
+
+	if (g_pFrameScheduler != nullptr)
+	{
+		g_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_WINDOW);
+	}
+}
+
+/***********************************************************
+ *  SetFrameScheduler()
+ *
+ *  This method is used to set the frame scheduler that gets
+ *  notified whenever input changes the view of the scene.
+ ***********************************************************/
+void ViewManager::SetFrameScheduler(FrameScheduler* pFrameScheduler)
+{
+	g_pFrameScheduler = pFrameScheduler;
 }
 
 
@@ -173,33 +272,21 @@ void ViewManager::ProcessKeyboardEvents()
 		glfwSetWindowShouldClose(m_pWindow, true);
 	}
 
+	// camera movement is applied in fixed steps by UpdateCamera(),
+	// so only remember which movement keys are held down here
+
 	// process camera zooming in and out
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
-	}
+	gMoveForward = (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS);
+	gMoveBackward = (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS);
 
 	// process camera panning left and right
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
-	}
-	{
-		// Process camera panning up and down using 'Q' and 'E'
-		if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
-			g_pCamera->ProcessKeyboard(UP, gDeltaTime); // pan camera up
+	gMoveLeft = (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS);
+	gMoveRight = (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS);
+
+	// Process camera panning up and down using 'Q' and 'E'
+	gMoveUp = (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS);
+	gMoveDown = (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS);
 
-		if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
-			g_pCamera->ProcessKeyboard(DOWN, gDeltaTime); // pan camera down
-	}
 	//Orthographic view
 	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
 	{
@@ -209,34 +296,166 @@ void ViewManager::ProcessKeyboardEvents()
 		g_pCamera->Position = glm::vec3(0.0f, 4.0f, 10.f);
 		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 		g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
+		// jump straight to the new position instead of interpolating
+		gPreviousPosition = g_pCamera->Position;
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
 		bOrthographicProjection = false;
 }
 
+/***********************************************************
+ *  ProcessInput()
+ *
+ *  This method is used to process the waiting keyboard input.
+ *  It runs every loop iteration, even when no frame is
+ *  rendered, and tells the frame scheduler whenever the view
+ *  of the scene has changed or is about to change.
+ ***********************************************************/
+void ViewManager::ProcessInput()
+{
+	// remember the camera state to detect any changes
+	glm::vec3 lastPosition = g_pCamera->Position;
+	glm::vec3 lastFront = g_pCamera->Front;
+	glm::vec3 lastUp = g_pCamera->Up;
+	bool bLastOrthographic = bOrthographicProjection;
+
+	// process any keyboard events that may be waiting in the 
+	// event queue
+	ProcessKeyboardEvents();
+
+	bool bMoving = gMoveForward || gMoveBackward || gMoveLeft ||
+		gMoveRight || gMoveUp || gMoveDown;
+
+	// once movement stops, settle the interpolated view on the
+	// final simulated position so an idle frame is not left
+	// lagging part of a step behind
+	bool bSettled = false;
+	if ((bMoving == false) && (gPreviousPosition != g_pCamera->Position))
+	{
+		gPreviousPosition = g_pCamera->Position;
+		bSettled = true;
+	}
+
+	if (g_pFrameScheduler != nullptr)
+	{
+		bool bCameraChanged =
+			(lastPosition != g_pCamera->Position) ||
+			(lastFront != g_pCamera->Front) ||
+			(lastUp != g_pCamera->Up) ||
+			(bLastOrthographic != bOrthographicProjection) ||
+			(bSettled == true);
+
+		if (bCameraChanged == true)
+		{
+			g_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_INPUT | FrameScheduler::DIRTY_CAMERA);
+		}
+		// a held movement key keeps moving the camera without
+		// sending new events, so keep the loop from blocking
+		g_pFrameScheduler->SetInputActive(bMoving);
+	}
+}
+
+/***********************************************************
+ *  UpdateCamera()
+ *
+ *  This method is used to advance the camera by one fixed
+ *  simulation step, moving it according to the held keys.
+ *  Using a fixed step keeps the movement the same at any
+ *  frame rate.
+ ***********************************************************/
+void ViewManager::UpdateCamera(float stepSeconds)
+{
+	TRACE_SCOPE("UpdateCamera");
+
+	gPreviousPosition = g_pCamera->Position;
+
+	// process camera zooming in and out
+	if (gMoveForward)
+	{
+		g_pCamera->ProcessKeyboard(FORWARD, stepSeconds);
+	}
+	if (gMoveBackward)
+	{
+		g_pCamera->ProcessKeyboard(BACKWARD, stepSeconds);
+	}
+
+	// process camera panning left and right
+	if (gMoveLeft)
+	{
+		g_pCamera->ProcessKeyboard(LEFT, stepSeconds);
+	}
+	if (gMoveRight)
+	{
+		g_pCamera->ProcessKeyboard(RIGHT, stepSeconds);
+	}
+
+	// process camera panning up and down
+	if (gMoveUp)
+	{
+		g_pCamera->ProcessKeyboard(UP, stepSeconds);
+	}
+	if (gMoveDown)
+	{
+		g_pCamera->ProcessKeyboard(DOWN, stepSeconds);
+	}
+
+	if ((g_pFrameScheduler != nullptr) && (gPreviousPosition != g_pCamera->Position))
+	{
+		g_pFrameScheduler->MarkDirty(FrameScheduler::DIRTY_CAMERA);
+	}
+	if (stepSeconds > 0.0f)
+	{
+		gCameraVelocity = (g_pCamera->Position - gPreviousPosition) / stepSeconds;
+	}
+}
+
+/***********************************************************
+ *  GetCameraPosition()
+ *
+ *  This method returns the position of the camera after the
+ *  latest simulation step.
+ ***********************************************************/
+glm::vec3 ViewManager::GetCameraPosition() const
+{
+	return(g_pCamera->Position);
+}
+
+/***********************************************************
+ *  GetCameraVelocity()
+ *
+ *  This method returns how fast and in which direction the
+ *  camera moved over the latest simulation step.
+ ***********************************************************/
+glm::vec3 ViewManager::GetCameraVelocity() const
+{
+	return(gCameraVelocity);
+}
+
 /***********************************************************
  *  PrepareSceneView()
  *
  *  This method is used for preparing the 3D scene by loading
  *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  rendering.  The camera position is blended between the
+ *  last two simulation steps by the passed in alpha.
  ***********************************************************/
-void ViewManager::PrepareSceneView()
+void ViewManager::PrepareSceneView(float interpolationAlpha)
 {
+	TRACE_SCOPE("PrepareSceneView");
+
 	glm::mat4 view;
 	glm::mat4 projection;
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
-
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+	// render the camera part of the way between the previous and
+	// the current simulation step so motion stays smooth when the
+	// frame rate and the simulation rate differ
+	glm::vec3 simulatedPosition = g_pCamera->Position;
+	glm::vec3 viewPosition = glm::mix(gPreviousPosition, simulatedPosition, interpolationAlpha);
+	g_pCamera->Position = viewPosition;
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
+	g_pCamera->Position = simulatedPosition;
 
 	//adding the orthographic view
 	if (bOrthographicProjection)
@@ -247,8 +466,10 @@ void ViewManager::PrepareSceneView()
 	else
 	{
 		// define the current projection matrix
-		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+		projection = glm::perspective(glm::radians(g_pCamera->Zoom), g_AspectRatio, 0.1f, 100.0f);
 	}
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
@@ -257,6 +478,7 @@ void ViewManager::PrepareSceneView()
 		// set the view matrix into the shader for proper rendering
 		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_pShaderManager->setVec3Value(g_ViewPositionName, viewPosition);
+		RenderStats::Count(RenderStats::UNIFORM_UPDATES, 3);
 	}
 }
\ No newline at end of file
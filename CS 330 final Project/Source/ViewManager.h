@@ -12,6 +12,8 @@
 #include "ShaderManager.h"
 #include "camera.h"
 
+class FrameScheduler;
+
 // GLFW library
 #include "GLFW/glfw3.h" 
 
@@ -31,6 +33,9 @@ public:
 
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset);
 
+	// window damage and resize callbacks so the scene is redrawn when needed
+	static void Window_Refresh_Callback(GLFWwindow* window);
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
 
 
 private:
@@ -38,6 +43,9 @@ private:
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// the view and projection of the last prepared frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -45,7 +53,26 @@ private:
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+
+	// set the frame scheduler that is notified about input and camera changes
+	void SetFrameScheduler(FrameScheduler* pFrameScheduler);
+
+	// process the keyboard input that controls the camera
+	void ProcessInput();
+
+	// move the camera by one fixed simulation step
+	void UpdateCamera(float stepSeconds);
 	
 	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
+	void PrepareSceneView(float interpolationAlpha = 1.0f);
+
+	// the view and projection of the last prepared frame, for
+	// drawing with shaders other than the scene shader
+	const glm::mat4& GetViewMatrix() const { return(m_viewMatrix); }
+	const glm::mat4& GetProjectionMatrix() const { return(m_projectionMatrix); }
+
+	// where the camera is and how fast it moved over the last
+	// simulation step, in units per second
+	glm::vec3 GetCameraPosition() const;
+	glm::vec3 GetCameraVelocity() const;
 };
\ No newline at end of file
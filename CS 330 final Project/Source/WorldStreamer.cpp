@@ -0,0 +1,686 @@
+///////////////////////////////////////////////////////////////////////////////
+// worldstreamer.cpp
+// ============
+// chunked world streaming - a venue of party chunks loaded and unloaded on a
+// background thread around the camera, ahead of where it is heading, within
+// a memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "WorldStreamer.h"
+#include "AssetPack.h"
+#include "StressScene.h"
+#include "HitchDetector.h"
+#include "TraceRecorder.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// size of a chunk - one table of a generated party scene
+	const float CHUNK_WIDTH = 24.0f;
+	const float CHUNK_DEPTH = 14.0f;
+	// what each chunk holds
+	const STRESS_SCENE_PARAMS CHUNK_CONTENTS = { 1, 3, 4, 0, 0 };
+
+	// chunks nearer than this to the camera, or to where it is
+	// heading, are loaded, and chunks further than the unload
+	// distance are unloaded - the gap keeps a chunk on the edge
+	// from loading and unloading over and over
+	const float LOAD_DISTANCE = 36.0f;
+	const float UNLOAD_DISTANCE = 48.0f;
+	// how far ahead the camera movement is followed, and how much
+	// less a chunk is needed for only being ahead of the camera
+	const float PREFETCH_SECONDS = 4.0f;
+	const float PREFETCH_PENALTY = CHUNK_DEPTH * 0.5f;
+	// a chunk this near the camera should always be loaded
+	const float NEAR_DISTANCE = CHUNK_WIDTH * 0.5f;
+
+	// most chunks waiting for the loader thread at once
+	const int MAX_QUEUED_LOADS = 2;
+	// most texture bytes uploaded in one frame
+	const size_t UPLOAD_BYTES_PER_FRAME = 2 * 1024 * 1024;
+
+	const double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+
+	/***********************************************************
+	 *  GetPlanarDistance()
+	 *
+	 *  This function returns the distance between two points
+	 *  across the floor, ignoring the height.
+	 ***********************************************************/
+	float GetPlanarDistance(const glm::vec3& a, const glm::vec3& b)
+	{
+		float x = a.x - b.x;
+		float z = a.z - b.z;
+		return(std::sqrt(x * x + z * z));
+	}
+}
+
+/***********************************************************
+ *  WorldStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+WorldStreamer::WorldStreamer(SceneManager* pSceneManager, int columns, int rows, size_t budgetBytes, unsigned int seed)
+{
+	m_pSceneManager = pSceneManager;
+	m_columns = (columns > 0) ? columns : 1;
+	m_rows = (rows > 0) ? rows : 1;
+	m_budgetBytes = budgetBytes;
+	m_seed = seed;
+	m_liveBytes = 0;
+	m_estimatedChunkBytes = 0;
+	m_bShutdown = false;
+	m_peakBytes = 0;
+	m_loads = 0;
+	m_unloads = 0;
+	m_lateChunkFrames = 0;
+	m_maxUploadMs = 0.0;
+	m_updateCount = 0;
+
+	// the venue is centered on the origin
+	m_chunks.resize((size_t)m_columns * m_rows);
+	for (int i = 0; i < (int)m_chunks.size(); i++)
+	{
+		WORLD_CHUNK& chunk = m_chunks[i];
+		chunk.center = glm::vec3(
+			((i % m_columns) - m_columns * 0.5f + 0.5f) * CHUNK_WIDTH,
+			0.0f,
+			((i / m_columns) - m_rows * 0.5f + 0.5f) * CHUNK_DEPTH);
+		chunk.state = CHUNK_UNLOADED;
+		chunk.priority = 0.0f;
+		chunk.bWanted = false;
+		chunk.bytes = 0;
+	}
+
+	// reserved up front, so the updates do not allocate
+	m_liveChunks.reserve(m_chunks.size());
+	m_wantedChunks.reserve(m_chunks.size());
+	m_loadedChunks.reserve(m_chunks.size());
+	m_finishedChunks.reserve(m_chunks.size());
+}
+
+/***********************************************************
+ *  ~WorldStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+WorldStreamer::~WorldStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		m_bShutdown = true;
+	}
+	m_loaderReady.notify_all();
+	if (m_loader.joinable())
+	{
+		m_loader.join();
+	}
+
+	// the textures are freed with the chunks
+	for (WORLD_CHUNK& chunk : m_chunks)
+	{
+		FreeImages(chunk);
+	}
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to start the loader thread.
+ ***********************************************************/
+void WorldStreamer::Start()
+{
+	if (false == m_loader.joinable())
+	{
+		m_loader = std::thread(&WorldStreamer::LoaderLoop, this);
+	}
+
+	std::cout << "INFO: streaming a venue of " << m_columns << " x " << m_rows << " chunks within "
+		<< (m_budgetBytes / BYTES_PER_MEGABYTE) << " MB" << std::endl;
+}
+
+/***********************************************************
+ *  LoaderLoop()
+ *
+ *  This method is the loop of the loader thread - it builds
+ *  the requested chunks in turn and hands them back.
+ ***********************************************************/
+void WorldStreamer::LoaderLoop()
+{
+	TraceRecorder::SetThreadName("world streaming");
+
+	while (true)
+	{
+		int chunkIndex = -1;
+		{
+			std::unique_lock<std::mutex> lock(m_loaderMutex);
+			m_loaderReady.wait(lock, [this]() { return(m_bShutdown || (false == m_loadRequests.empty())); });
+			if (true == m_bShutdown)
+			{
+				return;
+			}
+			chunkIndex = m_loadRequests.front();
+			m_loadRequests.pop_front();
+		}
+
+		BuildChunk(chunkIndex);
+
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		m_loadedChunks.push_back(chunkIndex);
+	}
+}
+
+/***********************************************************
+ *  BuildChunk()
+ *
+ *  This method is used on the loader thread to generate the
+ *  party area of a chunk from the seed, place its objects
+ *  within the chunk, tint its materials and decode its own
+ *  copy of every texture image it uses.
+ ***********************************************************/
+void WorldStreamer::BuildChunk(int chunkIndex)
+{
+	TRACE_SCOPE("WorldStreamer::BuildChunk");
+	HitchActivity activity(HitchDetector::ACTIVITY_ASSET_LOAD, "WorldStreamer::BuildChunk");
+
+	WORLD_CHUNK& chunk = m_chunks[chunkIndex];
+
+	STRESS_SCENE_PARAMS params = CHUNK_CONTENTS;
+	params.seed = m_seed ^ ((unsigned int)chunkIndex * 0x9E3779B9u);
+	SCENE_DESCRIPTION scene;
+	GenerateStressScene(params, scene);
+
+	// decode the images - a texture that fails to load leaves its
+	// objects drawn in their color
+	std::vector<int> textureOfTag(scene.textures.size(), -1);
+	chunk.images.clear();
+	for (size_t i = 0; i < scene.textures.size(); i++)
+	{
+		CHUNK_IMAGE image = { NULL, 0, 0, 0, 0 };
+		image.pixels = AssetPack::LoadImagePixels(scene.textures[i].filename.c_str(),
+			&image.width, &image.height, &image.colorChannels, 0);
+		if ((NULL != image.pixels) && (image.colorChannels != 3) && (image.colorChannels != 4))
+		{
+			AssetPack::FreeImagePixels(image.pixels);
+			image.pixels = NULL;
+		}
+		if (NULL == image.pixels)
+		{
+			continue;
+		}
+
+		textureOfTag[i] = (int)chunk.images.size();
+		chunk.images.push_back(image);
+	}
+
+	// every chunk has its own shade of the materials
+	float tint = 0.85f + 0.3f * ((params.seed >> 8) & 0xFF) / 255.0f;
+	chunk.materials.clear();
+	for (const SCENE_MATERIAL_DESC& materialDesc : scene.materials)
+	{
+		SceneManager::OBJECT_MATERIAL material;
+		material.diffuseColor = glm::min(materialDesc.diffuseColor * tint, glm::vec3(1.0f));
+		material.specularColor = materialDesc.specularColor;
+		material.shininess = materialDesc.shininess;
+		material.tag = materialDesc.tag;
+		chunk.materials.push_back(material);
+	}
+
+	chunk.objects.clear();
+	for (const SCENE_OBJECT_DESC& objectDesc : scene.objects)
+	{
+		SceneManager::STREAMED_OBJECT object;
+		object.model =
+			glm::translate(chunk.center + objectDesc.position) *
+			glm::rotate(glm::radians(objectDesc.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f)) *
+			glm::rotate(glm::radians(objectDesc.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+			glm::rotate(glm::radians(objectDesc.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+			glm::scale(objectDesc.scale);
+		object.mesh = objectDesc.mesh;
+		object.texture = -1;
+		object.color = objectDesc.color;
+		object.uvScale = objectDesc.uvScale;
+		object.material = -1;
+		for (size_t i = 0; i < scene.textures.size(); i++)
+		{
+			if (scene.textures[i].tag == objectDesc.texture)
+			{
+				object.texture = textureOfTag[i];
+			}
+		}
+		for (size_t i = 0; i < scene.materials.size(); i++)
+		{
+			if (scene.materials[i].tag == objectDesc.material)
+			{
+				object.material = (int)i;
+			}
+		}
+		chunk.objects.push_back(object);
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to bring the loaded chunks in line
+ *  with where the camera is and where it is heading.
+ ***********************************************************/
+void WorldStreamer::Update(const glm::vec3& cameraPosition, const glm::vec3& cameraVelocity)
+{
+	TRACE_SCOPE("WorldStreamer::Update");
+	HITCH_PHASE("WorldStreaming");
+
+	CollectBuiltChunks();
+	PrioritizeChunks(cameraPosition, cameraVelocity);
+	RequestLoads();
+	UploadTextures();
+
+	m_peakBytes = (m_liveBytes > m_peakBytes) ? m_liveBytes : m_peakBytes;
+	m_updateCount++;
+}
+
+/***********************************************************
+ *  CollectBuiltChunks()
+ *
+ *  This method is used to take the chunks built by the loader
+ *  thread.  Chunks that are still wanted go on to have their
+ *  textures uploaded, and the rest are dropped.
+ ***********************************************************/
+void WorldStreamer::CollectBuiltChunks()
+{
+	m_finishedChunks.clear();
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		m_finishedChunks.swap(m_loadedChunks);
+	}
+
+	for (int chunkIndex : m_finishedChunks)
+	{
+		WORLD_CHUNK& chunk = m_chunks[chunkIndex];
+
+		// the chunk was counted at the estimated size while queued
+		m_liveBytes -= chunk.bytes;
+		chunk.bytes = 0;
+		for (const CHUNK_IMAGE& image : chunk.images)
+		{
+			chunk.bytes += GpuResourceTracker::GetTextureBytes(image.width, image.height, image.colorChannels, true);
+		}
+		m_liveBytes += chunk.bytes;
+		m_estimatedChunkBytes = chunk.bytes;
+
+		chunk.state = CHUNK_UPLOADING;
+		chunk.textures.resize(chunk.images.size());
+		chunk.textureIDs.assign(chunk.images.size(), 0);
+		if (chunk.priority > UNLOAD_DISTANCE)
+		{
+			UnloadChunk(chunkIndex);
+		}
+	}
+}
+
+/***********************************************************
+ *  PrioritizeChunks()
+ *
+ *  This method is used to work out how much every chunk near
+ *  the camera, or near where the camera is heading, is
+ *  needed.  The chunks within the load distance are wanted,
+ *  nearest first, and the live chunks beyond the unload
+ *  distance are unloaded.
+ ***********************************************************/
+void WorldStreamer::PrioritizeChunks(const glm::vec3& cameraPosition, const glm::vec3& cameraVelocity)
+{
+	glm::vec3 heading = cameraPosition + glm::vec3(cameraVelocity.x, 0.0f, cameraVelocity.z) * PREFETCH_SECONDS;
+
+	// the chunks that may be wanted lie in the box around both
+	// points
+	float minX = std::min(cameraPosition.x, heading.x) - LOAD_DISTANCE;
+	float maxX = std::max(cameraPosition.x, heading.x) + LOAD_DISTANCE;
+	float minZ = std::min(cameraPosition.z, heading.z) - LOAD_DISTANCE;
+	float maxZ = std::max(cameraPosition.z, heading.z) + LOAD_DISTANCE;
+	int firstColumn = std::max(0, (int)std::floor(minX / CHUNK_WIDTH + m_columns * 0.5f));
+	int lastColumn = std::min(m_columns - 1, (int)std::floor(maxX / CHUNK_WIDTH + m_columns * 0.5f));
+	int firstRow = std::max(0, (int)std::floor(minZ / CHUNK_DEPTH + m_rows * 0.5f));
+	int lastRow = std::min(m_rows - 1, (int)std::floor(maxZ / CHUNK_DEPTH + m_rows * 0.5f));
+
+	bool bNearChunkMissing = false;
+	m_wantedChunks.clear();
+	for (int chunkIndex : m_liveChunks)
+	{
+		m_chunks[chunkIndex].bWanted = false;
+	}
+	for (int row = firstRow; row <= lastRow; row++)
+	{
+		for (int column = firstColumn; column <= lastColumn; column++)
+		{
+			int chunkIndex = row * m_columns + column;
+			WORLD_CHUNK& chunk = m_chunks[chunkIndex];
+			float cameraDistance = GetPlanarDistance(chunk.center, cameraPosition);
+			float headingDistance = GetPlanarDistance(chunk.center, heading) + PREFETCH_PENALTY;
+			chunk.priority = std::min(cameraDistance, headingDistance);
+			chunk.bWanted = (chunk.priority < LOAD_DISTANCE);
+			if ((true == chunk.bWanted) && (chunk.state == CHUNK_UNLOADED))
+			{
+				m_wantedChunks.push_back(chunkIndex);
+			}
+			if ((cameraDistance < NEAR_DISTANCE) && (chunk.state != CHUNK_RESIDENT))
+			{
+				bNearChunkMissing = true;
+			}
+		}
+	}
+	if (true == bNearChunkMissing)
+	{
+		m_lateChunkFrames++;
+	}
+
+	// the live chunks outside the box are further than the load
+	// distance from both points
+	for (size_t i = 0; i < m_liveChunks.size();)
+	{
+		WORLD_CHUNK& chunk = m_chunks[m_liveChunks[i]];
+		if (false == chunk.bWanted)
+		{
+			chunk.priority = std::min(
+				GetPlanarDistance(chunk.center, cameraPosition),
+				GetPlanarDistance(chunk.center, heading) + PREFETCH_PENALTY);
+		}
+		// the unload takes the chunk out of the live list, except
+		// for a chunk the loader thread is building, which stays
+		// until it comes back
+		size_t liveCount = m_liveChunks.size();
+		if (chunk.priority > UNLOAD_DISTANCE)
+		{
+			UnloadChunk(m_liveChunks[i]);
+		}
+		if (m_liveChunks.size() == liveCount)
+		{
+			i++;
+		}
+	}
+
+	std::sort(m_wantedChunks.begin(), m_wantedChunks.end(),
+		[this](int a, int b) { return(m_chunks[a].priority < m_chunks[b].priority); });
+}
+
+/***********************************************************
+ *  RequestLoads()
+ *
+ *  This method is used to hand the loader thread the wanted
+ *  chunks, nearest first.  When a chunk would not fit within
+ *  the budget, the loaded chunks that are needed less than
+ *  it are unloaded, furthest first, to make room.  A chunk that
+ *  still does not fit waits, with every chunk after it.
+ ***********************************************************/
+void WorldStreamer::RequestLoads()
+{
+	int queuedLoads = 0;
+	for (int chunkIndex : m_liveChunks)
+	{
+		queuedLoads += (m_chunks[chunkIndex].state == CHUNK_QUEUED) ? 1 : 0;
+	}
+
+	for (int chunkIndex : m_wantedChunks)
+	{
+		if (queuedLoads >= MAX_QUEUED_LOADS)
+		{
+			break;
+		}
+
+		WORLD_CHUNK& chunk = m_chunks[chunkIndex];
+		while (m_liveBytes + m_estimatedChunkBytes > m_budgetBytes)
+		{
+			int furthest = -1;
+			for (int liveIndex : m_liveChunks)
+			{
+				const WORLD_CHUNK& live = m_chunks[liveIndex];
+				if ((live.state != CHUNK_QUEUED) && (live.priority > chunk.priority) &&
+					((furthest < 0) || (live.priority > m_chunks[furthest].priority)))
+				{
+					furthest = liveIndex;
+				}
+			}
+			if (furthest < 0)
+			{
+				return;
+			}
+			UnloadChunk(furthest);
+		}
+
+		chunk.state = CHUNK_QUEUED;
+		chunk.bytes = m_estimatedChunkBytes;
+		m_liveBytes += chunk.bytes;
+		m_liveChunks.push_back(chunkIndex);
+		{
+			std::lock_guard<std::mutex> lock(m_loaderMutex);
+			m_loadRequests.push_back(chunkIndex);
+		}
+		m_loaderReady.notify_one();
+		queuedLoads++;
+		m_loads++;
+	}
+}
+
+/***********************************************************
+ *  UploadTextures()
+ *
+ *  This method is used to upload the next rows of the chunk
+ *  textures, for the most needed chunks first, until the
+ *  bytes for this frame are spent.  Each texture has its
+ *  mipmaps made once its last row is in, and a chunk is drawn
+ *  once all of its textures are complete.
+ ***********************************************************/
+void WorldStreamer::UploadTextures()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t budget = UPLOAD_BYTES_PER_FRAME;
+	bool bUploaded = false;
+
+	// the textures are bound on the spare unit, so the units of the
+	// scene texture slots keep their textures
+	glActiveTexture(GL_TEXTURE0 + SceneManager::SPARE_TEXTURE_UNIT);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while (budget > 0)
+	{
+		// the most needed chunk still uploading
+		int next = -1;
+		for (int chunkIndex : m_liveChunks)
+		{
+			const WORLD_CHUNK& chunk = m_chunks[chunkIndex];
+			if ((chunk.state == CHUNK_UPLOADING) &&
+				((next < 0) || (chunk.priority < m_chunks[next].priority)))
+			{
+				next = chunkIndex;
+			}
+		}
+		if (next < 0)
+		{
+			break;
+		}
+
+		WORLD_CHUNK& chunk = m_chunks[next];
+		bool bComplete = true;
+		for (size_t i = 0; (i < chunk.images.size()) && (budget > 0); i++)
+		{
+			CHUNK_IMAGE& image = chunk.images[i];
+			if (NULL == image.pixels)
+			{
+				continue;
+			}
+
+			GLenum format = (image.colorChannels == 4) ? GL_RGBA : GL_RGB;
+			GLTextureHandle& texture = chunk.textures[i];
+			if (0 == texture.Get())
+			{
+				texture.Create("WorldStreamer chunk", GPU_RESOURCE_SITE);
+				glBindTexture(GL_TEXTURE_2D, texture.Get());
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexImage2D(GL_TEXTURE_2D, 0, (image.colorChannels == 4) ? GL_RGBA8 : GL_RGB8,
+					image.width, image.height, 0, format, GL_UNSIGNED_BYTE, NULL);
+				chunk.textureIDs[i] = texture.Get();
+			}
+			else
+			{
+				glBindTexture(GL_TEXTURE_2D, texture.Get());
+			}
+
+			size_t rowBytes = (size_t)image.width * image.colorChannels;
+			int rows = std::min(image.height - image.uploadedRows, std::max(1, (int)(budget / rowBytes)));
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, image.uploadedRows, image.width, rows, format, GL_UNSIGNED_BYTE,
+				image.pixels + rowBytes * image.uploadedRows);
+			image.uploadedRows += rows;
+			budget -= std::min(budget, rows * rowBytes);
+			bUploaded = true;
+
+			if (image.uploadedRows >= image.height)
+			{
+				glGenerateMipmap(GL_TEXTURE_2D);
+				texture.SetByteSize(GpuResourceTracker::GetTextureBytes(
+					image.width, image.height, image.colorChannels, true));
+				AssetPack::FreeImagePixels(image.pixels);
+				image.pixels = NULL;
+			}
+			else
+			{
+				bComplete = false;
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// the loop stops with budget left only once every image of
+		// the chunk is in
+		if ((true == bComplete) && (budget > 0))
+		{
+			chunk.state = CHUNK_RESIDENT;
+			chunk.images.clear();
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glActiveTexture(GL_TEXTURE0);
+
+	if (true == bUploaded)
+	{
+		double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		m_maxUploadMs = (uploadMs > m_maxUploadMs) ? uploadMs : m_maxUploadMs;
+	}
+}
+
+/***********************************************************
+ *  UnloadChunk()
+ *
+ *  This method is used to free a chunk.  A chunk the loader
+ *  thread has not started is taken off its queue, and one it
+ *  is building is dropped once it comes back.
+ ***********************************************************/
+void WorldStreamer::UnloadChunk(int chunkIndex)
+{
+	WORLD_CHUNK& chunk = m_chunks[chunkIndex];
+	if (chunk.state == CHUNK_UNLOADED)
+	{
+		return;
+	}
+
+	if (chunk.state == CHUNK_QUEUED)
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		std::deque<int>::iterator request = std::find(m_loadRequests.begin(), m_loadRequests.end(), chunkIndex);
+		if (request == m_loadRequests.end())
+		{
+			// being built - it is dropped when it comes back, since
+			// it is no longer wanted by then
+			chunk.priority = UNLOAD_DISTANCE * 2.0f;
+			return;
+		}
+		m_loadRequests.erase(request);
+	}
+	else
+	{
+		m_unloads++;
+	}
+	m_liveBytes -= chunk.bytes;
+	chunk.bytes = 0;
+
+	FreeImages(chunk);
+	chunk.objects.clear();
+	chunk.materials.clear();
+	chunk.textures.clear();
+	chunk.textureIDs.clear();
+	chunk.state = CHUNK_UNLOADED;
+
+	std::vector<int>::iterator live = std::find(m_liveChunks.begin(), m_liveChunks.end(), chunkIndex);
+	if (live != m_liveChunks.end())
+	{
+		*live = m_liveChunks.back();
+		m_liveChunks.pop_back();
+	}
+}
+
+/***********************************************************
+ *  FreeImages()
+ *
+ *  This method is used to free the decoded images of a chunk
+ *  that have not been uploaded.
+ ***********************************************************/
+void WorldStreamer::FreeImages(WORLD_CHUNK& chunk)
+{
+	for (CHUNK_IMAGE& image : chunk.images)
+	{
+		if (NULL != image.pixels)
+		{
+			AssetPack::FreeImagePixels(image.pixels);
+			image.pixels = NULL;
+		}
+	}
+	chunk.images.clear();
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used to draw every chunk that has all of
+ *  its textures uploaded.
+ ***********************************************************/
+void WorldStreamer::Render()
+{
+	TRACE_SCOPE("WorldStreamer::Render");
+
+	for (int chunkIndex : m_liveChunks)
+	{
+		const WORLD_CHUNK& chunk = m_chunks[chunkIndex];
+		if (chunk.state == CHUNK_RESIDENT)
+		{
+			m_pSceneManager->RenderStreamedObjects(
+				chunk.objects.data(), (int)chunk.objects.size(), chunk.textureIDs.data(), chunk.materials.data());
+		}
+	}
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used to print how many chunks were loaded
+ *  and unloaded, the most memory they held, and how often the
+ *  chunk under the camera was not ready.
+ ***********************************************************/
+void WorldStreamer::PrintReport() const
+{
+	std::cout << "STREAMING: venue:" << m_columns << "x" << m_rows
+		<< ", loads:" << m_loads
+		<< ", unloads:" << m_unloads
+		<< ", peak MB:" << (m_peakBytes / BYTES_PER_MEGABYTE)
+		<< ", budget MB:" << (m_budgetBytes / BYTES_PER_MEGABYTE)
+		<< ", frames missing a near chunk:" << m_lateChunkFrames << " of " << m_updateCount
+		<< ", max upload ms:" << m_maxUploadMs << std::endl;
+}
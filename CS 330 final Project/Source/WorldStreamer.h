@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////
+// worldstreamer.h
+// ============
+// chunked world streaming - a venue of party chunks loaded and unloaded on a
+// background thread around the camera, ahead of where it is heading, within
+// a memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "GpuResourceTracker.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  WorldStreamer
+ *
+ *  This class streams a venue made of a grid of chunks, each
+ *  one a party area with its own objects, materials and
+ *  textures.  Only the chunks around the camera, and around
+ *  where the camera will be a few seconds from now, are kept
+ *  loaded.  The chunks are built and their images decoded on
+ *  a loader thread, and the textures are uploaded on the main
+ *  thread a slice of rows at a time, within a budget of bytes
+ *  per frame, so no frame takes the whole cost of a chunk.
+ *  The textures of the loaded chunks are kept within a memory
+ *  budget by unloading the chunks furthest from the camera
+ *  first.
+ ***********************************************************/
+class WorldStreamer
+{
+public:
+	// constructor
+	WorldStreamer(SceneManager* pSceneManager, int columns, int rows, size_t budgetBytes, unsigned int seed);
+	// destructor
+	~WorldStreamer();
+
+	// start the loader thread
+	void Start();
+
+	// choose the chunks to keep from the camera position and
+	// velocity, hand the loads to the loader thread, unload what
+	// is no longer needed and upload the next slice of textures
+	void Update(const glm::vec3& cameraPosition, const glm::vec3& cameraVelocity);
+
+	// draw the chunks that are fully loaded
+	void Render();
+
+	// print the streaming totals
+	void PrintReport() const;
+
+private:
+	enum CHUNK_STATE
+	{
+		CHUNK_UNLOADED = 0,
+		// waiting for, or being built by, the loader thread
+		CHUNK_QUEUED,
+		// built, with textures still to upload
+		CHUNK_UPLOADING,
+		CHUNK_RESIDENT
+	};
+
+	// an image decoded by the loader thread, uploaded a slice of
+	// rows at a time
+	struct CHUNK_IMAGE
+	{
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+		int uploadedRows;
+	};
+
+	struct WORLD_CHUNK
+	{
+		glm::vec3 center;
+		CHUNK_STATE state;
+		// how near the chunk is to the camera and to where the camera
+		// is heading, smaller being more needed
+		float priority;
+		bool bWanted;
+		// written by the loader thread while the chunk is queued
+		std::vector<SceneManager::STREAMED_OBJECT> objects;
+		std::vector<SceneManager::OBJECT_MATERIAL> materials;
+		std::vector<CHUNK_IMAGE> images;
+		// the textures, made as the images are uploaded
+		std::vector<GLTextureHandle> textures;
+		std::vector<uint32_t> textureIDs;
+		// GPU bytes of the textures, counted at the estimated size
+		// while the chunk is queued
+		size_t bytes;
+	};
+
+	SceneManager* m_pSceneManager;
+	int m_columns;
+	int m_rows;
+	size_t m_budgetBytes;
+	unsigned int m_seed;
+	std::vector<WORLD_CHUNK> m_chunks;
+	// the chunks that are not unloaded
+	std::vector<int> m_liveChunks;
+	// the chunks wanted this update that are unloaded, nearest
+	// first
+	std::vector<int> m_wantedChunks;
+
+	// bytes held by the live chunks, counting each queued chunk
+	// at the size of the last chunk built
+	size_t m_liveBytes;
+	size_t m_estimatedChunkBytes;
+
+	// the loader thread and its queues
+	std::thread m_loader;
+	std::mutex m_loaderMutex;
+	std::condition_variable m_loaderReady;
+	std::deque<int> m_loadRequests;
+	std::vector<int> m_loadedChunks;
+	std::vector<int> m_finishedChunks;
+	bool m_bShutdown;
+
+	// streaming totals
+	size_t m_peakBytes;
+	int m_loads;
+	int m_unloads;
+	int m_lateChunkFrames;
+	double m_maxUploadMs;
+	int m_updateCount;
+
+	// the loop of the loader thread
+	void LoaderLoop();
+	// build the objects of a chunk and decode its images
+	void BuildChunk(int chunkIndex);
+
+	// work out which chunks are wanted and how much
+	void PrioritizeChunks(const glm::vec3& cameraPosition, const glm::vec3& cameraVelocity);
+	// take the chunks the loader thread has built
+	void CollectBuiltChunks();
+	// queue loads for the wanted chunks, unloading chunks that are
+	// needed less to stay within the budget
+	void RequestLoads();
+	// upload the next slices of the chunk textures
+	void UploadTextures();
+	// free a chunk and everything it loaded
+	void UnloadChunk(int chunkIndex);
+	// free the decoded images of a chunk
+	void FreeImages(WORLD_CHUNK& chunk);
+};
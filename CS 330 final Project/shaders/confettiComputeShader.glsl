@@ -0,0 +1,152 @@
+#version 430 core
+// confetti simulation - every pass of the GPU particle system is in this
+// file, and the program for each pass is built with one of the defines
+// PASS_PREPARE, PASS_UPDATE, PASS_EMIT or PASS_FINISH
+
+#if defined(PASS_PREPARE) || defined(PASS_FINISH)
+layout (local_size_x = 1) in;
+#else
+layout (local_size_x = 256) in;
+#endif
+
+#define GROUP_SIZE 256u
+
+struct Particle {
+    vec4 positionLife;      // xyz position, w seconds left to live
+    vec4 velocitySize;      // xyz velocity, w half the width of the piece
+    vec4 color;
+    vec4 spin;              // x angle, y angular velocity, z flutter phase
+};
+
+// the particles are ping-ponged between two buffers - the living particles
+// of the source buffer are written packed into the target buffer
+layout (std430, binding = 0) readonly buffer SourceParticles {
+    Particle sourceParticles[];
+};
+layout (std430, binding = 1) writeonly buffer TargetParticles {
+    Particle targetParticles[];
+};
+// the counts and the indirect commands, so the CPU never reads them back
+layout (std430, binding = 2) buffer Control {
+    uvec4 dispatchCommand;  // groups for the update pass
+    uvec4 drawCommand;      // vertex count, instance count, first, base instance
+    uint sourceCount;
+    uint targetCount;
+};
+
+uniform uint capacity;
+uniform float deltaTime;
+uniform float time;
+uniform vec3 gravity;
+uniform vec3 wind;
+uniform float drag;
+uniform float floorHeight;
+
+uniform uint emitCount;
+uniform uint emitSeed;
+uniform vec3 emitPosition;
+uniform float emitSpeed;
+uniform float emitLife;
+
+// a hash of an integer, for per particle random numbers
+uint Hash(uint value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352du;
+    value ^= value >> 15;
+    value *= 0x846ca68bu;
+    value ^= value >> 16;
+    return value;
+}
+
+// a random number from 0 up to 1, moving the state on
+float Random(inout uint state)
+{
+    state = Hash(state);
+    return float(state >> 8) / 16777216.0;
+}
+
+void main()
+{
+#if defined(PASS_PREPARE)
+    // size the update pass for the living particles and empty the target
+    dispatchCommand = uvec4((sourceCount + GROUP_SIZE - 1u) / GROUP_SIZE, 1u, 1u, 0u);
+    targetCount = 0u;
+
+#elif defined(PASS_UPDATE)
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= sourceCount)
+    {
+        return;
+    }
+
+    Particle particle = sourceParticles[index];
+    particle.positionLife.w -= deltaTime;
+    if (particle.positionLife.w <= 0.0)
+    {
+        // dead particles are not copied, which packs the survivors
+        return;
+    }
+
+    vec3 position = particle.positionLife.xyz;
+    vec3 velocity = particle.velocitySize.xyz;
+    if (position.y > floorHeight)
+    {
+        // the pieces drift toward the wind speed and sway as they fall
+        velocity += gravity * deltaTime;
+        velocity += (wind - velocity) * (1.0 - exp(-drag * deltaTime));
+        float sway = sin(time * 3.0 + particle.spin.z);
+        velocity.x += sway * 1.5 * deltaTime;
+        velocity.z += cos(time * 2.3 + particle.spin.z) * 1.5 * deltaTime;
+        position += velocity * deltaTime;
+        particle.spin.x += particle.spin.y * deltaTime;
+    }
+    if (position.y <= floorHeight)
+    {
+        // pieces that land stay where they are until they expire
+        position.y = floorHeight;
+        velocity = vec3(0.0);
+    }
+    particle.positionLife.xyz = position;
+    particle.velocitySize.xyz = velocity;
+
+    targetParticles[atomicAdd(targetCount, 1u)] = particle;
+
+#elif defined(PASS_EMIT)
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= emitCount)
+    {
+        return;
+    }
+
+    uint slot = atomicAdd(targetCount, 1u);
+    if (slot >= capacity)
+    {
+        // the buffer is full - the count is clamped by the finish pass
+        return;
+    }
+
+    uint state = Hash(emitSeed ^ (index * 0x9e3779b9u));
+    // a direction over the upper hemisphere
+    float angle = Random(state) * 6.2831853;
+    float height = Random(state);
+    float spread = sqrt(1.0 - height * height);
+    vec3 direction = vec3(cos(angle) * spread, height, sin(angle) * spread);
+
+    const vec3 palette[6] = vec3[6](
+        vec3(1.0, 0.2, 0.3), vec3(1.0, 0.8, 0.1), vec3(0.2, 0.8, 0.3),
+        vec3(0.2, 0.5, 1.0), vec3(0.8, 0.3, 0.9), vec3(1.0, 0.5, 0.1));
+
+    Particle particle;
+    particle.positionLife = vec4(emitPosition, emitLife * (0.5 + 0.5 * Random(state)));
+    particle.velocitySize = vec4(direction * emitSpeed * (0.3 + 0.7 * Random(state)), 0.04 + 0.04 * Random(state));
+    particle.color = vec4(palette[Hash(state) % 6u], 1.0);
+    particle.spin = vec4(Random(state) * 6.2831853, (Random(state) - 0.5) * 20.0, Random(state) * 6.2831853, 0.0);
+    targetParticles[slot] = particle;
+
+#elif defined(PASS_FINISH)
+    // the target becomes the source of the next step and is drawn
+    sourceCount = min(targetCount, capacity);
+    drawCommand = uvec4(4u, sourceCount, 0u, 0u);
+#endif
+}
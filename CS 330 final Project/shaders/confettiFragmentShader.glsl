@@ -0,0 +1,11 @@
+#version 430 core
+// confetti billboards - flat colored pieces
+
+in vec4 confettiColor;
+
+out vec4 fragmentColor;
+
+void main()
+{
+    fragmentColor = confettiColor;
+}
@@ -0,0 +1,41 @@
+#version 430 core
+// confetti billboards - one instance per particle, read straight from the
+// particle buffer written by the compute passes
+
+struct Particle {
+    vec4 positionLife;
+    vec4 velocitySize;
+    vec4 color;
+    vec4 spin;
+};
+
+layout (std430, binding = 0) readonly buffer Particles {
+    Particle particles[];
+};
+
+out vec4 confettiColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    Particle particle = particles[gl_InstanceID];
+
+    // the corners of a triangle strip quad from the vertex index
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+
+    // spin the piece in the view plane, and narrow it as it turns
+    // over so it looks like it is tumbling
+    float angle = particle.spin.x;
+    corner.x *= max(abs(cos(angle * 0.7)), 0.15);
+    vec2 rotated = vec2(
+        corner.x * cos(angle) - corner.y * sin(angle),
+        corner.x * sin(angle) + corner.y * cos(angle));
+
+    vec4 viewPosition = view * vec4(particle.positionLife.xyz, 1.0);
+    viewPosition.xy += rotated * particle.velocitySize.w;
+    gl_Position = projection * viewPosition;
+
+    confettiColor = particle.color;
+}
@@ -0,0 +1,41 @@
+#version 330 core
+// texture feedback - writes which texture slot each pixel samples and the
+// mip level it needs, for the texture residency
+
+out vec4 fragmentColor;
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+#define TOTAL_TEXTURE_SLOTS 16
+
+uniform bool bUseTexture = false;
+// the scene sets its sampler to the texture slot, so here it is
+// read as the slot number
+uniform int objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// full size of the texture in each slot
+uniform vec2 textureSizes[TOTAL_TEXTURE_SLOTS];
+// levels to take off for the feedback being rendered smaller
+// than the window
+uniform float feedbackLodBias = 0.0f;
+
+void main()
+{
+    if ((bUseTexture == false) || (objectTexture < 0) || (objectTexture >= TOTAL_TEXTURE_SLOTS))
+    {
+        fragmentColor = vec4(0.0f);
+        return;
+    }
+
+    // the level the texture would be sampled at, from how many
+    // texels one pixel covers
+    vec2 texel = fragmentTextureCoordinate * UVscale * textureSizes[objectTexture];
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5f * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8f)) - feedbackLodBias;
+
+    // slot 0 is written as 1, so 0 means no texture
+    fragmentColor = vec4(float(objectTexture + 1) / 255.0f, clamp(floor(lod), 0.0f, 15.0f) / 255.0f, 0.0f, 1.0f);
+}
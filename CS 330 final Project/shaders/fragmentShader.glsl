@@ -48,7 +48,7 @@ struct SpotLight {
     bool bActive;
 };
 
-#define TOTAL_POINT_LIGHTS 5
+#define TOTAL_POINT_LIGHTS 16
 
 uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
@@ -60,11 +60,15 @@ uniform SpotLight spotLight;
 uniform Material material;
 uniform sampler2D objectTexture;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// the offset and size of the texture in its atlas page, all of
+// the texture when it is not packed into one
+uniform vec4 atlasRect = vec4(0.0f, 0.0f, 1.0f, 1.0f);
 
 // the scaled texture coordinate to use in calculations
 vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
 
 // function prototypes
+vec4 SampleObjectTexture();
 vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
@@ -105,7 +109,7 @@ void main()
     
         if(bUseTexture == true)
         {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinateScaled)).a);
+            fragmentColor = vec4(phongResult, (SampleObjectTexture()).a);
         }
         else
         {
@@ -116,7 +120,7 @@ void main()
     {
         if(bUseTexture == true)
         {
-            fragmentColor = texture(objectTexture, fragmentTextureCoordinateScaled);
+            fragmentColor = SampleObjectTexture();
         }
         else
         {
@@ -125,6 +129,18 @@ void main()
     }
 }
 
+// samples the object texture, wrapping the coordinate inside the
+// atlas rectangle as GL_REPEAT would.  The gradients are taken
+// from the coordinate before it is wrapped, so the mip level does
+// not jump where the coordinate wraps.
+vec4 SampleObjectTexture()
+{
+    vec2 atlasCoordinate = atlasRect.xy + fract(fragmentTextureCoordinateScaled) * atlasRect.zw;
+    return textureGrad(objectTexture, atlasCoordinate,
+        dFdx(fragmentTextureCoordinateScaled) * atlasRect.zw,
+        dFdy(fragmentTextureCoordinateScaled) * atlasRect.zw);
+}
+
 // calculates the color when using a directional light.
 vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
 {
@@ -141,9 +157,9 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
     // combine results
     if(bUseTexture == true)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
+        ambient = light.ambient * vec3(SampleObjectTexture());
+        diffuse = light.diffuse * diff * material.diffuseColor * vec3(SampleObjectTexture());
+        specular = light.specular * spec * material.specularColor * vec3(SampleObjectTexture());
     }
     else
     {
@@ -173,8 +189,8 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     if(bUseTexture == true)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
+        ambient = light.ambient * vec3(SampleObjectTexture());
+        diffuse = light.diffuse * diff * material.diffuseColor * vec3(SampleObjectTexture());
         specular = light.specular * specularComponent * material.specularColor;
     }
     else
@@ -210,9 +226,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     if(bUseTexture == true)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
+        ambient = light.ambient * vec3(SampleObjectTexture());
+        diffuse = light.diffuse * diff * material.diffuseColor * vec3(SampleObjectTexture());
+        specular = light.specular * spec * material.specularColor * vec3(SampleObjectTexture());
     }
     else
     {
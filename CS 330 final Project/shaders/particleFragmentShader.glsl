@@ -0,0 +1,14 @@
+#version 330 core
+// CPU particle billboards - soft round puffs
+
+in vec4 particleColor;
+in vec2 particleCorner;
+
+out vec4 fragmentColor;
+
+void main()
+{
+    // fade from the middle of the quad to its edge
+    float falloff = 1.0 - smoothstep(0.2, 1.0, length(particleCorner));
+    fragmentColor = vec4(particleColor.rgb, particleColor.a * falloff);
+}
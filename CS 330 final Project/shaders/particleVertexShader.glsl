@@ -0,0 +1,24 @@
+#version 330 core
+// CPU particle billboards - one instance per particle, with the instance
+// values streamed in by the CPU every frame
+layout (location = 0) in vec4 inPositionSize;   // xyz position, w half size
+layout (location = 1) in vec4 inColor;
+
+out vec4 particleColor;
+out vec2 particleCorner;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    // the corners of a triangle strip quad from the vertex index
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+
+    vec4 viewPosition = view * vec4(inPositionSize.xyz, 1.0);
+    viewPosition.xy += corner * inPositionSize.w;
+    gl_Position = projection * viewPosition;
+
+    particleColor = inColor;
+    particleCorner = corner;
+}